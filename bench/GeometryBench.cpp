@@ -0,0 +1,192 @@
+// Microbenchmark of the geometry kernels and the shape intersection tests built on them. The same source is
+// compiled once per geometry configuration (see bench/CMakeLists.txt), so that the scalar and SIMD kernels and
+// the float and double geo_type can be compared side by side:
+//
+//     for b in geometry-bench-*; do ./$b; done
+//
+// Each run prints one line of JSON with the time per operation of each kernel in nanoseconds.
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <builders/ShapeBuilder.hpp>
+#include <geometry/Point.hpp>
+#include <geometry/Ray.hpp>
+#include <geometry/RayPacket.hpp>
+#include <geometry/Vector.hpp>
+#include <Shapes.hpp>
+
+using namespace geometry;
+
+namespace
+{
+    const std::size_t rayCount = 1 << 16;
+    const int repetitions = 32;
+
+    // Sum of results, printed so that the compiler cannot drop the work being timed
+    double checksum = 0.0;
+
+    // Nanoseconds per call of kernel(i) for i over all rays, best of several repetitions
+    template <typename Kernel>
+    double time(Kernel&& kernel)
+    {
+        double best = 0.0;
+
+        for (int repetition = 0; repetition < repetitions; repetition++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            double sum = 0.0;
+
+            for (std::size_t i = 0; i < rayCount; i++)
+            {
+                sum += kernel(i);
+            }
+
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            double perCall = elapsed.count() / rayCount;
+            checksum += sum;
+
+            if (repetition == 0 || perCall < best)
+            {
+                best = perCall;
+            }
+        }
+
+        return best;
+    }
+
+    // Regular n x n grid of quads in the z = 0 plane, spanning [-1, 1] x [-1, 1]
+    shapes::MeshData grid(std::size_t n)
+    {
+        shapes::MeshData mesh;
+
+        for (std::size_t y = 0; y <= n; y++)
+        {
+            for (std::size_t x = 0; x <= n; x++)
+            {
+                mesh.addVertex(2.0 * x / n - 1.0, 2.0 * y / n - 1.0, 0.0);
+            }
+        }
+
+        for (std::size_t y = 0; y < n; y++)
+        {
+            for (std::size_t x = 0; x < n; x++)
+            {
+                std::uint32_t i = std::uint32_t(y * (n + 1) + x);
+                mesh.addPolygon({i, i + 1, i + std::uint32_t(n) + 2, i + std::uint32_t(n) + 1});
+            }
+        }
+
+        return mesh;
+    }
+
+    double distance(const shapes::Shape::IntersectionResult& result)
+    {
+        return result.shape() ? result.distance() : 0.0;
+    }
+
+    // Packets of consecutive rays, timed per ray: each call to the kernel tests the packet starting at ray i and
+    // is repeated for every width'th ray only
+    template <typename Kernel>
+    double timePackets(const std::vector<RayPacket3>& packets, Kernel&& kernel)
+    {
+        const std::size_t width = RayPacket3::width();
+
+        return time([&](std::size_t i) {
+            return i % width == 0 ? kernel(packets[i / width]) : 0.0;
+        });
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> spread(-1.0, 1.0);
+
+    // Rays from around z = -4 towards the unit cube about the origin, roughly half of which hit each shape
+    std::vector<Ray3> rays;
+    std::vector<Vector3> vectors;
+    rays.reserve(rayCount);
+    vectors.reserve(rayCount);
+
+    for (std::size_t i = 0; i < rayCount; i++)
+    {
+        Point3 origin(geo_type(spread(rng)), geo_type(spread(rng)), geo_type(-4.0));
+        Point3 target(geo_type(1.5 * spread(rng)), geo_type(1.5 * spread(rng)), geo_type(0.0));
+        rays.emplace_back(origin, normalize(target - origin));
+        vectors.emplace_back(geo_type(spread(rng)), geo_type(spread(rng)), geo_type(spread(rng)));
+    }
+
+    std::vector<RayPacket3> packets(rayCount / RayPacket3::width());
+
+    for (std::size_t i = 0; i < rayCount; i++)
+    {
+        packets[i / RayPacket3::width()].push(rays[i]);
+    }
+
+    auto surface = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 1.0);
+    shapes::Sphere sphere(Point3(0, 0, 0), Vector3(0, 1, 0), 1.0, surface);
+    shapes::Rectangle rectangle(Point3(-1, -1, 0), Point3(1, -1, 0), Point3(-1, 1, 0), surface);
+    shapes::Box box(Vector3(2, 2, 2), Point3(0, 0, 0), Vector3(0.05, 0.1, 0), surface);
+    shapes::TriangleMesh mesh(grid(64), surface);
+
+    double vectorOps = time([&](std::size_t i) {
+        const Vector3& a = vectors[i];
+        const Vector3& b = vectors[(i + 1) % rayCount];
+        Vector3 n = normalize(cross_product(a, b) + a * geo_type(0.5) - b);
+        return n * a;
+    });
+
+    double sphereTime = time([&](std::size_t i) { return distance(sphere.calculateRayIntersection(rays[i])); });
+    double rectangleTime = time([&](std::size_t i) { return distance(rectangle.calculateRayIntersection(rays[i])); });
+    double boxTime = time([&](std::size_t i) { return distance(box.calculateRayIntersection(rays[i])); });
+    double meshTime = time([&](std::size_t i) { return distance(mesh.calculateRayIntersection(rays[i])); });
+
+    PacketMask3 all;
+    all.fill(true);
+
+    auto packetDistance = [&](const shapes::Shape& shape, const RayPacket3& packet) {
+        shapes::Shape::PacketResults results;
+        shape.calculatePacketIntersection(packet, all, results);
+        double sum = 0.0;
+
+        for (const auto& result : results)
+        {
+            sum += distance(result);
+        }
+
+        return sum;
+    };
+
+    double spherePacketTime = timePackets(packets, [&](const RayPacket3& packet) { return packetDistance(sphere, packet); });
+    double rectanglePacketTime = timePackets(packets, [&](const RayPacket3& packet) { return packetDistance(rectangle, packet); });
+
+#ifdef GEOMETRY_SIMD_KERNELS
+    const char* kernels = "simd";
+#else
+    const char* kernels = "scalar";
+#endif
+
+    const char* nanCheck = GEOMETRY_NAN_CHECK == GEOMETRY_NAN_CHECK_COUNT ? "count" :
+            GEOMETRY_NAN_CHECK == GEOMETRY_NAN_CHECK_ASSERT ? "assert" : "off";
+
+    std::cout << "{\"geo-type\": \"" << (sizeof(geo_type) == sizeof(float) ? "float" : "double") << "\""
+              << ", \"kernels\": \"" << kernels << "\""
+              << ", \"nan-check\": \"" << nanCheck << "\""
+              << ", \"sizeof-vector3\": " << sizeof(Vector3)
+              << ", \"vector-ops-ns\": " << vectorOps
+              << ", \"sphere-ns\": " << sphereTime
+              << ", \"rectangle-ns\": " << rectangleTime
+              << ", \"sphere-packet-ns\": " << spherePacketTime
+              << ", \"rectangle-packet-ns\": " << rectanglePacketTime
+              << ", \"box-ns\": " << boxTime
+              << ", \"mesh-ns\": " << meshTime
+              << ", \"checksum\": " << checksum << "}" << std::endl;
+
+    return 0;
+}
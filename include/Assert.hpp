@@ -4,7 +4,7 @@
 #include <cassert>
 
 #ifdef NDEBUG
-#   define Assert(x) static_cast<void>(x)
+#   define Assert(x) static_cast<void>(sizeof(x))
 #else
 #   define Assert(x) assert(x)
 #endif
@@ -1,79 +1,61 @@
 #ifndef Camera_HPP
 #define Camera_HPP
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <random>
 #include <thread>
 #include <tuple>
 #include <vector>
 
 #include <geometry/Point.hpp>
 #include <geometry/Ray.hpp>
+#include <geometry/RayPacket.hpp>
 #include <graphics/Image.hpp>
+#include <sampling/Samplers.hpp>
 #include <threading/ThreadPool.hpp>
+#include <PixelStatistics.hpp>
 #include <RandomGenerator.hpp>
+#include <RenderStatistics.hpp>
 
 using namespace geometry;
 
-struct AntiAliaserNone
+// Camera samples traced together: lane i holds the ray of sample sampleIndex[i] of pixel (x[i], y[i])
+template <std::size_t Width>
+struct CameraPacket
 {
-    class iterator
+    using Colours = std::array<graphics::ColourRgb<float>, Width>;
+
+    geometry::RayPacket<geometry::geo_type, Width> rays;
+    std::array<size_t, Width> x;
+    std::array<size_t, Width> y;
+    std::array<size_t, Width> sampleIndex;
+    std::uint32_t dimension = 0;        // First sampler dimension left after the camera's
+
+    CameraPacket() :
+        rays(),
+        x(),
+        y(),
+        sampleIndex()
     {
-    private:
-        int m_n;
 
-    public:
-        iterator(int n = 0) : m_n(n) { }
-        iterator& operator++() { ++m_n; return *this; }
-        bool operator!=(iterator rhs) { return m_n != rhs.m_n; }
-
-        Vector2 operator*() const {
-            return Vector2(0, 0);
-        }
-    };
-
-    AntiAliaserNone(size_t) { }
-
-    iterator begin() const { return iterator(0); }
-    iterator end() const { return iterator(1); }
-
-private:
-
-    friend class iterator;
-};
-
-class AntiAliaserRandom
-{
-private:
-    size_t m_aaAmount;
+    }
 
-public:
-    class iterator
+    // Positions the sampler on the sample of a lane, past the dimensions spent on its camera ray
+    void resumeSample(sampling::Sampler& sampler, std::size_t lane) const
     {
-    private:
-        int m_n;
-
-    public:
-        iterator(int n = 0) : m_n(n) { }
-        iterator& operator++() { ++m_n; return *this; }
-        bool operator!=(iterator rhs) { return m_n != rhs.m_n; }
-
-        Vector2 operator*() const {
-            thread_local std::uniform_real_distribution<double> dist(-1.0, 1.0);
-            return Vector2(dist(RandomGenerator::get_instance()), dist(RandomGenerator::get_instance()));
-        }
-    };
-
-    AntiAliaserRandom(size_t _aaAmount = 1) :
-        m_aaAmount(_aaAmount)
-    { }
-
-    iterator begin() const { return iterator(0); }
-    iterator end() const { return iterator(m_aaAmount); }
+        resumeSample(sampler, lane, dimension);
+    }
 
-    friend class iterator;
+    // As above, at a later dimension of the sample
+    void resumeSample(sampling::Sampler& sampler, std::size_t lane, std::uint32_t sampleDimension) const
+    {
+        sampler.startSample(x[lane], y[lane], sampleIndex[lane], sampleDimension);
+    }
 };
 
 class Camera
@@ -87,6 +69,14 @@ private:
     size_t m_resolutionX;
     size_t m_resolutionY;
     size_t m_antiAliasingAmount;
+    size_t m_tileSize;
+    threading::ProblemSpace::Ordering m_tileOrder;
+    sampling::Sampler::Type m_samplerType;
+    double m_adaptiveThreshold;
+    size_t m_minSamplesPerPixel;
+    size_t m_samplesPerPass;
+    double m_noiseTarget;
+    double m_timeBudget;
 
 public:
     Camera(size_t resX, size_t resY, Point3 location, Vector3 direction, double focalLength = 1.0,
@@ -97,40 +87,179 @@ public:
             m_focalLength(focalLength),
             m_resolutionX(resX),
             m_resolutionY(resY),
-            m_antiAliasingAmount(antiAliasingAmount) {
+            m_antiAliasingAmount(antiAliasingAmount),
+            m_tileSize(16),
+            m_tileOrder(threading::ProblemSpace::Ordering::eHilbert),
+            m_samplerType(sampling::Sampler::Type::eSobol),
+            m_adaptiveThreshold(0.0),
+            m_minSamplesPerPixel(16),
+            m_samplesPerPass(0),
+            m_noiseTarget(0.0),
+            m_timeBudget(0.0) {
         double aspectRatio = double(resX) / double(resY);
         m_sensorSize = Vector2(aspectRatio, 1.0);
     }
 
-    Camera(Point2t<int64_t> resolution, Point3 location, Vector3 direction, double roll, double focalLength, int64_t samplesPerPixel) :
+    Camera(Point2t<int64_t> resolution, Point3 location, Vector3 direction, double roll, double focalLength, int64_t samplesPerPixel,
+            int64_t tileSize = 16, threading::ProblemSpace::Ordering tileOrder = threading::ProblemSpace::Ordering::eHilbert,
+            sampling::Sampler::Type samplerType = sampling::Sampler::Type::eSobol) :
         m_location(location),
         m_direction(normalize(direction)),
         m_up({0.0, 1.0, 0.0}),
         m_focalLength(focalLength),
         m_resolutionX(resolution.x()),
         m_resolutionY(resolution.y()),
-        m_antiAliasingAmount(samplesPerPixel) {
+        m_antiAliasingAmount(samplesPerPixel),
+        m_tileSize(tileSize),
+        m_tileOrder(tileOrder),
+        m_samplerType(samplerType),
+        m_adaptiveThreshold(0.0),
+        m_minSamplesPerPixel(16),
+        m_samplesPerPass(0),
+        m_noiseTarget(0.0),
+        m_timeBudget(0.0) {
             (void)roll;
             double aspectRatio = double(m_resolutionX) / double(m_resolutionY);
         m_sensorSize = Vector2(aspectRatio, 1.0);
     }
 
-    template <typename Renderer, typename AntiAliaser = AntiAliaserRandom>
-    threading::TaskHandle render(threading::ThreadPool& pool, Renderer renderer) const
+    size_t resolutionX() const
+    {
+        return m_resolutionX;
+    }
+
+    size_t resolutionY() const
+    {
+        return m_resolutionY;
+    }
+
+    size_t samplesPerPixel() const
+    {
+        return m_antiAliasingAmount;
+    }
+
+    void setSamplesPerPixel(size_t samplesPerPixel)
+    {
+        m_antiAliasingAmount = samplesPerPixel;
+    }
+
+    sampling::Sampler::Type samplerType() const
+    {
+        return m_samplerType;
+    }
+
+    void setSamplerType(sampling::Sampler::Type samplerType)
+    {
+        m_samplerType = samplerType;
+    }
+
+    double adaptiveThreshold() const
+    {
+        return m_adaptiveThreshold;
+    }
+
+    // With a threshold above zero, pixels are sampled in batches of minSamplesPerPixel and retired as soon as the
+    // 95% confidence interval of their luminance is within that fraction of its mean. samplesPerPixel() remains the
+    // most any pixel takes. A threshold of zero samples every pixel fully.
+    void setAdaptiveSampling(double threshold, size_t minSamplesPerPixel)
+    {
+        m_adaptiveThreshold = threshold;
+        m_minSamplesPerPixel = minSamplesPerPixel;
+    }
+
+    size_t samplesPerPass() const
+    {
+        return m_samplesPerPass;
+    }
+
+    double noiseTarget() const
+    {
+        return m_noiseTarget;
+    }
+
+    double timeBudget() const
+    {
+        return m_timeBudget;
+    }
+
+    // Number of passes a progressive render takes to reach samplesPerPixel(), or one otherwise
+    size_t passCount() const
+    {
+        if (m_samplesPerPass == 0) {
+            return 1;
+        }
+
+        return std::max<size_t>((m_antiAliasingAmount + m_samplesPerPass - 1) / m_samplesPerPass, 1);
+    }
+
+    // With samplesPerPass above zero the image is rendered progressively: every pass adds that many samples to
+    // each pixel and leaves the image fully resolved, so it can be shown or saved at any time. The render ends
+    // once samplesPerPixel() is reached, once the time budget in seconds has run out, or once the mean relative
+    // error of the pixels drops below the noise target, whichever comes first. Zero disables either limit.
+    void setProgressive(size_t samplesPerPass, double noiseTarget, double timeBudget)
+    {
+        m_samplesPerPass = samplesPerPass;
+        m_noiseTarget = noiseTarget;
+        m_timeBudget = timeBudget;
+    }
+
+    // Renders the image tile by tile. The renderer is called as renderer(ray, sampler) for every camera sample, with
+    // the sampler positioned on that sample and its first two dimensions already spent on the pixel jitter. If
+    // statistics are given, they receive the sample count, mean and variance of every pixel.
+    template <typename Renderer>
+    threading::TaskHandle render(threading::ThreadPool& pool, Renderer renderer,
+            std::shared_ptr<PixelStatistics> statistics = nullptr) const
+    {
+        return renderPackets<1>(pool, [renderer](const CameraPacket<1>& packet, sampling::Sampler& sampler, CameraPacket<1>::Colours& colours) {
+            packet.resumeSample(sampler, 0);
+            colours[0] = renderer(packet.rays.ray(0), sampler);
+        }, statistics);
+    }
+
+    // As render(), with the camera samples handed over in packets of up to Width. The renderer is called as
+    // renderer(packet, sampler, colours) and fills in the colour of each lane in use. Packets are filled in scanline
+    // order over a tile, so their rays are nearly parallel, and are only cut short at the end of each sweep over the
+    // tile; wide packets can take in the samples of many pixels at once.
+    template <std::size_t Width, typename Renderer>
+    threading::TaskHandle renderPackets(threading::ThreadPool& pool, Renderer renderer,
+            std::shared_ptr<PixelStatistics> statistics = nullptr) const
     {
-        AntiAliaser antiAliaser = AntiAliaser(m_antiAliasingAmount);
         auto image = graphics::Image<graphics::ColourRgb<float>>(m_resolutionX, m_resolutionY);
 
         Camera c(*this);
 
+        bool progressive = m_samplesPerPass > 0;
+
+        // Progressive renders need the per pixel sample counts to carry the image over from one pass to the next
+        if (!statistics && (m_adaptiveThreshold > 0.0 || progressive)) {
+            statistics = std::make_shared<PixelStatistics>(m_resolutionX, m_resolutionY);
+        }
+
         //TODO: optimize
 
-        threading::TaskHandle taskHandle = pool.enqueueTask(std::move(image), [=](graphics::Image<graphics::ColourRgb<float>>& result, const threading::Problem& problem, const std::atomic<bool>& cancelled) {
-            (void)cancelled;
+        threading::TileLayout tiles(m_resolutionX, m_resolutionY, m_tileSize, m_tileOrder);
+        threading::PassSettings passes;
+
+        if (progressive) {
+            passes.passCount = passCount();
 
-            size_t x = 0;
-            size_t y = problem[0];
-            auto row = *(result.begin() + y);
+            if (m_timeBudget > 0.0) {
+                passes.deadline = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_timeBudget));
+            }
+
+            if (m_noiseTarget > 0.0) {
+                double noiseTarget = m_noiseTarget;
+                passes.stopCondition = [statistics, noiseTarget](size_t) {
+                    return statistics->noiseEstimate() < noiseTarget;
+                };
+            }
+        }
+
+        threading::TaskHandle taskHandle = pool.enqueueTask(std::move(image), [=](graphics::Image<graphics::ColourRgb<float>>& result, const threading::Problem& problem, const std::atomic<bool>& cancelled) {
+            threading::Tile tile = tiles.tile(problem);
+            RandomGenerator::reseed_for(problem.index(), problem.pass());
+            std::unique_ptr<sampling::Sampler> sampler = sampling::createSampler(c.m_samplerType, c.m_antiAliasingAmount);
 
             Vector2 halfSensor = c.m_sensorSize / 2;
             Vector3 right = cross_product(c.m_direction, c.m_up);
@@ -138,28 +267,117 @@ public:
 
             double recipResX = 1.0 / c.m_resolutionX;
             double recipResY = 1.0 / c.m_resolutionY;
-            double yf = -double(y * 2) * recipResY + 1.0;
 
-            for (auto& pixel : row) {
-                double xf = -double(x * 2) * recipResX + 1.0;
+            size_t maxSamples = std::max<size_t>(c.m_antiAliasingAmount, 1);
+            bool adaptive = statistics && c.m_adaptiveThreshold > 0.0;
 
-                int samples = 0;
+            // Progressive renders take one batch per pass of the task. Otherwise, without adaptive sampling every pixel
+            // takes all of its samples at once.
+            size_t batchSize = maxSamples;
 
-                //Apply anti aliasing by generating vectors with slightly offset directions.
-                for (const auto& aaOffsetVector : antiAliaser) {
-                    double xfaa = (xf + aaOffsetVector.x() * recipResX) * halfSensor.x();
-                    double yfaa = (yf + aaOffsetVector.y() * recipResY) * halfSensor.y();
+            if (progressive) {
+                batchSize = std::min(c.m_samplesPerPass, maxSamples);
+            } else if (adaptive) {
+                batchSize = std::min(std::max<size_t>(c.m_minSamplesPerPixel, 2), maxSamples);
+            }
 
-                    Ray3 ray(c.m_location, geometry::normalize(xfaa * right + yfaa * c.m_up + focalLengthDirection));
+            // Samples taken by each pixel of the tile in the current sweep, and their sum
+            size_t tileArea = tile.width * tile.height;
+            std::vector<size_t> firstSample(tileArea);
+            std::vector<size_t> lastSample(tileArea);
+            std::vector<graphics::ColourRgb<float>> sums(tileArea);
 
-                    pixel += renderer(ray);
-                    samples++;
+            CameraPacket<Width> packet;
+            typename CameraPacket<Width>::Colours colours;
+
+            auto tracePacket = [&]() {
+                if (packet.rays.count == 0) {
+                    return;
                 }
 
-                pixel *= (1.0 / samples);
-                x++;
+                packet.rays.pad();
+                renderer(packet, *sampler, colours);
+
+                for (size_t lane = 0; lane < packet.rays.count; lane++) {
+                    sums[(packet.y[lane] - tile.y) * tile.width + packet.x[lane] - tile.x] += colours[lane];
+
+                    if (statistics) {
+                        statistics->at(packet.x[lane], packet.y[lane]).add(PixelStatistics::luminance(colours[lane]));
+                    }
+                }
+
+                packet.rays.clear();
+            };
+
+            // Each sweep over the tile adds a batch of samples to the pixels that have not converged yet. Pixels hold
+            // the mean of the samples taken so far, which is updated with the sum of every batch.
+            for (bool active = true; active && !cancelled; ) {
+                active = false;
+
+                for (size_t y = tile.y; y < tile.y + tile.height; y++) {
+                    double yf = -double(y * 2) * recipResY + 1.0;
+
+                    for (size_t x = tile.x; x < tile.x + tile.width; x++) {
+                        double xf = -double(x * 2) * recipResX + 1.0;
+                        size_t index = (y - tile.y) * tile.width + x - tile.x;
+
+                        PixelStatistics::Accumulator* pixelStatistics = statistics ? &statistics->at(x, y) : nullptr;
+                        size_t first = pixelStatistics ? pixelStatistics->count : 0;
+
+                        firstSample[index] = first;
+                        lastSample[index] = first;
+                        sums[index] = graphics::ColourRgb<float>(0, 0, 0);
+
+                        if (first >= maxSamples || (adaptive && pixelStatistics->relativeError() < c.m_adaptiveThreshold)) {
+                            continue;
+                        }
+
+                        lastSample[index] = std::min(first + batchSize, maxSamples);
+
+                        //Apply anti aliasing by jittering the ray across the pixel
+                        for (size_t i = first; i < lastSample[index]; i++) {
+                            sampler->startSample(x, y, i);
+                            Point2 jitter = sampler->next2D();
+
+                            double xfaa = (xf + (jitter.x() * 2 - 1) * recipResX) * halfSensor.x();
+                            double yfaa = (yf + (jitter.y() * 2 - 1) * recipResY) * halfSensor.y();
+
+                            packet.x[packet.rays.count] = x;
+                            packet.y[packet.rays.count] = y;
+                            packet.sampleIndex[packet.rays.count] = i;
+                            packet.dimension = std::uint32_t(sampler->dimension());
+                            packet.rays.push(Ray3(c.m_location, geometry::normalize(xfaa * right + yfaa * c.m_up + focalLengthDirection)));
+
+                            if (packet.rays.full()) {
+                                tracePacket();
+                            }
+                        }
+                    }
+                }
+
+                tracePacket();
+
+                for (size_t y = tile.y; y < tile.y + tile.height; y++) {
+                    auto pixel = (*(result.begin() + y)).begin() + tile.x;
+
+                    for (size_t index = (y - tile.y) * tile.width; index < (y - tile.y + 1) * tile.width; index++, pixel++) {
+                        size_t first = firstSample[index];
+                        size_t last = lastSample[index];
+
+                        if (last == first) {
+                            continue;
+                        }
+
+                        *pixel = (*pixel * float(first) + sums[index]) * (1.0f / float(last));
+
+                        RenderStatistics::countSamples(last - first);
+                        active = active || (adaptive && !progressive && last < maxSamples);
+                    }
+                }
             }
-        }, threading::ProblemSpace(c.m_resolutionY));
+
+            RenderStatistics::flush();
+        }, tiles, passes);
 
         return taskHandle;
     }
@@ -0,0 +1,541 @@
+#ifndef COMPILED_SCENE_HPP
+#define COMPILED_SCENE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <acceleration/BoundingVolumeHierarchy.hpp>
+#include <geometry/Point.hpp>
+#include <geometry/Ray.hpp>
+#include <geometry/RayPacket.hpp>
+#include <geometry/Vector.hpp>
+#include <shapes/Shape.hpp>
+#include <Surface.hpp>
+
+// The geometry of a scene flattened for intersection. Shapes of the common types copy what their intersection test
+// needs into one structure-of-arrays per type through Shape::compile(), so that testing them takes neither a virtual
+// call nor a trip through the shape object. Other shapes are still tested through their virtual interface. Surfaces
+// are gathered into a dense material table, and every hit reports the index of its surface in that table. Shapes
+// with a surface per primitive take a block of the table, and their hits report an index into that block.
+//
+// The arrays of each type are in the leaf order of the bounding volume hierarchy, so the primitives of a leaf sit
+// next to each other in memory.
+class CompiledScene
+{
+public:
+    using IntersectionResult = shapes::Shape::IntersectionResult;
+
+    CompiledScene() :
+        m_spheres(),
+        m_rectangles(),
+        m_planes(),
+        m_shapes(),
+        m_bounded(),
+        m_unbounded(),
+        m_hierarchy(),
+        m_materials(),
+        m_materialIds()
+    {
+
+    }
+
+    explicit CompiledScene(const std::vector<std::shared_ptr<shapes::Shape>>& geometry) :
+        m_spheres(),
+        m_rectangles(),
+        m_planes(),
+        m_shapes(),
+        m_bounded(),
+        m_unbounded(),
+        m_hierarchy(),
+        m_materials(),
+        m_materialIds()
+    {
+        std::vector<const shapes::Shape*> bounded;
+        std::vector<geometry::BoundingBox3> bounds;
+
+        for (const auto& shape : geometry)
+        {
+            geometry::BoundingBox3 box = shape->boundingBox();
+
+            if (box.isBounded())
+            {
+                bounded.push_back(shape.get());
+                bounds.push_back(box);
+            }
+            else
+            {
+                m_unbounded.push_back(add(*shape));
+            }
+        }
+
+        m_hierarchy = acceleration::BoundingVolumeHierarchy(bounds);
+        m_bounded.resize(bounded.size());
+
+        for (std::uint32_t index : m_hierarchy.primitiveIndices())
+        {
+            m_bounded[index] = add(*bounded[index]);
+        }
+    }
+
+    // Surfaces of all the shapes, indexed by IntersectionResult::material()
+    const std::vector<Surface>& materials() const
+    {
+        return m_materials;
+    }
+
+    // Called by Shape::compile(), with the data of the shape's intersection test
+    void addSphere(const shapes::Shape& shape, const geometry::Point3& centre, double radiusSquared, double recipRadius)
+    {
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            m_spheres.centre[axis].push_back(centre[axis]);
+        }
+
+        m_spheres.radiusSquared.push_back(radiusSquared);
+        m_spheres.recipRadius.push_back(recipRadius);
+        m_added = m_spheres.add(shape, m_material, eSphere);
+    }
+
+    void addRectangle(const shapes::Shape& shape, const geometry::Point3& corner, const geometry::Vector3& normal,
+            const geometry::Vector3& side0, const geometry::Vector3& side1, float side0Side1, float side1Side1,
+            float side0Side0, float recipDenominator)
+    {
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            m_rectangles.corner[axis].push_back(corner[axis]);
+            m_rectangles.normal[axis].push_back(normal[axis]);
+            m_rectangles.side0[axis].push_back(side0[axis]);
+            m_rectangles.side1[axis].push_back(side1[axis]);
+        }
+
+        m_rectangles.side0Side1.push_back(side0Side1);
+        m_rectangles.side1Side1.push_back(side1Side1);
+        m_rectangles.side0Side0.push_back(side0Side0);
+        m_rectangles.recipDenominator.push_back(recipDenominator);
+        m_added = m_rectangles.add(shape, m_material, eRectangle);
+    }
+
+    void addPlane(const shapes::Shape& shape, const geometry::Point3& origin, const geometry::Vector3& normal)
+    {
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            m_planes.origin[axis].push_back(origin[axis]);
+            m_planes.normal[axis].push_back(normal[axis]);
+        }
+
+        m_added = m_planes.add(shape, m_material, ePlane);
+    }
+
+    // Nearest intersection further along the ray than minDistance
+    IntersectionResult nearestIntersection(const geometry::Ray3& ray, double minDistance) const
+    {
+        IntersectionResult nearest;
+        double maxDistance = nearest.distance();
+
+        auto intersect = [&](std::uint32_t handle, double& distanceLimit) {
+            IntersectionResult intersection = intersectPrimitive(handle, ray);
+
+            if (intersection.distance() < distanceLimit && intersection.distance() > minDistance)
+            {
+                nearest = intersection;
+                distanceLimit = intersection.distance();
+            }
+        };
+
+        for (std::uint32_t handle : m_unbounded)
+        {
+            intersect(handle, maxDistance);
+        }
+
+        m_hierarchy.intersect(ray, minDistance, maxDistance, [&](std::uint32_t index, double& distanceLimit) {
+            intersect(m_bounded[index], distanceLimit);
+        });
+
+        return nearest;
+    }
+
+    // Nearest intersections of all the rays of a packet, as nearestIntersection() would find them one by one. The
+    // primitives are tested with the packet kernels of their shapes.
+    void nearestIntersection(const geometry::RayPacket3& packet, double minDistance, shapes::Shape::PacketResults& nearest) const
+    {
+        constexpr std::size_t width = geometry::RayPacket3::width();
+        std::array<double, width> maxDistances;
+        shapes::Shape::PacketResults results;
+
+        for (std::size_t lane = 0; lane < width; lane++)
+        {
+            nearest[lane] = IntersectionResult();
+            maxDistances[lane] = nearest[lane].distance();
+        }
+
+        auto intersect = [&](std::uint32_t handle, const geometry::PacketMask3& active, std::array<double, width>& distanceLimits) {
+            const PrimitiveArrays& primitives = arrays(handle);
+            std::uint32_t index = handle & sm_indexMask;
+
+            primitives.shapes[index]->calculatePacketIntersection(packet, active, results);
+
+            for (std::size_t lane = 0; lane < packet.count; lane++)
+            {
+                if (active[lane] && results[lane].distance() < distanceLimits[lane] && results[lane].distance() > minDistance)
+                {
+                    nearest[lane] = results[lane];
+                    nearest[lane].setMaterial(primitives.materials[index] + results[lane].material());
+                    distanceLimits[lane] = results[lane].distance();
+                }
+            }
+        };
+
+        geometry::PacketMask3 all;
+        all.fill(true);
+
+        for (std::uint32_t handle : m_unbounded)
+        {
+            intersect(handle, all, maxDistances);
+        }
+
+        m_hierarchy.intersect(packet, minDistance, maxDistances, [&](std::uint32_t index, const geometry::PacketMask3& active,
+                std::array<double, width>& distanceLimits) {
+            intersect(m_bounded[index], active, distanceLimits);
+        });
+    }
+
+    // True if anything blocks the ray between minDistance and maxDistance
+    bool isOccluded(const geometry::Ray3& ray, double minDistance, double maxDistance) const
+    {
+        for (std::uint32_t handle : m_unbounded)
+        {
+            if (occludes(handle, ray, minDistance, maxDistance))
+            {
+                return true;
+            }
+        }
+
+        return m_hierarchy.intersectsAny(ray, minDistance, maxDistance, [&](std::uint32_t index, double) {
+            return occludes(m_bounded[index], ray, minDistance, maxDistance);
+        });
+    }
+
+private:
+    // Primitives are referred to by handles holding their type in the top bits and their index in the arrays of
+    // that type below
+    enum PrimitiveType : std::uint32_t
+    {
+        eSphere,
+        eRectangle,
+        ePlane,
+        eShape          // Any other shape, tested through its virtual interface
+    };
+
+    static constexpr std::uint32_t sm_typeShift = 30;
+    static constexpr std::uint32_t sm_indexMask = (1u << sm_typeShift) - 1;
+
+    // The shape and material of every primitive of a type, only read once it has been hit
+    struct PrimitiveArrays
+    {
+        std::vector<const shapes::Shape*> shapes;
+        std::vector<std::uint32_t> materials;
+
+        PrimitiveArrays() :
+            shapes(),
+            materials()
+        {
+
+        }
+
+        std::uint32_t add(const shapes::Shape& shape, std::uint32_t material, PrimitiveType type)
+        {
+            shapes.push_back(&shape);
+            materials.push_back(material);
+            return (std::uint32_t(type) << sm_typeShift) | std::uint32_t(shapes.size() - 1);
+        }
+    };
+
+    struct SphereArrays : public PrimitiveArrays
+    {
+        std::array<std::vector<geometry::geo_type>, 3> centre;
+        std::vector<double> radiusSquared;
+        std::vector<double> recipRadius;
+
+        SphereArrays() :
+            centre(),
+            radiusSquared(),
+            recipRadius()
+        {
+
+        }
+    };
+
+    // Corner and normal of each rectangle, its two sides from the corner and the terms of the barycentric test
+    struct RectangleArrays : public PrimitiveArrays
+    {
+        std::array<std::vector<geometry::geo_type>, 3> corner;
+        std::array<std::vector<geometry::geo_type>, 3> normal;
+        std::array<std::vector<geometry::geo_type>, 3> side0;
+        std::array<std::vector<geometry::geo_type>, 3> side1;
+        std::vector<float> side0Side1;
+        std::vector<float> side1Side1;
+        std::vector<float> side0Side0;
+        std::vector<float> recipDenominator;
+
+        RectangleArrays() :
+            corner(),
+            normal(),
+            side0(),
+            side1(),
+            side0Side1(),
+            side1Side1(),
+            side0Side0(),
+            recipDenominator()
+        {
+
+        }
+    };
+
+    struct PlaneArrays : public PrimitiveArrays
+    {
+        std::array<std::vector<geometry::geo_type>, 3> origin;
+        std::array<std::vector<geometry::geo_type>, 3> normal;
+
+        PlaneArrays() :
+            origin(),
+            normal()
+        {
+
+        }
+    };
+
+    std::uint32_t add(const shapes::Shape& shape)
+    {
+        if (shape.surfaceCount() > 1)
+        {
+            // The shape's hits pick among its surfaces, so they take a block of the table of their own
+            m_material = std::uint32_t(m_materials.size());
+
+            for (std::size_t i = 0; i < shape.surfaceCount(); i++)
+            {
+                m_materials.push_back(shape.surface(i));
+            }
+        }
+        else
+        {
+            auto material = m_materialIds.find(&shape.surface());
+
+            if (material == m_materialIds.end())
+            {
+                material = m_materialIds.emplace(&shape.surface(), std::uint32_t(m_materials.size())).first;
+                m_materials.push_back(shape.surface());
+            }
+
+            m_material = material->second;
+        }
+
+        if (!shape.compile(*this))
+        {
+            m_added = m_shapes.add(shape, m_material, eShape);
+        }
+
+        return m_added;
+    }
+
+    const PrimitiveArrays& arrays(std::uint32_t handle) const
+    {
+        switch (handle >> sm_typeShift)
+        {
+            case eSphere:
+                return m_spheres;
+            case eRectangle:
+                return m_rectangles;
+            case ePlane:
+                return m_planes;
+            default:
+                return m_shapes;
+        }
+    }
+
+    // The tests below repeat the arithmetic of Sphere, Rectangle and Plane exactly, so that the compiled scene finds
+    // the same hits as the shapes themselves
+
+    double sphereDistance(std::uint32_t i, const geometry::Ray3& ray, double& p2) const
+    {
+        using geometry::geo_type;
+
+        geo_type x = m_spheres.centre[0][i] - ray.origin()[0];
+        geo_type y = m_spheres.centre[1][i] - ray.origin()[1];
+        geo_type z = m_spheres.centre[2][i] - ray.origin()[2];
+
+        double projectedCentre = x * ray.direction()[0] + y * ray.direction()[1] + z * ray.direction()[2];
+        double discriminant = m_spheres.radiusSquared[i] - ((x * x + y * y + z * z) - projectedCentre * projectedCentre);
+
+        if (discriminant < 0)
+        {
+            p2 = std::numeric_limits<double>::quiet_NaN();
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        double squareRootDiscriminant = std::sqrt(discriminant);
+        p2 = projectedCentre + squareRootDiscriminant;
+
+        return projectedCentre - squareRootDiscriminant;
+    }
+
+    // Distance to the rectangle's plane, and whether the ray meets the plane inside the rectangle
+    double rectangleDistance(std::uint32_t i, const geometry::Ray3& ray) const
+    {
+        using geometry::geo_type;
+        const RectangleArrays& r = m_rectangles;
+
+        geo_type numerator = r.normal[0][i] * (r.corner[0][i] - ray.origin()[0]) + r.normal[1][i] * (r.corner[1][i] - ray.origin()[1]) +
+                r.normal[2][i] * (r.corner[2][i] - ray.origin()[2]);
+
+        return numerator / (r.normal[0][i] * ray.direction()[0] + r.normal[1][i] * ray.direction()[1] + r.normal[2][i] * ray.direction()[2]);
+    }
+
+    // On success u and v are the coordinates of the hit along side0 and side1
+    bool rectangleContains(std::uint32_t i, const geometry::Ray3& ray, double distance, float& u, float& v) const
+    {
+        using geometry::geo_type;
+        const RectangleArrays& r = m_rectangles;
+
+        geo_type t = geo_type(distance);
+        geo_type x = (ray.origin()[0] + t * ray.direction()[0]) - r.corner[0][i];
+        geo_type y = (ray.origin()[1] + t * ray.direction()[1]) - r.corner[1][i];
+        geo_type z = (ray.origin()[2] + t * ray.direction()[2]) - r.corner[2][i];
+
+        double v2v0 = x * r.side0[0][i] + y * r.side0[1][i] + z * r.side0[2][i];
+        double v2v1 = x * r.side1[0][i] + y * r.side1[1][i] + z * r.side1[2][i];
+
+        u = (r.side1Side1[i] * v2v0 - r.side0Side1[i] * v2v1) * r.recipDenominator[i];
+
+        if (u >= 0 && u <= 1)
+        {
+            v = (r.side0Side0[i] * v2v1 - r.side0Side1[i] * v2v0) * r.recipDenominator[i];
+            return v >= 0 && v <= 1;
+        }
+
+        return false;
+    }
+
+    geometry::Vector3 sphereNormal(std::uint32_t i, const geometry::Ray3& ray, double distance) const
+    {
+        geometry::Vector3 newOrigin(m_spheres.centre[0][i] - ray.origin()[0], m_spheres.centre[1][i] - ray.origin()[1],
+                m_spheres.centre[2][i] - ray.origin()[2]);
+
+        return (distance * ray.direction() - newOrigin) * m_spheres.recipRadius[i];
+    }
+
+    double planeDistance(std::uint32_t i, const geometry::Ray3& ray) const
+    {
+        using geometry::geo_type;
+        const PlaneArrays& p = m_planes;
+
+        geo_type numerator = p.normal[0][i] * (p.origin[0][i] - ray.origin()[0]) + p.normal[1][i] * (p.origin[1][i] - ray.origin()[1]) +
+                p.normal[2][i] * (p.origin[2][i] - ray.origin()[2]);
+
+        return numerator / (p.normal[0][i] * ray.direction()[0] + p.normal[1][i] * ray.direction()[1] + p.normal[2][i] * ray.direction()[2]);
+    }
+
+    IntersectionResult intersectPrimitive(std::uint32_t handle, const geometry::Ray3& ray) const
+    {
+        std::uint32_t i = handle & sm_indexMask;
+
+        switch (handle >> sm_typeShift)
+        {
+            case eSphere:
+            {
+                double p2;
+                double p1 = sphereDistance(i, ray, p2);
+
+                double distance = p1 > 0 ? p1 : p2;
+
+                if (distance > 0)
+                {
+                    IntersectionResult result(distance, m_spheres.shapes[i], sphereNormal(i, ray, distance));
+                    result.setMaterial(m_spheres.materials[i]);
+                    return result;
+                }
+
+                return IntersectionResult();
+            }
+            case eRectangle:
+            {
+                const RectangleArrays& r = m_rectangles;
+                double distance = rectangleDistance(i, ray);
+                float u, v;
+
+                if (rectangleContains(i, ray, distance, u, v))
+                {
+                    IntersectionResult result(distance, r.shapes[i], geometry::Vector3(r.normal[0][i], r.normal[1][i], r.normal[2][i]), u, v);
+                    result.setMaterial(r.materials[i]);
+                    return result;
+                }
+
+                return IntersectionResult();
+            }
+            case ePlane:
+            {
+                const PlaneArrays& p = m_planes;
+                IntersectionResult result(planeDistance(i, ray), p.shapes[i], geometry::Vector3(p.normal[0][i], p.normal[1][i], p.normal[2][i]));
+                result.setMaterial(p.materials[i]);
+                return result;
+            }
+            default:
+            {
+                IntersectionResult result = m_shapes.shapes[i]->calculateRayIntersection(ray);
+                result.setMaterial(m_shapes.materials[i] + result.material());
+                return result;
+            }
+        }
+    }
+
+    bool occludes(std::uint32_t handle, const geometry::Ray3& ray, double minDistance, double maxDistance) const
+    {
+        std::uint32_t i = handle & sm_indexMask;
+
+        switch (handle >> sm_typeShift)
+        {
+            case eSphere:
+            {
+                double p2;
+                double p1 = sphereDistance(i, ray, p2);
+
+                return (p1 > minDistance && p1 < maxDistance) || (p2 > minDistance && p2 < maxDistance);
+            }
+            case eRectangle:
+            {
+                double distance = rectangleDistance(i, ray);
+                float u, v;
+                return distance > minDistance && distance < maxDistance && rectangleContains(i, ray, distance, u, v);
+            }
+            case ePlane:
+            {
+                double distance = planeDistance(i, ray);
+                return distance > minDistance && distance < maxDistance;
+            }
+            default:
+                return m_shapes.shapes[i]->intersectsWithin(ray, minDistance, maxDistance);
+        }
+    }
+
+    SphereArrays m_spheres;
+    RectangleArrays m_rectangles;
+    PlaneArrays m_planes;
+    PrimitiveArrays m_shapes;
+
+    std::vector<std::uint32_t> m_bounded;       // Handles of the hierarchy's primitives, by primitive index
+    std::vector<std::uint32_t> m_unbounded;
+    acceleration::BoundingVolumeHierarchy m_hierarchy;
+
+    std::vector<Surface> m_materials;
+    std::map<const Surface*, std::uint32_t> m_materialIds;
+
+    // Material of the shape being added, and the handle its compile() produced
+    std::uint32_t m_material = 0;
+    std::uint32_t m_added = 0;
+};
+
+#endif
@@ -163,4 +163,47 @@ public:
     }
 };
 
+class InvalidParameterValueException : public BuilderException
+{
+public:
+    InvalidParameterValueException(const std::string& paramName, const std::string& value)
+    {
+        message() << "Invalid value '" << value << "' for parameter '" << paramName << "'.";
+    }
+};
+
+class MeshLoadException : public BuilderException
+{
+public:
+    MeshLoadException(const std::string& location, const std::string& reason) :
+        m_location(location),
+        m_reason(reason)
+    {
+        message() << "Cannot load mesh (" << location << "): " << reason << ".";
+    }
+
+    const std::string& location() const
+    {
+        return m_location;
+    }
+
+    const std::string& reason() const
+    {
+        return m_reason;
+    }
+
+private:
+    std::string m_location;
+    std::string m_reason;
+};
+
+class SphereSetLoadException : public BuilderException
+{
+public:
+    SphereSetLoadException(const std::string& filename, const std::string& reason)
+    {
+        message() << "Cannot load sphere set (" << filename << "): " << reason << ".";
+    }
+};
+
 #endif
@@ -2,6 +2,8 @@
 #define INTERSECTION_INFO_HPP
 
 #include <cassert>
+#include <cstdint>
+#include <vector>
 
 #include <geometry/Point.hpp>
 #include <geometry/Vector.hpp>
@@ -11,13 +13,17 @@
 class IntersectionInfo
 {
 public:
-    IntersectionInfo(const geometry::Ray3& ray, const shapes::Shape::IntersectionResult& result) :
+    // The surface is looked up by the result's material in the given table, as kept by the scene that found it
+    IntersectionInfo(const geometry::Ray3& ray, const shapes::Shape::IntersectionResult& result, const std::vector<Surface>& materials) :
         m_shape(result.shape()),
-        m_distance(result.distance())
+        m_surface(m_shape ? &materials[result.material()] : nullptr),
+        m_primitive(result.primitive()),
+        m_distance(result.distance()),
+        m_uv(result.uv())
     {
         if (m_shape)
         {
-            calculate(ray);
+            calculate(ray, result.normal());
         }
     }
 
@@ -51,10 +57,27 @@ public:
         return m_normal;
     }
 
-    const Surface& surface() const
+    // Parametric coordinates of the hit, as reported by the shape's intersection test
+    const geometry::Point2& uv() const
+    {
+        return m_uv;
+    }
+
+    std::uint32_t primitive() const
+    {
+        return m_primitive;
+    }
+
+    const shapes::Shape& shape() const
     {
         assert(m_shape);
-        return m_shape->surface();
+        return *m_shape;
+    }
+
+    const Surface& surface() const
+    {
+        assert(m_surface);
+        return *m_surface;
     }
 
     double cosAngleOfIncidence() const
@@ -63,10 +86,10 @@ public:
     }
 
 private:
-    void calculate(const geometry::Ray3& ray)
+    void calculate(const geometry::Ray3& ray, const geometry::Vector3& normal)
     {
         m_location = ray.origin() + ray.direction() * m_distance;
-        m_normal = m_shape->calculateNormal(m_location);
+        m_normal = normal;
         m_cosAngleOfIncidence = m_normal * ray.direction();
         m_enteringSurface = m_cosAngleOfIncidence < 0.0;
 
@@ -83,7 +106,10 @@ private:
     }
 
     const shapes::Shape* m_shape;
+    const Surface* m_surface;
+    std::uint32_t m_primitive;
     double m_distance;
+    geometry::Point2 m_uv;
     geometry::Point3 m_location;
     geometry::Vector3 m_normal;
     double m_cosAngleOfIncidence;
@@ -0,0 +1,141 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP 1
+#endif
+
+// Read only view of a whole file. On POSIX systems the file is memory mapped, so nothing is read until the pages
+// are touched and the pages are shared with the page cache; elsewhere the file is read into memory.
+class MappedFile
+{
+public:
+    // Size and modification time, cheap to query and enough to notice that a file has been replaced. The
+    // modification time is zero where it is not available.
+    struct Stamp
+    {
+        std::uint64_t size = 0;
+        std::int64_t modified = 0;
+
+        bool operator==(const Stamp& other) const
+        {
+            return size == other.size && modified == other.modified;
+        }
+    };
+
+    explicit MappedFile(const std::string& filename) :
+        m_data(nullptr),
+        m_size(0)
+    {
+#ifdef MAPPED_FILE_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            return;
+        }
+
+        struct stat info;
+
+        if (::fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void* data = ::mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+            if (data != MAP_FAILED)
+            {
+                m_data = static_cast<const unsigned char*>(data);
+                m_size = std::size_t(info.st_size);
+            }
+        }
+
+        ::close(fd);
+#else
+        std::ifstream file(filename, std::ios::binary);
+
+        if (file.is_open())
+        {
+            m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            m_data = reinterpret_cast<const unsigned char*>(m_buffer.data());
+            m_size = m_buffer.size();
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+#ifdef MAPPED_FILE_MMAP
+        if (m_data)
+        {
+            ::munmap(const_cast<unsigned char*>(m_data), m_size);
+        }
+#endif
+    }
+
+    // False if the file could not be opened, or is empty
+    bool isOpen() const
+    {
+        return m_data != nullptr;
+    }
+
+    const unsigned char* data() const
+    {
+        return m_data;
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    // Stamp of the file, or an all zero stamp if it cannot be queried
+    static Stamp stamp(const std::string& filename)
+    {
+        Stamp result;
+
+#ifdef MAPPED_FILE_MMAP
+        struct stat info;
+
+        if (::stat(filename.c_str(), &info) == 0)
+        {
+            result.size = std::uint64_t(info.st_size);
+#if defined(__linux__)
+            result.modified = std::int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#else
+            result.modified = std::int64_t(info.st_mtime);
+#endif
+        }
+#else
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+
+        if (file.is_open())
+        {
+            result.size = std::uint64_t(file.tellg());
+        }
+#endif
+
+        return result;
+    }
+
+private:
+    const unsigned char* m_data;
+    std::size_t m_size;
+
+#ifndef MAPPED_FILE_MMAP
+    std::vector<char> m_buffer;
+#endif
+};
+
+#endif
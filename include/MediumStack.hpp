@@ -0,0 +1,65 @@
+#ifndef MEDIUM_STACK_HPP
+#define MEDIUM_STACK_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Refractive indices of the media a path is nested in, innermost last. The capacity is fixed so that paths can be
+// copied and branched without touching the heap. Nesting deeper than the capacity only counts the extra levels, so
+// that the matching exits still line up; the innermost stored medium stands in for the ones that did not fit.
+class MediumStack
+{
+public:
+    static constexpr std::size_t sm_capacity = 8;
+
+    explicit MediumStack(float outerRefractiveIndex = 1.0f) :
+        m_refractiveIndices(),
+        m_size(1),
+        m_overflow(0)
+    {
+        m_refractiveIndices[0] = outerRefractiveIndex;
+    }
+
+    float top() const
+    {
+        return m_refractiveIndices[m_size - 1];
+    }
+
+    std::size_t depth() const
+    {
+        return m_size + m_overflow;
+    }
+
+    void push(float refractiveIndex)
+    {
+        if (m_size < sm_capacity)
+        {
+            m_refractiveIndices[m_size++] = refractiveIndex;
+        }
+        else
+        {
+            m_overflow++;
+        }
+    }
+
+    // The outermost medium is never popped, so exiting a surface that was never entered leaves the path in it
+    void pop()
+    {
+        if (m_overflow > 0)
+        {
+            m_overflow--;
+        }
+        else if (m_size > 1)
+        {
+            m_size--;
+        }
+    }
+
+private:
+    std::array<float, sm_capacity> m_refractiveIndices;
+    std::uint16_t m_size;
+    std::uint16_t m_overflow;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef PIXEL_STATISTICS_HPP
+#define PIXEL_STATISTICS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <graphics/Colour.hpp>
+#include <graphics/Image.hpp>
+
+// Running statistics of the samples taken in every pixel of a render, used to stop sampling pixels that have
+// converged. Each pixel is only ever touched by the tile that contains it, so no synchronisation is needed.
+class PixelStatistics
+{
+public:
+    // Welford's online mean and variance of the sample luminance
+    struct Accumulator
+    {
+        std::uint32_t count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+
+        void add(double value)
+        {
+            count++;
+            double delta = value - mean;
+            mean += delta / count;
+            m2 += delta * (value - mean);
+        }
+
+        double variance() const
+        {
+            return count > 1 ? m2 / (count - 1) : 0.0;
+        }
+
+        // Half width of the 95% confidence interval of the mean, relative to the mean. Dark pixels are measured
+        // against a small floor instead, so that they are not sampled forever chasing an invisible error.
+        double relativeError() const
+        {
+            if (count < 2)
+            {
+                return std::numeric_limits<double>::infinity();
+            }
+
+            return sm_confidence * std::sqrt(variance() / count) / std::max(mean, double(sm_darkFloor));
+        }
+    };
+
+    PixelStatistics(std::size_t width, std::size_t height) :
+        m_width(width),
+        m_height(height),
+        m_pixels(width * height)
+    { }
+
+    std::size_t width() const { return m_width; }
+    std::size_t height() const { return m_height; }
+
+    Accumulator& at(std::size_t x, std::size_t y)
+    {
+        return m_pixels[y * m_width + x];
+    }
+
+    const Accumulator& at(std::size_t x, std::size_t y) const
+    {
+        return m_pixels[y * m_width + x];
+    }
+
+    static double luminance(const graphics::ColourRgb<float>& colour)
+    {
+        return 0.2126 * colour.red() + 0.7152 * colour.green() + 0.0722 * colour.blue();
+    }
+
+    // Mean relative error over the whole image, used to stop progressive renders once they are clean enough.
+    // Infinite until every pixel has at least two samples.
+    double noiseEstimate() const
+    {
+        double sum = 0.0;
+
+        for (const Accumulator& pixel : m_pixels)
+        {
+            sum += pixel.relativeError();
+        }
+
+        return m_pixels.empty() ? 0.0 : sum / m_pixels.size();
+    }
+
+    // Samples taken per pixel, scaled against maxSamples from black through red and yellow to white
+    graphics::Image<graphics::ColourRgb<float>> heatmap(std::size_t maxSamples) const
+    {
+        graphics::Image<graphics::ColourRgb<float>> image(m_width, m_height);
+        double scale = 3.0 / std::max<std::size_t>(maxSamples, 1);
+
+        for (std::size_t y = 0; y < m_height; y++)
+        {
+            graphics::ColourRgb<float>* row = image.data() + y * image.stride();
+
+            for (std::size_t x = 0; x < m_width; x++)
+            {
+                double t = at(x, y).count * scale;
+                row[x] = graphics::ColourRgb<float>(std::min(t, 1.0), std::min(std::max(t - 1.0, 0.0), 1.0),
+                        std::min(std::max(t - 2.0, 0.0), 1.0));
+            }
+        }
+
+        return image;
+    }
+
+private:
+    static constexpr double sm_confidence = 1.96;
+    static constexpr double sm_darkFloor = 0.01;
+
+    std::size_t m_width;
+    std::size_t m_height;
+    std::vector<Accumulator> m_pixels;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef RANDOM_GENERATOR_HPP
 #define RANDOM_GENERATOR_HPP
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <random>
 
 class RandomGenerator
@@ -15,6 +18,45 @@ public:
 
         return randgen;
     }
+
+    // Fixes the seed used by reseed_for(). Until this is called generators stay seeded from std::random_device.
+    // The calling thread's generator is reseeded too, on a stream of its own, since it also draws random numbers
+    // (e.g. for dithering when saving images).
+    static void seed(std::uint64_t value)
+    {
+        seed_value() = value;
+        seeded() = true;
+        reseed_for(std::numeric_limits<std::uint64_t>::max());
+    }
+
+    // Reseeds the calling thread's generator from the global seed and the index of the work item about to run, so
+    // that seeded renders are reproducible regardless of how work is distributed between threads. Work items run
+    // once per pass of a progressive render also give the pass, so that each pass draws new numbers.
+    static void reseed_for(std::uint64_t workIndex, std::uint64_t pass = 0)
+    {
+        if (!seeded())
+        {
+            return;
+        }
+
+        std::uint64_t value = seed_value();
+        std::seed_seq sequence{std::uint32_t(value), std::uint32_t(value >> 32), std::uint32_t(workIndex), std::uint32_t(workIndex >> 32),
+                std::uint32_t(pass), std::uint32_t(pass >> 32)};
+        get_instance().seed(sequence);
+    }
+
+private:
+    static std::atomic<std::uint64_t>& seed_value()
+    {
+        static std::atomic<std::uint64_t> value(0);
+        return value;
+    }
+
+    static std::atomic<bool>& seeded()
+    {
+        static std::atomic<bool> value(false);
+        return value;
+    }
 };
 
 #endif
@@ -1,14 +1,52 @@
 #ifndef RAYTRACER_HPP
 #define RAYTRACER_HPP
 
+#include <cstddef>
 #include <memory>
 
+#include <geometry/Ray.hpp>
+#include <geometry/RayPacket.hpp>
 #include <graphics/Colour.hpp>
 #include <threading/ThreadPool.hpp>
+#include <Camera.hpp>
 
 
+class PixelStatistics;
 class Scene;
 
-threading::TaskHandle render(threading::ThreadPool& pool, const std::shared_ptr<Scene>& scene);
+namespace sampling
+{
+    class Sampler;
+}
+
+// Traces a single camera sample through the scene, taking every random decision from the sampler, which must
+// already be positioned on the sample. Does not allocate.
+graphics::ColourRgb<float> tracePath(const geometry::Ray3& ray, const Scene& scene, sampling::Sampler& sampler);
+
+// As above with independent random numbers
+graphics::ColourRgb<float> tracePath(const geometry::Ray3& ray, const Scene& scene);
+
+// Traces the camera samples of a packet, finding the first hits of their rays together before following each path
+// on its own with tracePath()
+void tracePacket(const CameraPacket<geometry::packetWidth()>& packet, const Scene& scene, sampling::Sampler& sampler,
+        CameraPacket<geometry::packetWidth()>::Colours& colours);
+
+// Camera samples traced together by the wavefront integrator
+constexpr std::size_t wavefrontWidth()
+{
+    return 1024;
+}
+
+// Wavefront integrator: traces the camera samples of a packet breadth first, one bounce of all of their paths at a
+// time. Each bounce intersects every path, sorts the hits by the kind of surface they landed on, shades them one kind
+// after another and finally traces the shadow rays of the bounce, so that each stage runs the same code over many
+// rays in a row. The result has the same expectation as tracePath(), but each sample draws its random numbers in a
+// different order.
+void traceWavefront(const CameraPacket<wavefrontWidth()>& packet, const Scene& scene, sampling::Sampler& sampler,
+        CameraPacket<wavefrontWidth()>::Colours& colours);
+
+// Renders the scene's camera view. Per pixel sample counts and variances go to statistics when given.
+threading::TaskHandle render(threading::ThreadPool& pool, const std::shared_ptr<Scene>& scene,
+        const std::shared_ptr<PixelStatistics>& statistics = nullptr);
 
 #endif
@@ -0,0 +1,45 @@
+#ifndef RENDER_SETTINGS_HPP
+#define RENDER_SETTINGS_HPP
+
+// Integrator options that are independent of the camera
+struct RenderSettings
+{
+    enum class FresnelMode
+    {
+        eBoth,          // Trace both the reflected and the refracted ray and blend them by the Fresnel term
+        eStochastic     // Trace one of them, picked with probability equal to the Fresnel term
+    };
+
+    enum class MisHeuristic
+    {
+        eBalance,       // Weight each strategy by its share of the summed pdfs
+        ePower          // As above with squared pdfs, which favours the stronger strategy more decisively
+    };
+
+    enum class Integrator
+    {
+        eRecursive,     // Follow one sample at a time, depth first
+        eWavefront      // Follow large batches of samples one bounce at a time, see traceWavefront()
+    };
+
+    Integrator integrator = Integrator::eRecursive;
+
+    FresnelMode fresnelMode = FresnelMode::eStochastic;
+
+    // In stochastic mode, dielectric hits at a path depth below this still trace both rays. Splitting the first few
+    // bounces keeps the noise down where it matters most while the cost of deep paths stays linear.
+    int fresnelSplitDepth = 0;
+
+    // Samples a point on an emitter at every diffuse vertex (next event estimation) and combines it with the
+    // light found by the bounced ray through multiple importance sampling. When off, light is only gathered by
+    // rays that hit emitters.
+    bool lightSampling = true;
+    MisHeuristic misHeuristic = MisHeuristic::ePower;
+
+    // Traces camera rays in packets of adjacent samples, which finds their first hits in fewer traversal
+    // steps. The image is the same either way up to rounding, except with the independent sampler, which then
+    // draws its random numbers in a different order. Only used by the recursive integrator.
+    bool packetTracing = true;
+};
+
+#endif
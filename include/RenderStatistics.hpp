@@ -0,0 +1,69 @@
+#ifndef RENDER_STATISTICS_HPP
+#define RENDER_STATISTICS_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Counts rays and camera samples. Workers count into thread local counters and fold them into the global totals
+// with flush() once per unit of work, so counting costs no shared writes in the inner loops.
+class RenderStatistics
+{
+public:
+    struct Counters
+    {
+        std::uint64_t rays;
+        std::uint64_t samples;
+    };
+
+    static void countRay()
+    {
+        local().rays++;
+    }
+
+    static void countSamples(std::uint64_t samples)
+    {
+        local().samples += samples;
+    }
+
+    static void flush()
+    {
+        Counters& counters = local();
+
+        totalRays().fetch_add(counters.rays, std::memory_order_relaxed);
+        totalSamples().fetch_add(counters.samples, std::memory_order_relaxed);
+        counters = Counters{0, 0};
+    }
+
+    // Sum of all flushed counters
+    static Counters totals()
+    {
+        return Counters{totalRays().load(), totalSamples().load()};
+    }
+
+    static void reset()
+    {
+        totalRays() = 0;
+        totalSamples() = 0;
+    }
+
+private:
+    static Counters& local()
+    {
+        thread_local Counters counters{0, 0};
+        return counters;
+    }
+
+    static std::atomic<std::uint64_t>& totalRays()
+    {
+        static std::atomic<std::uint64_t> rays(0);
+        return rays;
+    }
+
+    static std::atomic<std::uint64_t>& totalSamples()
+    {
+        static std::atomic<std::uint64_t> samples(0);
+        return samples;
+    }
+};
+
+#endif
@@ -4,9 +4,12 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <builders/ParamTypes.hpp>
 #include <Camera.hpp>
+#include <CompiledScene.hpp>
+#include <RenderSettings.hpp>
 #include <shapes/Shape.hpp>
 #include <Surface.hpp>
 
@@ -16,19 +19,30 @@ public:
     using ShapeListType = std::vector<std::shared_ptr<shapes::Shape>>;
 
     Scene(const std::string& title, const std::string& description, const Camera& camera,
-            const ShapeListType& geometry) :
+            const ShapeListType& geometry, const RenderSettings& settings = RenderSettings()) :
         m_title(title),
         m_description(description),
         m_camera(camera),
-        m_geometry(geometry)
+        m_geometry(geometry),
+        m_settings(settings),
+        m_lights(),
+        m_sampledLights(),
+        m_compiled()
     {
         for (auto& shape : m_geometry)
         {
             if (shape->surface().emittance() > 0.0)
             {
                 m_lights.push_back(shape);
+
+                if (shape->surfaceArea() > 0.0)
+                {
+                    m_sampledLights.push_back(shape);
+                }
             }
         }
+
+        m_compiled = CompiledScene(m_geometry);
     }
 
     const Camera& camera() const
@@ -36,6 +50,16 @@ public:
         return m_camera;
     }
 
+    Camera& camera()
+    {
+        return m_camera;
+    }
+
+    const RenderSettings& settings() const
+    {
+        return m_settings;
+    }
+
     const ShapeListType& geometry() const
     {
         return m_geometry;
@@ -46,12 +70,45 @@ public:
         return m_lights;
     }
 
+    // Emitters that support sampleSurface(), and so can be sampled directly by the integrator
+    const ShapeListType& sampledLights() const
+    {
+        return m_sampledLights;
+    }
+
+    // Surfaces of the scene's shapes, indexed by the material of the intersections found by the queries below
+    const std::vector<Surface>& materials() const
+    {
+        return m_compiled.materials();
+    }
+
+    // Nearest intersection further along the ray than minDistance
+    shapes::Shape::IntersectionResult nearestIntersection(const geometry::Ray3& ray, double minDistance) const
+    {
+        return m_compiled.nearestIntersection(ray, minDistance);
+    }
+
+    // Nearest intersections of all the rays of a packet, as nearestIntersection() would find them one by one
+    void nearestIntersection(const geometry::RayPacket3& packet, double minDistance, shapes::Shape::PacketResults& nearest) const
+    {
+        m_compiled.nearestIntersection(packet, minDistance, nearest);
+    }
+
+    // True if anything blocks the ray between minDistance and maxDistance
+    bool isOccluded(const geometry::Ray3& ray, double minDistance, double maxDistance) const
+    {
+        return m_compiled.isOccluded(ray, minDistance, maxDistance);
+    }
+
 private:
     std::string m_title;
     std::string m_description;
     Camera m_camera;
     ShapeListType m_geometry;
+    RenderSettings m_settings;
     ShapeListType m_lights;
+    ShapeListType m_sampledLights;
+    CompiledScene m_compiled;
 };
 
 #endif
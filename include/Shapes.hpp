@@ -3,8 +3,12 @@
 
 #include <shapes/Box.hpp>
 #include <shapes/Chmutov.hpp>
+#include <shapes/Instance.hpp>
 #include <shapes/Plane.hpp>
 #include <shapes/Rectangle.hpp>
+#include <shapes/SignedDistanceField.hpp>
 #include <shapes/Sphere.hpp>
+#include <shapes/SphereSet.hpp>
+#include <shapes/TriangleMesh.hpp>
 
 #endif
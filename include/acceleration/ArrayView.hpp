@@ -0,0 +1,62 @@
+#ifndef ACCELERATION_ARRAY_VIEW_HPP
+#define ACCELERATION_ARRAY_VIEW_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <Assert.hpp>
+
+namespace acceleration
+{
+
+    // Read only view of a contiguous array owned elsewhere, such as a vector or a memory mapped file. Lets
+    // acceleration structures run directly on data they did not build or copy.
+    template <typename T>
+    class ArrayView
+    {
+    public:
+        ArrayView() :
+            m_data(nullptr),
+            m_size(0)
+        { }
+
+        ArrayView(const T* data, std::size_t size) :
+            m_data(data),
+            m_size(size)
+        { }
+
+        ArrayView(const std::vector<T>& vector) :
+            m_data(vector.data()),
+            m_size(vector.size())
+        { }
+
+        // Copies view the same array; none of them own it
+        ArrayView(const ArrayView&) = default;
+        ArrayView& operator=(const ArrayView&) = default;
+
+        const T* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        const T* begin() const { return m_data; }
+        const T* end() const { return m_data + m_size; }
+
+        const T& front() const
+        {
+            Assert(m_size > 0);
+            return m_data[0];
+        }
+
+        const T& operator[](std::size_t index) const
+        {
+            return m_data[index];
+        }
+
+    private:
+        const T* m_data;
+        std::size_t m_size;
+    };
+
+}
+
+#endif
@@ -0,0 +1,1184 @@
+#ifndef ACCELERATION_BOUNDING_VOLUME_HIERARCHY_HPP
+#define ACCELERATION_BOUNDING_VOLUME_HIERARCHY_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <acceleration/ArrayView.hpp>
+#include <acceleration/BuildStatistics.hpp>
+#include <geometry/BoundingBox.hpp>
+#include <geometry/Ray.hpp>
+#include <geometry/RayPacket.hpp>
+#include <threading/WorkerGroup.hpp>
+
+namespace acceleration
+{
+
+    // Binary BVH over an arbitrary set of primitives, built with the surface area heuristic or along a Morton curve.
+    // The hierarchy only knows the bounds of each primitive; intersection of the primitives themselves is left to
+    // the caller.
+    //
+    // Large inputs are built on several threads: the top levels are split with their binning and partitioning
+    // shared between the threads, and the subtrees below them are then built by one thread each. The result is the
+    // same whatever the number of threads.
+    //
+    // Built hierarchies are immutable and share their arrays between copies. A hierarchy can also wrap node and
+    // index arrays stored elsewhere, e.g. in a memory mapped cache file, without copying them.
+    class BoundingVolumeHierarchy
+    {
+    public:
+        struct Node
+        {
+            geometry::BoundingBox3 bounds;
+            std::uint32_t offset;       // Index of the first primitive for leaves, of the second child otherwise
+            std::uint16_t count;        // Number of primitives in a leaf, zero for interior nodes
+            std::uint16_t axis;         // Split axis of interior nodes
+        };
+
+        static constexpr std::size_t defaultMaxLeafSize()
+        {
+            return 4;
+        }
+
+        enum class BuildMethod
+        {
+            eSah,       // Surface area heuristic, with exact sweeps over small nodes and binning over large ones
+            eMorton     // Primitives sorted along a Morton curve and split at its bits: much quicker, looser bounds
+        };
+
+        struct BuildSettings
+        {
+            BuildMethod method = BuildMethod::eSah;
+            std::size_t maxLeafSize = defaultMaxLeafSize();   // At most 65535
+            std::size_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        };
+
+        // Settings of hierarchies built without any, such as those of the shapes of a scene, on the calling thread
+        static BuildSettings& defaultBuildSettings()
+        {
+            thread_local BuildSettings settings;
+            return settings;
+        }
+
+        // Replaces the default settings of the calling thread until it goes out of scope
+        class ScopedBuildSettings
+        {
+        public:
+            explicit ScopedBuildSettings(const BuildSettings& settings) :
+                m_previous(defaultBuildSettings())
+            {
+                defaultBuildSettings() = settings;
+            }
+
+            ScopedBuildSettings(const ScopedBuildSettings&) = delete;
+            ScopedBuildSettings& operator=(const ScopedBuildSettings&) = delete;
+
+            ~ScopedBuildSettings()
+            {
+                defaultBuildSettings() = m_previous;
+            }
+
+        private:
+            BuildSettings m_previous;
+        };
+
+        BoundingVolumeHierarchy() :
+            m_storage(),
+            m_nodes(),
+            m_primitiveIndices()
+        { }
+
+        explicit BoundingVolumeHierarchy(const std::vector<geometry::BoundingBox3>& primitiveBounds) :
+            BoundingVolumeHierarchy(primitiveBounds, defaultBuildSettings())
+        { }
+
+        BoundingVolumeHierarchy(const std::vector<geometry::BoundingBox3>& primitiveBounds, const BuildSettings& settings);
+
+        // Wraps arrays taken from another hierarchy's nodes() and primitiveIndices(). The storage is kept alive as
+        // long as the hierarchy, or any copy of it, is.
+        BoundingVolumeHierarchy(ArrayView<Node> nodes, ArrayView<std::uint32_t> primitiveIndices, std::shared_ptr<const void> storage) :
+            m_storage(std::move(storage)),
+            m_nodes(nodes),
+            m_primitiveIndices(primitiveIndices)
+        { }
+
+        bool empty() const
+        {
+            return m_nodes.empty();
+        }
+
+        const geometry::BoundingBox3& bounds() const
+        {
+            static const geometry::BoundingBox3 emptyBounds;
+            return m_nodes.empty() ? emptyBounds : m_nodes.front().bounds;
+        }
+
+        ArrayView<Node> nodes() const
+        {
+            return m_nodes;
+        }
+
+        // Primitive indices in leaf order
+        ArrayView<std::uint32_t> primitiveIndices() const
+        {
+            return m_primitiveIndices;
+        }
+
+        // Expected cost of tracing a ray that reaches the root, under the surface area heuristic with the costs the
+        // builder uses. Only comparable between hierarchies over the same primitives.
+        double sahCost() const;
+
+        // Visits the primitives whose bounds the ray passes through in [minDistance, maxDistance], nearest nodes
+        // first. The intersector is called as intersector(primitiveIndex, maxDistance) and is expected to shrink
+        // maxDistance whenever it finds a closer hit.
+        template <typename Intersector>
+        void intersect(const geometry::Ray3& ray, double minDistance, double& maxDistance, Intersector&& intersector) const;
+
+        // Any-hit query: returns as soon as predicate(primitiveIndex, maxDistance) reports a primitive blocking the
+        // ray within [minDistance, maxDistance].
+        template <typename Predicate>
+        bool intersectsAny(const geometry::Ray3& ray, double minDistance, double maxDistance, Predicate&& predicate) const;
+
+        // As intersect(), for all the rays of a packet at once. Each node is visited once for the whole packet, and
+        // leaves are handed to the intersector as intersector(primitiveIndex, activeLanes, maxDistances) with the
+        // lanes whose rays reach them. Nodes are first tested against the frustum of a coherent packet, which culls
+        // them for every ray in a single test.
+        template <typename T, std::size_t Width, typename Intersector>
+        void intersect(const geometry::RayPacket<T, Width>& packet, double minDistance, std::array<double, Width>& maxDistances,
+                Intersector&& intersector) const;
+
+    private:
+        static constexpr double sm_traversalCost = 1.0;
+        static constexpr double sm_intersectionCost = 1.0;
+        static constexpr std::size_t sm_stackSize = 64;
+        static constexpr std::size_t sm_maxDepth = sm_stackSize / 2;
+
+        // Nodes with more primitives than this are split by binning their centroids instead of sorting them
+        static constexpr std::size_t sm_sweepSize = 64;
+        static constexpr std::size_t sm_binCount = 32;
+
+        // Fewest primitives per thread worth sharing the binning and partitioning of a node for, and fewest in a
+        // subtree handed to a thread of its own
+        static constexpr std::size_t sm_minChunkSize = 16384;
+        static constexpr std::size_t sm_minSubtreeSize = 1024;
+
+        // Relative error bound of the slab distances, as derived in "Robust BVH Ray Traversal" (Ize, 2013)
+        static constexpr double boundsErrorBound()
+        {
+            return 3 * std::numeric_limits<double>::epsilon() * 0.5 / (1 - 3 * std::numeric_limits<double>::epsilon() * 0.5);
+        }
+
+        struct BuildPrimitive
+        {
+            geometry::BoundingBox3 bounds;
+            std::array<geometry::geo_type, 3> centroid;
+            std::uint32_t index;
+
+            BuildPrimitive() :
+                bounds(),
+                centroid(),
+                index(0)
+            {
+
+            }
+
+            BuildPrimitive(const geometry::BoundingBox3& _bounds, const std::array<geometry::geo_type, 3>& _centroid, std::uint32_t _index) :
+                bounds(_bounds),
+                centroid(_centroid),
+                index(_index)
+            {
+
+            }
+        };
+
+        struct Storage
+        {
+            std::vector<Node> nodes;
+            std::vector<std::uint32_t> primitiveIndices;
+
+            Storage() :
+                nodes(),
+                primitiveIndices()
+            {
+
+            }
+        };
+
+        // Arrays shared by every thread of a build. Each node only touches its own range of them, so threads
+        // building different subtrees never touch the same elements. The same workers run every parallel loop of
+        // the build.
+        struct BuildState
+        {
+            BuildSettings settings;
+            std::unique_ptr<threading::WorkerGroup> workers;
+            std::vector<BuildPrimitive> primitives;
+            std::vector<BuildPrimitive> scratch;
+            std::vector<double> areas;
+            std::vector<std::uint64_t> mortonCodes;    // Sorted, for the Morton builder only
+
+            BuildState() :
+                settings(),
+                workers(),
+                primitives(),
+                scratch(),
+                areas(),
+                mortonCodes()
+            {
+
+            }
+        };
+
+        // Where to split a node: its primitives are ordered so that [begin, middle) goes to the first child. A
+        // middle at the node's beginning makes it a leaf.
+        struct Split
+        {
+            std::size_t axis;
+            std::size_t middle;
+        };
+
+        struct Bin
+        {
+            geometry::BoundingBox3 bounds;
+            std::size_t count;
+
+            Bin() :
+                bounds(),
+                count(0)
+            {
+
+            }
+        };
+
+        using Bins = std::array<std::array<Bin, sm_binCount>, 3>;
+
+        // Upper levels of a parallel build, in the same depth first order as the final nodes. Nodes that stand for
+        // a whole subtree refer to it by index, the others to their second child.
+        struct TopNode
+        {
+            geometry::BoundingBox3 bounds;
+            std::size_t axis;
+            std::size_t secondChild;
+            std::size_t subtree;
+        };
+
+        struct Subtree
+        {
+            std::size_t begin;
+            std::size_t end;
+            std::size_t depth;
+            Storage storage;
+        };
+
+        static constexpr std::size_t noSubtree()
+        {
+            return std::numeric_limits<std::size_t>::max();
+        }
+
+        static std::size_t chunkCount(std::size_t count, std::size_t threadCount)
+        {
+            return std::max<std::size_t>(std::min(threadCount, count / sm_minChunkSize), 1);
+        }
+
+        static std::pair<geometry::BoundingBox3, geometry::BoundingBox3> rangeBounds(const BuildState& state, std::size_t begin, std::size_t end,
+                std::size_t threadCount);
+
+        static Split split(BuildState& state, std::size_t begin, std::size_t end, std::size_t depth, const geometry::BoundingBox3& bounds,
+                const geometry::BoundingBox3& centroidBounds, std::size_t threadCount);
+
+        static Split sweepSplit(BuildState& state, std::size_t begin, std::size_t end, std::size_t depth, const geometry::BoundingBox3& bounds,
+                const geometry::BoundingBox3& centroidBounds);
+
+        static Split binnedSplit(BuildState& state, std::size_t begin, std::size_t end, std::size_t depth, const geometry::BoundingBox3& bounds,
+                const geometry::BoundingBox3& centroidBounds, std::size_t threadCount);
+
+        static Split mortonSplit(BuildState& state, std::size_t begin, std::size_t end, std::size_t depth,
+                const geometry::BoundingBox3& centroidBounds);
+
+        static Split medianSplit(BuildState& state, std::size_t begin, std::size_t end, const geometry::BoundingBox3& centroidBounds);
+
+        static void sortByMortonCode(BuildState& state);
+
+        static std::uint32_t build(Storage& storage, BuildState& state, std::size_t begin, std::size_t end, std::size_t depth);
+
+        static std::size_t buildTop(std::vector<TopNode>& top, std::vector<Subtree>& subtrees, BuildState& state, std::size_t begin,
+                std::size_t end, std::size_t depth, std::size_t subtreeSize);
+
+        static std::uint32_t emit(Storage& storage, const std::vector<TopNode>& top, const std::vector<Subtree>& subtrees, std::size_t index);
+
+        static bool intersectsBounds(const geometry::BoundingBox3& bounds, const std::array<double, 3>& origin,
+                const std::array<double, 3>& inverseDirection, double minDistance, double maxDistance);
+
+        // Bounds of the slab distances of every ray of a coherent packet: along each axis, the distances to the
+        // planes of a node lie between those for the smallest and largest inverse direction of the packet
+        struct Frustum
+        {
+            std::array<double, 3> origin;
+            std::array<double, 3> minInverseDirection;
+            std::array<double, 3> maxInverseDirection;
+            std::array<bool, 3> negativeDirection;
+        };
+
+        static bool intersectsBounds(const geometry::BoundingBox3& bounds, const Frustum& frustum, double minDistance, double maxDistance);
+
+        template <typename T, std::size_t Width>
+        static Frustum frustum(const geometry::RayPacket<T, Width>& packet);
+
+        // Shared traversal loop; the visitor returns true to terminate the traversal early.
+        template <typename Visitor>
+        bool traverse(const geometry::Ray3& ray, double minDistance, double& maxDistance, Visitor&& visitor) const;
+
+        std::shared_ptr<const void> m_storage;
+        ArrayView<Node> m_nodes;
+        ArrayView<std::uint32_t> m_primitiveIndices;
+    };
+
+    inline BoundingVolumeHierarchy::BoundingVolumeHierarchy(const std::vector<geometry::BoundingBox3>& primitiveBounds, const BuildSettings& settings) :
+        m_storage(),
+        m_nodes(),
+        m_primitiveIndices()
+    {
+        if (primitiveBounds.empty())
+        {
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        BuildState state;
+        state.settings = settings;
+        // Leaves store their primitive count in 16 bits
+        state.settings.maxLeafSize = std::min<std::size_t>(std::max<std::size_t>(settings.maxLeafSize, 1),
+                std::numeric_limits<std::uint16_t>::max());
+        state.settings.threadCount = std::max<std::size_t>(settings.threadCount, 1);
+        state.workers = std::make_unique<threading::WorkerGroup>(state.settings.threadCount);
+        state.primitives.resize(primitiveBounds.size());
+        state.scratch.resize(primitiveBounds.size());
+        state.areas.resize(primitiveBounds.size());
+
+        std::size_t count = primitiveBounds.size();
+        std::size_t chunks = chunkCount(count, state.settings.threadCount);
+
+        state.workers->run(chunks, [&](std::size_t chunk) {
+            for (std::size_t i = count * chunk / chunks; i < count * (chunk + 1) / chunks; i++)
+            {
+                const auto& bounds = primitiveBounds[i];
+                state.primitives[i] = BuildPrimitive{bounds, {bounds.centre(0), bounds.centre(1), bounds.centre(2)}, std::uint32_t(i)};
+            }
+        });
+
+        if (state.settings.method == BuildMethod::eMorton)
+        {
+            sortByMortonCode(state);
+        }
+
+        // Enough subtrees for the threads to balance their load, unless they would be too small to be worth it
+        std::size_t subtreeSize = std::max(std::size_t(sm_minSubtreeSize), count / (8 * state.settings.threadCount));
+        std::vector<TopNode> top;
+        std::vector<Subtree> subtrees;
+        buildTop(top, subtrees, state, 0, count, 0, subtreeSize);
+
+        // Largest subtrees first, so that a large one is not left for last
+        std::vector<std::size_t> order(subtrees.size());
+
+        for (std::size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return subtrees[a].end - subtrees[a].begin > subtrees[b].end - subtrees[b].begin;
+        });
+
+        state.workers->run(subtrees.size(), [&](std::size_t i) {
+            Subtree& subtree = subtrees[order[i]];
+            subtree.storage.nodes.reserve(2 * (subtree.end - subtree.begin));
+            subtree.storage.primitiveIndices.reserve(subtree.end - subtree.begin);
+            build(subtree.storage, state, subtree.begin, subtree.end, subtree.depth);
+        });
+
+        auto storage = std::make_shared<Storage>();
+        storage->nodes.reserve(2 * count);
+        storage->primitiveIndices.reserve(count);
+        emit(*storage, top, subtrees, 0);
+
+        m_nodes = storage->nodes;
+        m_primitiveIndices = storage->primitiveIndices;
+        m_storage = std::move(storage);
+
+        std::chrono::duration<double> buildTime = std::chrono::steady_clock::now() - start;
+        BuildStatistics::record(count, buildTime.count(), sahCost());
+    }
+
+    inline double BoundingVolumeHierarchy::sahCost() const
+    {
+        if (m_nodes.empty())
+        {
+            return 0.0;
+        }
+
+        double rootArea = m_nodes.front().bounds.surfaceArea();
+        double cost = 0.0;
+
+        for (const Node& node : m_nodes)
+        {
+            // Flat hierarchies, e.g. of points, have no area; every node is then as likely to be visited
+            double probability = rootArea > 0.0 ? node.bounds.surfaceArea() / rootArea : 1.0;
+            cost += probability * (node.count > 0 ? sm_intersectionCost * node.count : sm_traversalCost);
+        }
+
+        return cost;
+    }
+
+    inline std::pair<geometry::BoundingBox3, geometry::BoundingBox3> BoundingVolumeHierarchy::rangeBounds(const BuildState& state, std::size_t begin,
+            std::size_t end, std::size_t threadCount)
+    {
+        std::size_t count = end - begin;
+        std::size_t chunks = chunkCount(count, threadCount);
+
+        auto expand = [&](std::pair<geometry::BoundingBox3, geometry::BoundingBox3>& bounds, std::size_t chunkBegin, std::size_t chunkEnd) {
+            for (std::size_t i = chunkBegin; i < chunkEnd; i++)
+            {
+                bounds.first.expand(state.primitives[i].bounds);
+                bounds.second.expand(geometry::Point3(state.primitives[i].centroid));
+            }
+        };
+
+        // Most nodes are small enough for one thread, and are visited too often to spend an allocation on
+        if (chunks == 1)
+        {
+            std::pair<geometry::BoundingBox3, geometry::BoundingBox3> bounds;
+            expand(bounds, begin, end);
+            return bounds;
+        }
+
+        std::vector<std::pair<geometry::BoundingBox3, geometry::BoundingBox3>> chunkBounds(chunks);
+
+        state.workers->run(chunks, [&](std::size_t chunk) {
+            expand(chunkBounds[chunk], begin + count * chunk / chunks, begin + count * (chunk + 1) / chunks);
+        });
+
+        for (std::size_t chunk = 1; chunk < chunks; chunk++)
+        {
+            chunkBounds[0].first.expand(chunkBounds[chunk].first);
+            chunkBounds[0].second.expand(chunkBounds[chunk].second);
+        }
+
+        return chunkBounds[0];
+    }
+
+    inline BoundingVolumeHierarchy::Split BoundingVolumeHierarchy::split(BuildState& state, std::size_t begin, std::size_t end, std::size_t depth,
+            const geometry::BoundingBox3& bounds, const geometry::BoundingBox3& centroidBounds, std::size_t threadCount)
+    {
+        if (end - begin == 1)
+        {
+            return Split{0, begin};
+        }
+
+        if (state.settings.method == BuildMethod::eMorton)
+        {
+            return mortonSplit(state, begin, end, depth, centroidBounds);
+        }
+
+        if (end - begin <= sm_sweepSize)
+        {
+            return sweepSplit(state, begin, end, depth, bounds, centroidBounds);
+        }
+
+        return binnedSplit(state, begin, end, depth, bounds, centroidBounds, threadCount);
+    }
+
+    inline BoundingVolumeHierarchy::Split BoundingVolumeHierarchy::sweepSplit(BuildState& state, std::size_t begin, std::size_t end,
+            std::size_t depth, const geometry::BoundingBox3& bounds, const geometry::BoundingBox3& centroidBounds)
+    {
+        std::vector<BuildPrimitive>& primitives = state.primitives;
+        std::vector<double>& areaScratch = state.areas;
+
+        std::size_t count = end - begin;
+        double parentArea = bounds.surfaceArea();
+        double leafCost = sm_intersectionCost * count;
+        double bestCost = std::numeric_limits<double>::infinity();
+        std::size_t bestAxis = 0;
+        std::size_t bestSplit = 0;
+        std::size_t sortedAxis = 3;
+
+        auto sortAlong = [&](std::size_t axis) {
+            std::sort(primitives.begin() + begin, primitives.begin() + end, [axis](const BuildPrimitive& a, const BuildPrimitive& b) {
+                return a.centroid[axis] < b.centroid[axis];
+            });
+
+            sortedAxis = axis;
+        };
+
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            if (!(centroidBounds.extent(axis) > 0.0))
+            {
+                continue;
+            }
+
+            sortAlong(axis);
+
+            // Sweep from the right, recording the area of every suffix
+            geometry::BoundingBox3 rightBounds;
+
+            for (std::size_t i = end - 1; i > begin; i--)
+            {
+                rightBounds.expand(primitives[i].bounds);
+                areaScratch[i] = rightBounds.surfaceArea();
+            }
+
+            // Sweep from the left, evaluating the cost of splitting after each primitive
+            geometry::BoundingBox3 leftBounds;
+
+            for (std::size_t i = begin; i + 1 < end; i++)
+            {
+                leftBounds.expand(primitives[i].bounds);
+
+                std::size_t leftCount = i + 1 - begin;
+                std::size_t rightCount = count - leftCount;
+                double cost = sm_traversalCost + sm_intersectionCost *
+                        (leftBounds.surfaceArea() * leftCount + areaScratch[i + 1] * rightCount) / parentArea;
+
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i + 1;
+                }
+            }
+        }
+
+        if (count <= state.settings.maxLeafSize && leafCost <= bestCost)
+        {
+            return Split{0, begin};
+        }
+
+        if (bestSplit == 0 || depth >= sm_maxDepth)
+        {
+            // Coincident centroids or a degenerate chain of splits: fall back to a median split
+            bestAxis = centroidBounds.longestAxis();
+            bestSplit = begin + count / 2;
+            sortAlong(bestAxis);
+        }
+        else if (sortedAxis != bestAxis)
+        {
+            sortAlong(bestAxis);
+        }
+
+        return Split{bestAxis, bestSplit};
+    }
+
+    inline BoundingVolumeHierarchy::Split BoundingVolumeHierarchy::binnedSplit(BuildState& state, std::size_t begin, std::size_t end,
+            std::size_t depth, const geometry::BoundingBox3& bounds, const geometry::BoundingBox3& centroidBounds, std::size_t threadCount)
+    {
+        std::size_t count = end - begin;
+
+        if (depth >= sm_maxDepth)
+        {
+            return medianSplit(state, begin, end, centroidBounds);
+        }
+
+        std::array<double, 3> binScale;
+
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            double extent = centroidBounds.extent(axis);
+            binScale[axis] = extent > 0.0 ? sm_binCount / extent : 0.0;
+        }
+
+        // The same rounding for binning and partitioning, so that both put every primitive on the same side
+        auto binIndex = [&](const BuildPrimitive& primitive, std::size_t axis) {
+            return std::min(sm_binCount - 1, std::size_t((double(primitive.centroid[axis]) - centroidBounds.min()[axis]) * binScale[axis]));
+        };
+
+        std::size_t chunks = chunkCount(count, threadCount);
+        std::vector<Bins> chunkBins(chunks);
+
+        auto chunkBegin = [&](std::size_t chunk) {
+            return begin + count * chunk / chunks;
+        };
+
+        state.workers->run(chunks, [&](std::size_t chunk) {
+            Bins& bins = chunkBins[chunk];
+
+            for (std::size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+            {
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    if (binScale[axis] > 0.0)
+                    {
+                        Bin& bin = bins[axis][binIndex(state.primitives[i], axis)];
+                        bin.bounds.expand(state.primitives[i].bounds);
+                        bin.count++;
+                    }
+                }
+            }
+        });
+
+        Bins bins = chunkBins[0];
+
+        for (std::size_t chunk = 1; chunk < chunks; chunk++)
+        {
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                for (std::size_t b = 0; b < sm_binCount; b++)
+                {
+                    bins[axis][b].bounds.expand(chunkBins[chunk][axis][b].bounds);
+                    bins[axis][b].count += chunkBins[chunk][axis][b].count;
+                }
+            }
+        }
+
+        // Same cost as the sweep, evaluated only at the planes between bins
+        double parentArea = bounds.surfaceArea();
+        double bestCost = std::numeric_limits<double>::infinity();
+        std::size_t bestAxis = 0;
+        std::size_t bestBin = 0;
+
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            if (!(binScale[axis] > 0.0))
+            {
+                continue;
+            }
+
+            std::array<double, sm_binCount> rightArea;
+            std::array<std::size_t, sm_binCount> rightCount;
+            geometry::BoundingBox3 rightBounds;
+            std::size_t rightTotal = 0;
+
+            for (std::size_t b = sm_binCount - 1; b > 0; b--)
+            {
+                rightBounds.expand(bins[axis][b].bounds);
+                rightTotal += bins[axis][b].count;
+                rightArea[b] = rightBounds.surfaceArea();
+                rightCount[b] = rightTotal;
+            }
+
+            geometry::BoundingBox3 leftBounds;
+            std::size_t leftCount = 0;
+
+            for (std::size_t b = 1; b < sm_binCount; b++)
+            {
+                leftBounds.expand(bins[axis][b - 1].bounds);
+                leftCount += bins[axis][b - 1].count;
+
+                if (leftCount == 0 || rightCount[b] == 0)
+                {
+                    continue;
+                }
+
+                double cost = sm_traversalCost + sm_intersectionCost *
+                        (leftBounds.surfaceArea() * leftCount + rightArea[b] * rightCount[b]) / parentArea;
+
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        if (bestBin == 0)
+        {
+            return medianSplit(state, begin, end, centroidBounds);
+        }
+
+        // Stable partition through the scratch array: each chunk knows from its bins how many of its primitives go
+        // left, and so where to write them
+        std::vector<std::size_t> leftOffsets(chunks);
+        std::vector<std::size_t> rightOffsets(chunks);
+        std::size_t leftTotal = 0;
+
+        for (std::size_t chunk = 0; chunk < chunks; chunk++)
+        {
+            leftOffsets[chunk] = begin + leftTotal;
+
+            for (std::size_t b = 0; b < bestBin; b++)
+            {
+                leftTotal += chunkBins[chunk][bestAxis][b].count;
+            }
+        }
+
+        for (std::size_t chunk = 0; chunk < chunks; chunk++)
+        {
+            rightOffsets[chunk] = chunkBegin(chunk) + leftTotal - (leftOffsets[chunk] - begin);
+        }
+
+        state.workers->run(chunks, [&](std::size_t chunk) {
+            std::size_t left = leftOffsets[chunk];
+            std::size_t right = rightOffsets[chunk];
+
+            for (std::size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+            {
+                state.scratch[binIndex(state.primitives[i], bestAxis) < bestBin ? left++ : right++] = state.primitives[i];
+            }
+        });
+
+        state.workers->run(chunks, [&](std::size_t chunk) {
+            std::copy(state.scratch.begin() + chunkBegin(chunk), state.scratch.begin() + chunkBegin(chunk + 1),
+                    state.primitives.begin() + chunkBegin(chunk));
+        });
+
+        return Split{bestAxis, begin + leftTotal};
+    }
+
+    inline BoundingVolumeHierarchy::Split BoundingVolumeHierarchy::mortonSplit(BuildState& state, std::size_t begin, std::size_t end,
+            std::size_t depth, const geometry::BoundingBox3& centroidBounds)
+    {
+        if (end - begin <= state.settings.maxLeafSize)
+        {
+            return Split{0, begin};
+        }
+
+        const std::vector<std::uint64_t>& codes = state.mortonCodes;
+        std::uint64_t difference = codes[begin] ^ codes[end - 1];
+
+        if (difference == 0 || depth >= sm_maxDepth)
+        {
+            return medianSplit(state, begin, end, centroidBounds);
+        }
+
+        // The codes are sorted and share every bit above the highest one that differs, so the primitives with that
+        // bit set follow all those without it
+        std::size_t bit = 63;
+
+        while (!((difference >> bit) & 1))
+        {
+            bit--;
+        }
+
+        auto middle = std::partition_point(codes.begin() + begin, codes.begin() + end, [bit](std::uint64_t code) {
+            return !((code >> bit) & 1);
+        });
+
+        return Split{2 - bit % 3, std::size_t(middle - codes.begin())};
+    }
+
+    inline BoundingVolumeHierarchy::Split BoundingVolumeHierarchy::medianSplit(BuildState& state, std::size_t begin, std::size_t end,
+            const geometry::BoundingBox3& centroidBounds)
+    {
+        std::size_t axis = centroidBounds.longestAxis();
+        std::size_t middle = begin + (end - begin) / 2;
+
+        // Morton ordered primitives are already in a spatially coherent order, and keep their codes sorted
+        if (state.settings.method != BuildMethod::eMorton)
+        {
+            std::nth_element(state.primitives.begin() + begin, state.primitives.begin() + middle, state.primitives.begin() + end,
+                    [axis](const BuildPrimitive& a, const BuildPrimitive& b) {
+                return a.centroid[axis] < b.centroid[axis];
+            });
+        }
+
+        return Split{axis, middle};
+    }
+
+    inline void BoundingVolumeHierarchy::sortByMortonCode(BuildState& state)
+    {
+        std::size_t count = state.primitives.size();
+        std::size_t threadCount = state.settings.threadCount;
+        geometry::BoundingBox3 centroidBounds = rangeBounds(state, 0, count, threadCount).second;
+
+        // 21 bits per axis, interleaved with x in the highest bit of each group of three
+        auto spread = [](std::uint64_t value) {
+            value &= 0x1fffff;
+            value = (value | value << 32) & 0x1f00000000ffff;
+            value = (value | value << 16) & 0x1f0000ff0000ff;
+            value = (value | value << 8) & 0x100f00f00f00f00f;
+            value = (value | value << 4) & 0x10c30c30c30c30c3;
+            value = (value | value << 2) & 0x1249249249249249;
+            return value;
+        };
+
+        const double cells = double(1 << 21);
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> keys(count);
+        std::size_t chunks = chunkCount(count, threadCount);
+
+        state.workers->run(chunks, [&](std::size_t chunk) {
+            for (std::size_t i = count * chunk / chunks; i < count * (chunk + 1) / chunks; i++)
+            {
+                std::uint64_t code = 0;
+
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    double extent = centroidBounds.extent(axis);
+                    double cell = extent > 0.0 ? (state.primitives[i].centroid[axis] - centroidBounds.min()[axis]) / extent * cells : 0.0;
+                    code |= spread(std::min(std::uint64_t(cell), std::uint64_t(cells - 1))) << (2 - axis);
+                }
+
+                keys[i] = std::make_pair(code, std::uint32_t(i));
+            }
+        });
+
+        // Sorted in chunks, then merged pairwise
+        state.workers->run(chunks, [&](std::size_t chunk) {
+            std::sort(keys.begin() + count * chunk / chunks, keys.begin() + count * (chunk + 1) / chunks);
+        });
+
+        for (std::size_t width = 1; width < chunks; width *= 2)
+        {
+            state.workers->run((chunks + 2 * width - 1) / (2 * width), [&](std::size_t pair) {
+                std::size_t first = 2 * width * pair;
+                std::size_t middle = std::min(first + width, chunks);
+                std::size_t last = std::min(first + 2 * width, chunks);
+                std::inplace_merge(keys.begin() + count * first / chunks, keys.begin() + count * middle / chunks, keys.begin() + count * last / chunks);
+            });
+        }
+
+        state.mortonCodes.resize(count);
+
+        state.workers->run(chunks, [&](std::size_t chunk) {
+            for (std::size_t i = count * chunk / chunks; i < count * (chunk + 1) / chunks; i++)
+            {
+                state.mortonCodes[i] = keys[i].first;
+                state.scratch[i] = state.primitives[keys[i].second];
+            }
+        });
+
+        state.primitives.swap(state.scratch);
+    }
+
+    inline std::uint32_t BoundingVolumeHierarchy::build(Storage& storage, BuildState& state, std::size_t begin, std::size_t end, std::size_t depth)
+    {
+        std::vector<Node>& nodes = storage.nodes;
+        std::uint32_t nodeIndex = std::uint32_t(nodes.size());
+        nodes.push_back(Node{geometry::BoundingBox3(), 0, 0, 0});
+
+        auto nodeBounds = rangeBounds(state, begin, end, 1);
+        nodes[nodeIndex].bounds = nodeBounds.first;
+
+        Split nodeSplit = split(state, begin, end, depth, nodeBounds.first, nodeBounds.second, 1);
+
+        if (nodeSplit.middle == begin)
+        {
+            nodes[nodeIndex].offset = std::uint32_t(storage.primitiveIndices.size());
+            nodes[nodeIndex].count = std::uint16_t(end - begin);
+
+            for (std::size_t i = begin; i < end; i++)
+            {
+                storage.primitiveIndices.push_back(state.primitives[i].index);
+            }
+
+            return nodeIndex;
+        }
+
+        build(storage, state, begin, nodeSplit.middle, depth + 1);
+        std::uint32_t secondChild = build(storage, state, nodeSplit.middle, end, depth + 1);
+
+        nodes[nodeIndex].offset = secondChild;
+        nodes[nodeIndex].axis = std::uint16_t(nodeSplit.axis);
+
+        return nodeIndex;
+    }
+
+    inline std::size_t BoundingVolumeHierarchy::buildTop(std::vector<TopNode>& top, std::vector<Subtree>& subtrees, BuildState& state,
+            std::size_t begin, std::size_t end, std::size_t depth, std::size_t subtreeSize)
+    {
+        std::size_t index = top.size();
+
+        if (end - begin > subtreeSize)
+        {
+            auto nodeBounds = rangeBounds(state, begin, end, state.settings.threadCount);
+            Split nodeSplit = split(state, begin, end, depth, nodeBounds.first, nodeBounds.second, state.settings.threadCount);
+
+            if (nodeSplit.middle != begin)
+            {
+                top.push_back(TopNode{nodeBounds.first, nodeSplit.axis, 0, noSubtree()});
+                buildTop(top, subtrees, state, begin, nodeSplit.middle, depth + 1, subtreeSize);
+                std::size_t secondChild = buildTop(top, subtrees, state, nodeSplit.middle, end, depth + 1, subtreeSize);
+                top[index].secondChild = secondChild;
+                return index;
+            }
+        }
+
+        top.push_back(TopNode{geometry::BoundingBox3(), 0, 0, subtrees.size()});
+        subtrees.push_back(Subtree{begin, end, depth, Storage()});
+        return index;
+    }
+
+    inline std::uint32_t BoundingVolumeHierarchy::emit(Storage& storage, const std::vector<TopNode>& top, const std::vector<Subtree>& subtrees,
+            std::size_t index)
+    {
+        std::uint32_t nodeIndex = std::uint32_t(storage.nodes.size());
+        const TopNode& topNode = top[index];
+
+        if (topNode.subtree != noSubtree())
+        {
+            // Subtrees were built with offsets of their own, which now move along with them
+            const Storage& subtree = subtrees[topNode.subtree].storage;
+            std::uint32_t primitiveOffset = std::uint32_t(storage.primitiveIndices.size());
+
+            for (Node node : subtree.nodes)
+            {
+                node.offset += node.count > 0 ? primitiveOffset : nodeIndex;
+                storage.nodes.push_back(node);
+            }
+
+            storage.primitiveIndices.insert(storage.primitiveIndices.end(), subtree.primitiveIndices.begin(), subtree.primitiveIndices.end());
+            return nodeIndex;
+        }
+
+        storage.nodes.push_back(Node{topNode.bounds, 0, 0, std::uint16_t(topNode.axis)});
+        emit(storage, top, subtrees, index + 1);
+        storage.nodes[nodeIndex].offset = emit(storage, top, subtrees, topNode.secondChild);
+
+        return nodeIndex;
+    }
+
+    inline bool BoundingVolumeHierarchy::intersectsBounds(const geometry::BoundingBox3& bounds, const std::array<double, 3>& origin,
+            const std::array<double, 3>& inverseDirection, double minDistance, double maxDistance)
+    {
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            double t0 = (bounds.min()[axis] - origin[axis]) * inverseDirection[axis];
+            double t1 = (bounds.max()[axis] - origin[axis]) * inverseDirection[axis];
+
+            if (t0 > t1)
+            {
+                std::swap(t0, t1);
+            }
+
+            // Rounding in the slab distances must not cull a ray that grazes the box, or rays through an edge
+            // shared by primitives in different nodes could miss all of them
+            t1 *= 1.0 + 2.0 * boundsErrorBound();
+
+            // Written so that NaNs (ray origin on a slab with a zero direction component) never cull the node
+            minDistance = t0 > minDistance ? t0 : minDistance;
+            maxDistance = t1 < maxDistance ? t1 : maxDistance;
+
+            if (minDistance > maxDistance)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    inline bool BoundingVolumeHierarchy::intersectsBounds(const geometry::BoundingBox3& bounds, const Frustum& frustum,
+            double minDistance, double maxDistance)
+    {
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            double nearPlane = frustum.negativeDirection[axis] ? bounds.max()[axis] : bounds.min()[axis];
+            double farPlane = frustum.negativeDirection[axis] ? bounds.min()[axis] : bounds.max()[axis];
+            double nearOffset = nearPlane - frustum.origin[axis];
+            double farOffset = farPlane - frustum.origin[axis];
+
+            // The offsets are the same for every ray and the inverse directions share a sign, so the extreme
+            // distances come from the extreme inverse directions
+            double t0 = std::min(nearOffset * frustum.minInverseDirection[axis], nearOffset * frustum.maxInverseDirection[axis]);
+            double t1 = std::max(farOffset * frustum.minInverseDirection[axis], farOffset * frustum.maxInverseDirection[axis]);
+
+            t1 *= 1.0 + 2.0 * boundsErrorBound();
+
+            minDistance = std::max(t0, minDistance);
+            maxDistance = std::min(t1, maxDistance);
+
+            if (minDistance > maxDistance)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename T, std::size_t Width>
+    inline BoundingVolumeHierarchy::Frustum BoundingVolumeHierarchy::frustum(const geometry::RayPacket<T, Width>& packet)
+    {
+        Frustum frustum;
+
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            frustum.origin[axis] = packet.origin[axis][0];
+            frustum.minInverseDirection[axis] = packet.inverseDirection[axis][0];
+            frustum.maxInverseDirection[axis] = packet.inverseDirection[axis][0];
+            frustum.negativeDirection[axis] = packet.direction[axis][0] < 0;
+
+            for (std::size_t lane = 1; lane < packet.count; lane++)
+            {
+                frustum.minInverseDirection[axis] = std::min(frustum.minInverseDirection[axis], packet.inverseDirection[axis][lane]);
+                frustum.maxInverseDirection[axis] = std::max(frustum.maxInverseDirection[axis], packet.inverseDirection[axis][lane]);
+            }
+        }
+
+        return frustum;
+    }
+
+    template <typename Visitor>
+    inline bool BoundingVolumeHierarchy::traverse(const geometry::Ray3& ray, double minDistance, double& maxDistance, Visitor&& visitor) const
+    {
+        if (m_nodes.empty())
+        {
+            return false;
+        }
+
+        const std::array<double, 3> origin = {ray.origin()[0], ray.origin()[1], ray.origin()[2]};
+        const std::array<double, 3>& inverseDirection = ray.inverseDirection();
+        const std::array<bool, 3> negativeDirection = {ray.direction()[0] < 0.0, ray.direction()[1] < 0.0, ray.direction()[2] < 0.0};
+
+        std::array<std::uint32_t, sm_stackSize> stack;
+        std::size_t stackSize = 0;
+        std::uint32_t nodeIndex = 0;
+
+        while (true)
+        {
+            const Node& node = m_nodes[nodeIndex];
+
+            if (intersectsBounds(node.bounds, origin, inverseDirection, minDistance, maxDistance))
+            {
+                if (node.count > 0)
+                {
+                    for (std::uint32_t i = node.offset; i < node.offset + node.count; i++)
+                    {
+                        if (visitor(m_primitiveIndices[i], maxDistance))
+                        {
+                            return true;
+                        }
+                    }
+                }
+                else
+                {
+                    // Descend into the child nearer to the ray origin first
+                    if (negativeDirection[node.axis])
+                    {
+                        stack[stackSize++] = nodeIndex + 1;
+                        nodeIndex = node.offset;
+                    }
+                    else
+                    {
+                        stack[stackSize++] = node.offset;
+                        nodeIndex = nodeIndex + 1;
+                    }
+
+                    continue;
+                }
+            }
+
+            if (stackSize == 0)
+            {
+                return false;
+            }
+
+            nodeIndex = stack[--stackSize];
+        }
+    }
+
+    template <typename Intersector>
+    inline void BoundingVolumeHierarchy::intersect(const geometry::Ray3& ray, double minDistance, double& maxDistance, Intersector&& intersector) const
+    {
+        traverse(ray, minDistance, maxDistance, [&](std::uint32_t primitive, double& distanceLimit) {
+            intersector(primitive, distanceLimit);
+            return false;
+        });
+    }
+
+    template <typename Predicate>
+    inline bool BoundingVolumeHierarchy::intersectsAny(const geometry::Ray3& ray, double minDistance, double maxDistance, Predicate&& predicate) const
+    {
+        return traverse(ray, minDistance, maxDistance, [&](std::uint32_t primitive, double& distanceLimit) {
+            return predicate(primitive, distanceLimit);
+        });
+    }
+
+    template <typename T, std::size_t Width, typename Intersector>
+    inline void BoundingVolumeHierarchy::intersect(const geometry::RayPacket<T, Width>& packet, double minDistance,
+            std::array<double, Width>& maxDistances, Intersector&& intersector) const
+    {
+        if (m_nodes.empty() || packet.count == 0)
+        {
+            return;
+        }
+
+        const bool coherent = packet.isCoherent();
+        const Frustum packetFrustum = frustum(packet);
+
+        std::array<std::uint32_t, sm_stackSize> stack;
+        std::size_t stackSize = 0;
+        std::uint32_t nodeIndex = 0;
+
+        while (true)
+        {
+            const Node& node = m_nodes[nodeIndex];
+            geometry::PacketMask<Width> active;
+            bool anyActive = false;
+
+            double maxDistance = maxDistances[0];
+
+            for (std::size_t lane = 1; lane < packet.count; lane++)
+            {
+                maxDistance = std::max(maxDistance, maxDistances[lane]);
+            }
+
+            if (!coherent || intersectsBounds(node.bounds, packetFrustum, minDistance, maxDistance))
+            {
+                // Same test as the single ray traversal, lane by lane
+                for (std::size_t lane = 0; lane < Width; lane++)
+                {
+                    double near = minDistance;
+                    double far = lane < packet.count ? maxDistances[lane] : -std::numeric_limits<double>::infinity();
+
+                    for (std::size_t axis = 0; axis < 3; axis++)
+                    {
+                        double t0 = (node.bounds.min()[axis] - double(packet.origin[axis][lane])) * packet.inverseDirection[axis][lane];
+                        double t1 = (node.bounds.max()[axis] - double(packet.origin[axis][lane])) * packet.inverseDirection[axis][lane];
+                        double tNear = t0 > t1 ? t1 : t0;
+                        double tFar = (t0 > t1 ? t0 : t1) * (1.0 + 2.0 * boundsErrorBound());
+
+                        near = tNear > near ? tNear : near;
+                        far = tFar < far ? tFar : far;
+                    }
+
+                    active[lane] = near <= far;
+                    anyActive = anyActive || active[lane];
+                }
+            }
+
+            if (anyActive)
+            {
+                if (node.count > 0)
+                {
+                    for (std::uint32_t i = node.offset; i < node.offset + node.count; i++)
+                    {
+                        intersector(m_primitiveIndices[i], active, maxDistances);
+                    }
+                }
+                else
+                {
+                    // Nearer child first, along the direction of the first ray
+                    if (packet.direction[node.axis][0] < 0)
+                    {
+                        stack[stackSize++] = nodeIndex + 1;
+                        nodeIndex = node.offset;
+                    }
+                    else
+                    {
+                        stack[stackSize++] = node.offset;
+                        nodeIndex = nodeIndex + 1;
+                    }
+
+                    continue;
+                }
+            }
+
+            if (stackSize == 0)
+            {
+                return;
+            }
+
+            nodeIndex = stack[--stackSize];
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef ACCELERATION_BUILD_STATISTICS_HPP
+#define ACCELERATION_BUILD_STATISTICS_HPP
+
+#include <cstddef>
+#include <mutex>
+
+namespace acceleration
+{
+
+    // Time spent building bounding volume hierarchies, and the quality of the largest one, e.g. a scene's largest
+    // mesh. Hierarchies loaded from a cache are not counted.
+    class BuildStatistics
+    {
+    public:
+        struct Totals
+        {
+            std::size_t hierarchies;
+            std::size_t primitives;
+            double seconds;
+            std::size_t largestPrimitives;
+            double largestSahCost;
+        };
+
+        static void record(std::size_t primitives, double seconds, double sahCost)
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            Totals& sums = current();
+
+            sums.hierarchies++;
+            sums.primitives += primitives;
+            sums.seconds += seconds;
+
+            if (primitives >= sums.largestPrimitives)
+            {
+                sums.largestPrimitives = primitives;
+                sums.largestSahCost = sahCost;
+            }
+        }
+
+        // Sum of all builds since the last reset()
+        static Totals totals()
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            return current();
+        }
+
+        static void reset()
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            current() = Totals{0, 0, 0.0, 0, 0.0};
+        }
+
+    private:
+        static std::mutex& mutex()
+        {
+            static std::mutex value;
+            return value;
+        }
+
+        static Totals& current()
+        {
+            static Totals value{0, 0, 0.0, 0, 0.0};
+            return value;
+        }
+    };
+
+}
+
+#endif
@@ -168,6 +168,8 @@ namespace builders
         switch (targetType) {
             case ParamType::eFloat:
                 return paramCast<ParamTypes::Float, ParamTypes::Integer>(arg);
+            case ParamType::eFloatList:
+                return paramCast<ParamTypes::FloatList, ParamTypes::IntegerList>(arg);
             case ParamType::eIdentifier:
                 return paramCast<ParamTypes::Identifier, ParamTypes::String>(arg);
             case ParamType::eImageSize:
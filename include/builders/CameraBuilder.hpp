@@ -3,6 +3,7 @@
 
 #include <builders/BuilderBase.hpp>
 #include <Camera.hpp>
+#include <Exceptions.hpp>
 
 namespace builders
 {
@@ -17,9 +18,44 @@ namespace builders
             parameter("roll", ParamType::eFloat, OPTIONAL, 0.0);
             parameter("focal-length", ParamType::eFloat, OPTIONAL, 1.0);
             parameter("samples-per-pixel", ParamType::eInteger, OPTIONAL, 64l);
+            parameter("tile-size", ParamType::eInteger, OPTIONAL, 16l);
+            parameter("tile-order", ParamType::eString, OPTIONAL, std::string("hilbert"));
+            parameter("sampler", ParamType::eString, OPTIONAL, std::string("sobol"));
+            parameter("adaptive-threshold", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("min-samples-per-pixel", ParamType::eInteger, OPTIONAL, 16l);
+            parameter("samples-per-pass", ParamType::eInteger, OPTIONAL, 0l);
+            parameter("noise-target", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("time-budget", ParamType::eFloat, OPTIONAL, 0.0);
+        }
+
+        // Public so that front ends can accept the same sampler names as scene files
+        static sampling::Sampler::Type samplerType(const std::string& name) {
+            if (name == "independent") {
+                return sampling::Sampler::Type::eIndependent;
+            } else if (name == "stratified") {
+                return sampling::Sampler::Type::eStratified;
+            } else if (name == "sobol") {
+                return sampling::Sampler::Type::eSobol;
+            } else if (name == "blue-noise") {
+                return sampling::Sampler::Type::eBlueNoise;
+            }
+
+            throw InvalidParameterValueException("sampler", name);
         }
 
     private:
+        static threading::ProblemSpace::Ordering tileOrder(const std::string& name) {
+            if (name == "linear") {
+                return threading::ProblemSpace::Ordering::eLinear;
+            } else if (name == "morton") {
+                return threading::ProblemSpace::Ordering::eMorton;
+            } else if (name == "hilbert") {
+                return threading::ProblemSpace::Ordering::eHilbert;
+            }
+
+            throw InvalidParameterValueException("tile-order", name);
+        }
+
         virtual std::shared_ptr<Camera> construct(const BuilderArgs& args) {
             const auto& resolution = args.get<ParamTypes::ImageSize>("resolution");
             const auto& location = args.get<ParamTypes::Point3>("location");
@@ -27,8 +63,44 @@ namespace builders
             const auto& roll = args.get<ParamTypes::Float>("roll");
             const auto& focalLength = args.get<ParamTypes::Float>("focal-length");
             const auto& samplesPerPixel = args.get<ParamTypes::Integer>("samples-per-pixel");
+            const auto& tileSize = args.get<ParamTypes::Integer>("tile-size");
+            const auto& order = args.get<ParamTypes::String>("tile-order");
+            const auto& sampler = args.get<ParamTypes::String>("sampler");
+            const auto& adaptiveThreshold = args.get<ParamTypes::Float>("adaptive-threshold");
+            const auto& minSamplesPerPixel = args.get<ParamTypes::Integer>("min-samples-per-pixel");
+            const auto& samplesPerPass = args.get<ParamTypes::Integer>("samples-per-pass");
+            const auto& noiseTarget = args.get<ParamTypes::Float>("noise-target");
+            const auto& timeBudget = args.get<ParamTypes::Float>("time-budget");
+
+            if (tileSize < 1) {
+                throw InvalidParameterValueException("tile-size", std::to_string(tileSize));
+            }
+
+            if (adaptiveThreshold < 0.0) {
+                throw InvalidParameterValueException("adaptive-threshold", std::to_string(adaptiveThreshold));
+            }
+
+            if (minSamplesPerPixel < 1) {
+                throw InvalidParameterValueException("min-samples-per-pixel", std::to_string(minSamplesPerPixel));
+            }
+
+            if (samplesPerPass < 0) {
+                throw InvalidParameterValueException("samples-per-pass", std::to_string(samplesPerPass));
+            }
+
+            if (noiseTarget < 0.0) {
+                throw InvalidParameterValueException("noise-target", std::to_string(noiseTarget));
+            }
+
+            if (timeBudget < 0.0) {
+                throw InvalidParameterValueException("time-budget", std::to_string(timeBudget));
+            }
+
+            auto camera = std::make_shared<Camera>(resolution, location, direction, roll, focalLength, samplesPerPixel, tileSize, tileOrder(order), samplerType(sampler));
+            camera->setAdaptiveSampling(adaptiveThreshold, minSamplesPerPixel);
+            camera->setProgressive(samplesPerPass, noiseTarget, timeBudget);
 
-            return std::make_shared<Camera>(resolution, location, direction, roll, focalLength, samplesPerPixel);
+            return camera;
         }
     };
 
@@ -64,13 +64,13 @@ namespace builders
     Target paramCast(const Source& arg);
 
     template <>
-    ParamTypes::Identifier paramCast<ParamTypes::Identifier>(const ParamTypes::String& arg)
+    inline ParamTypes::Identifier paramCast<ParamTypes::Identifier>(const ParamTypes::String& arg)
     {
         return ParamTypes::Identifier(arg);
     }
 
     template <>
-    ParamTypes::ImageSize paramCast<ParamTypes::ImageSize>(const ParamTypes::IntegerList& arg)
+    inline ParamTypes::ImageSize paramCast<ParamTypes::ImageSize>(const ParamTypes::IntegerList& arg)
     {
         if (arg.size() != 2) {
             throw InvalidArrayConversionException(arg, arg.size(), ParamType::eImageSize, 2);
@@ -80,11 +80,17 @@ namespace builders
     }
 
     template <>
-    ParamTypes::Float paramCast<ParamTypes::Float>(const ParamTypes::Integer& arg)
+    inline ParamTypes::Float paramCast<ParamTypes::Float>(const ParamTypes::Integer& arg)
     {
         return static_cast<ParamTypes::Float>(arg);
     }
 
+    template <>
+    inline ParamTypes::FloatList paramCast<ParamTypes::FloatList>(const ParamTypes::IntegerList& arg)
+    {
+        return ParamTypes::FloatList(arg.begin(), arg.end());
+    }
+
     template <typename Target, typename Source>
     Target paramCast(const ParamValue& arg) try
     {
@@ -11,7 +11,10 @@ namespace builders
     class CustomShapeBuilder : public BuilderBase<shapes::Shape>
     {
     public:
-        CustomShapeBuilder() {
+        CustomShapeBuilder() :
+            m_surfaceGetter(),
+            m_prototypeGetter()
+        {
             setAllowExtraArguments(true);
         }
 
@@ -19,16 +22,12 @@ namespace builders
             m_surfaceGetter = surfaceGetter;
         }
 
-    private:
-        virtual ParamValue customConvert(const ParamValue& arg, ParamType targetType) override final {
-            switch (targetType) {
-                case ParamType::eSurface:
-                    return getSurface(arg);
-                default:
-                    throw InvalidConversionException(arg, targetType);
-            }
+        void setPrototypeMapGetter(const std::function<const ParamTypes::PrototypeMap&()>& prototypeGetter) {
+            m_prototypeGetter = prototypeGetter;
         }
 
+    protected:
+        // Surface given by name or inline, for shapes that take surfaces through parameters of their own
         std::shared_ptr<Surface> getSurface(const ParamValue& arg) {
             ParamType argType = getParamType(arg);
 
@@ -49,7 +48,30 @@ namespace builders
             }
         }
 
+        // Prototype group declared under the scene's "prototypes"
+        std::shared_ptr<const shapes::Prototype> getPrototype(const std::string& name) {
+            auto prototypeName = IdentifierString(name);
+            auto prototypeIter = m_prototypeGetter().find(prototypeName);
+
+            if (prototypeIter == m_prototypeGetter().end()) {
+                throw UndeclaredIdentifierException(prototypeName);
+            }
+
+            return prototypeIter->second;
+        }
+
+    private:
+        virtual ParamValue customConvert(const ParamValue& arg, ParamType targetType) override final {
+            switch (targetType) {
+                case ParamType::eSurface:
+                    return getSurface(arg);
+                default:
+                    throw InvalidConversionException(arg, targetType);
+            }
+        }
+
         std::function<const ParamTypes::SurfaceMap&()> m_surfaceGetter;
+        std::function<const ParamTypes::PrototypeMap&()> m_prototypeGetter;
     };
 
 }
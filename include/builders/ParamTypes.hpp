@@ -11,6 +11,7 @@
 #include <geometry/Point.hpp>
 #include <geometry/Vector.hpp>
 #include <graphics/Colour.hpp>
+#include <shapes/Prototype.hpp>
 #include <shapes/Shape.hpp>
 #include <Surface.hpp>
 
@@ -118,6 +119,9 @@ namespace builders
         using Vector2     = geometry::Vector2;
         using Vector3     = geometry::Vector3;
 
+        // Not a parameter type: prototype groups are built by the scene and looked up by name
+        using PrototypeMap = std::map<Identifier, std::shared_ptr<const shapes::Prototype>>;
+
         template <typename T> struct Index;
         template <> struct Index<Boolean>     : public std::integral_constant<ParamType, ParamType::eBoolean>     { };
         template <> struct Index<Camera>      : public std::integral_constant<ParamType, ParamType::eCamera>      { };
@@ -0,0 +1,75 @@
+#ifndef RENDER_SETTINGS_BUILDER_HPP
+#define RENDER_SETTINGS_BUILDER_HPP
+
+#include <builders/BuilderBase.hpp>
+#include <Exceptions.hpp>
+#include <RenderSettings.hpp>
+
+namespace builders
+{
+
+    class RenderSettingsBuilder : public BuilderBase<RenderSettings>
+    {
+    public:
+        RenderSettingsBuilder() {
+            parameter("integrator", ParamType::eString, OPTIONAL, std::string("recursive"));
+            parameter("fresnel-mode", ParamType::eString, OPTIONAL, std::string("stochastic"));
+            parameter("fresnel-split-depth", ParamType::eInteger, OPTIONAL, 0l);
+            parameter("light-sampling", ParamType::eBoolean, OPTIONAL, true);
+            parameter("mis-heuristic", ParamType::eString, OPTIONAL, std::string("power"));
+            parameter("packet-tracing", ParamType::eBoolean, OPTIONAL, true);
+        }
+
+    private:
+        static RenderSettings::Integrator integrator(const std::string& name) {
+            if (name == "recursive") {
+                return RenderSettings::Integrator::eRecursive;
+            } else if (name == "wavefront") {
+                return RenderSettings::Integrator::eWavefront;
+            }
+
+            throw InvalidParameterValueException("integrator", name);
+        }
+
+        static RenderSettings::FresnelMode fresnelMode(const std::string& name) {
+            if (name == "both") {
+                return RenderSettings::FresnelMode::eBoth;
+            } else if (name == "stochastic") {
+                return RenderSettings::FresnelMode::eStochastic;
+            }
+
+            throw InvalidParameterValueException("fresnel-mode", name);
+        }
+
+        static RenderSettings::MisHeuristic misHeuristic(const std::string& name) {
+            if (name == "balance") {
+                return RenderSettings::MisHeuristic::eBalance;
+            } else if (name == "power") {
+                return RenderSettings::MisHeuristic::ePower;
+            }
+
+            throw InvalidParameterValueException("mis-heuristic", name);
+        }
+
+        virtual std::shared_ptr<RenderSettings> construct(const BuilderArgs& args) {
+            auto settings = std::make_shared<RenderSettings>();
+            const auto& splitDepth = args.get<ParamTypes::Integer>("fresnel-split-depth");
+
+            if (splitDepth < 0) {
+                throw InvalidParameterValueException("fresnel-split-depth", std::to_string(splitDepth));
+            }
+
+            settings->integrator = integrator(args.get<ParamTypes::String>("integrator"));
+            settings->fresnelMode = fresnelMode(args.get<ParamTypes::String>("fresnel-mode"));
+            settings->fresnelSplitDepth = int(splitDepth);
+            settings->lightSampling = args.get<ParamTypes::Boolean>("light-sampling");
+            settings->misHeuristic = misHeuristic(args.get<ParamTypes::String>("mis-heuristic"));
+            settings->packetTracing = args.get<ParamTypes::Boolean>("packet-tracing");
+
+            return settings;
+        }
+    };
+
+}
+
+#endif
@@ -3,8 +3,10 @@
 
 #include <set>
 
+#include <acceleration/BoundingVolumeHierarchy.hpp>
 #include <builders/BuilderBase.hpp>
 #include <builders/CameraBuilder.hpp>
+#include <builders/RenderSettingsBuilder.hpp>
 #include <builders/ShapeBuilder.hpp>
 #include <Scene.hpp>
 
@@ -20,7 +22,10 @@ namespace builders
             parameter("description", ParamType::eString, OPTIONAL, "");
             parameter("camera", ParamType::eCamera, REQUIRED);
             parameter("Surfaces", ParamType::eSurfaceMap, OPTIONAL, ParamTypes::SurfaceMap());
-            parameter("geometry", ParamType::eShapeMap, REQUIRED);
+            parameter("prototypes", ParamType::eObject, OPTIONAL, std::make_shared<BuilderArgs>());
+            parameter("geometry", ParamType::eObject, REQUIRED);
+            parameter("render", ParamType::eObject, OPTIONAL, std::make_shared<BuilderArgs>());
+            parameter("bvh-builder", ParamType::eString, OPTIONAL, std::string("sah"));
         }
 
     private:
@@ -28,14 +33,34 @@ namespace builders
             const auto& title = args.get<ParamTypes::String>("title");
             const auto& description = args.get<ParamTypes::String>("description");
             const auto& camera = *args.get<ParamTypes::Camera>("camera");
-            const auto& geometryMap = args.get<ParamTypes::ShapeMap>("geometry");
+
+            // Every hierarchy built for the scene, its shapes' included, is built the way the scene asks for
+            acceleration::BoundingVolumeHierarchy::BuildSettings buildSettings = acceleration::BoundingVolumeHierarchy::defaultBuildSettings();
+            buildSettings.method = bvhBuildMethod(args.get<ParamTypes::String>("bvh-builder"));
+            acceleration::BoundingVolumeHierarchy::ScopedBuildSettings scopedBuildSettings(buildSettings);
+
+            // Parameters are converted in name order, so the prototypes are built here to have them ready before
+            // the geometry that places them
+            m_shapeBuilder.setPrototypes(createPrototypeMap(args.get<ParamTypes::Object>("prototypes")));
+            auto geometryMap = createShapeMap(args.get<ParamTypes::Object>("geometry"));
+            RenderSettings settings = *RenderSettingsBuilder().build(*args.get<ParamTypes::Object>("render"));
 
             std::vector<std::shared_ptr<shapes::Shape>> geometry;
             std::transform(geometryMap.begin(), geometryMap.end(), std::back_inserter(geometry), [](auto& s){
                 return std::move(s.second);
             });
 
-            return std::make_shared<Scene>(title, description, camera, geometry);
+            return std::make_shared<Scene>(title, description, camera, geometry, settings);
+        }
+
+        static acceleration::BoundingVolumeHierarchy::BuildMethod bvhBuildMethod(const std::string& name) {
+            if (name == "sah") {
+                return acceleration::BoundingVolumeHierarchy::BuildMethod::eSah;
+            } else if (name == "morton") {
+                return acceleration::BoundingVolumeHierarchy::BuildMethod::eMorton;
+            }
+
+            throw InvalidParameterValueException("bvh-builder", name);
         }
 
         virtual ParamValue customConvert(const ParamValue& arg, ParamType targetType) override {
@@ -43,7 +68,7 @@ namespace builders
                 case ParamType::eCamera:
                     return createCamera(arg);
                 case ParamType::eShapeMap:
-                    return createShapeMap(arg);
+                    return createShapeMap(boost::get<ParamTypes::Object>(arg));
                 case ParamType::eSurfaceMap:
                     return createSurfaceMap(arg);
                 default:
@@ -56,9 +81,7 @@ namespace builders
             return m_cameraBuilder.build(*cameraArgs);
         }
 
-        ParamValue createShapeMap(const ParamValue& arg) {
-            const auto& shapeEntries = boost::get<ParamTypes::Object>(arg);
-
+        ParamTypes::ShapeMap createShapeMap(const ParamTypes::Object& shapeEntries) {
             if (!m_surfacesConstructed) {
                 throw SomeKindOfException();
             }
@@ -80,6 +103,40 @@ namespace builders
             return geometry;
         }
 
+        // Each prototype is a group of shapes given like the geometry. Their names are local to the group, and
+        // they cannot be instances themselves, as no prototypes are known while the groups are built.
+        ParamTypes::PrototypeMap createPrototypeMap(const ParamTypes::Object& prototypeEntries) {
+            if (!m_surfacesConstructed && prototypeEntries->size() > 0) {
+                throw SomeKindOfException();
+            }
+
+            ParamTypes::PrototypeMap prototypes;
+
+            for (const auto& prototypeEntry : *prototypeEntries) {
+                const ParamTypes::Identifier& prototypeName = prototypeEntry.first;
+                const ParamTypes::Object& shapeEntries = boost::get<ParamTypes::Object>(prototypeEntry.second);
+
+                if (m_definedNames.find(prototypeName) != m_definedNames.end()) {
+                    throw SomeKindOfNameConflictException();
+                }
+
+                if (shapeEntries->size() == 0) {
+                    throw InvalidParameterValueException("prototypes", prototypeName);
+                }
+
+                m_definedNames.insert(prototypeName);
+                std::vector<std::shared_ptr<shapes::Shape>> shapes;
+
+                for (const auto& shapeEntry : *shapeEntries) {
+                    shapes.push_back(m_shapeBuilder.build(*boost::get<ParamTypes::Object>(shapeEntry.second)));
+                }
+
+                prototypes[prototypeName] = std::make_shared<const shapes::Prototype>(shapes);
+            }
+
+            return prototypes;
+        }
+
         ParamValue createSurfaceMap(const ParamValue& arg) {
             const auto& surfaceEntries = boost::get<ParamTypes::Object>(arg);
             ParamTypes::SurfaceMap surfaces;
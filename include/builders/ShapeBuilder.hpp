@@ -30,7 +30,9 @@ namespace builders
             }
         };
 
-        ShapeBuilder()
+        ShapeBuilder() :
+            m_surfaces(),
+            m_prototypes()
         {
             setAllowExtraArguments(true);
             parameter("shape", ParamType::eString, REQUIRED);
@@ -41,6 +43,11 @@ namespace builders
             m_surfaces = surfaces;
         }
 
+        void setPrototypes(const ParamTypes::PrototypeMap& prototypes)
+        {
+            m_prototypes = prototypes;
+        }
+
     private:
         static std::map<std::string, std::unique_ptr<CustomShapeBuilder>>& shapeBuilderRegistry()
         {
@@ -61,6 +68,7 @@ namespace builders
 
             CustomShapeBuilder& builder = *builderIter->second;
             builder.setSurfaceMapGetter([&]() -> const ParamTypes::SurfaceMap& { return m_surfaces; });
+            builder.setPrototypeMapGetter([&]() -> const ParamTypes::PrototypeMap& { return m_prototypes; });
             BuilderArgs shapeArgs;
 
             std::copy_if(args.begin(), args.end(), std::inserter(shapeArgs, shapeArgs.end()),
@@ -71,6 +79,7 @@ namespace builders
         }
 
         ParamTypes::SurfaceMap m_surfaces;
+        ParamTypes::PrototypeMap m_prototypes;
     };
 
 }
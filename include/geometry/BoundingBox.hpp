@@ -0,0 +1,169 @@
+#ifndef BOUNDING_BOX_HPP
+#define BOUNDING_BOX_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <geometry/Point.hpp>
+#include <geometry/Vector.hpp>
+
+namespace geometry
+{
+
+    template <typename T, std::size_t Dimensions>
+    class BoundingBox
+    {
+    public:
+        // Default constructed boxes are empty; expanding them by any point yields that point.
+        BoundingBox() :
+            m_min(filled(std::numeric_limits<T>::infinity())),
+            m_max(filled(-std::numeric_limits<T>::infinity()))
+        {
+
+        }
+
+        BoundingBox(const Point<T, Dimensions>& p1, const Point<T, Dimensions>& p2) :
+            BoundingBox()
+        {
+            expand(p1);
+            expand(p2);
+        }
+
+        static BoundingBox<T, Dimensions> infinite()
+        {
+            BoundingBox<T, Dimensions> box;
+            box.m_min = filled(-std::numeric_limits<T>::infinity());
+            box.m_max = filled(std::numeric_limits<T>::infinity());
+            return box;
+        }
+
+        const Point<T, Dimensions>& min() const
+        {
+            return m_min;
+        }
+
+        const Point<T, Dimensions>& max() const
+        {
+            return m_max;
+        }
+
+        bool isEmpty() const
+        {
+            for (std::size_t i = 0; i < Dimensions; i++)
+            {
+                if (m_min[i] > m_max[i])
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool isBounded() const
+        {
+            for (std::size_t i = 0; i < Dimensions; i++)
+            {
+                if (!std::isfinite(m_min[i]) || !std::isfinite(m_max[i]))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        BoundingBox<T, Dimensions>& expand(const Point<T, Dimensions>& p)
+        {
+            for (std::size_t i = 0; i < Dimensions; i++)
+            {
+                m_min[i] = std::min(m_min[i], p[i]);
+                m_max[i] = std::max(m_max[i], p[i]);
+            }
+
+            return *this;
+        }
+
+        BoundingBox<T, Dimensions>& expand(const BoundingBox<T, Dimensions>& box)
+        {
+            for (std::size_t i = 0; i < Dimensions; i++)
+            {
+                m_min[i] = std::min(m_min[i], box.m_min[i]);
+                m_max[i] = std::max(m_max[i], box.m_max[i]);
+            }
+
+            return *this;
+        }
+
+        T extent(std::size_t axis) const
+        {
+            return m_max[axis] - m_min[axis];
+        }
+
+        T centre(std::size_t axis) const
+        {
+            return (m_min[axis] + m_max[axis]) * T(0.5);
+        }
+
+        Point<T, Dimensions> centroid() const
+        {
+            std::array<T, Dimensions> c;
+
+            for (std::size_t i = 0; i < Dimensions; i++)
+            {
+                c[i] = centre(i);
+            }
+
+            return Point<T, Dimensions>(c);
+        }
+
+        std::size_t longestAxis() const
+        {
+            std::size_t axis = 0;
+
+            for (std::size_t i = 1; i < Dimensions; i++)
+            {
+                if (extent(i) > extent(axis))
+                {
+                    axis = i;
+                }
+            }
+
+            return axis;
+        }
+
+        T surfaceArea() const
+        {
+            static_assert(Dimensions == 3, "Surface area is only defined for three dimensional boxes.");
+
+            if (isEmpty())
+            {
+                return T(0);
+            }
+
+            T x = extent(0);
+            T y = extent(1);
+            T z = extent(2);
+
+            return T(2) * (x * y + y * z + z * x);
+        }
+
+    private:
+        static Point<T, Dimensions> filled(T value)
+        {
+            std::array<T, Dimensions> components;
+            components.fill(value);
+            return Point<T, Dimensions>(components);
+        }
+
+        Point<T, Dimensions> m_min;
+        Point<T, Dimensions> m_max;
+    };
+
+    using BoundingBox3 = BoundingBox<geo_type, 3>;
+
+}
+
+#endif
@@ -0,0 +1,379 @@
+#ifndef GEOMETRY_DISTANCE_PROGRAM_HPP
+#define GEOMETRY_DISTANCE_PROGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include <Assert.hpp>
+
+namespace geometry
+{
+
+    // Node of a signed distance expression: a primitive placed about a centre, a boolean combination of two
+    // children, optionally blended over a smoothing radius, or a displacement of a single child.
+    struct DistanceNode
+    {
+        enum class Type
+        {
+            eSphere,
+            eBox,
+            eTorus,
+            eUnion,
+            eIntersection,
+            eDifference,
+            eRipple
+        };
+
+        using Position = std::array<double, 3>;
+
+        Type type;
+        Position centre;
+        // Sphere: radius. Box: half extents and corner rounding. Torus: major and minor radius. Booleans: smoothing
+        // radius. Ripple: amplitude and frequency.
+        std::array<double, 4> parameters;
+        std::vector<std::shared_ptr<const DistanceNode>> children;
+
+        static std::shared_ptr<DistanceNode> sphere(const Position& centre, double radius)
+        {
+            return std::make_shared<DistanceNode>(DistanceNode{Type::eSphere, centre, {{radius, 0, 0, 0}}, {}});
+        }
+
+        static std::shared_ptr<DistanceNode> box(const Position& centre, const Position& halfSize, double rounding)
+        {
+            return std::make_shared<DistanceNode>(DistanceNode{Type::eBox, centre, {{halfSize[0], halfSize[1], halfSize[2], rounding}}, {}});
+        }
+
+        // Torus about the y axis
+        static std::shared_ptr<DistanceNode> torus(const Position& centre, double majorRadius, double minorRadius)
+        {
+            return std::make_shared<DistanceNode>(DistanceNode{Type::eTorus, centre, {{majorRadius, minorRadius, 0, 0}}, {}});
+        }
+
+        static std::shared_ptr<DistanceNode> combine(Type type, const std::shared_ptr<const DistanceNode>& left, const std::shared_ptr<const DistanceNode>& right, double smoothing)
+        {
+            return std::make_shared<DistanceNode>(DistanceNode{type, {{0, 0, 0}}, {{smoothing, 0, 0, 0}}, {left, right}});
+        }
+
+        // Moves the child's surface by amplitude * sin(fx) sin(fy) sin(fz)
+        static std::shared_ptr<DistanceNode> ripple(const std::shared_ptr<const DistanceNode>& child, double amplitude, double frequency)
+        {
+            return std::make_shared<DistanceNode>(DistanceNode{Type::eRipple, {{0, 0, 0}}, {{amplitude, frequency, 0, 0}}, {child}});
+        }
+    };
+
+    // A distance expression compiled into postfix order: primitives push their distance onto a small stack and
+    // operators replace the top entries with their result, so evaluating it is one pass over a flat array with no
+    // recursion or virtual calls. Compiling also bounds the expression's Lipschitz constant, which limits how far the
+    // surface can be from a point given the value there, and the region outside which the value is positive.
+    class DistanceProgram
+    {
+    public:
+        using Position = DistanceNode::Position;
+
+        // Deepest expression that can be evaluated, counting the root as one
+        static constexpr std::size_t maxDepth()
+        {
+            return 32;
+        }
+
+        explicit DistanceProgram(const DistanceNode& root) :
+            m_code(),
+            m_constants(),
+            m_lipschitz(compile(root, 1)),
+            m_lower(),
+            m_upper()
+        {
+            const Extent rootExtent = extent(root, 0.0);
+            m_lower = rootExtent.lower;
+            m_upper = rootExtent.upper;
+        }
+
+        double evaluate(const Position& p) const
+        {
+            std::array<double, maxDepth()> stack;
+            std::size_t top = 0;
+
+            for (const Instruction& instruction : m_code)
+            {
+                const double* c = m_constants.data() + instruction.constants;
+
+                switch (instruction.opcode)
+                {
+                    case Opcode::eSphere:
+                        stack[top++] = length(p[0] - c[0], p[1] - c[1], p[2] - c[2]) - c[3];
+                        break;
+                    case Opcode::eBox:
+                    {
+                        // c[3..5] are the half extents less the rounding radius, c[6]
+                        double qx = std::abs(p[0] - c[0]) - c[3];
+                        double qy = std::abs(p[1] - c[1]) - c[4];
+                        double qz = std::abs(p[2] - c[2]) - c[5];
+                        double outside = length(std::max(qx, 0.0), std::max(qy, 0.0), std::max(qz, 0.0));
+                        stack[top++] = outside + std::min(std::max(qx, std::max(qy, qz)), 0.0) - c[6];
+                        break;
+                    }
+                    case Opcode::eTorus:
+                    {
+                        double dx = p[0] - c[0];
+                        double dz = p[2] - c[2];
+                        double ring = std::sqrt(dx * dx + dz * dz) - c[3];
+                        stack[top++] = length(ring, p[1] - c[1], 0.0) - c[4];
+                        break;
+                    }
+                    case Opcode::eUnion:
+                        top--;
+                        stack[top - 1] = std::min(stack[top - 1], stack[top]);
+                        break;
+                    case Opcode::eSmoothUnion:
+                        top--;
+                        stack[top - 1] = smoothMin(stack[top - 1], stack[top], c[0]);
+                        break;
+                    case Opcode::eIntersection:
+                        top--;
+                        stack[top - 1] = std::max(stack[top - 1], stack[top]);
+                        break;
+                    case Opcode::eSmoothIntersection:
+                        top--;
+                        stack[top - 1] = -smoothMin(-stack[top - 1], -stack[top], c[0]);
+                        break;
+                    case Opcode::eDifference:
+                        top--;
+                        stack[top - 1] = std::max(stack[top - 1], -stack[top]);
+                        break;
+                    case Opcode::eSmoothDifference:
+                        top--;
+                        stack[top - 1] = -smoothMin(-stack[top - 1], stack[top], c[0]);
+                        break;
+                    case Opcode::eRipple:
+                        stack[top - 1] += c[0] * std::sin(c[1] * p[0]) * std::sin(c[1] * p[1]) * std::sin(c[1] * p[2]);
+                        break;
+                }
+            }
+
+            Assert(top == 1);
+            return stack[0];
+        }
+
+        // Unit gradient by central differences
+        std::array<double, 3> gradientDirection(const Position& p, double step) const
+        {
+            std::array<double, 3> gradient;
+
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                Position ahead = p;
+                Position behind = p;
+                ahead[axis] += step;
+                behind[axis] -= step;
+                gradient[axis] = evaluate(ahead) - evaluate(behind);
+            }
+
+            double recipLength = 1.0 / length(gradient[0], gradient[1], gradient[2]);
+
+            for (double& component : gradient)
+            {
+                component *= recipLength;
+            }
+
+            return gradient;
+        }
+
+        // No point is nearer to the surface than the value there divided by this
+        double lipschitzBound() const
+        {
+            return m_lipschitz;
+        }
+
+        // Corners of a box outside of which the expression is positive. The box is inverted if the expression is
+        // positive everywhere.
+        const Position& lower() const
+        {
+            return m_lower;
+        }
+
+        const Position& upper() const
+        {
+            return m_upper;
+        }
+
+        std::size_t size() const
+        {
+            return m_code.size();
+        }
+
+    private:
+        enum class Opcode : std::uint8_t
+        {
+            eSphere,
+            eBox,
+            eTorus,
+            eUnion,
+            eSmoothUnion,
+            eIntersection,
+            eSmoothIntersection,
+            eDifference,
+            eSmoothDifference,
+            eRipple
+        };
+
+        struct Instruction
+        {
+            Opcode opcode;
+            std::uint32_t constants;
+        };
+
+        struct Extent
+        {
+            Position lower;
+            Position upper;
+        };
+
+        std::vector<Instruction> m_code;
+        std::vector<double> m_constants;
+        double m_lipschitz;
+        Position m_lower;
+        Position m_upper;
+
+        static double length(double x, double y, double z)
+        {
+            return std::sqrt(x * x + y * y + z * z);
+        }
+
+        // Polynomial smooth minimum, which undercuts min(a, b) by at most k / 4 where the two are within k of each
+        // other. Its gradient is a convex combination of theirs, so it is no steeper than the steeper of the two.
+        static double smoothMin(double a, double b, double k)
+        {
+            double h = std::max(k - std::abs(a - b), 0.0) / k;
+            return std::min(a, b) - 0.25 * h * h * k;
+        }
+
+        void emit(Opcode opcode, std::initializer_list<double> constants)
+        {
+            m_code.push_back(Instruction{opcode, static_cast<std::uint32_t>(m_constants.size())});
+            m_constants.insert(m_constants.end(), constants);
+        }
+
+        // Appends the node's code after its children's, returning its Lipschitz bound
+        double compile(const DistanceNode& node, std::size_t depth)
+        {
+            Assert(depth <= maxDepth());
+
+            const Position& c = node.centre;
+            const auto& p = node.parameters;
+
+            switch (node.type)
+            {
+                case DistanceNode::Type::eSphere:
+                    emit(Opcode::eSphere, {c[0], c[1], c[2], p[0]});
+                    return 1.0;
+                case DistanceNode::Type::eBox:
+                    emit(Opcode::eBox, {c[0], c[1], c[2], p[0] - p[3], p[1] - p[3], p[2] - p[3], p[3]});
+                    return 1.0;
+                case DistanceNode::Type::eTorus:
+                    emit(Opcode::eTorus, {c[0], c[1], c[2], p[0], p[1]});
+                    return 1.0;
+                case DistanceNode::Type::eRipple:
+                {
+                    double child = compile(*node.children[0], depth + 1);
+                    emit(Opcode::eRipple, {p[0], p[1]});
+                    // The displacement's gradient has length at most amplitude * frequency
+                    return child + std::abs(p[0] * p[1]);
+                }
+                default:
+                    break;
+            }
+
+            // Min and max, smoothed or not, are no steeper than the steeper of their arguments
+            double left = compile(*node.children[0], depth + 1);
+            double right = compile(*node.children[1], depth + 1);
+            bool smooth = p[0] > 0.0;
+
+            switch (node.type)
+            {
+                case DistanceNode::Type::eUnion:
+                    emit(smooth ? Opcode::eSmoothUnion : Opcode::eUnion, {p[0]});
+                    break;
+                case DistanceNode::Type::eIntersection:
+                    emit(smooth ? Opcode::eSmoothIntersection : Opcode::eIntersection, {p[0]});
+                    break;
+                default:
+                    emit(smooth ? Opcode::eSmoothDifference : Opcode::eDifference, {p[0]});
+                    break;
+            }
+
+            return std::max(left, right);
+        }
+
+        // Box containing every point at which the node's value is at most the margin. Primitives are exact
+        // distances, so their boxes grow by the margin; the operators pass on a margin that accounts for how far they
+        // can undercut their children.
+        static Extent extent(const DistanceNode& node, double margin)
+        {
+            const Position& c = node.centre;
+            const auto& p = node.parameters;
+            Position reach = {{0, 0, 0}};
+
+            switch (node.type)
+            {
+                case DistanceNode::Type::eSphere:
+                    reach = {{p[0], p[0], p[0]}};
+                    break;
+                case DistanceNode::Type::eBox:
+                    reach = {{p[0], p[1], p[2]}};
+                    break;
+                case DistanceNode::Type::eTorus:
+                    reach = {{p[0] + p[1], p[1], p[0] + p[1]}};
+                    break;
+                case DistanceNode::Type::eUnion:
+                {
+                    Extent left = extent(*node.children[0], margin + 0.25 * p[0]);
+                    Extent right = extent(*node.children[1], margin + 0.25 * p[0]);
+
+                    for (std::size_t i = 0; i < 3; i++)
+                    {
+                        left.lower[i] = std::min(left.lower[i], right.lower[i]);
+                        left.upper[i] = std::max(left.upper[i], right.upper[i]);
+                    }
+
+                    return left;
+                }
+                case DistanceNode::Type::eIntersection:
+                {
+                    Extent left = extent(*node.children[0], margin);
+                    Extent right = extent(*node.children[1], margin);
+
+                    for (std::size_t i = 0; i < 3; i++)
+                    {
+                        left.lower[i] = std::max(left.lower[i], right.lower[i]);
+                        left.upper[i] = std::min(left.upper[i], right.upper[i]);
+                    }
+
+                    return left;
+                }
+                case DistanceNode::Type::eDifference:
+                    return extent(*node.children[0], margin);
+                case DistanceNode::Type::eRipple:
+                    return extent(*node.children[0], margin + std::abs(p[0]));
+            }
+
+            Extent result;
+
+            for (std::size_t i = 0; i < 3; i++)
+            {
+                result.lower[i] = c[i] - reach[i] - margin;
+                result.upper[i] = c[i] + reach[i] + margin;
+            }
+
+            return result;
+        }
+    };
+
+}
+
+#endif
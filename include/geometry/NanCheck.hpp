@@ -0,0 +1,103 @@
+#ifndef NAN_CHECK_HPP
+#define NAN_CHECK_HPP
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// How points and vectors are checked for NaN components, chosen at compile time with GEOMETRY_NAN_CHECK:
+//
+//  GEOMETRY_NAN_CHECK_OFF      no checks at all; the default for NDEBUG builds
+//  GEOMETRY_NAN_CHECK_ASSERT   report the kernel that produced the first NaN and abort; the default otherwise
+//  GEOMETRY_NAN_CHECK_COUNT    report the kernel that produced the first NaN, then count NaNs and carry on
+//
+// Checks are made on every point and vector constructed and on the result of every arithmetic kernel, so the first
+// report names the operation where a NaN appeared rather than wherever it was noticed.
+#define GEOMETRY_NAN_CHECK_OFF 0
+#define GEOMETRY_NAN_CHECK_ASSERT 1
+#define GEOMETRY_NAN_CHECK_COUNT 2
+
+#ifndef GEOMETRY_NAN_CHECK
+#   ifdef NDEBUG
+#       define GEOMETRY_NAN_CHECK GEOMETRY_NAN_CHECK_OFF
+#   else
+#       define GEOMETRY_NAN_CHECK GEOMETRY_NAN_CHECK_ASSERT
+#   endif
+#endif
+
+#if GEOMETRY_NAN_CHECK == GEOMETRY_NAN_CHECK_OFF
+#   define GEOMETRY_CHECK_NAN(value, kernel) static_cast<void>(0)
+#   define GEOMETRY_CHECK_NAN_SCALAR(value, kernel) static_cast<void>(0)
+#else
+#   define GEOMETRY_CHECK_NAN(value, kernel) ::geometry::NanCheck::check((value).isNaN(), kernel)
+#   define GEOMETRY_CHECK_NAN_SCALAR(value, kernel) ::geometry::NanCheck::check(std::isnan(value), kernel)
+#endif
+
+namespace geometry
+{
+
+    class NanCheck
+    {
+    public:
+        static void check(bool isNaN, const char* kernel)
+        {
+            if (isNaN)
+            {
+                report(kernel);
+            }
+        }
+
+        // NaNs seen since the last reset(); always zero when checks are off
+        static std::uint64_t count()
+        {
+            return counter().load(std::memory_order_relaxed);
+        }
+
+        // Kernel that produced the first NaN, or null if there has not been one
+        static const char* firstKernel()
+        {
+            return first().load();
+        }
+
+        static void reset()
+        {
+            counter() = 0;
+            first() = nullptr;
+        }
+
+    private:
+        // Separate from check(), which is all that runs while there are no NaNs
+        static void report(const char* kernel)
+        {
+            counter().fetch_add(1, std::memory_order_relaxed);
+            const char* expected = nullptr;
+
+            if (first().compare_exchange_strong(expected, kernel))
+            {
+                std::cerr << "geometry: first NaN produced by " << kernel << std::endl;
+            }
+
+            if (GEOMETRY_NAN_CHECK == GEOMETRY_NAN_CHECK_ASSERT)
+            {
+                std::abort();
+            }
+        }
+
+        static std::atomic<std::uint64_t>& counter()
+        {
+            static std::atomic<std::uint64_t> value(0);
+            return value;
+        }
+
+        static std::atomic<const char*>& first()
+        {
+            static std::atomic<const char*> value(nullptr);
+            return value;
+        }
+    };
+
+}
+
+#endif
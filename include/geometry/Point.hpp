@@ -117,14 +117,16 @@ namespace geometry
     template <typename T, size_t Dimensions>
     Point<T, Dimensions>& Point<T, Dimensions>::operator+=(const Vector<T, Dimensions>& rhs)
     {
-        std::transform(this->begin(), this->end(), rhs.begin(), this->begin(), std::plus<T>());
+        detail::vector_kernels<T, Dimensions>::add(this->data(), rhs.data(), this->data());
+        GEOMETRY_CHECK_NAN(*this, "Point translation");
         return *this;
     }
 
     template <typename T, size_t Dimensions>
     Point<T, Dimensions>& Point<T, Dimensions>::operator-=(const Vector<T, Dimensions>& rhs)
     {
-        std::transform(this->begin(), this->end(), rhs.begin(), this->begin(), std::minus<T>());
+        detail::vector_kernels<T, Dimensions>::subtract(this->data(), rhs.data(), this->data());
+        GEOMETRY_CHECK_NAN(*this, "Point translation");
         return *this;
     }
 
@@ -143,10 +145,11 @@ namespace geometry
     template <typename T, size_t Dimensions>
     Vector<T, Dimensions> Point<T, Dimensions>::operator-(const Point<T, Dimensions>& rhs) const
     {
-        std::array<T, Dimensions> temp;
-        std::transform(this->begin(), this->end(), rhs.begin(), temp.begin(), std::minus<T>());
+        Vector<T, Dimensions> result;
+        detail::vector_kernels<T, Dimensions>::subtract(this->data(), rhs.data(), result.data());
+        GEOMETRY_CHECK_NAN(result, "Point difference");
 
-        return Vector<T, Dimensions>(temp);
+        return result;
     }
 
     template <typename T, size_t Dimensions>
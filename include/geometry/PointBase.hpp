@@ -4,10 +4,12 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <iterator>
 #include <iostream>
 
-#include <Assert.hpp>
+#include <geometry/NanCheck.hpp>
+#include <geometry/VectorKernels.hpp>
 
 namespace geometry
 {
@@ -15,49 +17,45 @@ namespace geometry
     namespace detail
     {
 
+        // Fixed size array of coordinates shared by points and vectors. The components are stored as laid out by
+        // vector_storage, which may pad and align them for the SIMD kernels; only the first Dimensions are visible.
         template <typename T, std::size_t Dimensions>
-        class point_base : private std::array<T, Dimensions>
+        class point_base
         {
             static_assert(Dimensions > 0, "Dimensions must be greater than zero.");
 
         public:
             using container_type = typename std::array<T, Dimensions>;
-
-            using value_type             = typename container_type::value_type;
-            using iterator               = typename container_type::const_iterator;
-            using const_iterator         = typename container_type::const_iterator;
-            using reverse_iterator       = typename container_type::const_reverse_iterator;
-            using const_reverse_iterator = typename container_type::const_reverse_iterator;
-            using size_type              = typename container_type::size_type;
-            using difference_type        = typename container_type::difference_type;
-            using pointer                = typename container_type::const_pointer;
-            using const_pointer          = typename container_type::const_pointer;
-            using reference              = typename container_type::const_reference;
-            using const_reference        = typename container_type::const_reference;
-
-            using container_type::operator[];
-            using container_type::data;
-            using container_type::begin;
-            using container_type::end;
-            using container_type::cbegin;
-            using container_type::cend;
-            using container_type::rbegin;
-            using container_type::rend;
-            using container_type::crbegin;
-            using container_type::crend;
+            using storage_type   = vector_storage<T, Dimensions>;
+
+            using value_type             = T;
+            using iterator               = const T*;
+            using const_iterator         = const T*;
+            using reverse_iterator       = std::reverse_iterator<const T*>;
+            using const_reverse_iterator = std::reverse_iterator<const T*>;
+            using size_type              = std::size_t;
+            using difference_type        = std::ptrdiff_t;
+            using pointer                = const T*;
+            using const_pointer          = const T*;
+            using reference              = const T&;
+            using const_reference        = const T&;
 
             static constexpr size_type dimensions = Dimensions;
 
             point_base() :
-                std::array<T, Dimensions>()
+                m_components()
             {
-                Assert(!isNaN());
+
             }
 
-            point_base(const std::array<T, Dimensions>& components) :
-                std::array<T, Dimensions>(components)
+            point_base(const std::array<T, Dimensions>& components)
             {
-                Assert(!isNaN());
+                for (std::size_t i = 0; i < storage_type::lanes; i++)
+                {
+                    m_components[i] = i < Dimensions ? components[i] : T(0);
+                }
+
+                GEOMETRY_CHECK_NAN(*this, "point_base construction");
             }
 
             constexpr size_type size() const
@@ -65,6 +63,24 @@ namespace geometry
                 return Dimensions;
             }
 
+            T& operator[](size_type index) { return m_components[index]; }
+            const T& operator[](size_type index) const { return m_components[index]; }
+
+            T* data() { return m_components; }
+            const T* data() const { return m_components; }
+
+            T* begin() { return m_components; }
+            T* end() { return m_components + Dimensions; }
+            const T* begin() const { return m_components; }
+            const T* end() const { return m_components + Dimensions; }
+            const T* cbegin() const { return begin(); }
+            const T* cend() const { return end(); }
+
+            const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+            const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+            const_reverse_iterator crbegin() const { return rbegin(); }
+            const_reverse_iterator crend() const { return rend(); }
+
             friend std::ostream& operator<<(std::ostream& os, const point_base<T, Dimensions>& p)
             {
                 os << "(";
@@ -81,6 +97,9 @@ namespace geometry
             {
                 return std::any_of(begin(), end(), [](T x){ return std::isnan(x); });
             }
+
+        private:
+            alignas(storage_type::alignment) T m_components[storage_type::lanes];
         };
 
     }
@@ -1,6 +1,8 @@
 #ifndef RAY_HPP
 #define RAY_HPP
 
+#include <array>
+
 #include <geometry/Point.hpp>
 #include <geometry/Vector.hpp>
 
@@ -13,7 +15,8 @@ namespace geometry
     public:
         Ray(const Point<T, Dimensions>& origin, const Vector<T, Dimensions>& direction) :
             m_origin(origin),
-            m_direction(direction)
+            m_direction(direction),
+            m_inverseDirection(inverse(direction))
         {
 
         }
@@ -28,14 +31,34 @@ namespace geometry
             return m_direction;
         }
 
+        // Reciprocal of each direction component, in double precision whatever T is, for slab tests against
+        // axis aligned boxes. Worked out once per ray, since every box the ray meets needs it.
+        const std::array<double, Dimensions>& inverseDirection() const
+        {
+            return m_inverseDirection;
+        }
+
         Point<T, Dimensions>& operator()(T t) const
         {
             return m_origin + m_direction * t;
         }
 
     private:
+        static std::array<double, Dimensions> inverse(const Vector<T, Dimensions>& direction)
+        {
+            std::array<double, Dimensions> result;
+
+            for (size_t axis = 0; axis < Dimensions; axis++)
+            {
+                result[axis] = 1.0 / double(direction[axis]);
+            }
+
+            return result;
+        }
+
         Point<T, Dimensions> m_origin;
         Vector<T, Dimensions> m_direction;
+        std::array<double, Dimensions> m_inverseDirection;
     };
 
     using Ray2 = Ray<geo_type, 2>;
@@ -0,0 +1,112 @@
+#ifndef RAY_PACKET_HPP
+#define RAY_PACKET_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include <geometry/Ray.hpp>
+
+namespace geometry
+{
+
+    // Rays traced together, stored component by component so that a loop over the lanes compiles to vector
+    // instructions. Kernels may run over every lane: lanes past count() repeat the last ray in use, and their
+    // results are ignored.
+    template <typename T, std::size_t Width>
+    struct RayPacket
+    {
+        static constexpr std::size_t width()
+        {
+            return Width;
+        }
+
+        // Each row is aligned to the vector registers it fills, up to a cache line
+        alignas(std::min<std::size_t>(sizeof(T) * Width, 64)) T origin[3][Width];
+        alignas(std::min<std::size_t>(sizeof(T) * Width, 64)) T direction[3][Width];
+
+        // In double precision whatever T is, as used by the bounding volume hierarchy
+        alignas(std::min<std::size_t>(sizeof(double) * Width, 64)) double inverseDirection[3][Width];
+
+        std::size_t count = 0;
+
+        Ray<T, 3> ray(std::size_t lane) const
+        {
+            return Ray<T, 3>(Point3t<T>(origin[0][lane], origin[1][lane], origin[2][lane]),
+                    Vector3t<T>(direction[0][lane], direction[1][lane], direction[2][lane]));
+        }
+
+        // Appends a ray; the packet must not be full
+        void push(const Ray<T, 3>& ray)
+        {
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                origin[axis][count] = ray.origin()[axis];
+                direction[axis][count] = ray.direction()[axis];
+                inverseDirection[axis][count] = ray.inverseDirection()[axis];
+            }
+
+            count++;
+        }
+
+        bool full() const
+        {
+            return count == Width;
+        }
+
+        void clear()
+        {
+            count = 0;
+        }
+
+        // Copies the last ray in use into the remaining lanes
+        void pad()
+        {
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                for (std::size_t lane = count; lane < Width; lane++)
+                {
+                    origin[axis][lane] = origin[axis][count - 1];
+                    direction[axis][lane] = direction[axis][count - 1];
+                    inverseDirection[axis][lane] = inverseDirection[axis][count - 1];
+                }
+            }
+        }
+
+        // Rays from one origin whose directions all point into the same octant, away from the axis planes. Only
+        // such packets have a frustum that bounds them tightly; anything else is better traced ray by ray.
+        bool isCoherent() const
+        {
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                bool negative = direction[axis][0] < 0;
+
+                for (std::size_t lane = 0; lane < count; lane++)
+                {
+                    if (origin[axis][lane] != origin[axis][0] || !(direction[axis][lane] != 0) || (direction[axis][lane] < 0) != negative)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+    };
+
+    // Lanes taking part in an operation on a packet
+    template <std::size_t Width>
+    using PacketMask = std::array<bool, Width>;
+
+    // One AVX register of geo_type, or two SSE registers
+    constexpr std::size_t packetWidth()
+    {
+        return sizeof(geo_type) == sizeof(float) ? 8 : 4;
+    }
+
+    using RayPacket3 = RayPacket<geo_type, packetWidth()>;
+    using PacketMask3 = PacketMask<packetWidth()>;
+
+}
+
+#endif
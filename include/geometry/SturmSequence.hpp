@@ -0,0 +1,291 @@
+#ifndef GEOMETRY_STURM_SEQUENCE_HPP
+#define GEOMETRY_STURM_SEQUENCE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace geometry
+{
+
+    // Sturm sequence of a polynomial: the polynomial, its derivative and the negated remainders of dividing each
+    // member by the next. The number of distinct real roots in an interval is the difference between the number
+    // of sign changes along the sequence at its two ends, which lets roots be bracketed one at a time by bisection
+    // and then polished with Newton steps, without any starting guess.
+    template <std::size_t Degree>
+    class SturmSequence
+    {
+    public:
+        using Coefficients = std::array<double, Degree + 1>;
+
+        // Coefficients from the constant term up
+        explicit SturmSequence(const Coefficients& coefficients) :
+            m_polynomials(),
+            m_degrees(),
+            m_count(0)
+        {
+            m_polynomials[0] = coefficients;
+            m_degrees[0] = Degree;
+
+            if (!normalize(0, 0.0))
+            {
+                return;
+            }
+
+            m_count = 1;
+
+            if (m_degrees[0] == 0)
+            {
+                return;
+            }
+
+            for (std::size_t i = 1; i <= m_degrees[0]; i++)
+            {
+                m_polynomials[1][i - 1] = double(i) * m_polynomials[0][i];
+            }
+
+            m_degrees[1] = m_degrees[0] - 1;
+            normalize(1, 0.0);
+            m_count = 2;
+
+            while (m_count <= Degree && m_degrees[m_count - 1] > 0)
+            {
+                double scale = remainder(m_count);
+
+                if (!normalize(m_count, scale))
+                {
+                    // The previous member divides the one before it, so it is the greatest common divisor of the
+                    // polynomial and its derivative. The sequence still counts distinct roots correctly.
+                    break;
+                }
+
+                m_count++;
+            }
+        }
+
+        // Number of distinct real roots in (lower, upper]
+        int rootCount(double lower, double upper) const
+        {
+            return signChanges(lower) - signChanges(upper);
+        }
+
+        // Smallest root in (lower, upper]. Returns false if there is none.
+        bool smallestRoot(double lower, double upper, double& root) const
+        {
+            int lowerChanges = signChanges(lower);
+            int upperChanges = signChanges(upper);
+
+            if (lowerChanges - upperChanges <= 0)
+            {
+                return false;
+            }
+
+            // Halve the interval, keeping the lower half whenever it has a root, until a single root is left
+            for (int i = 0; i < 64 && lowerChanges - upperChanges > 1; i++)
+            {
+                double middle = 0.5 * (lower + upper);
+                int middleChanges = signChanges(middle);
+
+                if (lowerChanges - middleChanges > 0)
+                {
+                    upper = middle;
+                    upperChanges = middleChanges;
+                }
+                else
+                {
+                    lower = middle;
+                    lowerChanges = middleChanges;
+                }
+            }
+
+            root = polish(lower, upper, lowerChanges);
+            return true;
+        }
+
+    private:
+        std::array<Coefficients, Degree + 1> m_polynomials;
+        std::array<std::size_t, Degree + 1> m_degrees;
+        std::size_t m_count;
+
+        static double evaluate(const Coefficients& polynomial, std::size_t degree, double x)
+        {
+            double value = polynomial[degree];
+
+            for (std::size_t i = degree; i > 0; i--)
+            {
+                value = value * x + polynomial[i - 1];
+            }
+
+            return value;
+        }
+
+        int signChanges(double x) const
+        {
+            int changes = 0;
+            double previous = 0.0;
+
+            for (std::size_t k = 0; k < m_count; k++)
+            {
+                double value = evaluate(m_polynomials[k], m_degrees[k], x);
+
+                if (value != 0.0)
+                {
+                    changes += (previous < 0.0 && value > 0.0) || (previous > 0.0 && value < 0.0);
+                    previous = value;
+                }
+            }
+
+            return changes;
+        }
+
+        // Drops leading coefficients that are only rounding residue, relative to the polynomial's own coefficients
+        // or to the given scale if that is larger, and scales the polynomial so that its leading coefficient is +1
+        // or -1, which keeps the signs the sequence depends on. Returns false for a polynomial that is zero.
+        bool normalize(std::size_t k, double scale)
+        {
+            Coefficients& polynomial = m_polynomials[k];
+            double largest = scale;
+
+            for (std::size_t i = 0; i <= m_degrees[k]; i++)
+            {
+                largest = std::max(largest, std::abs(polynomial[i]));
+            }
+
+            while (m_degrees[k] > 0 && std::abs(polynomial[m_degrees[k]]) <= 1e-12 * largest)
+            {
+                m_degrees[k]--;
+            }
+
+            double leading = std::abs(polynomial[m_degrees[k]]);
+
+            if (!(leading > 1e-12 * largest))
+            {
+                return false;
+            }
+
+            for (std::size_t i = 0; i <= m_degrees[k]; i++)
+            {
+                polynomial[i] /= leading;
+            }
+
+            return true;
+        }
+
+        // Member k is minus the remainder of dividing member k - 2 by member k - 1. Returns the size of the
+        // largest coefficient of the dividend, against which the remainder's coefficients are rounding residue.
+        double remainder(std::size_t k)
+        {
+            Coefficients dividend = m_polynomials[k - 2];
+            const Coefficients& divisor = m_polynomials[k - 1];
+            std::size_t divisorDegree = m_degrees[k - 1];
+            double scale = 0.0;
+
+            for (std::size_t i = 0; i <= m_degrees[k - 2]; i++)
+            {
+                scale = std::max(scale, std::abs(dividend[i]));
+            }
+
+            for (std::size_t shift = m_degrees[k - 2] - divisorDegree + 1; shift-- > 0;)
+            {
+                double quotient = dividend[shift + divisorDegree] / divisor[divisorDegree];
+
+                for (std::size_t i = 0; i <= divisorDegree; i++)
+                {
+                    dividend[shift + i] -= quotient * divisor[i];
+                }
+            }
+
+            m_degrees[k] = divisorDegree - 1;
+            m_polynomials[k].fill(0.0);
+
+            for (std::size_t i = 0; i < divisorDegree; i++)
+            {
+                m_polynomials[k][i] = -dividend[i];
+            }
+
+            return scale;
+        }
+
+        // The single root in (lower, upper]. Newton steps are taken while they stay within the bracket and bisection
+        // otherwise; a root of even multiplicity, where the polynomial keeps its sign, is found by bisecting on the
+        // sign changes of the sequence instead.
+        double polish(double lower, double upper, int lowerChanges) const
+        {
+            const Coefficients& p = m_polynomials[0];
+            std::size_t degree = m_degrees[0];
+            double lowerValue = evaluate(p, degree, lower);
+            double upperValue = evaluate(p, degree, upper);
+
+            if (upperValue == 0.0)
+            {
+                return upper;
+            }
+
+            if ((lowerValue < 0.0) == (upperValue < 0.0))
+            {
+                for (int i = 0; i < 64 && upper - lower > 1e-15 * std::max(1.0, std::abs(upper)); i++)
+                {
+                    double middle = 0.5 * (lower + upper);
+
+                    if (lowerChanges - signChanges(middle) > 0)
+                    {
+                        upper = middle;
+                    }
+                    else
+                    {
+                        lower = middle;
+                    }
+                }
+
+                return 0.5 * (lower + upper);
+            }
+
+            double x = 0.5 * (lower + upper);
+
+            for (int i = 0; i < 64; i++)
+            {
+                double value = evaluate(p, degree, x);
+                double slope = 0.0;
+
+                for (std::size_t j = degree; j > 0; j--)
+                {
+                    slope = slope * x + double(j) * p[j];
+                }
+
+                if (value == 0.0)
+                {
+                    return x;
+                }
+
+                if ((value < 0.0) == (lowerValue < 0.0))
+                {
+                    lower = x;
+                }
+                else
+                {
+                    upper = x;
+                }
+
+                double next = x - value / slope;
+
+                if (!(next > lower && next < upper))
+                {
+                    next = 0.5 * (lower + upper);
+                }
+
+                if (std::abs(next - x) <= 1e-15 * std::max(1.0, std::abs(x)))
+                {
+                    return next;
+                }
+
+                x = next;
+            }
+
+            return x;
+        }
+    };
+
+}
+
+#endif
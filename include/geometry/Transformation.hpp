@@ -23,6 +23,11 @@ namespace geometry
         Vector<T, Dimensions> operator*(const Vector<T, Dimensions>& rhs) const;
         Point<T, Dimensions> operator*(const Point<T, Dimensions>& rhs) const;
 
+        T operator()(std::size_t row, std::size_t column) const
+        {
+            return m_data[row][column];
+        }
+
         friend Transformation<T, Dimensions> transpose(const Transformation<T, Dimensions>& src)
         {
             Transformation<T, Dimensions> result;
@@ -42,6 +47,83 @@ namespace geometry
         std::array<Vector<T, Dimensions>, Dimensions> m_data;
     };
 
+    template <typename T>
+    T determinant(const Transformation<T, 3ul>& m)
+    {
+        return m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) -
+               m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0)) +
+               m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+    }
+
+    // Inverse by cofactors; the transformation must not be singular
+    template <typename T>
+    Transformation<T, 3ul> inverse(const Transformation<T, 3ul>& m)
+    {
+        T r = 1 / determinant(m);
+
+        return Transformation<T, 3ul>{
+            {(m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) * r, (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)) * r, (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)) * r},
+            {(m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2)) * r, (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)) * r, (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)) * r},
+            {(m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0)) * r, (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)) * r, (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)) * r}
+        };
+    }
+
+    // Affine map of three dimensional space, a linear transformation followed by a translation: the 4x4 matrix
+    // whose top three rows are [linear | translation] and whose last row is [0 0 0 1]
+    template <typename T>
+    class AffineTransformation
+    {
+    public:
+        AffineTransformation(const Transformation<T, 3ul>& linear, const Vector<T, 3ul>& translation) :
+            m_linear(linear),
+            m_translation(translation)
+        {
+
+        }
+
+        static AffineTransformation<T> identity()
+        {
+            return AffineTransformation<T>(Transformation<T, 3ul>{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, Vector<T, 3ul>({0, 0, 0}));
+        }
+
+        // The transformation that applies rhs first and then this one
+        AffineTransformation<T> operator*(const AffineTransformation<T>& rhs) const
+        {
+            return AffineTransformation<T>(m_linear * rhs.m_linear, m_linear * rhs.m_translation + m_translation);
+        }
+
+        Point<T, 3ul> operator*(const Point<T, 3ul>& rhs) const
+        {
+            return m_linear * rhs + m_translation;
+        }
+
+        // Directions are not translated
+        Vector<T, 3ul> operator*(const Vector<T, 3ul>& rhs) const
+        {
+            return m_linear * rhs;
+        }
+
+        const Transformation<T, 3ul>& linear() const
+        {
+            return m_linear;
+        }
+
+        const Vector<T, 3ul>& translation() const
+        {
+            return m_translation;
+        }
+
+        friend AffineTransformation<T> inverse(const AffineTransformation<T>& src)
+        {
+            Transformation<T, 3ul> linear = inverse(src.m_linear);
+            return AffineTransformation<T>(linear, -(linear * src.m_translation));
+        }
+
+    private:
+        Transformation<T, 3ul> m_linear;
+        Vector<T, 3ul> m_translation;
+    };
+
     //template <typename T, std::size_t Dimensions>
     template <typename T>
     Transformation<T, 3ul> rotation(T alpha, T beta, T gamma)
@@ -137,7 +219,7 @@ namespace geometry
         Vector<T, Dimensions> result;
 
         for (std::size_t row = 0; row < Dimensions; row++) {
-            result.m_data[row] = m_data[row] * rhs;
+            result[row] = static_cast<Vector<T, Dimensions>>(m_data[row]) * rhs;
         }
 
         return result;
@@ -10,7 +10,12 @@
 namespace geometry
 {
 
+    // Precision of all scene geometry, double unless the build defines GEOMETRY_FLOAT
+#ifdef GEOMETRY_FLOAT
+    typedef float geo_type;
+#else
     typedef double geo_type;
+#endif
 
     template <typename T, size_t Dimensions>
     class Vector : public detail::point_base<T, Dimensions>
@@ -135,36 +140,41 @@ namespace geometry
     template <typename T, size_t Dimensions>
     Vector<T, Dimensions> Vector<T, Dimensions>::operator-() const
     {
-        Vector<T, Dimensions> result = *this;
-        std::transform(result.begin(), result.end(), result.begin(), std::negate<T>());
+        Vector<T, Dimensions> result;
+        detail::vector_kernels<T, Dimensions>::negate(this->data(), result.data());
+        GEOMETRY_CHECK_NAN(result, "Vector negation");
         return result;
     }
 
     template <typename T, size_t Dimensions>
     Vector<T, Dimensions>& Vector<T, Dimensions>::operator+=(const Vector<T, Dimensions>& rhs)
     {
-        std::transform(this->begin(), this->end(), rhs.begin(), this->begin(), std::plus<T>());
+        detail::vector_kernels<T, Dimensions>::add(this->data(), rhs.data(), this->data());
+        GEOMETRY_CHECK_NAN(*this, "Vector addition");
         return *this;
     }
 
     template <typename T, size_t Dimensions>
     Vector<T, Dimensions>& Vector<T, Dimensions>::operator-=(const Vector<T, Dimensions>& rhs)
     {
-        std::transform(this->begin(), this->end(), rhs.begin(), this->begin(), std::minus<T>());
+        detail::vector_kernels<T, Dimensions>::subtract(this->data(), rhs.data(), this->data());
+        GEOMETRY_CHECK_NAN(*this, "Vector subtraction");
         return *this;
     }
 
     template <typename T, size_t Dimensions>
     Vector<T, Dimensions>& Vector<T, Dimensions>::operator*=(T rhs)
     {
-        std::transform(this->begin(), this->end(), this->begin(), [=](T lhs) { return lhs * rhs; });
+        detail::vector_kernels<T, Dimensions>::scale(this->data(), rhs, this->data());
+        GEOMETRY_CHECK_NAN(*this, "Vector scaling");
         return *this;
     }
 
     template <typename T, size_t Dimensions>
     Vector<T, Dimensions>& Vector<T, Dimensions>::operator/=(T rhs)
     {
-        std::transform(this->begin(), this->end(), this->begin(), [=](T lhs) { return lhs / rhs; });
+        detail::vector_kernels<T, Dimensions>::divide(this->data(), rhs, this->data());
+        GEOMETRY_CHECK_NAN(*this, "Vector division");
         return *this;
     }
 
@@ -195,7 +205,9 @@ namespace geometry
     template <typename T, size_t Dimensions>
     T Vector<T, Dimensions>::operator*(const Vector<T, Dimensions>& rhs) const
     {
-        return std::inner_product(this->begin(), this->end(), rhs.begin(), 0.0);
+        T result = detail::vector_kernels<T, Dimensions>::dot(this->data(), rhs.data());
+        GEOMETRY_CHECK_NAN_SCALAR(result, "Vector dot product");
+        return result;
     }
 
     template <typename T, size_t Dimensions>
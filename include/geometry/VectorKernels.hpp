@@ -0,0 +1,312 @@
+#ifndef VECTOR_KERNELS_HPP
+#define VECTOR_KERNELS_HPP
+
+#include <cstddef>
+
+// GEOMETRY_SIMD selects the SSE/AVX kernels below for three and four component points and vectors. It is only
+// honoured when the compiler targets SSE2 or better.
+#if defined(GEOMETRY_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define GEOMETRY_SIMD_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace geometry
+{
+
+    namespace detail
+    {
+
+        // Memory layout of a point or vector: the number of components allocated and their alignment. Components
+        // past Dimensions are padding; they start at zero but are otherwise unspecified and never read back.
+        template <typename T, std::size_t Dimensions>
+        struct vector_storage
+        {
+            static constexpr std::size_t lanes = Dimensions;
+            static constexpr std::size_t alignment = alignof(T);
+        };
+
+        template <typename T>
+        inline void scalar_cross(const T* lhs, const T* rhs, T* result)
+        {
+            T x = lhs[1] * rhs[2] - lhs[2] * rhs[1];
+            T y = lhs[2] * rhs[0] - lhs[0] * rhs[2];
+            T z = lhs[0] * rhs[1] - lhs[1] * rhs[0];
+
+            result[0] = x;
+            result[1] = y;
+            result[2] = z;
+        }
+
+        // Component-wise arithmetic on the storage of points and vectors. Every operation reads and writes whole
+        // storage, so the output may alias either input.
+        template <typename T, std::size_t Dimensions>
+        struct vector_kernels
+        {
+            static void add(const T* lhs, const T* rhs, T* result)
+            {
+                for (std::size_t i = 0; i < Dimensions; i++)
+                {
+                    result[i] = lhs[i] + rhs[i];
+                }
+            }
+
+            static void subtract(const T* lhs, const T* rhs, T* result)
+            {
+                for (std::size_t i = 0; i < Dimensions; i++)
+                {
+                    result[i] = lhs[i] - rhs[i];
+                }
+            }
+
+            static void negate(const T* v, T* result)
+            {
+                for (std::size_t i = 0; i < Dimensions; i++)
+                {
+                    result[i] = -v[i];
+                }
+            }
+
+            static void scale(const T* v, T s, T* result)
+            {
+                for (std::size_t i = 0; i < Dimensions; i++)
+                {
+                    result[i] = v[i] * s;
+                }
+            }
+
+            static void divide(const T* v, T s, T* result)
+            {
+                for (std::size_t i = 0; i < Dimensions; i++)
+                {
+                    result[i] = v[i] / s;
+                }
+            }
+
+            static T dot(const T* lhs, const T* rhs)
+            {
+                T sum = T(0);
+
+                for (std::size_t i = 0; i < Dimensions; i++)
+                {
+                    sum += lhs[i] * rhs[i];
+                }
+
+                return sum;
+            }
+
+            static void cross(const T* lhs, const T* rhs, T* result)
+            {
+                scalar_cross(lhs, rhs, result);
+            }
+        };
+
+#ifdef GEOMETRY_SIMD_KERNELS
+
+        // Three component vectors are padded to four so that they fill a register. Alignment stays at 16 bytes
+        // even for doubles, since C++14 allocators do not honour anything stricter; the AVX kernels use unaligned
+        // loads, which cost nothing extra on aligned data.
+        template <std::size_t Dimensions>
+        struct packed_storage
+        {
+            static_assert(Dimensions == 3 || Dimensions == 4, "Only three and four component vectors are packed.");
+
+            static constexpr std::size_t lanes = 4;
+            static constexpr std::size_t alignment = 16;
+        };
+
+        template <> struct vector_storage<float, 3>  : public packed_storage<3> { };
+        template <> struct vector_storage<float, 4>  : public packed_storage<4> { };
+        template <> struct vector_storage<double, 3> : public packed_storage<3> { };
+        template <> struct vector_storage<double, 4> : public packed_storage<4> { };
+
+        // Sums are taken in the same order as the scalar kernels, so double precision results are bit for bit the
+        // same. The padding component is left out of every reduction, so it cannot leak infinities or NaNs.
+        template <std::size_t Dimensions>
+        struct packed_float_kernels
+        {
+            static void add(const float* lhs, const float* rhs, float* result)
+            {
+                _mm_store_ps(result, _mm_add_ps(_mm_load_ps(lhs), _mm_load_ps(rhs)));
+            }
+
+            static void subtract(const float* lhs, const float* rhs, float* result)
+            {
+                _mm_store_ps(result, _mm_sub_ps(_mm_load_ps(lhs), _mm_load_ps(rhs)));
+            }
+
+            static void negate(const float* v, float* result)
+            {
+                _mm_store_ps(result, _mm_xor_ps(_mm_load_ps(v), _mm_set1_ps(-0.0f)));
+            }
+
+            static void scale(const float* v, float s, float* result)
+            {
+                _mm_store_ps(result, _mm_mul_ps(_mm_load_ps(v), _mm_set1_ps(s)));
+            }
+
+            static void divide(const float* v, float s, float* result)
+            {
+                _mm_store_ps(result, _mm_div_ps(_mm_load_ps(v), _mm_set1_ps(s)));
+            }
+
+            static float dot(const float* lhs, const float* rhs)
+            {
+                __m128 products = _mm_mul_ps(_mm_load_ps(lhs), _mm_load_ps(rhs));
+                __m128 sum = _mm_add_ss(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1)));
+                sum = _mm_add_ss(sum, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 2, 2, 2)));
+
+                if (Dimensions == 4)
+                {
+                    sum = _mm_add_ss(sum, _mm_shuffle_ps(products, products, _MM_SHUFFLE(3, 3, 3, 3)));
+                }
+
+                return _mm_cvtss_f32(sum);
+            }
+
+            static void cross(const float* lhs, const float* rhs, float* result)
+            {
+                __m128 a = _mm_load_ps(lhs);
+                __m128 b = _mm_load_ps(rhs);
+                __m128 ayzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+                __m128 azxy = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+                __m128 byzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+                __m128 bzxy = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+
+                _mm_store_ps(result, _mm_sub_ps(_mm_mul_ps(ayzx, bzxy), _mm_mul_ps(azxy, byzx)));
+            }
+        };
+
+#ifdef __AVX__
+        template <std::size_t Dimensions>
+        struct packed_double_kernels
+        {
+            static void add(const double* lhs, const double* rhs, double* result)
+            {
+                _mm256_storeu_pd(result, _mm256_add_pd(_mm256_loadu_pd(lhs), _mm256_loadu_pd(rhs)));
+            }
+
+            static void subtract(const double* lhs, const double* rhs, double* result)
+            {
+                _mm256_storeu_pd(result, _mm256_sub_pd(_mm256_loadu_pd(lhs), _mm256_loadu_pd(rhs)));
+            }
+
+            static void negate(const double* v, double* result)
+            {
+                _mm256_storeu_pd(result, _mm256_xor_pd(_mm256_loadu_pd(v), _mm256_set1_pd(-0.0)));
+            }
+
+            static void scale(const double* v, double s, double* result)
+            {
+                _mm256_storeu_pd(result, _mm256_mul_pd(_mm256_loadu_pd(v), _mm256_set1_pd(s)));
+            }
+
+            static void divide(const double* v, double s, double* result)
+            {
+                _mm256_storeu_pd(result, _mm256_div_pd(_mm256_loadu_pd(v), _mm256_set1_pd(s)));
+            }
+
+            static double dot(const double* lhs, const double* rhs)
+            {
+                __m256d products = _mm256_mul_pd(_mm256_loadu_pd(lhs), _mm256_loadu_pd(rhs));
+                __m128d xy = _mm256_castpd256_pd128(products);
+                __m128d zw = _mm256_extractf128_pd(products, 1);
+                __m128d sum = _mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), zw);
+
+                if (Dimensions == 4)
+                {
+                    sum = _mm_add_sd(sum, _mm_unpackhi_pd(zw, zw));
+                }
+
+                return _mm_cvtsd_f64(sum);
+            }
+
+#ifdef __AVX2__
+            static void cross(const double* lhs, const double* rhs, double* result)
+            {
+                __m256d a = _mm256_loadu_pd(lhs);
+                __m256d b = _mm256_loadu_pd(rhs);
+                __m256d ayzx = _mm256_permute4x64_pd(a, _MM_SHUFFLE(3, 0, 2, 1));
+                __m256d azxy = _mm256_permute4x64_pd(a, _MM_SHUFFLE(3, 1, 0, 2));
+                __m256d byzx = _mm256_permute4x64_pd(b, _MM_SHUFFLE(3, 0, 2, 1));
+                __m256d bzxy = _mm256_permute4x64_pd(b, _MM_SHUFFLE(3, 1, 0, 2));
+
+                _mm256_storeu_pd(result, _mm256_sub_pd(_mm256_mul_pd(ayzx, bzxy), _mm256_mul_pd(azxy, byzx)));
+            }
+#else
+            static void cross(const double* lhs, const double* rhs, double* result)
+            {
+                scalar_cross(lhs, rhs, result);
+            }
+#endif
+        };
+#else
+        // SSE2 only: each vector is handled as two pairs of components
+        template <std::size_t Dimensions>
+        struct packed_double_kernels
+        {
+            static void add(const double* lhs, const double* rhs, double* result)
+            {
+                _mm_store_pd(result, _mm_add_pd(_mm_load_pd(lhs), _mm_load_pd(rhs)));
+                _mm_store_pd(result + 2, _mm_add_pd(_mm_load_pd(lhs + 2), _mm_load_pd(rhs + 2)));
+            }
+
+            static void subtract(const double* lhs, const double* rhs, double* result)
+            {
+                _mm_store_pd(result, _mm_sub_pd(_mm_load_pd(lhs), _mm_load_pd(rhs)));
+                _mm_store_pd(result + 2, _mm_sub_pd(_mm_load_pd(lhs + 2), _mm_load_pd(rhs + 2)));
+            }
+
+            static void negate(const double* v, double* result)
+            {
+                __m128d sign = _mm_set1_pd(-0.0);
+                _mm_store_pd(result, _mm_xor_pd(_mm_load_pd(v), sign));
+                _mm_store_pd(result + 2, _mm_xor_pd(_mm_load_pd(v + 2), sign));
+            }
+
+            static void scale(const double* v, double s, double* result)
+            {
+                __m128d factor = _mm_set1_pd(s);
+                _mm_store_pd(result, _mm_mul_pd(_mm_load_pd(v), factor));
+                _mm_store_pd(result + 2, _mm_mul_pd(_mm_load_pd(v + 2), factor));
+            }
+
+            static void divide(const double* v, double s, double* result)
+            {
+                __m128d divisor = _mm_set1_pd(s);
+                _mm_store_pd(result, _mm_div_pd(_mm_load_pd(v), divisor));
+                _mm_store_pd(result + 2, _mm_div_pd(_mm_load_pd(v + 2), divisor));
+            }
+
+            static double dot(const double* lhs, const double* rhs)
+            {
+                __m128d xy = _mm_mul_pd(_mm_load_pd(lhs), _mm_load_pd(rhs));
+                __m128d zw = _mm_mul_pd(_mm_load_pd(lhs + 2), _mm_load_pd(rhs + 2));
+                __m128d sum = _mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), zw);
+
+                if (Dimensions == 4)
+                {
+                    sum = _mm_add_sd(sum, _mm_unpackhi_pd(zw, zw));
+                }
+
+                return _mm_cvtsd_f64(sum);
+            }
+
+            static void cross(const double* lhs, const double* rhs, double* result)
+            {
+                scalar_cross(lhs, rhs, result);
+            }
+        };
+#endif
+
+        template <> struct vector_kernels<float, 3>  : public packed_float_kernels<3> { };
+        template <> struct vector_kernels<float, 4>  : public packed_float_kernels<4> { };
+        template <> struct vector_kernels<double, 3> : public packed_double_kernels<3> { };
+        template <> struct vector_kernels<double, 4> : public packed_double_kernels<4> { };
+
+#endif
+
+    }
+
+}
+
+#endif
@@ -9,11 +9,10 @@ namespace geometry
     template <typename T>
     inline Vector<T, 3> cross_product(const Vector<T, 3>& lhs, const Vector<T, 3>& rhs)
     {
-        return Vector<T, 3>(std::array<T, 3>({
-            lhs[1] * rhs[2] - lhs[2] * rhs[1],
-            lhs[2] * rhs[0] - lhs[0] * rhs[2],
-            lhs[0] * rhs[1] - lhs[1] * rhs[0]
-        }));
+        Vector<T, 3> result;
+        detail::vector_kernels<T, 3>::cross(lhs.data(), rhs.data(), result.data());
+        GEOMETRY_CHECK_NAN(result, "cross product");
+        return result;
     }
 
     template <typename T, size_t Dimensions>
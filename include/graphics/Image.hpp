@@ -7,8 +7,10 @@
 #include <iterator>
 #include <memory>
 #include <random>
+#include <vector>
 
 #include <graphics/Colour.hpp>
+#include <graphics/PngWriter.hpp>
 
 namespace graphics
 {
@@ -199,6 +201,7 @@ namespace graphics
         PixelType* data() { return m_imageData.get(); }
         const PixelType* data() const { return m_imageData.get(); }
 
+        // Writes the image as a PNG, whatever the extension of fileName
         void save(const std::string& fileName) const;
 
     private:
@@ -215,23 +218,17 @@ namespace graphics
     template <typename PixelType>
     inline void Image<PixelType>::save(const std::string& fileName) const
     {
-        sf::Image outputImage;
-        outputImage.create(m_width, m_height);
-
-        size_t rowNumber = 0;
+        std::vector<std::uint8_t> rgb;
+        rgb.reserve(3 * m_width * m_height);
 
         for (auto row : *this) {
-            size_t colNumber = 0;
-
             for (auto& pixel : row) {
-                outputImage.setPixel(colNumber, rowNumber, colour_cast<sf::Color>(pixel));
-                colNumber++;
+                auto colour = colour_cast<ColourRgb<std::uint8_t>>(pixel);
+                rgb.insert(rgb.end(), {colour.red(), colour.green(), colour.blue()});
             }
-
-            rowNumber++;
         }
 
-        outputImage.saveToFile(fileName);
+        writePng(fileName, m_width, m_height, rgb);
     }
 
     template <typename PixelType>
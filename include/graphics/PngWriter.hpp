@@ -0,0 +1,134 @@
+#ifndef PNGWRITER_HPP
+#define PNGWRITER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace graphics
+{
+
+    namespace priv
+    {
+
+        inline const std::array<std::uint32_t, 256>& crcTable()
+        {
+            static const std::array<std::uint32_t, 256> table = []() {
+                std::array<std::uint32_t, 256> result{};
+
+                for (std::uint32_t n = 0; n < 256; n++) {
+                    std::uint32_t c = n;
+
+                    for (int k = 0; k < 8; k++) {
+                        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                    }
+
+                    result[n] = c;
+                }
+
+                return result;
+            }();
+
+            return table;
+        }
+
+        inline void appendBigEndian(std::vector<std::uint8_t>& out, std::uint32_t value)
+        {
+            out.push_back(std::uint8_t(value >> 24));
+            out.push_back(std::uint8_t(value >> 16));
+            out.push_back(std::uint8_t(value >> 8));
+            out.push_back(std::uint8_t(value));
+        }
+
+        inline void appendChunk(std::vector<std::uint8_t>& out, const char* type, const std::vector<std::uint8_t>& data)
+        {
+            appendBigEndian(out, std::uint32_t(data.size()));
+
+            std::size_t start = out.size();
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), data.begin(), data.end());
+
+            std::uint32_t crc = 0xffffffffu;
+
+            for (std::size_t i = start; i < out.size(); i++) {
+                crc = crcTable()[(crc ^ out[i]) & 0xff] ^ (crc >> 8);
+            }
+
+            appendBigEndian(out, crc ^ 0xffffffffu);
+        }
+
+        // Wraps data in a zlib stream of stored deflate blocks. Nothing is compressed, which keeps the writer free
+        // of a zlib dependency at the cost of file size.
+        inline std::vector<std::uint8_t> zlibStore(const std::vector<std::uint8_t>& data)
+        {
+            const std::size_t maxBlock = 65535;
+
+            std::vector<std::uint8_t> out = {0x78, 0x01};
+            out.reserve(data.size() + (data.size() / maxBlock + 1) * 5 + 6);
+
+            std::size_t offset = 0;
+
+            do {
+                std::size_t length = std::min(maxBlock, data.size() - offset);
+                bool last = offset + length == data.size();
+
+                out.push_back(last ? 1 : 0);
+                out.push_back(std::uint8_t(length));
+                out.push_back(std::uint8_t(length >> 8));
+                out.push_back(std::uint8_t(~length));
+                out.push_back(std::uint8_t(~length >> 8));
+                out.insert(out.end(), data.begin() + offset, data.begin() + offset + length);
+
+                offset += length;
+            } while (offset < data.size());
+
+            std::uint32_t a = 1;
+            std::uint32_t b = 0;
+
+            for (std::uint8_t byte : data) {
+                a = (a + byte) % 65521;
+                b = (b + a) % 65521;
+            }
+
+            appendBigEndian(out, (b << 16) | a);
+
+            return out;
+        }
+
+    }
+
+    // Writes 8 bit RGB pixels, stored row by row without padding, to an uncompressed PNG file. Returns false if the
+    // file could not be written.
+    inline bool writePng(const std::string& fileName, std::size_t width, std::size_t height, const std::vector<std::uint8_t>& rgb)
+    {
+        std::vector<std::uint8_t> header;
+        priv::appendBigEndian(header, std::uint32_t(width));
+        priv::appendBigEndian(header, std::uint32_t(height));
+        header.insert(header.end(), {8, 2, 0, 0, 0});
+
+        // Every row starts with filter type 0, leaving its bytes as they are
+        std::vector<std::uint8_t> rows;
+        rows.reserve((3 * width + 1) * height);
+
+        for (std::size_t y = 0; y < height; y++) {
+            rows.push_back(0);
+            rows.insert(rows.end(), rgb.begin() + 3 * width * y, rgb.begin() + 3 * width * (y + 1));
+        }
+
+        std::vector<std::uint8_t> file = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        priv::appendChunk(file, "IHDR", header);
+        priv::appendChunk(file, "IDAT", priv::zlibStore(rows));
+        priv::appendChunk(file, "IEND", {});
+
+        std::ofstream stream(fileName, std::ios::binary);
+        stream.write(reinterpret_cast<const char*>(file.data()), file.size());
+
+        return bool(stream);
+    }
+
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef SAMPLING_BLUE_NOISE_SAMPLER_HPP
+#define SAMPLING_BLUE_NOISE_SAMPLER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <sampling/Sampler.hpp>
+
+namespace sampling
+{
+
+    // Tileable blue noise threshold mask, built once with the void and cluster method (Ulichney 1993): neighbouring
+    // texels hold values that are as different as possible, so errors that follow the mask look like fine grain
+    // rather than clumps.
+    class BlueNoiseMask
+    {
+    public:
+        static constexpr std::size_t sm_size = 64;
+
+        static const BlueNoiseMask& instance()
+        {
+            static const BlueNoiseMask mask;
+            return mask;
+        }
+
+        // Value in (0, 1) at the given texel, wrapping around the edges
+        double value(std::uint32_t x, std::uint32_t y) const
+        {
+            return m_values[(y % sm_size) * sm_size + x % sm_size];
+        }
+
+    private:
+        static constexpr std::size_t sm_texels = sm_size * sm_size;
+        static constexpr double sm_sigma = 1.5;
+
+        BlueNoiseMask() :
+            m_values(sm_texels)
+        {
+            // Gaussian energy of a point as seen from every offset, with toroidal wrap
+            std::vector<float> kernel(sm_texels);
+
+            for (std::size_t dy = 0; dy < sm_size; dy++)
+            {
+                for (std::size_t dx = 0; dx < sm_size; dx++)
+                {
+                    double x = double(std::min(dx, sm_size - dx));
+                    double y = double(std::min(dy, sm_size - dy));
+                    kernel[dy * sm_size + dx] = float(std::exp(-(x * x + y * y) / (2 * sm_sigma * sm_sigma)));
+                }
+            }
+
+            std::vector<float> energy(sm_texels, 0.0f);
+            std::vector<bool> set(sm_texels, false);
+
+            auto toggle = [&](std::size_t texel, bool on) {
+                std::size_t px = texel % sm_size;
+                std::size_t py = texel / sm_size;
+                float sign = on ? 1.0f : -1.0f;
+
+                set[texel] = on;
+
+                for (std::size_t y = 0; y < sm_size; y++)
+                {
+                    const float* row = &kernel[((y + sm_size - py) % sm_size) * sm_size];
+
+                    for (std::size_t x = 0; x < sm_size; x++)
+                    {
+                        energy[y * sm_size + x] += sign * row[(x + sm_size - px) % sm_size];
+                    }
+                }
+            };
+
+            // Densest point of the pattern (tightest cluster) or emptiest texel outside of it (largest void)
+            auto extreme = [&](bool cluster) {
+                std::size_t best = 0;
+                float bestEnergy = cluster ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+
+                for (std::size_t i = 0; i < sm_texels; i++)
+                {
+                    if (set[i] == cluster && (cluster ? energy[i] > bestEnergy : energy[i] < bestEnergy))
+                    {
+                        best = i;
+                        bestEnergy = energy[i];
+                    }
+                }
+
+                return best;
+            };
+
+            // Random initial pattern, relaxed by moving points from clusters into voids until it is stable
+            std::mt19937 rng(1);
+            std::size_t initialPoints = sm_texels / 10;
+
+            for (std::size_t count = 0; count < initialPoints; )
+            {
+                std::size_t texel = rng() % sm_texels;
+
+                if (!set[texel])
+                {
+                    toggle(texel, true);
+                    count++;
+                }
+            }
+
+            for (std::size_t iteration = 0; iteration < sm_texels; iteration++)
+            {
+                std::size_t cluster = extreme(true);
+                toggle(cluster, false);
+                std::size_t gap = extreme(false);
+
+                if (gap == cluster)
+                {
+                    toggle(cluster, true);
+                    break;
+                }
+
+                toggle(gap, true);
+            }
+
+            std::vector<float> prototypeEnergy = energy;
+            std::vector<bool> prototype = set;
+            std::vector<std::uint32_t> rank(sm_texels);
+
+            // Ranks below the prototype's size: remove the tightest clusters one by one
+            for (std::size_t count = initialPoints; count > 0; count--)
+            {
+                std::size_t cluster = extreme(true);
+                toggle(cluster, false);
+                rank[cluster] = std::uint32_t(count - 1);
+            }
+
+            // Ranks above it: fill the largest voids one by one
+            energy = prototypeEnergy;
+            set = prototype;
+
+            for (std::size_t count = initialPoints; count < sm_texels; count++)
+            {
+                std::size_t gap = extreme(false);
+                toggle(gap, true);
+                rank[gap] = std::uint32_t(count);
+            }
+
+            for (std::size_t i = 0; i < sm_texels; i++)
+            {
+                m_values[i] = (rank[i] + 0.5) / sm_texels;
+            }
+        }
+
+        std::vector<double> m_values;
+    };
+
+    // Screen space blue noise: within a dimension, neighbouring pixels get values that differ as much as possible,
+    // so the remaining noise is pushed to high frequencies where it is least visible and blurs away fastest. The
+    // samples of a pixel walk an additive recurrence (golden ratio, or R2 in two dimensions) from the mask value,
+    // and each dimension reads the mask at its own toroidal offset to decorrelate it from the others.
+    class BlueNoiseSampler : public Sampler
+    {
+    public:
+        explicit BlueNoiseSampler(std::size_t samplesPerPixel) :
+            Sampler(samplesPerPixel),
+            m_mask(BlueNoiseMask::instance())
+        { }
+
+    protected:
+        virtual double sample1D(std::uint32_t dimension) override
+        {
+            return wrap(maskValue(hash(dimension)) + m_sampleIndex * sm_golden);
+        }
+
+        virtual geometry::Point2 sample2D(std::uint32_t dimension) override
+        {
+            std::uint32_t offset = hash(dimension);
+
+            return geometry::Point2(wrap(maskValue(offset) + m_sampleIndex * sm_r2x),
+                    wrap(maskValue(hash(offset)) + m_sampleIndex * sm_r2y));
+        }
+
+    private:
+        static constexpr double sm_golden = 0.6180339887498949;
+        static constexpr double sm_r2x = 0.7548776662466927;
+        static constexpr double sm_r2y = 0.5698402909980532;
+
+        double maskValue(std::uint32_t offset) const
+        {
+            return m_mask.value(m_pixelX + (offset & 0xffff), m_pixelY + (offset >> 16));
+        }
+
+        static double wrap(double x)
+        {
+            return x - std::floor(x);
+        }
+
+        const BlueNoiseMask& m_mask;
+    };
+
+}
+
+#endif
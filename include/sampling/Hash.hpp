@@ -0,0 +1,100 @@
+#ifndef SAMPLING_HASH_HPP
+#define SAMPLING_HASH_HPP
+
+#include <cstdint>
+
+namespace sampling
+{
+
+    // Integer hashes used to derive independent scrambles and permutations from a pixel and a dimension, without
+    // storing any per pixel state.
+
+    inline std::uint32_t hash(std::uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    inline std::uint32_t hashCombine(std::uint32_t seed, std::uint32_t value)
+    {
+        return seed ^ (hash(value) + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+    }
+
+    inline std::uint32_t reverseBits(std::uint32_t x)
+    {
+        x = (x << 16) | (x >> 16);
+        x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+        x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+        x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+        x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+        return x;
+    }
+
+    // Laine-Karras style permutation: each output bit only depends on the input bits below it
+    inline std::uint32_t laineKarrasPermutation(std::uint32_t x, std::uint32_t seed)
+    {
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return x;
+    }
+
+    // Hash based Owen scrambling (Burley 2020): every bit is flipped depending on the bits above it, which keeps the
+    // stratification of a (0, m, s)-net intact while randomising it
+    inline std::uint32_t nestedUniformScramble(std::uint32_t x, std::uint32_t seed)
+    {
+        return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+    }
+
+    // Random permutation of [0, length) indexed by i (Kensler 2013)
+    inline std::uint32_t permute(std::uint32_t i, std::uint32_t length, std::uint32_t seed)
+    {
+        std::uint32_t mask = length - 1;
+        mask |= mask >> 1;
+        mask |= mask >> 2;
+        mask |= mask >> 4;
+        mask |= mask >> 8;
+        mask |= mask >> 16;
+
+        // Cycle walking: permute within the enclosing power of two until the result lands inside the range
+        do
+        {
+            i ^= seed;
+            i *= 0xe170893du;
+            i ^= seed >> 16;
+            i ^= (i & mask) >> 4;
+            i ^= seed >> 8;
+            i *= 0x0929eb3fu;
+            i ^= seed >> 23;
+            i ^= (i & mask) >> 1;
+            i *= 1 | seed >> 27;
+            i *= 0x6935fa69u;
+            i ^= (i & mask) >> 11;
+            i *= 0x74dcb303u;
+            i ^= (i & mask) >> 2;
+            i *= 0x9e501cc3u;
+            i ^= (i & mask) >> 2;
+            i *= 0xc860a3dfu;
+            i &= mask;
+            i ^= i >> 5;
+        }
+        while (i >= length);
+
+        return (i + seed) % length;
+    }
+
+    // Maps all 32 bits to [0, 1)
+    inline double toUnitInterval(std::uint32_t x)
+    {
+        return x * (1.0 / 4294967296.0);
+    }
+
+}
+
+#endif
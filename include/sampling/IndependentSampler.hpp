@@ -0,0 +1,39 @@
+#ifndef SAMPLING_INDEPENDENT_SAMPLER_HPP
+#define SAMPLING_INDEPENDENT_SAMPLER_HPP
+
+#include <random>
+
+#include <sampling/Sampler.hpp>
+#include <RandomGenerator.hpp>
+
+namespace sampling
+{
+
+    // Independent uniform numbers from the thread's RandomGenerator, so seeded renders stay reproducible
+    class IndependentSampler : public Sampler
+    {
+    public:
+        explicit IndependentSampler(std::size_t samplesPerPixel = 1) :
+            Sampler(samplesPerPixel),
+            m_distribution()
+        { }
+
+    protected:
+        virtual double sample1D(std::uint32_t) override
+        {
+            return m_distribution(RandomGenerator::get_instance());
+        }
+
+        virtual geometry::Point2 sample2D(std::uint32_t) override
+        {
+            double x = m_distribution(RandomGenerator::get_instance());
+            return geometry::Point2(x, m_distribution(RandomGenerator::get_instance()));
+        }
+
+    private:
+        std::uniform_real_distribution<double> m_distribution;
+    };
+
+}
+
+#endif
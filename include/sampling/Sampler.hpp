@@ -0,0 +1,105 @@
+#ifndef SAMPLING_SAMPLER_HPP
+#define SAMPLING_SAMPLER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include <geometry/Point.hpp>
+#include <sampling/Hash.hpp>
+
+namespace sampling
+{
+
+    // Source of the random numbers behind every decision of a render: pixel jitter, bounce directions, light
+    // samples and Russian roulette. startSample() positions the sampler on one sample of one pixel, after which each
+    // call to next1D() or next2D() consumes the next dimension of that sample. Samplers that know about the other
+    // samples of the pixel, or about its neighbours, spread the values out so that the image converges faster than
+    // with independent random numbers.
+    //
+    // Samplers are stateful and meant to be used by one thread at a time.
+    class Sampler
+    {
+    public:
+        enum class Type
+        {
+            eIndependent,       // Uniform random numbers, as drawn from RandomGenerator
+            eStratified,        // Jittered strata over the samples of each pixel
+            eSobol,             // Owen scrambled Sobol points
+            eBlueNoise          // Blue noise across the screen, low discrepancy across the samples of a pixel
+        };
+
+        explicit Sampler(std::size_t samplesPerPixel) :
+            m_samplesPerPixel(std::uint32_t(std::max<std::size_t>(samplesPerPixel, 1))),
+            m_pixelX(0),
+            m_pixelY(0),
+            m_pixelSeed(0),
+            m_sampleIndex(0),
+            m_dimension(0)
+        { }
+
+        virtual ~Sampler()
+        {
+
+        }
+
+        // A non-zero dimension resumes a sample part way through, e.g. to trace it after its camera ray has been
+        // generated along with others. Samplers whose values are drawn in sequence rather than computed per
+        // dimension then give different, but equally distributed, values.
+        void startSample(std::size_t x, std::size_t y, std::size_t sampleIndex, std::uint32_t dimension = 0)
+        {
+            m_pixelX = std::uint32_t(x);
+            m_pixelY = std::uint32_t(y);
+            m_pixelSeed = hashCombine(hash(m_pixelX), m_pixelY);
+            m_sampleIndex = std::uint32_t(sampleIndex);
+            m_dimension = dimension;
+        }
+
+        std::uint32_t dimension() const
+        {
+            return m_dimension;
+        }
+
+        std::size_t sampleIndex() const
+        {
+            return m_sampleIndex;
+        }
+
+        double next1D()
+        {
+            return std::min(sample1D(m_dimension++), oneMinusEpsilon());
+        }
+
+        geometry::Point2 next2D()
+        {
+            // Rounding to a single precision geo_type could otherwise give exactly one
+            const geometry::geo_type limit = std::nextafter(geometry::geo_type(1), geometry::geo_type(0));
+            geometry::Point2 sample = sample2D(m_dimension++);
+            return geometry::Point2(std::min(sample.x(), limit), std::min(sample.y(), limit));
+        }
+
+    protected:
+        // Largest double below one
+        static constexpr double oneMinusEpsilon()
+        {
+            return 1.0 - 1.1102230246251565e-16;
+        }
+
+        // Values in [0, 1] for the given dimension of the current sample. Each dimension must be decorrelated from
+        // the others, so that e.g. the second bounce does not repeat the pattern of the first.
+        virtual double sample1D(std::uint32_t dimension) = 0;
+        virtual geometry::Point2 sample2D(std::uint32_t dimension) = 0;
+
+        std::uint32_t m_samplesPerPixel;
+        std::uint32_t m_pixelX;
+        std::uint32_t m_pixelY;
+        std::uint32_t m_pixelSeed;
+        std::uint32_t m_sampleIndex;
+
+    private:
+        std::uint32_t m_dimension;
+    };
+
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SAMPLING_SAMPLERS_HPP
+#define SAMPLING_SAMPLERS_HPP
+
+#include <memory>
+
+#include <sampling/BlueNoiseSampler.hpp>
+#include <sampling/IndependentSampler.hpp>
+#include <sampling/Sampler.hpp>
+#include <sampling/SobolSampler.hpp>
+#include <sampling/StratifiedSampler.hpp>
+
+namespace sampling
+{
+
+    inline std::unique_ptr<Sampler> createSampler(Sampler::Type type, std::size_t samplesPerPixel)
+    {
+        switch (type)
+        {
+            case Sampler::Type::eIndependent:
+                return std::make_unique<IndependentSampler>(samplesPerPixel);
+            case Sampler::Type::eStratified:
+                return std::make_unique<StratifiedSampler>(samplesPerPixel);
+            case Sampler::Type::eSobol:
+                return std::make_unique<SobolSampler>(samplesPerPixel);
+            case Sampler::Type::eBlueNoise:
+                return std::make_unique<BlueNoiseSampler>(samplesPerPixel);
+        }
+
+        return std::make_unique<IndependentSampler>(samplesPerPixel);
+    }
+
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SAMPLING_SOBOL_SAMPLER_HPP
+#define SAMPLING_SOBOL_SAMPLER_HPP
+
+#include <sampling/Sampler.hpp>
+
+namespace sampling
+{
+
+    // Owen scrambled Sobol points. Only the first two Sobol dimensions are used: every dimension (or pair of
+    // dimensions) of the sampler gets its own scramble and its own shuffle of the sample index, which keeps the
+    // points of a pixel well stratified in each pair while decorrelating the pairs from each other. Power of two
+    // sample counts give the best distribution.
+    class SobolSampler : public Sampler
+    {
+    public:
+        explicit SobolSampler(std::size_t samplesPerPixel) :
+            Sampler(samplesPerPixel)
+        { }
+
+    protected:
+        virtual double sample1D(std::uint32_t dimension) override
+        {
+            std::uint32_t seed = hashCombine(m_pixelSeed, dimension);
+            std::uint32_t index = nestedUniformScramble(m_sampleIndex, seed);
+
+            return toUnitInterval(nestedUniformScramble(reverseBits(index), hash(seed)));
+        }
+
+        virtual geometry::Point2 sample2D(std::uint32_t dimension) override
+        {
+            std::uint32_t seed = hashCombine(m_pixelSeed, dimension);
+            std::uint32_t index = nestedUniformScramble(m_sampleIndex, seed);
+
+            return geometry::Point2(toUnitInterval(nestedUniformScramble(reverseBits(index), hashCombine(seed, 1))),
+                    toUnitInterval(nestedUniformScramble(sobolSecondDimension(index), hashCombine(seed, 2))));
+        }
+
+    private:
+        // The second Sobol dimension, whose generator matrix is Pascal's triangle mod 2. The first is just the
+        // bit reversed index (van der Corput).
+        static std::uint32_t sobolSecondDimension(std::uint32_t index)
+        {
+            std::uint32_t result = 0;
+
+            for (std::uint32_t direction = 1u << 31; index != 0; index >>= 1, direction ^= direction >> 1)
+            {
+                if (index & 1)
+                {
+                    result ^= direction;
+                }
+            }
+
+            return result;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef SAMPLING_STRATIFIED_SAMPLER_HPP
+#define SAMPLING_STRATIFIED_SAMPLER_HPP
+
+#include <cmath>
+
+#include <sampling/Sampler.hpp>
+
+namespace sampling
+{
+
+    // Jittered stratification: the samples of a pixel each fall into a different stratum of every dimension, with
+    // the strata shuffled independently per dimension and per pixel. Two dimensional samples use a square grid of
+    // strata; samples beyond the largest square that fits are left unstratified.
+    class StratifiedSampler : public Sampler
+    {
+    public:
+        explicit StratifiedSampler(std::size_t samplesPerPixel) :
+            Sampler(samplesPerPixel),
+            m_gridSize(std::uint32_t(std::sqrt(double(m_samplesPerPixel))))
+        {
+            // Guard against the square root rounding down on exact squares
+            while ((m_gridSize + 1) * (m_gridSize + 1) <= m_samplesPerPixel)
+            {
+                m_gridSize++;
+            }
+        }
+
+    protected:
+        virtual double sample1D(std::uint32_t dimension) override
+        {
+            std::uint32_t seed = hashCombine(m_pixelSeed, dimension);
+            std::uint32_t stratum = permute(m_sampleIndex % m_samplesPerPixel, m_samplesPerPixel, seed);
+
+            return (stratum + jitter(seed, 0)) / m_samplesPerPixel;
+        }
+
+        virtual geometry::Point2 sample2D(std::uint32_t dimension) override
+        {
+            std::uint32_t seed = hashCombine(m_pixelSeed, dimension);
+            std::uint32_t strata = m_gridSize * m_gridSize;
+            std::uint32_t index = m_sampleIndex % m_samplesPerPixel;
+
+            if (index >= strata)
+            {
+                return geometry::Point2(jitter(seed, 0), jitter(seed, 1));
+            }
+
+            std::uint32_t stratum = permute(index, strata, seed);
+
+            return geometry::Point2((stratum % m_gridSize + jitter(seed, 0)) / m_gridSize,
+                    (stratum / m_gridSize + jitter(seed, 1)) / m_gridSize);
+        }
+
+    private:
+        double jitter(std::uint32_t seed, std::uint32_t axis) const
+        {
+            return toUnitInterval(hash(hashCombine(hashCombine(seed, m_sampleIndex), axis)));
+        }
+
+        std::uint32_t m_gridSize;
+    };
+
+}
+
+#endif
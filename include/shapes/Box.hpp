@@ -1,73 +1,169 @@
 #ifndef SHAPES_BOX_HPP
 #define SHAPES_BOX_HPP
 
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
 #include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
 #include <shapes/Shape.hpp>
-#include <shapes/Rectangle.hpp>
-
-#include <iostream>
 
 static constexpr double pi() { return std::atan(1.0) * 4.0; }
 
 namespace shapes
 {
 
+    // Box given by its centre, its size along each of its axes and its orientation. Rays are intersected with the
+    // three pairs of planes that bound it ("slabs"), in the box's own frame when it is rotated and directly in world
+    // coordinates, with the ray's cached inverse direction, when it is not.
     class Box : public Shape
     {
     private:
-        std::array<Rectangle, 6> m_sides;
+        geometry::Point3 m_centre;
+        std::array<double, 3> m_halfSize;
+        std::array<geometry::Vector3, 3> m_axes;
+        bool m_oriented;
+
+        // Ray relative to the centre of the box, in the box's frame
+        struct LocalRay
+        {
+            std::array<double, 3> origin;
+            std::array<double, 3> direction;
+            std::array<double, 3> inverseDirection;
+        };
+
+        LocalRay localRay(const geometry::Ray3& ray) const
+        {
+            LocalRay local;
+            geometry::Vector3 offset = ray.origin() - m_centre;
+
+            if (!m_oriented)
+            {
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    local.origin[axis] = offset[axis];
+                    local.direction[axis] = ray.direction()[axis];
+                    local.inverseDirection[axis] = ray.inverseDirection()[axis];
+                }
+
+                return local;
+            }
+
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                local.origin[axis] = offset * m_axes[axis];
+                local.direction[axis] = ray.direction() * m_axes[axis];
+                local.inverseDirection[axis] = 1.0 / local.direction[axis];
+            }
+
+            return local;
+        }
+
+        // Distances at which the ray enters and leaves all three slabs, and the axes of the faces it crosses
+        // there. The ray misses the box if nearDistance > farDistance.
+        void intersectSlabs(const LocalRay& ray, double& nearDistance, double& farDistance, std::size_t& nearAxis, std::size_t& farAxis) const
+        {
+            nearDistance = -std::numeric_limits<double>::infinity();
+            farDistance = std::numeric_limits<double>::infinity();
+            nearAxis = 0;
+            farAxis = 0;
+
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                double t0 = (-m_halfSize[axis] - ray.origin[axis]) * ray.inverseDirection[axis];
+                double t1 = (m_halfSize[axis] - ray.origin[axis]) * ray.inverseDirection[axis];
+
+                if (t0 > t1)
+                {
+                    std::swap(t0, t1);
+                }
+
+                // Written so that NaNs (ray origin on a face with a zero direction component) are ignored
+                if (t0 > nearDistance)
+                {
+                    nearDistance = t0;
+                    nearAxis = axis;
+                }
+
+                if (t1 < farDistance)
+                {
+                    farDistance = t1;
+                    farAxis = axis;
+                }
+            }
+        }
 
     public:
         Box(const geometry::Vector3& size, const geometry::Point3& location, const geometry::Vector3& orientation, const std::shared_ptr<Surface>& surface) :
             Shape(surface),
-            m_sides{
-                Rectangle({0, 0, 0}, {0, 0, 0}, {0, 0, 0}, surface),
-                Rectangle({0, 0, 0}, {0, 0, 0}, {0, 0, 0}, surface),
-                Rectangle({0, 0, 0}, {0, 0, 0}, {0, 0, 0}, surface),
-                Rectangle({0, 0, 0}, {0, 0, 0}, {0, 0, 0}, surface),
-                Rectangle({0, 0, 0}, {0, 0, 0}, {0, 0, 0}, surface),
-                Rectangle({0, 0, 0}, {0, 0, 0}, {0, 0, 0}, surface)
+            m_centre(location),
+            m_halfSize{0.5 * size[0], 0.5 * size[1], 0.5 * size[2]},
+            m_axes{geometry::Vector3(1, 0, 0), geometry::Vector3(0, 1, 0), geometry::Vector3(0, 0, 1)},
+            m_oriented(orientation[0] != 0 || orientation[1] != 0 || orientation[2] != 0)
+        {
+            if (m_oriented)
+            {
+                auto rotationTransform = geometry::rotation<geometry::geo_type>(orientation[0] * 2 * pi(), orientation[1] * 2 * pi(), orientation[2] * 2 * pi());
+
+                for (auto& axis : m_axes)
+                {
+                    axis = rotationTransform * axis;
+                }
             }
+        }
+
+        // Distances along the ray at which it enters and leaves the box, for shapes that use the box to bound
+        // the part of the ray they have to search. Returns false if the line of the ray misses the box.
+        bool rayInterval(const geometry::Ray3& ray, double& nearDistance, double& farDistance) const
         {
-            geometry::Vector3 s = size * 0.5;
-            geometry::Vector3 origin = static_cast<geometry::Vector<double, 3ul>>(location);
-
-            auto rotationTransform = geometry::rotation(orientation[0] * 2 * pi(), orientation[1] * 2 * pi(), orientation[2] * 2 * pi());
-
-            std::array<geometry::Point3, 8> points{
-                rotationTransform * geometry::Point3{-s[0],  s[1], -s[2]} + origin,
-                rotationTransform * geometry::Point3{ s[0],  s[1], -s[2]} + origin,
-                rotationTransform * geometry::Point3{ s[0],  s[1],  s[2]} + origin,
-                rotationTransform * geometry::Point3{-s[0],  s[1],  s[2]} + origin,
-                rotationTransform * geometry::Point3{-s[0], -s[1], -s[2]} + origin,
-                rotationTransform * geometry::Point3{ s[0], -s[1], -s[2]} + origin,
-                rotationTransform * geometry::Point3{ s[0], -s[1],  s[2]} + origin,
-                rotationTransform * geometry::Point3{-s[0], -s[1],  s[2]} + origin
-            };
-
-            m_sides[0] = Rectangle(points[0], points[1], points[3], surface);
-            m_sides[1] = Rectangle(points[4], points[5], points[0], surface);
-            m_sides[2] = Rectangle(points[5], points[6], points[1], surface);
-            m_sides[3] = Rectangle(points[6], points[7], points[2], surface);
-            m_sides[4] = Rectangle(points[7], points[4], points[3], surface);
-            m_sides[5] = Rectangle(points[7], points[4], points[6], surface);
+            std::size_t nearAxis, farAxis;
+            intersectSlabs(localRay(ray), nearDistance, farDistance, nearAxis, farAxis);
+
+            return nearDistance <= farDistance;
         }
 
+        // The primitive of a hit is the face, numbered 2 * axis for the face on the negative side of the axis and
+        // 2 * axis + 1 for the one on the positive side. The coordinates of the hit run across the face along the
+        // next two axes.
         virtual IntersectionResult calculateRayIntersection(const geometry::Ray3& ray) const
         {
-            IntersectionResult nearestIntersection;
+            LocalRay local = localRay(ray);
+            double nearDistance, farDistance;
+            std::size_t nearAxis, farAxis;
+            intersectSlabs(local, nearDistance, farDistance, nearAxis, farAxis);
 
-            for (const auto& side : m_sides)
+            if (!(nearDistance <= farDistance) || !(farDistance > 0))
             {
-                IntersectionResult i = side.calculateRayIntersection(ray);
+                return IntersectionResult();
+            }
 
-                if (i.distance() < nearestIntersection.distance())
-                {
-                    nearestIntersection = i;
-                }
+            // The ray enters through the face facing it, or leaves through the one facing away if it starts inside
+            bool entering = nearDistance > 0;
+            double distance = entering ? nearDistance : farDistance;
+            std::size_t axis = entering ? nearAxis : farAxis;
+            bool positiveFace = (local.direction[axis] < 0) == entering;
+
+            geometry::Vector3 normal = positiveFace ? m_axes[axis] : geometry::Vector3(-m_axes[axis]);
+            std::size_t uAxis = (axis + 1) % 3;
+            std::size_t vAxis = (axis + 2) % 3;
+            double u = (local.origin[uAxis] + distance * local.direction[uAxis] + m_halfSize[uAxis]) / (2 * m_halfSize[uAxis]);
+            double v = (local.origin[vAxis] + distance * local.direction[vAxis] + m_halfSize[vAxis]) / (2 * m_halfSize[vAxis]);
+
+            return IntersectionResult(distance, this, normal, float(u), float(v), std::uint32_t(2 * axis + (positiveFace ? 1 : 0)));
+        }
+
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const
+        {
+            double nearDistance, farDistance;
+
+            if (!rayInterval(ray, nearDistance, farDistance))
+            {
+                return false;
             }
 
-            return nearestIntersection;
+            return (nearDistance > minDistance && nearDistance < maxDistance) || (farDistance > minDistance && farDistance < maxDistance);
         }
 
         virtual geometry::Vector3 calculateNormal(const geometry::Point3&) const
@@ -80,6 +176,26 @@ namespace shapes
             (void)p;
             return geometry::Point2{0, 0};
         }
+
+        virtual geometry::BoundingBox3 boundingBox() const
+        {
+            // Half the extent of the box along each world axis
+            geometry::Vector3 extent;
+
+            for (std::size_t world = 0; world < 3; world++)
+            {
+                double sum = 0;
+
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    sum += std::abs(m_axes[axis][world]) * m_halfSize[axis];
+                }
+
+                extent[world] = sum;
+            }
+
+            return geometry::BoundingBox3(m_centre - extent, m_centre + extent);
+        }
     };
 
     class BoxBuilder : public builders::CustomShapeBuilder
@@ -109,8 +225,6 @@ namespace shapes
         }
     };
 
-    builders::ShapeBuilder::Registration BoxBuilder::sm_registration("box", std::make_unique<BoxBuilder>());
-
 }
 
 #endif
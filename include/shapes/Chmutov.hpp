@@ -1,87 +1,77 @@
 #ifndef SHAPES_CHMUTOV_HPP
 #define SHAPES_CHMUTOV_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <string>
+
 #include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
+#include <geometry/SturmSequence.hpp>
+#include <shapes/Box.hpp>
 #include <shapes/Shape.hpp>
+#include <Exceptions.hpp>
 
 namespace shapes
 {
 
+    // Quartic surface a + b (x^4 + y^4 + z^4) - c (x^2 + y^2 + z^2) = 0 about the origin, after Chmutov's
+    // surfaces. Along a ray the left hand side is a quartic in the distance, whose smallest root inside the bounding
+    // box is found with a Sturm sequence.
     class Chmutov : public Shape
     {
 
     public:
-        Chmutov(const geometry::Point3& origin, const geometry::Vector3& up, double outerRadius, double innerRadius, const std::shared_ptr<Surface>& surface) :
+        Chmutov(const geometry::Point3& origin, const geometry::Vector3& up, double a, double b, double c, const std::shared_ptr<Surface>& surface) :
             Shape(surface),
             m_origin(origin),
             m_up(up),
-            m_outerRadius(outerRadius),
-            m_innerRadius(innerRadius),
-            m_boundingBox(Vector3(4, 4, 4), origin, Vector3(0, 0, 0), surface)
+            m_a(a),
+            m_b(b),
+            m_c(c),
+            m_boundingBox(2 * extent(a, b, c) * Vector3(1, 1, 1), origin, Vector3(0, 0, 0), surface)
         {
 
         }
 
         virtual IntersectionResult calculateRayIntersection(const geometry::Ray3& ray) const
         {
-            geometry::Vector3 d = ray.direction();
-            geometry::Vector3 o = ray.origin() - m_origin;
+            double nearDistance, farDistance;
 
-            IntersectionResult i = m_boundingBox.calculateRayIntersection(ray);
-
-            if (std::isinf(i.distance()))
+            if (!m_boundingBox.rayInterval(ray, nearDistance, farDistance) || !(farDistance > hitEpsilon()))
             {
                 return IntersectionResult();
             }
 
-            geometry::Vector3 d2 = {d.x() * d.x(), d.y() * d.y(), d.z() * d.z()};
-            geometry::Vector3 o2 = {o.x() * o.x(), o.y() * o.y(), o.z() * o.z()};
-            geometry::Vector3 od = {o.x() * d.x(), o.y() * d.y(), o.z() * d.z()};
-
-            double A = b * (d2 * d2);
-            double B = 4 * b * (od * d2);
-            double C = 6 * b * (o2 * d2) - c * d * d;
-            double D = 4 * b * (o2 * od) - 2 * c * o * d;
-            double E = a + b * (o2 * o2) - c * o * o;
-
-            double t0 = 0;
-            double t = i.distance();
+            double t;
 
-            do
+            if (!alongRay(ray).smallestRoot(std::max(nearDistance, hitEpsilon()), farDistance, t))
             {
-                t0 = t;
-
-                double t02 = t0 * t0;
-                double f = A * t02 * t02 + B * t02 * t0 + C * t02 + D * t0 + E;
-                //double f_prime = 4 * A * t02 * t0 + 3 * B * t02 + 2 * C * t0 + D;
+                return IntersectionResult();
+            }
 
-                double af = std::abs(f);
+            return IntersectionResult(t, this, gradientDirection(ray.origin() - m_origin + t * ray.direction()));
+        }
 
-                if (af < 10)
-                {
-                    t = t0 + f * 0.003;
-                }
-                else
-                {
-                    t = t0 + f * 0.0003;
-                }
+        // Counting the roots is enough to answer an occlusion query, without finding any of them
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const
+        {
+            double nearDistance, farDistance;
 
-                if (t > 20) {
-                    return IntersectionResult();
-                }
-            } while (std::abs(t - t0) / t > 0.0000001);
+            if (!m_boundingBox.rayInterval(ray, nearDistance, farDistance))
+            {
+                return false;
+            }
 
+            double lower = std::max(std::max(nearDistance, minDistance), hitEpsilon());
+            double upper = std::min(farDistance, maxDistance);
 
-            return IntersectionResult(t, this);
+            return lower < upper && alongRay(ray).rootCount(lower, upper) > 0;
         }
 
         virtual geometry::Vector3 calculateNormal(const geometry::Point3& p) const
         {
-            float dx = 4 * b * p.x() * p.x() * p.x() - 2 * c * p.x();
-            float dy = 4 * b * p.y() * p.y() * p.y() - 2 * c * p.y();
-            float dz = 4 * b * p.z() * p.z() * p.z() - 2 * c * p.z();
-
-            return geometry::normalize(geometry::Vector3{dx, dy, dz});
+            return gradientDirection(p - m_origin);
         }
 
         virtual geometry::Point2 textureMap(const geometry::Point3&) const
@@ -90,18 +80,65 @@ namespace shapes
             return geometry::Point2{0, 0};
         }
 
+        virtual geometry::BoundingBox3 boundingBox() const
+        {
+            return m_boundingBox.boundingBox();
+        }
+
     private:
         geometry::Point3 m_origin;
         geometry::Vector3 m_up;
-        double m_outerRadius;
-        double m_innerRadius;
+        double m_a;
+        double m_b;
+        double m_c;
         Box m_boundingBox;
 
-        double a = 3;
-        double b = 2;
-        double c = 4.2;
+        // Largest coordinate of any point of the surface. On the surface, b x^4 - c x^2 is balanced by the terms
+        // of the other two axes, each at least -c^2 / 4b, so every coordinate satisfies b x^4 - c x^2 <= c^2 / 2b - a.
+        static double extent(double a, double b, double c)
+        {
+            double bound = c * c / (2 * b) - a;
+            double discriminant = std::max(0.0, c * c + 4 * b * bound);
+
+            return std::sqrt(std::max(0.0, (c + std::sqrt(discriminant)) / (2 * b)));
+        }
+
+        // Smallest distance reported as a hit, so that rays leaving the surface do not find the point they start
+        // from, as for triangle meshes
+        static constexpr double hitEpsilon()
+        {
+            return sizeof(geometry::geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+        }
+
+        // The implicit function along the ray, as a quartic in the distance
+        geometry::SturmSequence<4> alongRay(const geometry::Ray3& ray) const
+        {
+            geometry::Vector3 d = ray.direction();
+            geometry::Vector3 o = ray.origin() - m_origin;
+
+            geometry::Vector3 d2 = {d.x() * d.x(), d.y() * d.y(), d.z() * d.z()};
+            geometry::Vector3 o2 = {o.x() * o.x(), o.y() * o.y(), o.z() * o.z()};
+            geometry::Vector3 od = {o.x() * d.x(), o.y() * d.y(), o.z() * d.z()};
+
+            double A = m_b * (d2 * d2);
+            double B = 4 * m_b * (od * d2);
+            double C = 6 * m_b * (o2 * d2) - m_c * (d * d);
+            double D = 4 * m_b * (o2 * od) - 2 * m_c * (o * d);
+            double E = m_a + m_b * (o2 * o2) - m_c * (o * o);
+
+            return geometry::SturmSequence<4>({E, D, C, B, A});
+        }
+
+        // Unit gradient of the surface's implicit function at a point relative to the origin
+        geometry::Vector3 gradientDirection(const geometry::Vector3& p) const
+        {
+            double dx = 4 * m_b * p.x() * p.x() * p.x() - 2 * m_c * p.x();
+            double dy = 4 * m_b * p.y() * p.y() * p.y() - 2 * m_c * p.y();
+            double dz = 4 * m_b * p.z() * p.z() * p.z() - 2 * m_c * p.z();
+            double recipLength = 1.0 / std::sqrt(dx * dx + dy * dy + dz * dz);
 
-        double epsilon = 1e-10;
+            return geometry::Vector3(dx * recipLength, dy * recipLength, dz * recipLength);
+        }
     };
 
     class ChmutovBuilder : public builders::CustomShapeBuilder
@@ -112,8 +149,9 @@ namespace shapes
 
             parameter("location", ParamType::ePoint3, REQUIRED);
             parameter("up", ParamType::eVector3, OPTIONAL, Vector3(0, 0, 0));
-            parameter("outer-radius", ParamType::eFloat, OPTIONAL, 0.0);
-            parameter("inner-radius", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("a", ParamType::eFloat, OPTIONAL, 3.0);
+            parameter("b", ParamType::eFloat, OPTIONAL, 2.0);
+            parameter("c", ParamType::eFloat, OPTIONAL, 4.2);
             parameter("surface", ParamType::eSurface, REQUIRED);
         }
 
@@ -123,16 +161,21 @@ namespace shapes
         virtual std::shared_ptr<Shape> construct(const builders::BuilderArgs& args) {
             Point3 location = args.get<Point3>("location");
             Vector3 up = args.get<Vector3>("up");
-            double outerRadius = args.get<double>("outer-radius");
-            double innerRadius = args.get<double>("inner-radius");
+            double a = args.get<double>("a");
+            double b = args.get<double>("b");
+            double c = args.get<double>("c");
             const auto& surface = args.get<std::shared_ptr<Surface>>("surface");
 
-            return std::make_shared<Chmutov>(location, up, outerRadius, innerRadius, surface);
+            // The quartic terms have to dominate far from the origin for the surface to be bounded
+            if (!(b > 0.0))
+            {
+                throw InvalidParameterValueException("b", std::to_string(b));
+            }
+
+            return std::make_shared<Chmutov>(location, up, a, b, c, surface);
         }
     };
 
-    builders::ShapeBuilder::Registration ChmutovBuilder::sm_registration("chmutov", std::make_unique<ChmutovBuilder>());
-
 }
 
 #endif
@@ -0,0 +1,215 @@
+#ifndef SHAPES_INSTANCE_HPP
+#define SHAPES_INSTANCE_HPP
+
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
+#include <geometry/Transformation.hpp>
+#include <shapes/Prototype.hpp>
+#include <shapes/Shape.hpp>
+
+namespace shapes
+{
+
+    // Prototype group placed in the scene by an affine transformation. Rays are taken into the group's object space
+    // with the cached inverse and traced through the group's own hierarchy, so each instance only stores its
+    // transformations and bounds. The scene's hierarchy over the instances' bounds is the upper level.
+    //
+    // Hits report the surfaces of the group's shapes as the instance's materials. Instances report surfaceArea() as
+    // zero, so emissive groups are not sampled as lights.
+    class Instance : public Shape
+    {
+    public:
+        using Transformation = geometry::AffineTransformation<geometry::geo_type>;
+
+        // The transformation must not be singular
+        Instance(const std::shared_ptr<const Prototype>& prototype, const Transformation& toWorld) :
+            Shape(prototype->surfaces().front()),
+            m_prototype(prototype),
+            m_toObject(inverse(toWorld)),
+            m_normalToWorld(transpose(m_toObject.linear())),
+            m_bounds(worldBounds(prototype->boundingBox(), toWorld))
+        {
+
+        }
+
+        virtual IntersectionResult calculateRayIntersection(const geometry::Ray3& ray) const override
+        {
+            double scale;
+            geometry::Ray3 objectRay = toObject(ray, scale);
+            IntersectionResult hit = m_prototype->nearestIntersection(objectRay, hitEpsilon() * scale);
+
+            if (!hit.shape())
+            {
+                return IntersectionResult();
+            }
+
+            IntersectionResult result(hit.distance() / scale, this, normalize(m_normalToWorld * hit.normal()), float(hit.uv().x()),
+                    float(hit.uv().y()), hit.primitive());
+            result.setMaterial(hit.material());
+            return result;
+        }
+
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const override
+        {
+            double scale;
+            geometry::Ray3 objectRay = toObject(ray, scale);
+            return m_prototype->intersectsWithin(objectRay, minDistance * scale, maxDistance * scale);
+        }
+
+        // An instance has no single normal; hits report the normal of the shape that was hit
+        virtual geometry::Vector3 calculateNormal(const geometry::Point3&) const override
+        {
+            return geometry::Vector3{0, 0, 0};
+        }
+
+        virtual geometry::Point2 textureMap(const geometry::Point3&) const override
+        {
+            return geometry::Point2{0, 0};
+        }
+
+        virtual geometry::BoundingBox3 boundingBox() const override
+        {
+            return m_bounds;
+        }
+
+        virtual std::size_t surfaceCount() const override
+        {
+            return m_prototype->surfaces().size();
+        }
+
+        virtual const Surface& surface(std::size_t index) const override
+        {
+            return *m_prototype->surfaces()[index];
+        }
+
+        const Prototype& prototype() const
+        {
+            return *m_prototype;
+        }
+
+    private:
+        std::shared_ptr<const Prototype> m_prototype;
+        Transformation m_toObject;
+        geometry::Transformation<geometry::geo_type, 3> m_normalToWorld;
+        geometry::BoundingBox3 m_bounds;
+
+        // Smallest object space distance, per unit of world distance, reported as a hit, as for triangle meshes
+        static constexpr double hitEpsilon()
+        {
+            return sizeof(geometry::geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+        }
+
+        // The ray in object space, with a unit direction as the shapes expect. Distances along it are those along
+        // the world ray times scale.
+        geometry::Ray3 toObject(const geometry::Ray3& ray, double& scale) const
+        {
+            geometry::Vector3 direction = m_toObject * ray.direction();
+            scale = abs(direction);
+            return geometry::Ray3(m_toObject * ray.origin(), direction * (1.0 / scale));
+        }
+
+        // Bounds of the transformed corners, rounded outwards so that rounding cannot cull a ray that grazes them
+        static geometry::BoundingBox3 worldBounds(const geometry::BoundingBox3& objectBounds, const Transformation& toWorld)
+        {
+            using geometry::geo_type;
+
+            if (!objectBounds.isBounded())
+            {
+                return objectBounds.isEmpty() ? objectBounds : geometry::BoundingBox3::infinite();
+            }
+
+            geometry::BoundingBox3 bounds;
+
+            for (std::size_t corner = 0; corner < 8; corner++)
+            {
+                geometry::Point3 p((corner & 1) ? objectBounds.max()[0] : objectBounds.min()[0],
+                        (corner & 2) ? objectBounds.max()[1] : objectBounds.min()[1],
+                        (corner & 4) ? objectBounds.max()[2] : objectBounds.min()[2]);
+                bounds.expand(toWorld * p);
+            }
+
+            const geo_type lowest = -std::numeric_limits<geo_type>::infinity();
+            const geo_type highest = std::numeric_limits<geo_type>::infinity();
+            geometry::Point3 low = bounds.min();
+            geometry::Point3 high = bounds.max();
+
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                geo_type slack = 4 * std::numeric_limits<geo_type>::epsilon() * (std::abs(low[axis]) + std::abs(high[axis]));
+                low[axis] = std::nextafter(low[axis] - slack, lowest);
+                high[axis] = std::nextafter(high[axis] + slack, highest);
+            }
+
+            return geometry::BoundingBox3(low, high);
+        }
+    };
+
+    class InstanceBuilder : public builders::CustomShapeBuilder
+    {
+    public:
+        InstanceBuilder()
+        {
+            using namespace builders;
+
+            parameter("prototype", ParamType::eString, REQUIRED);
+            parameter("location", ParamType::ePoint3, OPTIONAL, Point3(0, 0, 0));
+            parameter("orientation", ParamType::eVector3, OPTIONAL, Vector3(0, 0, 0));
+            parameter("scale", ParamType::eFloat, OPTIONAL, 1.0);
+            parameter("transform", ParamType::eFloatList, OPTIONAL, ParamTypes::FloatList());
+        }
+
+    private:
+        static builders::ShapeBuilder::Registration sm_registration;
+
+        virtual std::shared_ptr<Shape> construct(const builders::BuilderArgs& args)
+        {
+            using geometry::geo_type;
+
+            const auto& prototype = getPrototype(args.get<std::string>("prototype"));
+            Point3 location = args.get<Point3>("location");
+            Vector3 orientation = args.get<Vector3>("orientation");
+            double scale = args.get<double>("scale");
+            const auto& matrix = args.get<builders::ParamTypes::FloatList>("transform");
+
+            // The matrix is given row by row, either as 4x4 or without its last row, which must be 0 0 0 1
+            Instance::Transformation transform = Instance::Transformation::identity();
+
+            if (!matrix.empty())
+            {
+                if ((matrix.size() != 12 && matrix.size() != 16) ||
+                        (matrix.size() == 16 && (matrix[12] != 0 || matrix[13] != 0 || matrix[14] != 0 || matrix[15] != 1)))
+                {
+                    throw InvalidParameterValueException("transform", std::to_string(matrix.size()) + " numbers");
+                }
+
+                transform = Instance::Transformation(geometry::Transformation<geo_type, 3>{
+                    {geo_type(matrix[0]), geo_type(matrix[1]), geo_type(matrix[2])},
+                    {geo_type(matrix[4]), geo_type(matrix[5]), geo_type(matrix[6])},
+                    {geo_type(matrix[8]), geo_type(matrix[9]), geo_type(matrix[10])}
+                }, Vector3(geo_type(matrix[3]), geo_type(matrix[7]), geo_type(matrix[11])));
+            }
+
+            // Orientation is given in turns about each axis, as for boxes, and applied after the matrix and scale
+            const double turn = 8.0 * std::atan(1.0);
+            auto rotationTransform = geometry::rotation<geo_type>(orientation[0] * turn, orientation[1] * turn, orientation[2] * turn);
+            auto scaling = geometry::Transformation<geo_type, 3>{{geo_type(scale), 0, 0}, {0, geo_type(scale), 0}, {0, 0, geo_type(scale)}};
+            Instance::Transformation placement(rotationTransform * scaling, Vector3(location[0], location[1], location[2]));
+            Instance::Transformation toWorld = placement * transform;
+            double determinant = geometry::determinant(toWorld.linear());
+
+            if (!(std::abs(determinant) > 0) || !std::isfinite(determinant))
+            {
+                throw InvalidParameterValueException("transform", "singular");
+            }
+
+            return std::make_shared<Instance>(prototype, toWorld);
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef SHAPES_MESH_CACHE_HPP
+#define SHAPES_MESH_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <MappedFile.hpp>
+#include <acceleration/ArrayView.hpp>
+#include <acceleration/BoundingVolumeHierarchy.hpp>
+
+namespace shapes
+{
+
+    // Binary cache of a mesh ready for rendering: transformed vertex arrays, triangle indices and the built
+    // hierarchy, written next to the source file as "<source>.<params hash>.meshcache". Loading maps the file and
+    // points the mesh straight at its arrays, so nothing is parsed, built or copied.
+    //
+    // A cache is used when its format version, byte order and node layout match this program, it was built with
+    // the same parameters, and the source still has the size and modification time it had when the cache was
+    // written, or failing that the same content hash. Anything else is treated as a miss and the cache rebuilt.
+    class MeshCache
+    {
+    public:
+        using Node = acceleration::BoundingVolumeHierarchy::Node;
+
+        static_assert(std::is_trivially_copyable<Node>::value, "hierarchy nodes are stored as raw bytes");
+
+        // Arrays of a cached mesh, kept alive by the storage
+        struct Entry
+        {
+            acceleration::ArrayView<double> x;
+            acceleration::ArrayView<double> y;
+            acceleration::ArrayView<double> z;
+            acceleration::ArrayView<std::uint32_t> indices;
+            acceleration::BoundingVolumeHierarchy hierarchy;
+            std::shared_ptr<const void> storage;
+
+            Entry() :
+                x(),
+                y(),
+                z(),
+                indices(),
+                hierarchy(),
+                storage()
+            {
+
+            }
+        };
+
+        // Bumped whenever the layout of the file, or the way meshes are built, changes
+        static constexpr std::uint32_t formatVersion()
+        {
+            return 1;
+        }
+
+        static std::string path(const std::string& source, std::uint64_t paramsHash)
+        {
+            char hex[17];
+            std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(paramsHash));
+            return source + "." + hex + ".meshcache";
+        }
+
+        // 64-bit hash of a block of bytes, read eight at a time and mixed with the splitmix64 finaliser. Fast
+        // enough to hash a large source file in a fraction of the time it takes to parse it.
+        static std::uint64_t hash(const void* data, std::size_t size, std::uint64_t seed = 0)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            std::uint64_t h = mix(seed ^ size);
+            std::size_t i = 0;
+
+            for (; i + 8 <= size; i += 8)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, bytes + i, 8);
+                h = mix(h ^ word);
+            }
+
+            if (i < size)
+            {
+                std::uint64_t word = 0;
+                std::memcpy(&word, bytes + i, size - i);
+                h = mix(h ^ word);
+            }
+
+            return h;
+        }
+
+        // Hash of the contents of a file, or zero if it cannot be read
+        static std::uint64_t hashFile(const std::string& filename)
+        {
+            MappedFile file(filename);
+            return file.isOpen() ? hash(file.data(), file.size()) : 0;
+        }
+
+        // Fills in the entry from the cache if it is valid for the source and parameters
+        static bool load(const std::string& cachePath, const std::string& source, std::uint64_t paramsHash, Entry& entry)
+        {
+            auto file = std::make_shared<MappedFile>(cachePath);
+
+            if (!file->isOpen() || file->size() < sizeof(Header))
+            {
+                return false;
+            }
+
+            Header header;
+            std::memcpy(&header, file->data(), sizeof(Header));
+
+            if (std::memcmp(header.magic, magic(), sizeof(header.magic)) != 0 || header.version != formatVersion() ||
+                    header.endianTag != endianTag() || header.nodeSize != sizeof(Node) || header.paramsHash != paramsHash)
+            {
+                return false;
+            }
+
+            // Bounding the counts first keeps the layout arithmetic from overflowing on a corrupt header
+            std::uint64_t limit = file->size();
+
+            if (header.vertexCount > limit || header.indexCount > limit || header.nodeCount > limit || header.primitiveIndexCount > limit)
+            {
+                return false;
+            }
+
+            Layout layout(header);
+
+            if (layout.end > file->size() || header.indexCount % 3 != 0)
+            {
+                return false;
+            }
+
+            MappedFile::Stamp stamp = MappedFile::stamp(source);
+            bool unchanged = stamp.modified != 0 && stamp.size == header.sourceSize && stamp.modified == header.sourceModified;
+
+            if (!unchanged && hashFile(source) != header.contentHash)
+            {
+                return false;
+            }
+
+            const unsigned char* base = file->data();
+
+            entry.x = view<double>(base, layout.x, header.vertexCount);
+            entry.y = view<double>(base, layout.y, header.vertexCount);
+            entry.z = view<double>(base, layout.z, header.vertexCount);
+            entry.indices = view<std::uint32_t>(base, layout.indices, header.indexCount);
+            entry.hierarchy = acceleration::BoundingVolumeHierarchy(view<Node>(base, layout.nodes, header.nodeCount),
+                    view<std::uint32_t>(base, layout.primitiveIndices, header.primitiveIndexCount), file);
+            entry.storage = file;
+
+            return true;
+        }
+
+        // Writes the cache, replacing any existing one. Failure to write is not an error: the mesh is simply
+        // rebuilt next time.
+        static bool store(const std::string& cachePath, const std::string& source, std::uint64_t paramsHash, const Entry& entry)
+        {
+            MappedFile::Stamp stamp = MappedFile::stamp(source);
+
+            Header header;
+            std::memcpy(header.magic, magic(), sizeof(header.magic));
+            header.version = formatVersion();
+            header.endianTag = endianTag();
+            header.nodeSize = sizeof(Node);
+            header.reserved = 0;
+            header.paramsHash = paramsHash;
+            header.contentHash = hashFile(source);
+            header.sourceSize = stamp.size;
+            header.sourceModified = stamp.modified;
+            header.vertexCount = entry.x.size();
+            header.indexCount = entry.indices.size();
+            header.nodeCount = entry.hierarchy.nodes().size();
+            header.primitiveIndexCount = entry.hierarchy.primitiveIndices().size();
+
+            Layout layout(header);
+
+            // Written under a temporary name and renamed, so that a concurrent reader never sees a partial file
+            std::string temporaryPath = cachePath + ".tmp";
+
+            {
+                std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+                if (!file.is_open())
+                {
+                    return false;
+                }
+
+                file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+                write(file, layout.x, entry.x);
+                write(file, layout.y, entry.y);
+                write(file, layout.z, entry.z);
+                write(file, layout.indices, entry.indices);
+                write(file, layout.nodes, entry.hierarchy.nodes());
+                write(file, layout.primitiveIndices, entry.hierarchy.primitiveIndices());
+
+                if (!file)
+                {
+                    file.close();
+                    std::remove(temporaryPath.c_str());
+                    return false;
+                }
+            }
+
+            if (std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+            {
+                std::remove(temporaryPath.c_str());
+                return false;
+            }
+
+            return true;
+        }
+
+    private:
+        struct Header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t endianTag;
+            std::uint32_t nodeSize;
+            std::uint32_t reserved;
+            std::uint64_t paramsHash;
+            std::uint64_t contentHash;
+            std::uint64_t sourceSize;
+            std::int64_t sourceModified;
+            std::uint64_t vertexCount;
+            std::uint64_t indexCount;
+            std::uint64_t nodeCount;
+            std::uint64_t primitiveIndexCount;
+        };
+
+        // Byte offsets of the arrays, each aligned to a cache line
+        struct Layout
+        {
+            std::uint64_t x;
+            std::uint64_t y;
+            std::uint64_t z;
+            std::uint64_t indices;
+            std::uint64_t nodes;
+            std::uint64_t primitiveIndices;
+            std::uint64_t end;
+
+            explicit Layout(const Header& header) :
+                x(align(sizeof(Header))),
+                y(align(x + header.vertexCount * sizeof(double))),
+                z(align(y + header.vertexCount * sizeof(double))),
+                indices(align(z + header.vertexCount * sizeof(double))),
+                nodes(align(indices + header.indexCount * sizeof(std::uint32_t))),
+                primitiveIndices(align(nodes + header.nodeCount * sizeof(Node))),
+                end(primitiveIndices + header.primitiveIndexCount * sizeof(std::uint32_t))
+            {
+
+            }
+
+            static std::uint64_t align(std::uint64_t offset)
+            {
+                return (offset + 63) & ~std::uint64_t(63);
+            }
+        };
+
+        static const char* magic()
+        {
+            return "RTMESH\0";
+        }
+
+        // Reads back as a different value on a host of the other byte order
+        static constexpr std::uint32_t endianTag()
+        {
+            return 0x01020304;
+        }
+
+        static std::uint64_t mix(std::uint64_t x)
+        {
+            x += 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        template <typename T>
+        static acceleration::ArrayView<T> view(const unsigned char* base, std::uint64_t offset, std::uint64_t count)
+        {
+            return acceleration::ArrayView<T>(reinterpret_cast<const T*>(base + offset), std::size_t(count));
+        }
+
+        template <typename T>
+        static void write(std::ofstream& file, std::uint64_t offset, acceleration::ArrayView<T> array)
+        {
+            static const char padding[64] = {};
+            std::uint64_t position = std::uint64_t(file.tellp());
+            file.write(padding, std::streamsize(offset - position));
+            file.write(reinterpret_cast<const char*>(array.data()), std::streamsize(array.size() * sizeof(T)));
+        }
+    };
+
+}
+
+#endif
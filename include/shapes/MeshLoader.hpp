@@ -0,0 +1,433 @@
+#ifndef SHAPES_MESH_LOADER_HPP
+#define SHAPES_MESH_LOADER_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Exceptions.hpp>
+
+namespace shapes
+{
+
+    // Triangle soup as loaded from a file: vertex coordinates in separate arrays, and three vertex indices per
+    // triangle. Polygons are split into fans of triangles.
+    struct MeshData
+    {
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> z;
+        std::vector<std::uint32_t> indices;
+
+        MeshData() :
+            x(),
+            y(),
+            z(),
+            indices()
+        {
+
+        }
+
+        std::size_t vertexCount() const
+        {
+            return x.size();
+        }
+
+        std::size_t triangleCount() const
+        {
+            return indices.size() / 3;
+        }
+
+        void addVertex(double vx, double vy, double vz)
+        {
+            x.push_back(vx);
+            y.push_back(vy);
+            z.push_back(vz);
+        }
+
+        void addPolygon(const std::vector<std::uint32_t>& polygon)
+        {
+            for (std::size_t i = 2; i < polygon.size(); i++)
+            {
+                indices.push_back(polygon[0]);
+                indices.push_back(polygon[i - 1]);
+                indices.push_back(polygon[i]);
+            }
+        }
+    };
+
+    class MeshLoader
+    {
+    public:
+        // Picks the format from the file extension, ".obj" or ".ply"
+        static MeshData load(const std::string& filename)
+        {
+            std::ifstream file(filename, std::ios::binary);
+
+            if (!file.is_open())
+            {
+                throw MeshLoadException(filename, "cannot open file");
+            }
+
+            std::string extension = filename.substr(std::min(filename.find_last_of('.'), filename.size()));
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(std::tolower(c)); });
+
+            try
+            {
+                if (extension == ".obj")
+                {
+                    return loadObj(file);
+                }
+                else if (extension == ".ply")
+                {
+                    return loadPly(file);
+                }
+            }
+            catch (const MeshLoadException& ex)
+            {
+                throw MeshLoadException(filename + ", " + ex.location(), ex.reason());
+            }
+
+            throw MeshLoadException(filename, "unknown mesh format '" + extension + "'");
+        }
+
+        // Wavefront OBJ: only vertex positions and faces are read. Face vertices may carry texture coordinate and
+        // normal indices ("f 1/2/3 ..."), which are ignored, and negative indices count back from the last vertex.
+        static MeshData loadObj(std::istream& in)
+        {
+            MeshData mesh;
+            std::vector<std::uint32_t> polygon;
+            std::string line;
+            std::size_t lineNumber = 0;
+
+            while (std::getline(in, line))
+            {
+                lineNumber++;
+                std::istringstream tokens(line);
+                std::string keyword;
+                tokens >> keyword;
+
+                if (keyword == "v")
+                {
+                    double x, y, z;
+
+                    if (!(tokens >> x >> y >> z))
+                    {
+                        throw MeshLoadException("line " + std::to_string(lineNumber), "malformed vertex");
+                    }
+
+                    mesh.addVertex(x, y, z);
+                }
+                else if (keyword == "f")
+                {
+                    polygon.clear();
+                    std::string vertex;
+
+                    while (tokens >> vertex)
+                    {
+                        long index = std::strtol(vertex.c_str(), nullptr, 10);
+                        long resolved = index < 0 ? long(mesh.vertexCount()) + index : index - 1;
+
+                        if (index == 0 || resolved < 0 || resolved >= long(mesh.vertexCount()))
+                        {
+                            throw MeshLoadException("line " + std::to_string(lineNumber), "face refers to undefined vertex '" + vertex + "'");
+                        }
+
+                        polygon.push_back(std::uint32_t(resolved));
+                    }
+
+                    mesh.addPolygon(polygon);
+                }
+            }
+
+            return mesh;
+        }
+
+        // Stanford PLY in any of its ascii, binary_little_endian and binary_big_endian encodings. Vertices need
+        // x, y and z properties and faces a vertex_indices (or vertex_index) list; other properties and elements
+        // are skipped.
+        static MeshData loadPly(std::istream& in)
+        {
+            std::string line;
+            std::getline(in, line);
+
+            if (trim(line) != "ply")
+            {
+                throw MeshLoadException("header", "not a PLY file");
+            }
+
+            Encoding encoding = Encoding::eAscii;
+            std::vector<Element> elements;
+
+            while (std::getline(in, line))
+            {
+                std::istringstream tokens(trim(line));
+                std::string keyword;
+                tokens >> keyword;
+
+                if (keyword == "format")
+                {
+                    std::string format;
+                    tokens >> format;
+
+                    if (format == "ascii")
+                    {
+                        encoding = Encoding::eAscii;
+                    }
+                    else if (format == "binary_little_endian")
+                    {
+                        encoding = Encoding::eLittleEndian;
+                    }
+                    else if (format == "binary_big_endian")
+                    {
+                        encoding = Encoding::eBigEndian;
+                    }
+                    else
+                    {
+                        throw MeshLoadException("header", "unknown format '" + format + "'");
+                    }
+                }
+                else if (keyword == "element")
+                {
+                    Element element;
+                    tokens >> element.name >> element.count;
+                    elements.push_back(element);
+                }
+                else if (keyword == "property")
+                {
+                    if (elements.empty())
+                    {
+                        throw MeshLoadException("header", "property outside of an element");
+                    }
+
+                    Property property;
+                    std::string type;
+                    tokens >> type;
+
+                    if (type == "list")
+                    {
+                        std::string countType;
+                        tokens >> countType >> type;
+                        property.countType = scalarType(countType);
+                        property.isList = true;
+                    }
+
+                    property.type = scalarType(type);
+                    tokens >> property.name;
+                    elements.back().properties.push_back(property);
+                }
+                else if (keyword == "end_header")
+                {
+                    break;
+                }
+            }
+
+            MeshData mesh;
+            PlyReader reader(in, encoding);
+            std::vector<std::uint32_t> polygon;
+
+            for (const Element& element : elements)
+            {
+                for (std::size_t i = 0; i < element.count; i++)
+                {
+                    double position[3] = {0.0, 0.0, 0.0};
+                    polygon.clear();
+
+                    for (const Property& property : element.properties)
+                    {
+                        if (property.isList)
+                        {
+                            std::size_t count = std::size_t(reader.read(property.countType));
+                            bool isFace = element.name == "face" && (property.name == "vertex_indices" || property.name == "vertex_index");
+
+                            for (std::size_t j = 0; j < count; j++)
+                            {
+                                double index = reader.read(property.type);
+
+                                if (isFace)
+                                {
+                                    if (!(index >= 0 && index < double(mesh.vertexCount())))
+                                    {
+                                        throw MeshLoadException("face " + std::to_string(i), "refers to undefined vertex");
+                                    }
+
+                                    polygon.push_back(std::uint32_t(index));
+                                }
+                            }
+                        }
+                        else
+                        {
+                            double value = reader.read(property.type);
+
+                            if (element.name == "vertex" && property.name.size() == 1 && property.name[0] >= 'x' && property.name[0] <= 'z')
+                            {
+                                position[property.name[0] - 'x'] = value;
+                            }
+                        }
+                    }
+
+                    if (!in)
+                    {
+                        throw MeshLoadException(element.name + " " + std::to_string(i), "unexpected end of file");
+                    }
+
+                    if (element.name == "vertex")
+                    {
+                        mesh.addVertex(position[0], position[1], position[2]);
+                    }
+                    else if (element.name == "face")
+                    {
+                        mesh.addPolygon(polygon);
+                    }
+                }
+            }
+
+            return mesh;
+        }
+
+    private:
+        enum class Encoding
+        {
+            eAscii,
+            eLittleEndian,
+            eBigEndian
+        };
+
+        enum class ScalarType
+        {
+            eInt8,
+            eUint8,
+            eInt16,
+            eUint16,
+            eInt32,
+            eUint32,
+            eFloat32,
+            eFloat64
+        };
+
+        struct Property
+        {
+            std::string name;
+            ScalarType type;
+            ScalarType countType;
+            bool isList;
+
+            Property() :
+                name(),
+                type(ScalarType::eFloat32),
+                countType(ScalarType::eUint8),
+                isList(false)
+            {
+
+            }
+        };
+
+        struct Element
+        {
+            std::string name;
+            std::size_t count;
+            std::vector<Property> properties;
+
+            Element() :
+                name(),
+                count(0),
+                properties()
+            {
+
+            }
+        };
+
+        // Reads single values in the file's encoding, widened to double, which holds every PLY scalar exactly
+        class PlyReader
+        {
+        public:
+            PlyReader(std::istream& in, Encoding encoding) :
+                m_in(in),
+                m_encoding(encoding)
+            { }
+
+            double read(ScalarType type)
+            {
+                if (m_encoding == Encoding::eAscii)
+                {
+                    double value = 0.0;
+                    m_in >> value;
+                    return value;
+                }
+
+                switch (type)
+                {
+                    case ScalarType::eInt8:    return readBinary<std::int8_t>();
+                    case ScalarType::eUint8:   return readBinary<std::uint8_t>();
+                    case ScalarType::eInt16:   return readBinary<std::int16_t>();
+                    case ScalarType::eUint16:  return readBinary<std::uint16_t>();
+                    case ScalarType::eInt32:   return readBinary<std::int32_t>();
+                    case ScalarType::eUint32:  return readBinary<std::uint32_t>();
+                    case ScalarType::eFloat32: return readBinary<float>();
+                    case ScalarType::eFloat64: return readBinary<double>();
+                }
+
+                return 0.0;
+            }
+
+        private:
+            template <typename T>
+            T readBinary()
+            {
+                unsigned char bytes[sizeof(T)] = {};
+                m_in.read(reinterpret_cast<char*>(bytes), sizeof(T));
+
+                if ((m_encoding == Encoding::eBigEndian) != isBigEndianHost())
+                {
+                    std::reverse(bytes, bytes + sizeof(T));
+                }
+
+                T value;
+                std::memcpy(&value, bytes, sizeof(T));
+                return value;
+            }
+
+            static bool isBigEndianHost()
+            {
+                const std::uint16_t probe = 1;
+                unsigned char firstByte;
+                std::memcpy(&firstByte, &probe, 1);
+                return firstByte == 0;
+            }
+
+            std::istream& m_in;
+            Encoding m_encoding;
+        };
+
+        static ScalarType scalarType(const std::string& name)
+        {
+            if (name == "char" || name == "int8") return ScalarType::eInt8;
+            if (name == "uchar" || name == "uint8") return ScalarType::eUint8;
+            if (name == "short" || name == "int16") return ScalarType::eInt16;
+            if (name == "ushort" || name == "uint16") return ScalarType::eUint16;
+            if (name == "int" || name == "int32") return ScalarType::eInt32;
+            if (name == "uint" || name == "uint32") return ScalarType::eUint32;
+            if (name == "float" || name == "float32") return ScalarType::eFloat32;
+            if (name == "double" || name == "float64") return ScalarType::eFloat64;
+
+            throw MeshLoadException("header", "unknown property type '" + name + "'");
+        }
+
+        // Header lines may end in "\r" when the file was written on Windows
+        static std::string trim(const std::string& s)
+        {
+            std::size_t end = s.find_last_not_of(" \t\r");
+            return end == std::string::npos ? std::string() : s.substr(0, end + 1);
+        }
+    };
+
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include <Exceptions.hpp>
 #include <shapes/Shape.hpp>
 #include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
+#include <CompiledScene.hpp>
 
 namespace shapes
 {
@@ -51,7 +53,33 @@ namespace shapes
         virtual IntersectionResult calculateRayIntersection(const geometry::Ray3& ray) const
         {
             geometry::Vector3 diff = m_origin - ray.origin();
-            return IntersectionResult((m_normal * (diff)) / (m_normal * ray.direction()), this);
+            return IntersectionResult((m_normal * (diff)) / (m_normal * ray.direction()), this, m_normal);
+        }
+
+        virtual void calculatePacketIntersection(const geometry::RayPacket3& packet, const geometry::PacketMask3&, PacketResults& results) const
+        {
+            using geometry::geo_type;
+            constexpr std::size_t width = geometry::RayPacket3::width();
+            double distances[width];
+
+            for (std::size_t lane = 0; lane < width; lane++)
+            {
+                geo_type numerator = m_normal[0] * (m_origin[0] - packet.origin[0][lane]) + m_normal[1] * (m_origin[1] - packet.origin[1][lane]) +
+                        m_normal[2] * (m_origin[2] - packet.origin[2][lane]);
+                distances[lane] = numerator / (m_normal[0] * packet.direction[0][lane] + m_normal[1] * packet.direction[1][lane] +
+                        m_normal[2] * packet.direction[2][lane]);
+            }
+
+            for (std::size_t lane = 0; lane < width; lane++)
+            {
+                results[lane] = IntersectionResult(distances[lane], this, m_normal);
+            }
+        }
+
+        virtual bool compile(CompiledScene& scene) const
+        {
+            scene.addPlane(*this, m_origin, m_normal);
+            return true;
         }
 
         virtual geometry::Vector3 calculateNormal(const geometry::Point3&) const
@@ -97,8 +125,6 @@ namespace shapes
         }
     };
 
-    builders::ShapeBuilder::Registration PlaneBuilder::sm_registration("plane", std::make_unique<PlaneBuilder>());
-
 }
 
 #endif
@@ -0,0 +1,167 @@
+#ifndef SHAPES_PROTOTYPE_HPP
+#define SHAPES_PROTOTYPE_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <acceleration/BoundingVolumeHierarchy.hpp>
+#include <shapes/Shape.hpp>
+
+namespace shapes
+{
+
+    // Group of shapes in an object space of their own, placed in the scene by instances. The group keeps its own
+    // bounding volume hierarchy, the lower level under the scene's, and its own table of surfaces, so that it is
+    // stored once however many instances refer to it.
+    class Prototype
+    {
+    public:
+        using IntersectionResult = Shape::IntersectionResult;
+
+        explicit Prototype(const std::vector<std::shared_ptr<Shape>>& shapes) :
+            m_bounded(),
+            m_unbounded(),
+            m_surfaces(),
+            m_hierarchy(),
+            m_bounds()
+        {
+            std::map<const Surface*, std::uint32_t> materialIds;
+            std::vector<Member> bounded;
+            std::vector<geometry::BoundingBox3> bounds;
+
+            for (const auto& shape : shapes)
+            {
+                Member member{shape, std::uint32_t(m_surfaces.size())};
+
+                // Like the scene's table: shapes with several surfaces take a block, the others share theirs
+                if (shape->surfaceCount() > 1)
+                {
+                    for (std::size_t i = 0; i < shape->surfaceCount(); i++)
+                    {
+                        m_surfaces.push_back(std::make_shared<Surface>(shape->surface(i)));
+                    }
+                }
+                else
+                {
+                    auto material = materialIds.find(&shape->surface());
+
+                    if (material == materialIds.end())
+                    {
+                        material = materialIds.emplace(&shape->surface(), std::uint32_t(m_surfaces.size())).first;
+                        m_surfaces.push_back(std::make_shared<Surface>(shape->surface()));
+                    }
+
+                    member.material = material->second;
+                }
+
+                geometry::BoundingBox3 box = shape->boundingBox();
+
+                if (box.isBounded())
+                {
+                    bounded.push_back(member);
+                    bounds.push_back(box);
+                    m_bounds.expand(box);
+                }
+                else
+                {
+                    m_unbounded.push_back(member);
+                    m_bounds = geometry::BoundingBox3::infinite();
+                }
+            }
+
+            m_hierarchy = acceleration::BoundingVolumeHierarchy(bounds);
+            m_bounded.resize(bounded.size());
+
+            for (std::uint32_t index : m_hierarchy.primitiveIndices())
+            {
+                m_bounded[index] = bounded[index];
+            }
+        }
+
+        // Nearest hit of the group's shapes further along the ray than minDistance. The result's material indexes
+        // surfaces().
+        IntersectionResult nearestIntersection(const geometry::Ray3& ray, double minDistance) const
+        {
+            IntersectionResult nearest;
+            double maxDistance = nearest.distance();
+
+            auto intersect = [&](const Member& member, double& distanceLimit) {
+                IntersectionResult intersection = member.shape->calculateRayIntersection(ray);
+
+                if (intersection.distance() < distanceLimit && intersection.distance() > minDistance)
+                {
+                    nearest = intersection;
+                    nearest.setMaterial(member.material + intersection.material());
+                    distanceLimit = intersection.distance();
+                }
+            };
+
+            for (const Member& member : m_unbounded)
+            {
+                intersect(member, maxDistance);
+            }
+
+            m_hierarchy.intersect(ray, minDistance, maxDistance, [&](std::uint32_t index, double& distanceLimit) {
+                intersect(m_bounded[index], distanceLimit);
+            });
+
+            return nearest;
+        }
+
+        bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const
+        {
+            for (const Member& member : m_unbounded)
+            {
+                if (member.shape->intersectsWithin(ray, minDistance, maxDistance))
+                {
+                    return true;
+                }
+            }
+
+            return m_hierarchy.intersectsAny(ray, minDistance, maxDistance, [&](std::uint32_t index, double) {
+                return m_bounded[index].shape->intersectsWithin(ray, minDistance, maxDistance);
+            });
+        }
+
+        // Bounds in object space, infinite if any of the shapes is unbounded
+        const geometry::BoundingBox3& boundingBox() const
+        {
+            return m_bounds;
+        }
+
+        const std::vector<std::shared_ptr<Surface>>& surfaces() const
+        {
+            return m_surfaces;
+        }
+
+        std::size_t size() const
+        {
+            return m_bounded.size() + m_unbounded.size();
+        }
+
+    private:
+        struct Member
+        {
+            std::shared_ptr<Shape> shape;
+            std::uint32_t material;     // Where the shape's surfaces start in surfaces()
+
+            Member(const std::shared_ptr<Shape>& _shape = nullptr, std::uint32_t _material = 0) :
+                shape(_shape),
+                material(_material)
+            {
+
+            }
+        };
+
+        std::vector<Member> m_bounded;
+        std::vector<Member> m_unbounded;
+        std::vector<std::shared_ptr<Surface>> m_surfaces;
+        acceleration::BoundingVolumeHierarchy m_hierarchy;
+        geometry::BoundingBox3 m_bounds;
+    };
+
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <shapes/Shape.hpp>
 #include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
+#include <CompiledScene.hpp>
 
 namespace shapes
 {
@@ -21,6 +23,30 @@ namespace shapes
         float m_v0_v0;
         float m_recipDenominator;
 
+        // Tests whether a point on the rectangle's plane lies within its edges. On success u and v are the
+        // point's coordinates along p2 - p0 and p1 - p0.
+        bool contains(const geometry::Point3& poi, float& u, float& v) const
+        {
+            geometry::Vector3 v2 = poi - m_p0;
+
+            double v2v0 = v2 * m_v0;
+            double v2v1 = v2 * m_v1;
+
+            u = (m_v1_v1 * v2v0 - m_v0_v1 * v2v1) * m_recipDenominator;
+
+            if (u >= 0 && u <= 1)
+            {
+                v = (m_v0_v0 * v2v1 - m_v0_v1 * v2v0) * m_recipDenominator;
+
+                if (v >= 0 && v <= 1)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
     public:
         Rectangle(const geometry::Point3& p0, const geometry::Point3& p1, const geometry::Point3& p2,
                 const std::shared_ptr<Surface>& surface) :
@@ -43,26 +69,78 @@ namespace shapes
         {
             geometry::Vector3 diff = m_p0 - ray.origin();
             double distance = (m_normal * diff) / (m_normal * ray.direction());
-            geometry::Point3 poi = ray.origin() + distance * ray.direction();
 
-            geometry::Vector3 v2 = poi - m_p0;
+            float u, v;
 
-            double v2v0 = v2 * m_v0;
-            double v2v1 = v2 * m_v1;
+            if (contains(ray.origin() + distance * ray.direction(), u, v))
+            {
+                return IntersectionResult(distance, this, m_normal, u, v);
+            }
 
-            float u = (m_v1_v1 * v2v0 - m_v0_v1 * v2v1) * m_recipDenominator;
+            return IntersectionResult();
+        }
 
-            if (u >= 0 && u <= 1)
+        virtual void calculatePacketIntersection(const geometry::RayPacket3& packet, const geometry::PacketMask3&, PacketResults& results) const override
+        {
+            using geometry::geo_type;
+            constexpr std::size_t width = geometry::RayPacket3::width();
+            double distances[width];
+            float us[width];
+            float vs[width];
+            bool inside[width];
+
+            // Same arithmetic as calculateRayIntersection() and contains(), with the branches turned into selects
+            for (std::size_t lane = 0; lane < width; lane++)
             {
+                geo_type dx = packet.direction[0][lane];
+                geo_type dy = packet.direction[1][lane];
+                geo_type dz = packet.direction[2][lane];
+
+                geo_type numerator = m_normal[0] * (m_p0[0] - packet.origin[0][lane]) + m_normal[1] * (m_p0[1] - packet.origin[1][lane]) +
+                        m_normal[2] * (m_p0[2] - packet.origin[2][lane]);
+                double distance = numerator / (m_normal[0] * dx + m_normal[1] * dy + m_normal[2] * dz);
+
+                geo_type t = geo_type(distance);
+                geo_type x = (packet.origin[0][lane] + t * dx) - m_p0[0];
+                geo_type y = (packet.origin[1][lane] + t * dy) - m_p0[1];
+                geo_type z = (packet.origin[2][lane] + t * dz) - m_p0[2];
+
+                double v2v0 = x * m_v0[0] + y * m_v0[1] + z * m_v0[2];
+                double v2v1 = x * m_v1[0] + y * m_v1[1] + z * m_v1[2];
+
+                float u = (m_v1_v1 * v2v0 - m_v0_v1 * v2v1) * m_recipDenominator;
                 float v = (m_v0_v0 * v2v1 - m_v0_v1 * v2v0) * m_recipDenominator;
 
-                if (v >= 0 && v <= 1)
-                {
-                    return IntersectionResult(distance, this);
-                }
+                distances[lane] = distance;
+                us[lane] = u;
+                vs[lane] = v;
+                inside[lane] = u >= 0 && u <= 1 && v >= 0 && v <= 1;
             }
 
-            return IntersectionResult();
+            for (std::size_t lane = 0; lane < width; lane++)
+            {
+                results[lane] = inside[lane] ? IntersectionResult(distances[lane], this, m_normal, us[lane], vs[lane]) : IntersectionResult();
+            }
+        }
+
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const override
+        {
+            double distance = (m_normal * (m_p0 - ray.origin())) / (m_normal * ray.direction());
+
+            // Reject on distance before paying for the barycentric test
+            if (!(distance > minDistance && distance < maxDistance))
+            {
+                return false;
+            }
+
+            float u, v;
+            return contains(ray.origin() + distance * ray.direction(), u, v);
+        }
+
+        virtual bool compile(CompiledScene& scene) const override
+        {
+            scene.addRectangle(*this, m_p0, m_normal, m_v0, m_v1, m_v0_v1, m_v1_v1, m_v0_v0, m_recipDenominator);
+            return true;
         }
 
         virtual geometry::Vector3 calculateNormal(const geometry::Point3&) const override
@@ -82,10 +160,22 @@ namespace shapes
             return geometry::Point2{x, y};
         }
 
-        virtual geometry::Point3 sampleSurface() const override
+        virtual geometry::BoundingBox3 boundingBox() const override
         {
-            thread_local std::uniform_real_distribution<double> dist(1.0);
-            return dist(RandomGenerator::get_instance()) * m_v0 + dist(RandomGenerator::get_instance()) * m_v1 + m_p0;
+            geometry::BoundingBox3 box(m_p0, m_p1);
+            box.expand(m_p2);
+            box.expand(m_p0 + m_v0 + m_v1);
+            return box;
+        }
+
+        virtual double surfaceArea() const override
+        {
+            return geometry::abs(geometry::cross_product(m_v0, m_v1));
+        }
+
+        virtual geometry::Point3 sampleSurface(const geometry::Point2& sample) const override
+        {
+            return sample.x() * m_v0 + sample.y() * m_v1 + m_p0;
         }
     };
 
@@ -115,8 +205,6 @@ namespace shapes
             return std::make_shared<Rectangle>(point1, point2, point3, surface);
         }
     };
-
-    builders::ShapeBuilder::Registration RectangleBuilder::sm_registration("rectangle", std::make_unique<RectangleBuilder>());
 }
 
 #endif
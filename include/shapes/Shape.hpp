@@ -1,37 +1,84 @@
 #ifndef SHAPE_HPP
 #define SHAPE_HPP
 
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 
+#include <geometry/BoundingBox.hpp>
 #include <geometry/Point.hpp>
 #include <geometry/Ray.hpp>
+#include <geometry/RayPacket.hpp>
 #include <geometry/Transformation.hpp>
 #include <geometry/Vector.hpp>
 #include <Surface.hpp>
 
+class CompiledScene;
+
 namespace shapes
 {
 
     class Shape
     {
     public:
+        // Hit record filled in by the intersection kernels, so that shading does not have to find out again what
+        // the kernel already knew when it accepted the hit
         class IntersectionResult
         {
         private:
             double m_distance;
             const shapes::Shape* m_shape;
+            std::uint32_t m_primitive;
+            std::uint32_t m_material;
+            geometry::Vector3 m_normal;
+            float m_u;
+            float m_v;
 
         public:
-            IntersectionResult(double distance = std::numeric_limits<double>::infinity(), const shapes::Shape* shape = nullptr) :
+            IntersectionResult() :
+                m_distance(std::numeric_limits<double>::infinity()),
+                m_shape(nullptr),
+                m_primitive(0),
+                m_material(0),
+                m_normal(),
+                m_u(0),
+                m_v(0)
+            { }
+
+            IntersectionResult(double distance, const shapes::Shape* shape, const geometry::Vector3& normal,
+                    float u = 0, float v = 0, std::uint32_t primitive = 0) :
                 m_distance(distance),
-                m_shape(shape)
+                m_shape(shape),
+                m_primitive(primitive),
+                m_material(0),
+                m_normal(normal),
+                m_u(u),
+                m_v(v)
             { }
 
             double distance() const { return m_distance; }
             const shapes::Shape* shape() const { return m_shape; }
+
+            // Unit geometric normal at the hit, facing whichever side the shape considers its outside
+            const geometry::Vector3& normal() const { return m_normal; }
+
+            // Parametric coordinates of the hit on the shape: the edge coordinates of a rectangle or the barycentric
+            // coordinates of a triangle. Shapes without a natural parametrisation leave them at zero.
+            geometry::Point2 uv() const { return geometry::Point2(m_u, m_v); }
+
+            // Part of the shape that was hit, for shapes made of many primitives such as triangle meshes
+            std::uint32_t primitive() const { return m_primitive; }
+
+            // Index of the shape's surface in the material table of the scene that found the hit. Shapes leave it
+            // at zero, or set the index of the surface among their own surfaces(); the scene offsets it by where the
+            // shape's surfaces start in the table.
+            std::uint32_t material() const { return m_material; }
+            void setMaterial(std::uint32_t material) { m_material = material; }
         };
 
+        using PacketResults = std::array<IntersectionResult, geometry::RayPacket3::width()>;
+
         Shape(const std::shared_ptr<Surface>& surface) :
             m_surface(surface) {
         }
@@ -43,22 +90,73 @@ namespace shapes
 
         virtual IntersectionResult calculateRayIntersection(const geometry::Ray3& ray) const = 0;
 
+        // calculateRayIntersection() for each active lane of a packet. Results of the other lanes are unspecified.
+        // Shapes whose test is cheap and branch free override this to run all the lanes at once.
+        virtual void calculatePacketIntersection(const geometry::RayPacket3& packet, const geometry::PacketMask3& active, PacketResults& results) const
+        {
+            for (std::size_t lane = 0; lane < packet.count; lane++)
+            {
+                if (active[lane])
+                {
+                    results[lane] = calculateRayIntersection(packet.ray(lane));
+                }
+            }
+        }
+
+        // Occlusion query: true if the ray hits the shape anywhere between minDistance and maxDistance. Shapes can
+        // override this to skip work that is only needed to report the nearest hit.
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const
+        {
+            double distance = calculateRayIntersection(ray).distance();
+            return distance > minDistance && distance < maxDistance;
+        }
+
+        // Hands the data of the shape's intersection test to one of the scene's add functions, so that the shape can
+        // be tested without a virtual call. Shapes that return false are tested through this interface instead.
+        virtual bool compile(CompiledScene&) const
+        {
+            return false;
+        }
+
         virtual geometry::Vector3 calculateNormal(const geometry::Point3& p) const = 0;
 
         virtual geometry::Point2 textureMap(const geometry::Point3& p) const = 0;
 
+        // Axis aligned bounds of the shape. Shapes that extend to infinity keep the default, which places them
+        // outside of the scene's bounding volume hierarchy.
+        virtual geometry::BoundingBox3 boundingBox() const
+        {
+            return geometry::BoundingBox3::infinite();
+        }
+
+        // Area of the shape, or zero for shapes that cannot be sampled. Emissive shapes with a non-zero area are
+        // sampled directly as lights; the others are only found by rays that happen to hit them.
         virtual double surfaceArea() const
         {
-            throw -1;
+            return 0.0;
         }
 
-        virtual geometry::Point3 sampleSurface() const
+        // Point picked uniformly over the surface, i.e. with an area density of 1 / surfaceArea(), as a function
+        // of a sample uniform on the unit square
+        virtual geometry::Point3 sampleSurface(const geometry::Point2&) const
         {
             throw -1;
         }
 
         const Surface& surface() const { return *m_surface; }
 
+        // Shapes made of many primitives may give each its own surface, and report which one a hit is on as the
+        // hit's material. The first is surface().
+        virtual std::size_t surfaceCount() const
+        {
+            return 1;
+        }
+
+        virtual const Surface& surface(std::size_t) const
+        {
+            return *m_surface;
+        }
+
     private:
         std::shared_ptr<Surface> m_surface;
     };
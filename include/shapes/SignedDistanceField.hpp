@@ -0,0 +1,389 @@
+#ifndef SHAPES_SIGNED_DISTANCE_FIELD_HPP
+#define SHAPES_SIGNED_DISTANCE_FIELD_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
+#include <geometry/DistanceProgram.hpp>
+#include <shapes/Box.hpp>
+#include <shapes/Shape.hpp>
+#include <Exceptions.hpp>
+
+namespace shapes
+{
+
+    // Surface where a distance expression of primitives and booleans is zero, found by sphere tracing: the value at a
+    // point, divided by the expression's Lipschitz bound, is a distance the ray can advance without crossing the
+    // surface. Steps are over-relaxed and retaken at their plain length when they turn out to have passed over the
+    // surface. Tracing only starts for rays that enter the box outside of which the expression is positive.
+    class SignedDistanceField : public Shape
+    {
+
+    public:
+        SignedDistanceField(const geometry::DistanceNode& field, const geometry::Point3& location, const std::shared_ptr<Surface>& surface) :
+            Shape(surface),
+            m_program(field),
+            m_location(location),
+            m_empty(false),
+            m_boundingBox(boundsSize(m_program), location + boundsOffset(m_program), Vector3(0, 0, 0), surface)
+        {
+            for (std::size_t i = 0; i < 3; i++)
+            {
+                m_empty = m_empty || !(m_program.lower()[i] <= m_program.upper()[i]);
+            }
+        }
+
+        virtual IntersectionResult calculateRayIntersection(const geometry::Ray3& ray) const
+        {
+            double t;
+
+            if (!trace(ray, hitEpsilon(), std::numeric_limits<double>::infinity(), t))
+            {
+                return IntersectionResult();
+            }
+
+            return IntersectionResult(t, this, normalAt(alongRay(ray, t)));
+        }
+
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const
+        {
+            double t;
+            return trace(ray, std::max(minDistance, hitEpsilon()), maxDistance, t);
+        }
+
+        virtual geometry::Vector3 calculateNormal(const geometry::Point3& p) const
+        {
+            return normalAt({{p[0] - m_location[0], p[1] - m_location[1], p[2] - m_location[2]}});
+        }
+
+        // A distance expression has no parameterisation of its surface, so every point maps to the texture's origin
+        virtual geometry::Point2 textureMap(const geometry::Point3&) const
+        {
+            return geometry::Point2{0, 0};
+        }
+
+        virtual geometry::BoundingBox3 boundingBox() const
+        {
+            return m_boundingBox.boundingBox();
+        }
+
+    private:
+        using Position = geometry::DistanceProgram::Position;
+
+        geometry::DistanceProgram m_program;
+        geometry::Point3 m_location;
+        bool m_empty;
+        Box m_boundingBox;
+
+        // Sphere tracing stops when the surface is known to be nearer than this, which also sets the step used for
+        // normals. Rays leaving the surface start within it.
+        static constexpr double hitTolerance()
+        {
+            return sizeof(geometry::geo_type) < sizeof(double) ? 1e-4 : 1e-6;
+        }
+
+        // Smallest distance reported as a hit, as for triangle meshes
+        static constexpr double hitEpsilon()
+        {
+            return sizeof(geometry::geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+        }
+
+        // Factor by which steps are lengthened, after Keinert et al., "Enhanced Sphere Tracing"
+        static constexpr double overRelaxation()
+        {
+            return 1.6;
+        }
+
+        static constexpr int maxSteps()
+        {
+            return 512;
+        }
+
+        // The bounding box is padded by the tolerance so that points the tracer accepts as hits are inside it
+        static geometry::Vector3 boundsSize(const geometry::DistanceProgram& program)
+        {
+            std::array<geometry::geo_type, 3> size;
+
+            for (std::size_t i = 0; i < 3; i++)
+            {
+                size[i] = geometry::geo_type(std::max(program.upper()[i] - program.lower()[i], 0.0) + 4 * hitTolerance());
+            }
+
+            return geometry::Vector3(size);
+        }
+
+        static geometry::Vector3 boundsOffset(const geometry::DistanceProgram& program)
+        {
+            std::array<geometry::geo_type, 3> offset;
+
+            for (std::size_t i = 0; i < 3; i++)
+            {
+                offset[i] = geometry::geo_type(0.5 * (program.lower()[i] + program.upper()[i]));
+            }
+
+            return geometry::Vector3(offset);
+        }
+
+        // Point along the ray relative to the location, in double precision whatever the geometry's precision
+        Position alongRay(const geometry::Ray3& ray, double t) const
+        {
+            Position p;
+
+            for (std::size_t i = 0; i < 3; i++)
+            {
+                p[i] = double(ray.origin()[i]) - double(m_location[i]) + t * double(ray.direction()[i]);
+            }
+
+            return p;
+        }
+
+        geometry::Vector3 normalAt(const Position& p) const
+        {
+            auto gradient = m_program.gradientDirection(p, hitTolerance());
+            return geometry::Vector3(gradient[0], gradient[1], gradient[2]);
+        }
+
+        // Distance to the first surface crossing in [lower, upper], if any
+        bool trace(const geometry::Ray3& ray, double lower, double upper, double& t) const
+        {
+            double nearDistance, farDistance;
+
+            if (m_empty || !m_boundingBox.rayInterval(ray, nearDistance, farDistance))
+            {
+                return false;
+            }
+
+            lower = std::max(lower, nearDistance);
+            upper = std::min(upper, farDistance);
+
+            if (!(lower < upper))
+            {
+                return false;
+            }
+
+            // Radii and the tolerance are measured along the ray, whose direction need not be a unit vector
+            const auto& direction = ray.direction();
+            const double speed = std::sqrt(double(direction * direction));
+            const double recipLipschitz = 1.0 / (m_program.lipschitzBound() * speed);
+            const double tolerance = hitTolerance() / speed;
+
+            t = lower;
+            double radius = m_program.evaluate(alongRay(ray, t)) * recipLipschitz;
+            double side = radius < 0.0 ? -1.0 : 1.0;
+
+            // A ray leaving the surface starts within the tolerance of it, on either side. It is traced on the side it
+            // heads into, once it is clear of the surface.
+            if (std::abs(radius) < tolerance)
+            {
+                auto gradient = m_program.gradientDirection(alongRay(ray, t), hitTolerance());
+                double cosine = gradient[0] * direction[0] + gradient[1] * direction[1] + gradient[2] * direction[2];
+                double step = tolerance;
+
+                side = cosine < 0.0 ? -1.0 : 1.0;
+
+                for (int i = 0; side * radius < tolerance; i++)
+                {
+                    t += step;
+                    step *= 2;
+
+                    // A ray that grazes the surface may not get clear of it at all
+                    if (i == 24 || t > upper)
+                    {
+                        return false;
+                    }
+
+                    radius = m_program.evaluate(alongRay(ray, t)) * recipLipschitz;
+                }
+            }
+
+            double relaxation = overRelaxation();
+            double previousRadius = 0.0;
+            double stepLength = 0.0;
+
+            for (int i = 0; i < maxSteps(); i++)
+            {
+                double signedRadius = side * radius;
+                double distance = std::abs(signedRadius);
+
+                // The spheres about consecutive points that are clear of the surface have to overlap, or the relaxed
+                // step may have passed over the surface. Go back to where the plain step would have ended.
+                bool overshot = relaxation > 1.0 && distance + previousRadius < stepLength;
+
+                if (overshot)
+                {
+                    stepLength -= relaxation * stepLength;
+                    relaxation = 1.0;
+                }
+                else
+                {
+                    if (distance < tolerance)
+                    {
+                        return true;
+                    }
+
+                    stepLength = relaxation * signedRadius;
+                }
+
+                previousRadius = distance;
+
+                if (t + stepLength > upper)
+                {
+                    // Only a plain step past the end shows that there is no surface before it
+                    if (!(relaxation > 1.0) || t + signedRadius > upper)
+                    {
+                        return false;
+                    }
+
+                    stepLength = signedRadius;
+                    relaxation = 1.0;
+                }
+
+                t += stepLength;
+                radius = m_program.evaluate(alongRay(ray, t)) * recipLipschitz;
+            }
+
+            return false;
+        }
+    };
+
+    // Reads one node of a distance expression, and its children, from nested objects such as
+    // {"op": "union", "smoothing": 0.2, "left": {"op": "sphere", ...}, "right": {"op": "box", ...}}
+    class DistanceNodeBuilder : public builders::BuilderBase<geometry::DistanceNode>
+    {
+    public:
+        explicit DistanceNodeBuilder(std::size_t depth = 1) :
+            m_depth(depth)
+        {
+            using namespace builders;
+
+            setAllowExtraArguments(false);
+
+            parameter("op", ParamType::eString, REQUIRED);
+            parameter("location", ParamType::ePoint3, OPTIONAL, Point3(0, 0, 0));
+            parameter("radius", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("dimensions", ParamType::eVector3, OPTIONAL, Vector3(0, 0, 0));
+            parameter("rounding", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("major-radius", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("minor-radius", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("smoothing", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("amplitude", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("frequency", ParamType::eFloat, OPTIONAL, 0.0);
+            parameter("left", ParamType::eObject, OPTIONAL, ParamTypes::Object());
+            parameter("right", ParamType::eObject, OPTIONAL, ParamTypes::Object());
+            parameter("child", ParamType::eObject, OPTIONAL, ParamTypes::Object());
+        }
+
+    private:
+        std::size_t m_depth;
+
+        virtual std::shared_ptr<geometry::DistanceNode> construct(const builders::BuilderArgs& args) {
+            using geometry::DistanceNode;
+
+            const auto& op = args.get<std::string>("op");
+            Point3 location = args.get<Point3>("location");
+            DistanceNode::Position centre = {{location[0], location[1], location[2]}};
+
+            if (op == "sphere") {
+                return DistanceNode::sphere(centre, positive(args, "radius"));
+            } else if (op == "box") {
+                Vector3 dimensions = args.get<Vector3>("dimensions");
+                DistanceNode::Position halfSize;
+
+                for (std::size_t i = 0; i < 3; i++) {
+                    if (!(dimensions[i] > 0.0)) {
+                        throw InvalidParameterValueException("dimensions", std::to_string(dimensions[i]));
+                    }
+
+                    halfSize[i] = 0.5 * dimensions[i];
+                }
+
+                double rounding = args.get<double>("rounding");
+
+                if (!(rounding >= 0.0 && rounding <= std::min(halfSize[0], std::min(halfSize[1], halfSize[2])))) {
+                    throw InvalidParameterValueException("rounding", std::to_string(rounding));
+                }
+
+                return DistanceNode::box(centre, halfSize, rounding);
+            } else if (op == "torus") {
+                return DistanceNode::torus(centre, positive(args, "major-radius"), positive(args, "minor-radius"));
+            } else if (op == "ripple") {
+                return DistanceNode::ripple(child(args, "child"), args.get<double>("amplitude"), args.get<double>("frequency"));
+            }
+
+            DistanceNode::Type type;
+
+            if (op == "union") {
+                type = DistanceNode::Type::eUnion;
+            } else if (op == "intersection") {
+                type = DistanceNode::Type::eIntersection;
+            } else if (op == "difference") {
+                type = DistanceNode::Type::eDifference;
+            } else {
+                throw InvalidParameterValueException("op", op);
+            }
+
+            double smoothing = args.get<double>("smoothing");
+
+            if (!(smoothing >= 0.0)) {
+                throw InvalidParameterValueException("smoothing", std::to_string(smoothing));
+            }
+
+            return DistanceNode::combine(type, child(args, "left"), child(args, "right"), smoothing);
+        }
+
+        static double positive(const builders::BuilderArgs& args, const std::string& name) {
+            double value = args.get<double>(name);
+
+            if (!(value > 0.0)) {
+                throw InvalidParameterValueException(name, std::to_string(value));
+            }
+
+            return value;
+        }
+
+        std::shared_ptr<geometry::DistanceNode> child(const builders::BuilderArgs& args, const std::string& name) const {
+            const auto& object = args.get<builders::ParamTypes::Object>(name);
+
+            if (!object) {
+                throw MissingParameterException(name);
+            }
+
+            // Evaluation keeps one value per level on a fixed size stack
+            if (m_depth >= geometry::DistanceProgram::maxDepth()) {
+                throw InvalidParameterValueException(name, "nested more than " + std::to_string(geometry::DistanceProgram::maxDepth()) + " deep");
+            }
+
+            return DistanceNodeBuilder(m_depth + 1).build(*object);
+        }
+    };
+
+    class SignedDistanceFieldBuilder : public builders::CustomShapeBuilder
+    {
+    public:
+        SignedDistanceFieldBuilder() {
+            using namespace builders;
+
+            parameter("location", ParamType::ePoint3, OPTIONAL, Point3(0, 0, 0));
+            parameter("field", ParamType::eObject, REQUIRED);
+            parameter("surface", ParamType::eSurface, REQUIRED);
+        }
+
+    private:
+        static builders::ShapeBuilder::Registration sm_registration;
+
+        virtual std::shared_ptr<Shape> construct(const builders::BuilderArgs& args) {
+            Point3 location = args.get<Point3>("location");
+            auto field = DistanceNodeBuilder().build(*args.get<builders::ParamTypes::Object>("field"));
+            const auto& surface = args.get<std::shared_ptr<Surface>>("surface");
+
+            return std::make_shared<SignedDistanceField>(*field, location, surface);
+        }
+    };
+
+}
+
+#endif
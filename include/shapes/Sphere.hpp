@@ -1,8 +1,13 @@
 #ifndef SHAPES_SPHERE_HPP
 #define SHAPES_SPHERE_HPP
 
+#include <algorithm>
+#include <cmath>
+
 #include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
 #include <shapes/Shape.hpp>
+#include <CompiledScene.hpp>
 
 namespace shapes
 {
@@ -14,6 +19,7 @@ namespace shapes
         geometry::Vector3 m_up;
         double m_radius;
         double m_radiusSquared;
+        double m_recipRadius;
 
     public:
         Sphere(const geometry::Point3& _origin, const geometry::Vector3& _up, double _radius, const std::shared_ptr<Surface>& _surface) :
@@ -21,7 +27,8 @@ namespace shapes
             m_origin(_origin),
             m_up(_up),
             m_radius(_radius),
-            m_radiusSquared(_radius * _radius)
+            m_radiusSquared(_radius * _radius),
+            m_recipRadius(1.0 / _radius)
         {
 
         }
@@ -40,18 +47,80 @@ namespace shapes
             double p1 = projectedCentre - squareRootDiscriminant;
             double p2 = projectedCentre + squareRootDiscriminant;
 
+            // The hit point relative to the centre is distance * direction - newOrigin, one radius long
             if (p1 > 0)
             {
-                return IntersectionResult(p1, this);
+                return IntersectionResult(p1, this, (p1 * ray.direction() - newOrigin) * m_recipRadius);
             }
             else if (p2 > 0)
             {
-                return IntersectionResult(p2, this);
+                return IntersectionResult(p2, this, (p2 * ray.direction() - newOrigin) * m_recipRadius);
             }
 
             return IntersectionResult();
         }
 
+        virtual void calculatePacketIntersection(const geometry::RayPacket3& packet, const geometry::PacketMask3&, PacketResults& results) const
+        {
+            using geometry::geo_type;
+            constexpr std::size_t width = geometry::RayPacket3::width();
+            double distances[width];
+            geo_type normals[3][width];
+
+            // Same arithmetic as calculateRayIntersection(), with the branches turned into selects. Every lane is
+            // computed and written, since that is cheaper than looking at the mask.
+            for (std::size_t lane = 0; lane < width; lane++)
+            {
+                geo_type x = m_origin[0] - packet.origin[0][lane];
+                geo_type y = m_origin[1] - packet.origin[1][lane];
+                geo_type z = m_origin[2] - packet.origin[2][lane];
+
+                double projectedCentre = x * packet.direction[0][lane] + y * packet.direction[1][lane] + z * packet.direction[2][lane];
+                double discriminant = m_radiusSquared - ((x * x + y * y + z * z) - projectedCentre * projectedCentre);
+
+                double squareRootDiscriminant = std::sqrt(std::max(discriminant, 0.0));
+                double p1 = projectedCentre - squareRootDiscriminant;
+                double p2 = projectedCentre + squareRootDiscriminant;
+                double distance = p1 > 0 ? p1 : (p2 > 0 ? p2 : std::numeric_limits<double>::infinity());
+
+                distances[lane] = discriminant < 0 ? std::numeric_limits<double>::infinity() : distance;
+                geo_type t = geo_type(distance);
+                normals[0][lane] = (t * packet.direction[0][lane] - x) * geo_type(m_recipRadius);
+                normals[1][lane] = (t * packet.direction[1][lane] - y) * geo_type(m_recipRadius);
+                normals[2][lane] = (t * packet.direction[2][lane] - z) * geo_type(m_recipRadius);
+            }
+
+            for (std::size_t lane = 0; lane < width; lane++)
+            {
+                results[lane] = distances[lane] < std::numeric_limits<double>::infinity() ?
+                        IntersectionResult(distances[lane], this, geometry::Vector3(normals[0][lane], normals[1][lane], normals[2][lane])) :
+                        IntersectionResult();
+            }
+        }
+
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const
+        {
+            geometry::Vector3 newOrigin = m_origin - ray.origin();
+            double projectedCentre = newOrigin * ray.direction();
+            double discriminant = m_radiusSquared - (newOrigin * newOrigin - projectedCentre * projectedCentre);
+
+            if (discriminant < 0) {
+                return false;
+            }
+
+            double squareRootDiscriminant = std::sqrt(discriminant);
+            double p1 = projectedCentre - squareRootDiscriminant;
+            double p2 = projectedCentre + squareRootDiscriminant;
+
+            return (p1 > minDistance && p1 < maxDistance) || (p2 > minDistance && p2 < maxDistance);
+        }
+
+        virtual bool compile(CompiledScene& scene) const
+        {
+            scene.addSphere(*this, m_origin, m_radiusSquared, m_recipRadius);
+            return true;
+        }
+
         virtual geometry::Vector3 calculateNormal(const geometry::Point3& p) const
         {
             return geometry::normalize(p - m_origin);
@@ -62,6 +131,27 @@ namespace shapes
             //TODO: implement
             return geometry::Point2{0, 0};
         }
+
+        virtual geometry::BoundingBox3 boundingBox() const
+        {
+            geometry::Vector3 extent(m_radius, m_radius, m_radius);
+            return geometry::BoundingBox3(m_origin - extent, m_origin + extent);
+        }
+
+        virtual double surfaceArea() const
+        {
+            return 16.0 * std::atan(1.0) * m_radiusSquared;
+        }
+
+        virtual geometry::Point3 sampleSurface(const geometry::Point2& sample) const
+        {
+            // Uniform in height and azimuth, which by Archimedes' hat-box theorem is uniform in area
+            double z = 1.0 - 2.0 * sample.x();
+            double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+            double phi = 8.0 * std::atan(1.0) * sample.y();
+
+            return m_origin + m_radius * geometry::Vector3(r * std::cos(phi), r * std::sin(phi), z);
+        }
     };
 
     class SphereBuilder : public builders::CustomShapeBuilder
@@ -91,8 +181,6 @@ namespace shapes
         }
     };
 
-    builders::ShapeBuilder::Registration SphereBuilder::sm_registration("sphere", std::make_unique<SphereBuilder>());
-
 }
 
 #endif
@@ -0,0 +1,556 @@
+#ifndef SHAPES_SPHERE_SET_HPP
+#define SHAPES_SPHERE_SET_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <acceleration/BoundingVolumeHierarchy.hpp>
+#include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
+#include <shapes/Shape.hpp>
+#include <Exceptions.hpp>
+#include <MappedFile.hpp>
+
+namespace shapes
+{
+
+    // Particles as loaded from a file: centres and radii in separate arrays, and a material index per particle if
+    // the file has them
+    struct SphereSetData
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> radius;
+        std::vector<std::uint16_t> materials;
+
+        SphereSetData() :
+            x(),
+            y(),
+            z(),
+            radius(),
+            materials()
+        {
+
+        }
+
+        std::size_t size() const
+        {
+            return x.size();
+        }
+    };
+
+    // Reads sphere set files, which are little endian binary: the eight bytes "SPHERES1", the number of particles and
+    // a word of flags as uint32, then the centre x, y and z and the radius of each particle as float32, and then, if
+    // bit 0 of the flags is set, a uint16 material index per particle.
+    class SphereSetLoader
+    {
+    public:
+        static SphereSetData load(const std::string& filename)
+        {
+            MappedFile file(filename);
+
+            if (!file.isOpen())
+            {
+                throw SphereSetLoadException(filename, "cannot open file");
+            }
+
+            const unsigned char* data = file.data();
+
+            if (file.size() < 16 || std::memcmp(data, "SPHERES1", 8) != 0)
+            {
+                throw SphereSetLoadException(filename, "not a sphere set file");
+            }
+
+            std::uint32_t count = read<std::uint32_t>(data + 8);
+            std::uint32_t flags = read<std::uint32_t>(data + 12);
+            bool hasMaterials = (flags & 1) != 0;
+            std::uint64_t expectedSize = 16 + std::uint64_t(count) * (16 + (hasMaterials ? 2 : 0));
+
+            if (file.size() != expectedSize)
+            {
+                throw SphereSetLoadException(filename, "expected " + std::to_string(expectedSize) + " bytes for " + std::to_string(count) +
+                        " particles, found " + std::to_string(file.size()));
+            }
+
+            SphereSetData spheres;
+            spheres.x.resize(count);
+            spheres.y.resize(count);
+            spheres.z.resize(count);
+            spheres.radius.resize(count);
+
+            for (std::uint32_t i = 0; i < count; i++)
+            {
+                const unsigned char* record = data + 16 + 16 * std::size_t(i);
+                spheres.x[i] = read<float>(record);
+                spheres.y[i] = read<float>(record + 4);
+                spheres.z[i] = read<float>(record + 8);
+                spheres.radius[i] = read<float>(record + 12);
+
+                if (!(spheres.radius[i] > 0.0f) || !std::isfinite(spheres.radius[i]) || !std::isfinite(spheres.x[i]) ||
+                        !std::isfinite(spheres.y[i]) || !std::isfinite(spheres.z[i]))
+                {
+                    throw SphereSetLoadException(filename, "particle " + std::to_string(i) + " is not a finite sphere");
+                }
+            }
+
+            if (hasMaterials)
+            {
+                spheres.materials.resize(count);
+
+                for (std::uint32_t i = 0; i < count; i++)
+                {
+                    spheres.materials[i] = read<std::uint16_t>(data + 16 + 16 * std::size_t(count) + 2 * std::size_t(i));
+                }
+            }
+
+            return spheres;
+        }
+
+    private:
+        template <typename T>
+        static T read(const unsigned char* bytes)
+        {
+            unsigned char ordered[sizeof(T)];
+            std::memcpy(ordered, bytes, sizeof(T));
+
+            if (isBigEndianHost())
+            {
+                std::reverse(ordered, ordered + sizeof(T));
+            }
+
+            T value;
+            std::memcpy(&value, ordered, sizeof(T));
+            return value;
+        }
+
+        static bool isBigEndianHost()
+        {
+            const std::uint16_t probe = 1;
+            unsigned char firstByte;
+            std::memcpy(&firstByte, &probe, 1);
+            return firstByte == 0;
+        }
+    };
+
+    // Large set of spheres, such as particles or a point cloud, as a single shape. The spheres are sorted along a
+    // Morton curve and grouped in clusters of sixteen, each stored as separate arrays of single precision x, y, z and
+    // radius, so the set takes about 16 bytes per sphere plus 4 for its hierarchy. The shape's bounding volume
+    // hierarchy is built over the clusters, and a cluster is tested with one pass over its lanes that compiles to
+    // vector instructions, four or eight spheres at a time. That test only has to find the lanes the ray might hit,
+    // with a margin for its rounding; those are confirmed with the same double precision test as Sphere.
+    //
+    // Each sphere may have a surface of its own, reported through the hit's material. Like meshes, sphere sets
+    // report surfaceArea() as zero and are not sampled as lights.
+    class SphereSet : public Shape
+    {
+    private:
+        static constexpr std::size_t sm_clusterWidth = 16;
+
+        // Lanes past the last sphere of the set repeat it
+        struct Cluster
+        {
+            float x[sm_clusterWidth];
+            float y[sm_clusterWidth];
+            float z[sm_clusterWidth];
+            float radius[sm_clusterWidth];
+        };
+
+        // The ray in single precision, as the cluster test uses it
+        struct ClusterRay
+        {
+            float origin[3];
+            float direction[3];
+            float slack;
+
+            // The slack is the absolute error from rounding the origin, on top of the relative error of the test itself
+            explicit ClusterRay(const geometry::Ray3& ray) :
+                origin{float(ray.origin()[0]), float(ray.origin()[1]), float(ray.origin()[2])},
+                direction{float(ray.direction()[0]), float(ray.direction()[1]), float(ray.direction()[2])},
+                slack(1e-6f * (std::abs(origin[0]) + std::abs(origin[1]) + std::abs(origin[2])))
+            {
+
+            }
+        };
+
+        // Smallest distance reported as a hit, so that rays leaving a sphere do not find the point they start from,
+        // as for triangle meshes
+        static constexpr double hitEpsilon()
+        {
+            return sizeof(geometry::geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+        }
+
+        std::vector<Cluster> m_clusters;
+        std::vector<std::uint16_t> m_materials;
+        std::vector<std::shared_ptr<Surface>> m_surfaces;
+        acceleration::BoundingVolumeHierarchy m_hierarchy;
+        std::size_t m_count;
+
+        // Bit mask of the lanes of a cluster whose sphere the ray may meet within (minDistance, maxDistance). Every
+        // lane is computed, and widened by the worst rounding of the test. The conditions are read from sign bits
+        // rather than compared, as the compiler will not vectorise float comparisons unless it may ignore traps.
+        static unsigned candidateLanes(const Cluster& cluster, const ClusterRay& ray, double minDistance, double maxDistance)
+        {
+            const float lower = float(minDistance);
+            const float upper = float(maxDistance);
+            std::int32_t missed[sm_clusterWidth];
+
+            for (std::size_t lane = 0; lane < sm_clusterWidth; lane++)
+            {
+                float x = cluster.x[lane] - ray.origin[0];
+                float y = cluster.y[lane] - ray.origin[1];
+                float z = cluster.z[lane] - ray.origin[2];
+                float projectedCentre = x * ray.direction[0] + y * ray.direction[1] + z * ray.direction[2];
+
+                // Offset of the centre from the ray, which keeps its precision where the centre is far along the ray
+                float px = x - projectedCentre * ray.direction[0];
+                float py = y - projectedCentre * ray.direction[1];
+                float pz = z - projectedCentre * ray.direction[2];
+
+                float slack = 1e-5f * (std::abs(projectedCentre) + cluster.radius[lane]) + ray.slack;
+                float reach = cluster.radius[lane] + slack;
+                float discriminant = reach * reach - (px * px + py * py + pz * pz);
+                float halfChord = std::sqrt(std::abs(discriminant));
+
+                missed[lane] = std::signbit(discriminant) | std::signbit(projectedCentre + halfChord - lower + slack) |
+                        std::signbit(upper + slack - projectedCentre + halfChord);
+            }
+
+            unsigned lanes = 0;
+
+            for (std::size_t lane = 0; lane < sm_clusterWidth; lane++)
+            {
+                lanes |= unsigned(missed[lane] == 0) << lane;
+            }
+
+            return lanes;
+        }
+
+        geometry::Point3 centre(std::uint32_t sphere) const
+        {
+            const Cluster& cluster = m_clusters[sphere / sm_clusterWidth];
+            std::size_t lane = sphere % sm_clusterWidth;
+            return geometry::Point3(cluster.x[lane], cluster.y[lane], cluster.z[lane]);
+        }
+
+        double radius(std::uint32_t sphere) const
+        {
+            return m_clusters[sphere / sm_clusterWidth].radius[sphere % sm_clusterWidth];
+        }
+
+        // Distances to where the ray enters and leaves the sphere, with Sphere's arithmetic. False if it misses.
+        bool sphereDistances(std::uint32_t sphere, const geometry::Ray3& ray, double& p1, double& p2) const
+        {
+            geometry::Vector3 newOrigin = centre(sphere) - ray.origin();
+            double projectedCentre = newOrigin * ray.direction();
+            double r = radius(sphere);
+            double discriminant = r * r - (newOrigin * newOrigin - projectedCentre * projectedCentre);
+
+            if (discriminant < 0)
+            {
+                return false;
+            }
+
+            double squareRootDiscriminant = std::sqrt(discriminant);
+            p1 = projectedCentre - squareRootDiscriminant;
+            p2 = projectedCentre + squareRootDiscriminant;
+            return true;
+        }
+
+        // Calls visitor(sphere) for every candidate sphere of the cluster, until it returns true
+        template <typename Visitor>
+        bool forCandidates(std::uint32_t cluster, const ClusterRay& clusterRay, double minDistance, double maxDistance, Visitor&& visitor) const
+        {
+            unsigned lanes = candidateLanes(m_clusters[cluster], clusterRay, minDistance, maxDistance);
+
+            for (std::uint32_t lane = 0; lanes != 0; lane++, lanes >>= 1)
+            {
+                if ((lanes & 1) && visitor(std::uint32_t(cluster * sm_clusterWidth + lane)))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+    public:
+        // The material of each sphere indexes the surfaces, of which there must be enough. Spheres without materials
+        // all take the first surface.
+        SphereSet(SphereSetData&& spheres, std::vector<std::shared_ptr<Surface>> surfaces) :
+            Shape(surfaces.front()),
+            m_clusters(),
+            m_materials(),
+            m_surfaces(std::move(surfaces)),
+            m_hierarchy(),
+            m_count(spheres.size())
+        {
+            if (m_count == 0)
+            {
+                return;
+            }
+
+            // Order along a Morton curve through the bounds of the centres, so that each cluster is compact
+            geometry::BoundingBox<double, 3> centres;
+
+            for (std::size_t i = 0; i < m_count; i++)
+            {
+                centres.expand(geometry::Point<double, 3>({spheres.x[i], spheres.y[i], spheres.z[i]}));
+            }
+
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> order(m_count);
+
+            for (std::size_t i = 0; i < m_count; i++)
+            {
+                std::array<std::uint32_t, 3> cell;
+                const double position[3] = {spheres.x[i], spheres.y[i], spheres.z[i]};
+
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    double extent = centres.extent(axis);
+                    double offset = extent > 0.0 ? (position[axis] - centres.min()[axis]) / extent : 0.0;
+                    cell[axis] = std::min(std::uint32_t(offset * 1024.0), std::uint32_t(1023));
+                }
+
+                order[i] = std::make_pair(mortonCode(cell), std::uint32_t(i));
+            }
+
+            std::sort(order.begin(), order.end());
+
+            std::size_t clusterCount = (m_count + sm_clusterWidth - 1) / sm_clusterWidth;
+            m_clusters.resize(clusterCount);
+
+            if (!spheres.materials.empty())
+            {
+                m_materials.resize(clusterCount * sm_clusterWidth);
+            }
+
+            std::vector<geometry::BoundingBox3> bounds(clusterCount);
+
+            for (std::size_t slot = 0; slot < clusterCount * sm_clusterWidth; slot++)
+            {
+                std::uint32_t i = order[std::min(slot, m_count - 1)].second;
+                Cluster& cluster = m_clusters[slot / sm_clusterWidth];
+                std::size_t lane = slot % sm_clusterWidth;
+
+                cluster.x[lane] = spheres.x[i];
+                cluster.y[lane] = spheres.y[i];
+                cluster.z[lane] = spheres.z[i];
+                cluster.radius[lane] = spheres.radius[i];
+
+                if (!m_materials.empty())
+                {
+                    m_materials[slot] = spheres.materials[i];
+                }
+
+                bounds[slot / sm_clusterWidth].expand(outwardBounds(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]));
+            }
+
+            m_hierarchy = acceleration::BoundingVolumeHierarchy(bounds);
+        }
+
+        std::size_t size() const
+        {
+            return m_count;
+        }
+
+        // Bytes held by the set, its hierarchy included
+        std::size_t memoryUsage() const
+        {
+            return m_clusters.size() * sizeof(Cluster) + m_materials.size() * sizeof(std::uint16_t) +
+                    m_hierarchy.nodes().size() * sizeof(acceleration::BoundingVolumeHierarchy::Node) +
+                    m_hierarchy.primitiveIndices().size() * sizeof(std::uint32_t);
+        }
+
+        virtual IntersectionResult calculateRayIntersection(const geometry::Ray3& ray) const override
+        {
+            ClusterRay clusterRay(ray);
+            double nearest = std::numeric_limits<double>::infinity();
+            std::uint32_t nearestSphere = 0;
+
+            m_hierarchy.intersect(ray, hitEpsilon(), nearest, [&](std::uint32_t cluster, double& distanceLimit) {
+                forCandidates(cluster, clusterRay, hitEpsilon(), distanceLimit, [&](std::uint32_t sphere) {
+                    double p1, p2;
+
+                    if (sphereDistances(sphere, ray, p1, p2))
+                    {
+                        double distance = p1 > hitEpsilon() ? p1 : p2;
+
+                        if (distance > hitEpsilon() && distance < distanceLimit)
+                        {
+                            distanceLimit = distance;
+                            nearestSphere = sphere;
+                        }
+                    }
+
+                    return false;
+                });
+            });
+
+            if (nearest == std::numeric_limits<double>::infinity())
+            {
+                return IntersectionResult();
+            }
+
+            geometry::Vector3 newOrigin = centre(nearestSphere) - ray.origin();
+            geometry::Vector3 normal = (nearest * ray.direction() - newOrigin) * (1.0 / radius(nearestSphere));
+
+            IntersectionResult result(nearest, this, normal, 0, 0, nearestSphere);
+            result.setMaterial(m_materials.empty() ? 0 : m_materials[nearestSphere]);
+            return result;
+        }
+
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const override
+        {
+            ClusterRay clusterRay(ray);
+
+            return m_hierarchy.intersectsAny(ray, minDistance, maxDistance, [&](std::uint32_t cluster, double) {
+                return forCandidates(cluster, clusterRay, minDistance, maxDistance, [&](std::uint32_t sphere) {
+                    double p1, p2;
+                    return sphereDistances(sphere, ray, p1, p2) && ((p1 > minDistance && p1 < maxDistance) || (p2 > minDistance && p2 < maxDistance));
+                });
+            });
+        }
+
+        // A set has no single normal; hits report the normal of the sphere that was hit
+        virtual geometry::Vector3 calculateNormal(const geometry::Point3&) const override
+        {
+            return geometry::Vector3{0, 0, 0};
+        }
+
+        virtual geometry::Point2 textureMap(const geometry::Point3&) const override
+        {
+            return geometry::Point2{0, 0};
+        }
+
+        virtual geometry::BoundingBox3 boundingBox() const override
+        {
+            return m_hierarchy.bounds();
+        }
+
+        virtual std::size_t surfaceCount() const override
+        {
+            return m_surfaces.size();
+        }
+
+        virtual const Surface& surface(std::size_t index) const override
+        {
+            return *m_surfaces[index];
+        }
+
+    private:
+        // Interleaves the bits of three 10 bit cell coordinates
+        static std::uint32_t mortonCode(const std::array<std::uint32_t, 3>& cell)
+        {
+            std::uint32_t code = 0;
+
+            for (std::uint32_t bit = 0; bit < 10; bit++)
+            {
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    code |= ((cell[axis] >> bit) & 1u) << (3 * bit + axis);
+                }
+            }
+
+            return code;
+        }
+
+        // Bounds of a sphere, rounded outwards to geo_type so that rounding cannot cull a ray that grazes it
+        static geometry::BoundingBox3 outwardBounds(double x, double y, double z, double r)
+        {
+            using geometry::geo_type;
+            const geo_type lowest = -std::numeric_limits<geo_type>::infinity();
+            const geo_type highest = std::numeric_limits<geo_type>::infinity();
+
+            geometry::Point3 low(std::nextafter(geo_type(x - r), lowest), std::nextafter(geo_type(y - r), lowest), std::nextafter(geo_type(z - r), lowest));
+            geometry::Point3 high(std::nextafter(geo_type(x + r), highest), std::nextafter(geo_type(y + r), highest), std::nextafter(geo_type(z + r), highest));
+
+            return geometry::BoundingBox3(low, high);
+        }
+    };
+
+    class SphereSetBuilder : public builders::CustomShapeBuilder
+    {
+    public:
+        SphereSetBuilder()
+        {
+            using namespace builders;
+
+            parameter("file", ParamType::eString, REQUIRED);
+            parameter("location", ParamType::ePoint3, OPTIONAL, Point3(0, 0, 0));
+            parameter("scale", ParamType::eFloat, OPTIONAL, 1.0);
+            parameter("surface", ParamType::eSurface, REQUIRED);
+            parameter("surfaces", ParamType::eObject, OPTIONAL, ParamTypes::Object());
+        }
+
+    private:
+        static builders::ShapeBuilder::Registration sm_registration;
+
+        virtual std::shared_ptr<Shape> construct(const builders::BuilderArgs& args)
+        {
+            const auto& file = args.get<std::string>("file");
+            Point3 location = args.get<Point3>("location");
+            double scale = args.get<double>("scale");
+            const auto& surface = args.get<std::shared_ptr<Surface>>("surface");
+            const auto& surfaceMap = args.get<builders::ParamTypes::Object>("surfaces");
+
+            if (!(scale > 0.0))
+            {
+                throw InvalidParameterValueException("scale", std::to_string(scale));
+            }
+
+            SphereSetData spheres = SphereSetLoader::load(file);
+
+            for (std::size_t i = 0; i < spheres.size(); i++)
+            {
+                spheres.x[i] = float(spheres.x[i] * scale + location[0]);
+                spheres.y[i] = float(spheres.y[i] * scale + location[1]);
+                spheres.z[i] = float(spheres.z[i] * scale + location[2]);
+                spheres.radius[i] = float(spheres.radius[i] * scale);
+            }
+
+            // Material indices pick from "surfaces", an object keyed by index; indices it leaves out take "surface"
+            std::size_t surfaceCount = 1;
+
+            for (std::uint16_t material : spheres.materials)
+            {
+                surfaceCount = std::max<std::size_t>(surfaceCount, material + 1u);
+            }
+
+            std::vector<std::shared_ptr<Surface>> surfaces(surfaceCount, surface);
+
+            if (surfaceMap)
+            {
+                for (const auto& entry : *surfaceMap)
+                {
+                    char* end = nullptr;
+                    unsigned long index = std::strtoul(entry.first.c_str(), &end, 10);
+
+                    if (entry.first.empty() || *end != '\0' || index > std::numeric_limits<std::uint16_t>::max())
+                    {
+                        throw InvalidParameterValueException("surfaces", entry.first);
+                    }
+
+                    if (index < surfaces.size())
+                    {
+                        surfaces[index] = getSurface(entry.second);
+                    }
+                }
+            }
+
+            return std::make_shared<SphereSet>(std::move(spheres), std::move(surfaces));
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,357 @@
+#ifndef SHAPES_TRIANGLE_MESH_HPP
+#define SHAPES_TRIANGLE_MESH_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <acceleration/BoundingVolumeHierarchy.hpp>
+#include <builders/CustomShapeBuilder.hpp>
+#include <builders/ShapeBuilder.hpp>
+#include <shapes/MeshCache.hpp>
+#include <shapes/MeshLoader.hpp>
+#include <shapes/Shape.hpp>
+
+namespace shapes
+{
+
+    // Triangle mesh with its own bounding volume hierarchy, so that the scene sees a single shape however many
+    // triangles it has. Vertex coordinates are kept in separate x, y and z arrays, indexed by three vertex
+    // indices per triangle. The arrays are only viewed by the mesh, so they can live in a memory mapped cache file
+    // as well as in the vectors of a freshly loaded mesh.
+    //
+    // Meshes report surfaceArea() as zero and so are not sampled as lights; emissive meshes are only found by
+    // rays that hit them.
+    class TriangleMesh : public Shape
+    {
+    private:
+        // Ray projected so that it runs along +z from the origin, as in "Watertight Ray/Triangle Intersection"
+        // (Woop, Benthin and Wald, 2013). Computed once per ray and shared by every triangle tested against it.
+        struct ShearedRay
+        {
+            std::array<double, 3> origin;
+            std::size_t kz;
+            std::size_t kx;
+            std::size_t ky;
+            double sx;
+            double sy;
+            double sz;
+
+            // Swapping kx and ky for rays along -kz keeps the winding of the projected triangles the same as seen
+            // along the ray
+            explicit ShearedRay(const geometry::Ray3& ray) :
+                origin{ray.origin()[0], ray.origin()[1], ray.origin()[2]},
+                kz(dominantAxis(ray.direction())),
+                kx((kz + (ray.direction()[kz] < 0.0 ? 2 : 1)) % 3),
+                ky((kz + (ray.direction()[kz] < 0.0 ? 1 : 2)) % 3),
+                sx(ray.direction()[kx] / ray.direction()[kz]),
+                sy(ray.direction()[ky] / ray.direction()[kz]),
+                sz(1.0 / ray.direction()[kz])
+            {
+
+            }
+
+            static std::size_t dominantAxis(const geometry::Vector3& d)
+            {
+                return std::abs(d[0]) > std::abs(d[1]) ? (std::abs(d[0]) > std::abs(d[2]) ? 0 : 2) : (std::abs(d[1]) > std::abs(d[2]) ? 1 : 2);
+            }
+        };
+
+        // Smallest distance reported as a hit. Rays leaving the surface of the mesh must not find the triangle
+        // they start on, and since the mesh reports a single nearest hit it has to skip those itself. Ray origins
+        // are only as precise as geo_type, so single precision builds need a larger margin.
+        static constexpr double hitEpsilon()
+        {
+            return sizeof(geometry::geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+        }
+
+        std::shared_ptr<const void> m_storage;
+        acceleration::ArrayView<double> m_x;
+        acceleration::ArrayView<double> m_y;
+        acceleration::ArrayView<double> m_z;
+        acceleration::ArrayView<std::uint32_t> m_indices;
+        acceleration::BoundingVolumeHierarchy m_hierarchy;
+
+        std::array<double, 3> vertex(std::uint32_t index) const
+        {
+            return {m_x[index], m_y[index], m_z[index]};
+        }
+
+        geometry::Point3 point(std::uint32_t index) const
+        {
+            return geometry::Point3(geometry::geo_type(m_x[index]), geometry::geo_type(m_y[index]), geometry::geo_type(m_z[index]));
+        }
+
+        // Distance along the ray to the triangle if it lies in (minDistance, maxDistance), or infinity otherwise.
+        // Rays through an edge or vertex shared by several triangles hit at least one of them. On a hit, u and v
+        // are the barycentric coordinates of the hit point with respect to the triangle's second and third vertex.
+        double intersectTriangle(const ShearedRay& ray, std::uint32_t triangle, double minDistance, double maxDistance, double& u, double& v) const
+        {
+            std::array<double, 3> a = vertex(m_indices[3 * triangle]);
+            std::array<double, 3> b = vertex(m_indices[3 * triangle + 1]);
+            std::array<double, 3> c = vertex(m_indices[3 * triangle + 2]);
+
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                a[axis] -= ray.origin[axis];
+                b[axis] -= ray.origin[axis];
+                c[axis] -= ray.origin[axis];
+            }
+
+            double ax = a[ray.kx] - ray.sx * a[ray.kz];
+            double ay = a[ray.ky] - ray.sy * a[ray.kz];
+            double bx = b[ray.kx] - ray.sx * b[ray.kz];
+            double by = b[ray.ky] - ray.sy * b[ray.kz];
+            double cx = c[ray.kx] - ray.sx * c[ray.kz];
+            double cy = c[ray.ky] - ray.sy * c[ray.kz];
+
+            // Scaled barycentric coordinates of a, b and c: all of the same sign exactly when the ray passes through
+            // the triangle
+            double ua = cx * by - cy * bx;
+            double ub = ax * cy - ay * cx;
+            double uc = bx * ay - by * ax;
+
+            if ((ua < 0.0 || ub < 0.0 || uc < 0.0) && (ua > 0.0 || ub > 0.0 || uc > 0.0))
+            {
+                return std::numeric_limits<double>::infinity();
+            }
+
+            double determinant = ua + ub + uc;
+
+            if (determinant == 0.0)
+            {
+                return std::numeric_limits<double>::infinity();
+            }
+
+            double scaledDistance = ua * ray.sz * a[ray.kz] + ub * ray.sz * b[ray.kz] + uc * ray.sz * c[ray.kz];
+            double recipDeterminant = 1.0 / determinant;
+            double distance = scaledDistance * recipDeterminant;
+
+            if (!(distance > minDistance && distance < maxDistance))
+            {
+                return std::numeric_limits<double>::infinity();
+            }
+
+            u = ub * recipDeterminant;
+            v = uc * recipDeterminant;
+            return distance;
+        }
+
+    public:
+        TriangleMesh(MeshData&& mesh, const std::shared_ptr<Surface>& surface) :
+            Shape(surface),
+            m_storage(),
+            m_x(),
+            m_y(),
+            m_z(),
+            m_indices(),
+            m_hierarchy()
+        {
+            auto data = std::make_shared<MeshData>(std::move(mesh));
+            m_x = data->x;
+            m_y = data->y;
+            m_z = data->z;
+            m_indices = data->indices;
+            m_storage = std::move(data);
+
+            std::vector<geometry::BoundingBox3> bounds;
+            bounds.reserve(triangleCount());
+
+            for (std::size_t triangle = 0; triangle < triangleCount(); triangle++)
+            {
+                geometry::BoundingBox3 box;
+
+                for (std::size_t corner = 0; corner < 3; corner++)
+                {
+                    box.expand(point(m_indices[3 * triangle + corner]));
+                }
+
+                bounds.push_back(box);
+            }
+
+            m_hierarchy = acceleration::BoundingVolumeHierarchy(bounds);
+        }
+
+        // Mesh over arrays that were built earlier, such as the contents of a mesh cache. The storage keeps the
+        // arrays alive for as long as the mesh exists.
+        TriangleMesh(acceleration::ArrayView<double> x, acceleration::ArrayView<double> y, acceleration::ArrayView<double> z,
+                acceleration::ArrayView<std::uint32_t> indices, const acceleration::BoundingVolumeHierarchy& hierarchy,
+                std::shared_ptr<const void> storage, const std::shared_ptr<Surface>& surface) :
+            Shape(surface),
+            m_storage(std::move(storage)),
+            m_x(x),
+            m_y(y),
+            m_z(z),
+            m_indices(indices),
+            m_hierarchy(hierarchy)
+        { }
+
+        acceleration::ArrayView<double> x() const { return m_x; }
+        acceleration::ArrayView<double> y() const { return m_y; }
+        acceleration::ArrayView<double> z() const { return m_z; }
+        acceleration::ArrayView<std::uint32_t> indices() const { return m_indices; }
+
+        const acceleration::BoundingVolumeHierarchy& hierarchy() const
+        {
+            return m_hierarchy;
+        }
+
+        std::size_t triangleCount() const
+        {
+            return m_indices.size() / 3;
+        }
+
+        std::size_t vertexCount() const
+        {
+            return m_x.size();
+        }
+
+        virtual IntersectionResult calculateRayIntersection(const geometry::Ray3& ray) const override
+        {
+            ShearedRay sheared(ray);
+            double nearest = std::numeric_limits<double>::infinity();
+            std::uint32_t nearestTriangle = 0;
+            double nearestU = 0.0;
+            double nearestV = 0.0;
+
+            m_hierarchy.intersect(ray, hitEpsilon(), nearest, [&](std::uint32_t triangle, double& distanceLimit) {
+                double u, v;
+                double distance = intersectTriangle(sheared, triangle, hitEpsilon(), distanceLimit, u, v);
+
+                if (distance < distanceLimit)
+                {
+                    distanceLimit = distance;
+                    nearestTriangle = triangle;
+                    nearestU = u;
+                    nearestV = v;
+                }
+            });
+
+            if (nearest == std::numeric_limits<double>::infinity())
+            {
+                return IntersectionResult();
+            }
+
+            // Only the nearest triangle's normal is needed, so it is worked out once the traversal is over
+            std::array<double, 3> a = vertex(m_indices[3 * nearestTriangle]);
+            std::array<double, 3> b = vertex(m_indices[3 * nearestTriangle + 1]);
+            std::array<double, 3> c = vertex(m_indices[3 * nearestTriangle + 2]);
+            geometry::Vector<double, 3> ab({b[0] - a[0], b[1] - a[1], b[2] - a[2]});
+            geometry::Vector<double, 3> ac({c[0] - a[0], c[1] - a[1], c[2] - a[2]});
+            geometry::Vector<double, 3> normal = geometry::normalize(geometry::cross_product(ab, ac));
+
+            return IntersectionResult(nearest, this, geometry::Vector3(geometry::geo_type(normal[0]), geometry::geo_type(normal[1]),
+                    geometry::geo_type(normal[2])), float(nearestU), float(nearestV), nearestTriangle);
+        }
+
+        virtual bool intersectsWithin(const geometry::Ray3& ray, double minDistance, double maxDistance) const override
+        {
+            ShearedRay sheared(ray);
+
+            return m_hierarchy.intersectsAny(ray, minDistance, maxDistance, [&](std::uint32_t triangle, double) {
+                double u, v;
+                return intersectTriangle(sheared, triangle, minDistance, maxDistance, u, v) < maxDistance;
+            });
+        }
+
+        // A mesh has no single normal; hits report the normal of the triangle that was hit
+        virtual geometry::Vector3 calculateNormal(const geometry::Point3&) const override
+        {
+            return geometry::Vector3{0, 0, 0};
+        }
+
+        virtual geometry::Point2 textureMap(const geometry::Point3&) const override
+        {
+            return geometry::Point2{0, 0};
+        }
+
+        virtual geometry::BoundingBox3 boundingBox() const override
+        {
+            return m_hierarchy.bounds();
+        }
+    };
+
+    class TriangleMeshBuilder : public builders::CustomShapeBuilder
+    {
+    public:
+        TriangleMeshBuilder()
+        {
+            using namespace builders;
+
+            parameter("file", ParamType::eString, REQUIRED);
+            parameter("location", ParamType::ePoint3, OPTIONAL, Point3(0, 0, 0));
+            parameter("scale", ParamType::eFloat, OPTIONAL, 1.0);
+            parameter("orientation", ParamType::eVector3, OPTIONAL, Vector3(0, 0, 0));
+            parameter("surface", ParamType::eSurface, REQUIRED);
+            parameter("cache", ParamType::eBoolean, OPTIONAL, true);
+        }
+
+    private:
+        static builders::ShapeBuilder::Registration sm_registration;
+
+        virtual std::shared_ptr<Shape> construct(const builders::BuilderArgs& args)
+        {
+            const auto& file = args.get<std::string>("file");
+            Point3 location = args.get<Point3>("location");
+            double scale = args.get<double>("scale");
+            Vector3 orientation = args.get<Vector3>("orientation");
+            const auto& surface = args.get<std::shared_ptr<Surface>>("surface");
+            bool useCache = args.get<bool>("cache");
+
+            if (!(scale > 0.0))
+            {
+                throw InvalidParameterValueException("scale", std::to_string(scale));
+            }
+
+            // The cache holds transformed vertices and their hierarchy, so it is keyed by everything that affects them
+            const auto& buildSettings = acceleration::BoundingVolumeHierarchy::defaultBuildSettings();
+            const double params[] = {scale, location[0], location[1], location[2], orientation[0], orientation[1], orientation[2],
+                    double(buildSettings.maxLeafSize), double(sizeof(geometry::geo_type)), double(buildSettings.method)};
+            std::uint64_t paramsHash = MeshCache::hash(params, sizeof(params), MeshCache::formatVersion());
+            std::string cachePath = MeshCache::path(file, paramsHash);
+            MeshCache::Entry entry;
+
+            if (useCache && MeshCache::load(cachePath, file, paramsHash, entry))
+            {
+                return std::make_shared<TriangleMesh>(entry.x, entry.y, entry.z, entry.indices, entry.hierarchy, entry.storage, surface);
+            }
+
+            MeshData mesh = MeshLoader::load(file);
+
+            // Orientation is given in turns about each axis, as for boxes. Vertices are stored in double precision
+            // whatever geo_type is, so they are transformed in double precision too.
+            const double turn = 8.0 * std::atan(1.0);
+            auto rotationTransform = geometry::rotation<double>(orientation[0] * turn, orientation[1] * turn, orientation[2] * turn);
+            geometry::Vector<double, 3> origin({location[0], location[1], location[2]});
+
+            for (std::size_t i = 0; i < mesh.vertexCount(); i++)
+            {
+                geometry::Point<double, 3> p = rotationTransform * geometry::Point<double, 3>({mesh.x[i] * scale, mesh.y[i] * scale, mesh.z[i] * scale}) + origin;
+                mesh.x[i] = p[0];
+                mesh.y[i] = p[1];
+                mesh.z[i] = p[2];
+            }
+
+            auto triangleMesh = std::make_shared<TriangleMesh>(std::move(mesh), surface);
+
+            if (useCache)
+            {
+                entry.x = triangleMesh->x();
+                entry.y = triangleMesh->y();
+                entry.z = triangleMesh->z();
+                entry.indices = triangleMesh->indices();
+                entry.hierarchy = triangleMesh->hierarchy();
+                MeshCache::store(cachePath, file, paramsHash, entry);
+            }
+
+            return triangleMesh;
+        }
+    };
+
+}
+
+#endif
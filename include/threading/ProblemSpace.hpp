@@ -0,0 +1,217 @@
+#ifndef PROBLEM_SPACE_HPP
+#define PROBLEM_SPACE_HPP
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace threading
+{
+
+    class ProblemSpace;
+
+    class Problem
+    {
+    private:
+        const ProblemSpace* m_problemSpace;
+        std::array<unsigned int, 4> m_currentProblem;
+        std::size_t m_index;
+        std::size_t m_pass;
+
+        Problem(const ProblemSpace&  _problemSpace, const std::array<unsigned int, 4>& _currentProblem = {0, 0, 0, 0}, std::size_t _index = 0) :
+            m_problemSpace(&_problemSpace),
+            m_currentProblem(_currentProblem),
+            m_index(_index),
+            m_pass(0)
+        { }
+
+    public:
+        Problem() :
+            m_problemSpace(nullptr),
+            m_currentProblem({0, 0, 0, 0}),
+            m_index(0),
+            m_pass(0)
+        { }
+
+        Problem& operator++();
+
+        Problem operator++(int) {
+            Problem it(*this);
+            ++(*this);
+            return it;
+        }
+
+        bool operator==(const Problem& rhs) const {
+            return m_currentProblem == rhs.m_currentProblem;
+        }
+
+        bool operator!=(const Problem& rhs) const {
+            return m_currentProblem != rhs.m_currentProblem;
+        }
+
+        unsigned int operator[](unsigned int dimensionId) const {
+            return m_currentProblem[dimensionId];
+        }
+
+        // Position of the problem in the problem space's iteration order
+        std::size_t index() const {
+            return m_index;
+        }
+
+        // Pass over the problem space this problem belongs to, for tasks that visit every problem repeatedly
+        std::size_t pass() const {
+            return m_pass;
+        }
+
+        friend class ProblemSpace;
+        friend class Task;
+    };
+
+    class ProblemSpace
+    {
+    public:
+        // Order in which the first two dimensions are walked. Morton and Hilbert orders keep consecutive problems
+        // close together in 2D, so that neighbouring work items touch the same data.
+        enum class Ordering
+        {
+            eLinear,
+            eMorton,
+            eHilbert
+        };
+
+    private:
+        std::array<unsigned int, 4> m_dimensions;
+        Ordering m_ordering;
+        std::shared_ptr<const std::vector<std::uint32_t>> m_order;    // Rank on the curve -> row-major 2D index
+
+        static void mortonDecode(std::uint64_t d, std::uint32_t& x, std::uint32_t& y) {
+            x = 0;
+            y = 0;
+
+            for (std::uint32_t bit = 0; bit < 32; bit++) {
+                x |= std::uint32_t((d >> (2 * bit)) & 1) << bit;
+                y |= std::uint32_t((d >> (2 * bit + 1)) & 1) << bit;
+            }
+        }
+
+        static void hilbertDecode(std::uint64_t d, std::uint32_t side, std::uint32_t& x, std::uint32_t& y) {
+            x = 0;
+            y = 0;
+
+            for (std::uint32_t s = 1; s < side; s *= 2) {
+                std::uint32_t rx = std::uint32_t(1 & (d / 2));
+                std::uint32_t ry = std::uint32_t(1 & (d ^ rx));
+
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = s - 1 - x;
+                        y = s - 1 - y;
+                    }
+
+                    std::swap(x, y);
+                }
+
+                x += s * rx;
+                y += s * ry;
+                d /= 4;
+            }
+        }
+
+        void buildOrder() {
+            std::uint32_t width = m_dimensions[0];
+            std::uint32_t height = m_dimensions[1];
+            std::uint32_t side = 1;
+
+            while (side < width || side < height) {
+                side *= 2;
+            }
+
+            // Walk the curve over the enclosing power of two square, keeping the cells that fall inside the space
+            auto order = std::make_shared<std::vector<std::uint32_t>>();
+            order->reserve(std::size_t(width) * height);
+
+            for (std::uint64_t d = 0; d < std::uint64_t(side) * side; d++) {
+                std::uint32_t x;
+                std::uint32_t y;
+
+                if (m_ordering == Ordering::eMorton) {
+                    mortonDecode(d, x, y);
+                } else {
+                    hilbertDecode(d, side, x, y);
+                }
+
+                if (x < width && y < height) {
+                    order->push_back(y * width + x);
+                }
+            }
+
+            m_order = std::move(order);
+        }
+
+    public:
+        typedef Problem iterator;
+        typedef Problem const_iterator;
+
+        ProblemSpace(unsigned int w, unsigned int x = 1, unsigned int y = 1, unsigned int z = 1, Ordering ordering = Ordering::eLinear) :
+            m_dimensions({w, x, y, z}),
+            m_ordering(ordering),
+            m_order()
+        {
+            if (m_ordering != Ordering::eLinear && size() > 0) {
+                buildOrder();
+            }
+        }
+
+        ProblemSpace::iterator begin() const {
+            return at(0);
+        }
+
+        ProblemSpace::iterator end() const {
+            return ProblemSpace::iterator(*this, {0, 0, 0, m_dimensions[3]}, size());
+        }
+
+        unsigned int dimension(unsigned int dimensionId) const {
+            return m_dimensions[dimensionId];
+        }
+
+        Ordering ordering() const {
+            return m_ordering;
+        }
+
+        std::size_t size() const {
+            return std::size_t(m_dimensions[0]) * m_dimensions[1] * m_dimensions[2] * m_dimensions[3];
+        }
+
+        // Random access in iteration order, so that ranges of problems can be handed out as plain index ranges
+        ProblemSpace::iterator at(std::size_t index) const {
+            if (index >= size()) {
+                return end();
+            }
+
+            std::size_t planeSize = std::size_t(m_dimensions[0]) * m_dimensions[1];
+            std::size_t cell = m_order ? (*m_order)[index % planeSize] : index % planeSize;
+            std::size_t outer = index / planeSize;
+
+            std::array<unsigned int, 4> problem = {
+                (unsigned int)(cell % m_dimensions[0]),
+                (unsigned int)(cell / m_dimensions[0]),
+                (unsigned int)(outer % m_dimensions[2]),
+                (unsigned int)(outer / m_dimensions[2])
+            };
+
+            return ProblemSpace::iterator(*this, problem, index);
+        }
+
+        friend class Problem;
+    };
+
+    inline Problem& Problem::operator++() {
+        *this = m_problemSpace->at(m_index + 1);
+        return *this;
+    }
+
+}
+
+#endif // PROBLEM_SPACE_HPP
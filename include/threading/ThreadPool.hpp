@@ -1,144 +1,179 @@
 #ifndef ThreadPool_HPP
 #define ThreadPool_HPP
 
-#include <array>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <utility>
 #include <vector>
 
 #include <graphics/Image.hpp>
-#include <threading/Barrier.hpp>
-#include <threading/Semaphore.hpp>
+#include <threading/ProblemSpace.hpp>
+#include <threading/TileLayout.hpp>
+#include <threading/WorkStealingQueue.hpp>
 
 namespace threading
 {
 
-    class ProblemSpace;
-
-    class Problem
+    // How often a task runs over its tiles, and when it stops early. Tasks with several passes visit every tile
+    // once per pass; the next pass starts when the previous one has finished.
+    struct PassSettings
     {
-    private:
-        const ProblemSpace* m_problemSpace;
-        std::array<unsigned int, 4> m_currentProblem;
+        std::size_t passCount = 1;
 
-        Problem(const ProblemSpace&  _problemSpace, const std::array<unsigned int, 4>& _currentProblem = {0, 0, 0, 0}) :
-            m_problemSpace(&_problemSpace),
-            m_currentProblem(_currentProblem)
-        { }
-
-    public:
-        Problem() :
-            m_problemSpace(nullptr),
-            m_currentProblem({0, 0, 0, 0})
-        { }
-
-        Problem& operator++();
-
-        Problem operator++(int) {
-            Problem it(*this);
-            ++(*this);
-            return it;
-        }
+        // No tiles are started past the deadline; the task then completes successfully with the work done so far
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
 
-        bool operator==(const Problem& rhs) const {
-            return m_currentProblem == rhs.m_currentProblem;
-        }
-
-        bool operator!=(const Problem& rhs) const {
-            return m_currentProblem != rhs.m_currentProblem;
-        }
-
-        unsigned int operator[](unsigned int dimensionId) const {
-            return m_currentProblem[dimensionId];
-        }
-
-        friend class ProblemSpace;
+        // Called with the number of passes completed after every pass but the last; returning true ends the task
+        std::function<bool(std::size_t passesCompleted)> stopCondition = nullptr;
     };
 
-    class ProblemSpace
-    {
-    private:
-        std::array<unsigned int, 4> m_dimensions;
-
-    public:
-        typedef Problem iterator;
-        typedef Problem const_iterator;
-
-        ProblemSpace(unsigned int w, unsigned int x = 1, unsigned int y = 1, unsigned int z = 1) :
-            m_dimensions({w, x, y, z})
-        { }
-
-        ProblemSpace::iterator begin() const {
-            return ProblemSpace::iterator(*this, {0, 0, 0, 0});
-        }
-
-        ProblemSpace::iterator end() const {
-            return ProblemSpace::iterator(*this, {0, 0, 0, m_dimensions[3]});
-        }
-
-        friend class Problem;
-    };
-
-    inline Problem& Problem::operator++() {
-        auto& p = m_currentProblem;
-        p[0] = (p[0] + 1) % m_problemSpace->m_dimensions[0];
-        p[1] = (p[1] + (p[0] == 0)) % m_problemSpace->m_dimensions[1];
-        p[2] = (p[2] + (p[0] == 0 && p[1] == 0)) % m_problemSpace->m_dimensions[2];
-        p[3] = (p[3] + (p[0] == 0 && p[1] == 0 && p[2] == 0));
-
-        return *this;
-    }
-
-
     class Task
     {
     private:
         typedef std::function<void(graphics::Image<graphics::ColourRgb<float>>& result, const Problem& problem, const std::atomic<bool>& cancelled)> TaskFunction;
+        typedef std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, const Tile&)> TileCallback;
 
         TaskFunction m_function;
-        ProblemSpace m_problemSpace;
-        std::unique_ptr<std::mutex> m_statusMutex;
-        std::unique_ptr<std::condition_variable> m_taskComplete;
+        TileLayout m_tiles;
+        PassSettings m_passSettings;
+        std::mutex m_statusMutex;
+        std::condition_variable m_taskComplete;
         std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, bool success)> m_completeCallback;
-        std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, const Problem&)> m_problemCallback;
+        std::shared_ptr<const TileCallback> m_tileCallback; // Only accessed through std::atomic_load and std::atomic_store
         std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result)> m_startCallback;
+        std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, std::size_t passesCompleted)> m_passCallback;
         std::atomic<bool> m_cancelled;
+        std::atomic<bool> m_stopRequested;
+        std::atomic<bool> m_timedOut;
+        std::atomic<bool> m_started;
+        std::atomic<std::size_t> m_remainingProblems;
+        std::atomic<std::size_t> m_passesCompleted;
+        std::size_t m_grainSize;
+        bool m_startNotified;
         bool m_completed;
         graphics::Image<graphics::ColourRgb<float>> m_result;
 
+        // Callbacks registered after the event they describe are invoked straight away, so a handle can be
+        // configured after the task has already been picked up by a worker.
         void notifyComplete() {
-            std::unique_lock<std::mutex> lock(*m_statusMutex);
+            std::unique_lock<std::mutex> lock(m_statusMutex);
             m_completed = true;
-            m_taskComplete->notify_all();
+            m_taskComplete.notify_all();
 
             if (m_completeCallback) {
                 m_completeCallback(m_result, !m_cancelled);
             }
         }
 
-        void notifyProblem(const Problem& problem) {
-            if (m_problemCallback) {
-                m_problemCallback(m_result, problem);
+        // Runs for every tile, so it does not take the status mutex; workers finishing tiles at once call the
+        // callback side by side
+        void notifyTile(const Problem& problem) {
+            std::shared_ptr<const TileCallback> callback = std::atomic_load(&m_tileCallback);
+
+            if (callback) {
+                (*callback)(m_result, m_tiles.tile(problem));
             }
         }
 
         void notifyStarted() {
+            if (m_started.exchange(true)) {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(m_statusMutex);
+            m_startNotified = true;
+
             if (m_startCallback) {
                 m_startCallback(m_result);
             }
         }
 
-        Task(graphics::Image<graphics::ColourRgb<float>>&& _image, const TaskFunction& _function, const ProblemSpace& _problemSpace) :
+        void run(std::size_t problemIndex) {
+            Problem problem = m_tiles.problemSpace().at(problemIndex);
+            problem.m_pass = m_passesCompleted;
+
+            //Execute task on a single problem from the problem space
+            m_function(m_result, problem, m_cancelled);
+            notifyTile(problem);
+        }
+
+        // Returns true once every problem of the current pass has been accounted for
+        bool retire(std::size_t problemCount) {
+            return m_remainingProblems.fetch_sub(problemCount) == problemCount;
+        }
+
+        // Called by the worker that retired the last problem of a pass. Returns true if the task goes on with
+        // another pass, or completes the task and returns false.
+        bool finishPass() {
+            std::size_t passesCompleted = m_passesCompleted + 1;
+
+            {
+                std::unique_lock<std::mutex> lock(m_statusMutex);
+
+                if (m_passCallback) {
+                    m_passCallback(m_result, passesCompleted);
+                }
+            }
+
+            bool another = !halted() && passesCompleted < m_passSettings.passCount &&
+                    !(m_passSettings.stopCondition && m_passSettings.stopCondition(passesCompleted));
+
+            if (another) {
+                m_remainingProblems = m_tiles.tileCount();
+            } else if (passesCompleted < m_passSettings.passCount && deadlinePassed()) {
+                noteDeadline();
+            }
+
+            m_passesCompleted = passesCompleted;
+
+            if (!another) {
+                notifyComplete();
+            }
+
+            return another;
+        }
+
+        // Remaining problems are skipped once the task is cancelled, stopped or past its deadline
+        bool halted() const {
+            return m_cancelled || m_stopRequested || deadlinePassed();
+        }
+
+        bool deadlinePassed() const {
+            return std::chrono::steady_clock::now() >= m_passSettings.deadline;
+        }
+
+        // Records that work was left undone because of the deadline, unless the task was ended on purpose
+        void noteDeadline() {
+            if (!m_cancelled && !m_stopRequested) {
+                m_timedOut = true;
+            }
+        }
+
+        Task(graphics::Image<graphics::ColourRgb<float>>&& _image, const TaskFunction& _function, const TileLayout& _tiles,
+                const PassSettings& _passSettings, std::size_t _grainSize) :
             m_function(_function),
-            m_problemSpace(_problemSpace),
-            m_statusMutex(std::make_unique<std::mutex>()),
-            m_taskComplete(std::make_unique<std::condition_variable>()),
+            m_tiles(_tiles),
+            m_passSettings(_passSettings),
+            m_statusMutex(),
+            m_taskComplete(),
+            m_completeCallback(),
+            m_tileCallback(),
+            m_startCallback(),
+            m_passCallback(),
             m_cancelled(false),
+            m_stopRequested(false),
+            m_timedOut(false),
+            m_started(false),
+            m_remainingProblems(_tiles.tileCount()),
+            m_passesCompleted(0),
+            m_grainSize(std::max<std::size_t>(_grainSize, 1)),
+            m_startNotified(false),
             m_completed(false),
             m_result(std::move(_image))
         { }
@@ -147,40 +182,39 @@ namespace threading
         Task(const Task&) = delete;
         Task& operator=(const Task&) = delete;
 
-        Task(Task&& task) :
-            m_function(std::move(task.m_function)),
-            m_problemSpace(std::move(task.m_problemSpace)),
-            m_statusMutex(std::move(task.m_statusMutex)),
-            m_taskComplete(std::move(task.m_taskComplete)),
-            m_cancelled(task.m_cancelled.load()),
-            m_completed(std::move(task.m_completed)),
-            m_result(std::move(task.m_result))
-        { }
+        void wait() {
+            std::unique_lock<std::mutex> lock(m_statusMutex);
+            m_taskComplete.wait(lock, [this]() { return m_completed; });
+        }
 
+        template<typename Rep, typename Period>
+        bool wait_for(const std::chrono::duration<Rep, Period>& rel_time) {
+            std::unique_lock<std::mutex> lock(m_statusMutex);
+            return m_taskComplete.wait_for(lock, rel_time, [this]() { return m_completed; });
+        }
 
-        Task& operator=(Task&& task) {
-            m_function = std::move(task.m_function);
-            m_problemSpace = std::move(task.m_problemSpace);
-            m_statusMutex = std::move(task.m_statusMutex);
-            m_taskComplete = std::move(task.m_taskComplete);
-            m_cancelled = task.m_cancelled.load();
-            m_completed = std::move(task.m_completed);
-            m_result = std::move(task.m_result);
+        void cancel() {
+            m_cancelled = true;
+        }
 
-            return *this;
+        // Ends the task early like cancel(), except that it completes successfully: tiles already rendered are
+        // kept as the result
+        void stop() {
+            m_stopRequested = true;
         }
 
-        void wait() {
-            std::unique_lock<std::mutex> lock(*m_statusMutex);
-            m_taskComplete->wait(lock, [this]() { return m_completed; });
+        // Passes finished so far; the last one may have been cut short by stop() or the deadline
+        std::size_t passesCompleted() const {
+            return m_passesCompleted;
         }
 
-        void cancel() {
-            m_cancelled = true;
+        // True if the task was ended by its deadline rather than by running all of its passes
+        bool timedOut() const {
+            return m_timedOut;
         }
 
         bool completed() {
-            std::unique_lock<std::mutex> lock(*m_statusMutex);
+            std::unique_lock<std::mutex> lock(m_statusMutex);
             return m_completed;
         }
 
@@ -188,24 +222,38 @@ namespace threading
             return m_cancelled;
         }
 
-        const ProblemSpace& problemSpace() const {
-            return m_problemSpace;
-        }
-
-        void operator()(ProblemSpace::iterator problem) {
-            m_function(m_result, problem, m_cancelled);
+        const TileLayout& tiles() const {
+            return m_tiles;
         }
 
         void setCompleteCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, bool success)> func) {
+            std::unique_lock<std::mutex> lock(m_statusMutex);
             m_completeCallback = func;
+
+            if (m_completed && m_completeCallback) {
+                m_completeCallback(m_result, !m_cancelled);
+            }
         }
 
-        void setProblemCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, const Problem&)> func) {
-            m_problemCallback = func;
+        // Called as each tile is finished, from the worker that rendered it. Unlike the other callbacks, calls for
+        // different tiles may run at the same time.
+        void setTileCallback(TileCallback func) {
+            std::atomic_store(&m_tileCallback, func ? std::make_shared<const TileCallback>(std::move(func)) : nullptr);
         }
 
         void setStartCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result)> func) {
+            std::unique_lock<std::mutex> lock(m_statusMutex);
             m_startCallback = func;
+
+            if (m_startNotified && m_startCallback) {
+                m_startCallback(m_result);
+            }
+        }
+
+        // Called after each pass, from the worker that finished it, before the next pass starts
+        void setPassCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, std::size_t passesCompleted)> func) {
+            std::unique_lock<std::mutex> lock(m_statusMutex);
+            m_passCallback = func;
         }
 
         const graphics::Image<graphics::ColourRgb<float>>& result() const {
@@ -234,161 +282,250 @@ namespace threading
             m_task->wait();
         }
 
+        template<typename Rep, typename Period>
+        bool wait_for(const std::chrono::duration<Rep, Period>& rel_time) {
+            return m_task->wait_for(rel_time);
+        }
+
         void cancel() {
             m_task->cancel();
         }
 
+        void stop() {
+            m_task->stop();
+        }
+
+        std::size_t passesCompleted() const {
+            return m_task->passesCompleted();
+        }
+
+        bool timedOut() const {
+            return m_task->timedOut();
+        }
+
         bool completed() {
             return m_task->completed();
         }
 
+        // Only safe to read once the task has completed
+        const graphics::Image<graphics::ColourRgb<float>>& result() const {
+            return m_task->result();
+        }
+
         void setCompleteCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, bool success)> func) {
             m_task->setCompleteCallback(func);
         }
 
-        void setProblemCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, const Problem&)> func) {
-            m_task->setProblemCallback(func);
+        void setTileCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, const Tile&)> func) {
+            m_task->setTileCallback(func);
         }
 
         void setStartCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result)> func) {
             m_task->setStartCallback(func);
         }
 
+        void setPassCallback(std::function<void(const graphics::Image<graphics::ColourRgb<float>>& result, std::size_t passesCompleted)> func) {
+            m_task->setPassCallback(func);
+        }
+
         friend class ThreadPool;
     };
 
+    // Work stealing pool. Every task enters as a single job covering its whole problem space; whoever runs a job
+    // splits it in halves until it is down to the task's grain size, keeping one half and pushing the rest onto its
+    // own deque for idle workers to steal. Any number of tasks can be in flight at once: new tasks are taken from
+    // the shared injection queue before local work, so a long running task does not starve one queued behind it.
     class ThreadPool
     {
     private:
+        struct Job
+        {
+            std::shared_ptr<Task> task;
+            std::size_t begin;
+            std::size_t end;
+
+            Job(std::shared_ptr<Task> _task = nullptr, std::size_t _begin = 0, std::size_t _end = 0) :
+                task(std::move(_task)),
+                begin(_begin),
+                end(_end)
+            { }
+        };
+
+        // Target number of jobs per worker a task is split into, trading scheduling overhead for load balance
+        static constexpr std::size_t sm_jobsPerWorker = 8;
+
+        std::vector<std::unique_ptr<WorkStealingQueue<Job>>> m_queues;
+        WorkStealingQueue<Job> m_injectedJobs;
         std::vector<std::thread> m_threads;
-        std::queue<std::shared_ptr<Task>> m_tasks;
-        std::mutex m_threadCounterMutex;
-        std::mutex m_problemMutex;
-        std::mutex m_queueMutex;
-        std::condition_variable m_tasksComplete;
-        std::size_t m_threadsDoneCount;
-        std::size_t m_totalThreads;
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wakeup;
+        std::atomic<std::size_t> m_queuedJobs;
+        std::atomic<std::size_t> m_sleepingWorkers;
+        std::atomic<std::size_t> m_activeTasks;
         std::atomic<bool> m_closeRequested;
-        std::atomic<bool> m_closing;
-        ProblemSpace::iterator m_currentProblem;
-        Semaphore m_queueSemaphore;
-        Barrier m_barrier;
-        bool m_running;
-
-        std::shared_ptr<Task> getNextTask() {
-            std::unique_lock<std::mutex> counterLock(m_threadCounterMutex);
-            m_threadsDoneCount++;
-
-            if (m_threadsDoneCount >= m_totalThreads) {
-                while (!m_queueSemaphore.wait_for(std::chrono::milliseconds(100))) {
-                    if (m_closeRequested) {
-                        m_closing = true;
-                        m_barrier.notify_all();
-                        return nullptr;
-                    }
-                }
 
-                m_threadsDoneCount = 0;
-                m_currentProblem = m_tasks.front()->problemSpace().begin();
+        void wakeWorker() {
+            if (m_sleepingWorkers > 0) {
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
+                m_wakeup.notify_one();
             }
+        }
 
-            counterLock.unlock();
-            m_barrier.wait_until_condition([this]() { return m_closing.load(); });
+        void pushJob(std::size_t workerId, Job&& job) {
+            m_queues[workerId]->push(std::move(job));
+            m_queuedJobs++;
+            wakeWorker();
+        }
 
-            if (m_closing) {
-                return nullptr;
+        bool tryAcquireJob(std::size_t workerId, Job& job) {
+            if (m_injectedJobs.steal(job) || m_queues[workerId]->pop(job)) {
+                m_queuedJobs--;
+                return true;
             }
 
-            return m_tasks.front();
-        }
+            for (std::size_t i = 1; i < m_queues.size(); i++) {
+                if (m_queues[(workerId + i) % m_queues.size()]->steal(job)) {
+                    m_queuedJobs--;
+                    return true;
+                }
+            }
 
-        void retireTask(std::shared_ptr<Task>& task) {
-            std::unique_lock<std::mutex> counterLock(m_threadCounterMutex);
-            m_threadsDoneCount++;
+            return false;
+        }
 
-            if (m_threadsDoneCount >= m_totalThreads) {
-                task->notifyComplete();
-                m_threadsDoneCount = 0;
+        bool acquireJob(std::size_t workerId, Job& job) {
+            while (!tryAcquireJob(workerId, job)) {
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
 
-                std::unique_lock<std::mutex> queueLock(m_queueMutex);
-                m_tasks.pop();
+                // Pushers bump m_queuedJobs before reading m_sleepingWorkers, so either they see this worker
+                // asleep and notify it or the predicate sees their job.
+                m_sleepingWorkers++;
+                m_wakeup.wait(lock, [this]() { return m_queuedJobs > 0 || (m_closeRequested && m_activeTasks == 0); });
+                m_sleepingWorkers--;
 
-                if (m_tasks.empty()) {
-                    m_tasksComplete.notify_all();
+                if (m_closeRequested && m_activeTasks == 0) {
+                    return false;
                 }
             }
 
-            counterLock.unlock();
-            m_barrier.wait();
+            return true;
         }
 
-        void threadFunction() {
-            while (true) {
-                std::shared_ptr<Task> task = getNextTask();
-                ProblemSpace::iterator problem;
+        void executeJob(std::size_t workerId, Job& job) {
+            Task& task = *job.task;
+            task.notifyStarted();
 
-                if (!task) {
-                    return;
-                }
-
-                task->notifyStarted();
+            while (job.end - job.begin > task.m_grainSize && !task.halted()) {
+                std::size_t middle = job.begin + (job.end - job.begin) / 2;
+                pushJob(workerId, Job{job.task, middle, job.end});
+                job.end = middle;
+            }
 
-                while (!task->cancelled()) {
-                    std::unique_lock<std::mutex> problemLock(m_problemMutex);
+            std::size_t next = job.begin;
 
-                    if (m_currentProblem == task->problemSpace().end()) {
-                        break;
-                    }
+            for (; next < job.end && !task.halted(); next++) {
+                task.run(next);
+            }
 
-                    problem = m_currentProblem++;
-                    problemLock.unlock();
+            if (next < job.end) {
+                task.noteDeadline();
+            }
 
-                    //Execute task on a single problem from the problem space
-                    (*task)(problem);
-                    task->notifyProblem(problem);
+            // Halted problems are retired without running, so the task still completes
+            if (task.retire(job.end - job.begin)) {
+                if (task.finishPass()) {
+                    pushJob(workerId, Job{job.task, 0, task.m_tiles.tileCount()});
+                } else {
+                    retireTask();
                 }
+            }
+        }
+
+        void retireTask() {
+            if (--m_activeTasks == 0 && m_closeRequested) {
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
+                m_wakeup.notify_all();
+            }
+        }
 
-                retireTask(task);
+        void threadFunction(std::size_t workerId) {
+            Job job;
+
+            while (acquireJob(workerId, job)) {
+                executeJob(workerId, job);
+                job.task.reset();
             }
         }
 
     public:
-        ThreadPool() :
-            m_threadsDoneCount(0),
-            m_totalThreads(std::thread::hardware_concurrency()),
-            m_closeRequested(false),
-            m_closing(false),
-            m_queueSemaphore(0),
-            m_barrier(std::thread::hardware_concurrency()),
-            m_running(false)
-        { }
+        explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency()) :
+            m_queues(),
+            m_injectedJobs(),
+            m_threads(),
+            m_sleepMutex(),
+            m_wakeup(),
+            m_queuedJobs(0),
+            m_sleepingWorkers(0),
+            m_activeTasks(0),
+            m_closeRequested(false)
+        {
+            threadCount = std::max<std::size_t>(threadCount, 1);
+
+            for (std::size_t i = 0; i < threadCount; i++) {
+                m_queues.emplace_back(std::make_unique<WorkStealingQueue<Job>>());
+            }
 
-        TaskHandle enqueueTask(graphics::Image<graphics::ColourRgb<float>>&& image, const Task::TaskFunction& function, const ProblemSpace& problemSpace) {
-            auto task = std::make_shared<Task>(Task(std::move(image), function, problemSpace));
-            TaskHandle handle(task);
+            for (std::size_t i = 0; i < threadCount; i++) {
+                m_threads.emplace_back(&ThreadPool::threadFunction, this, i);
+            }
+        }
 
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            m_tasks.emplace(std::move(task));
-            m_queueSemaphore.notify();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
 
-            if (!m_running) {
-                for (unsigned int i = 0; i < std::thread::hardware_concurrency(); i++) {
-                    m_threads.emplace_back(std::bind(&ThreadPool::threadFunction, this));
-                }
+        ~ThreadPool() {
+            wait();
+        }
+
+        std::size_t threadCount() const {
+            return m_threads.size();
+        }
 
-                m_running = true;
+        // The task function is called once per tile and pass. Contiguous ranges of tiles in the layout's order are handed to
+        // the same worker, so a space filling order keeps each worker's tiles spatially coherent.
+        TaskHandle enqueueTask(graphics::Image<graphics::ColourRgb<float>>&& image, const Task::TaskFunction& function, const TileLayout& tiles,
+                const PassSettings& passes = PassSettings()) {
+            std::size_t grainSize = tiles.tileCount() / (m_threads.size() * sm_jobsPerWorker);
+            auto task = std::shared_ptr<Task>(new Task(std::move(image), function, tiles, passes, grainSize));
+            TaskHandle handle(task);
+
+            if (tiles.tileCount() == 0) {
+                task->notifyStarted();
+                task->notifyComplete();
+                return handle;
             }
 
+            m_activeTasks++;
+            m_injectedJobs.push(Job{std::move(task), 0, tiles.tileCount()});
+            m_queuedJobs++;
+            wakeWorker();
+
             return handle;
         }
 
+        // Waits for every queued task to complete, then shuts the workers down
         void wait() {
-            //std::unique_lock<std::mutex> lock(m_queueMutex);
-            //m_tasksComplete.wait(lock, [this]() { return m_tasks.empty(); });
-            m_closeRequested = true;
+            {
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
+                m_closeRequested = true;
+            }
+
+            m_wakeup.notify_all();
 
             for (auto& thread : m_threads) {
-                thread.join();
+                if (thread.joinable()) {
+                    thread.join();
+                }
             }
         }
     };
@@ -0,0 +1,65 @@
+#ifndef TILE_LAYOUT_HPP
+#define TILE_LAYOUT_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+#include <threading/ProblemSpace.hpp>
+
+namespace threading
+{
+
+    struct Tile
+    {
+        std::size_t x;
+        std::size_t y;
+        std::size_t width;
+        std::size_t height;
+    };
+
+    // Splits an image into square tiles, one problem per tile. Tiles on the right and bottom edges are clipped to
+    // the image.
+    class TileLayout
+    {
+    private:
+        std::size_t m_imageWidth;
+        std::size_t m_imageHeight;
+        std::size_t m_tileSize;
+        ProblemSpace m_problemSpace;
+
+        static unsigned int tileCount(std::size_t imageSize, std::size_t tileSize) {
+            return (unsigned int)((imageSize + tileSize - 1) / tileSize);
+        }
+
+    public:
+        TileLayout(std::size_t imageWidth, std::size_t imageHeight, std::size_t tileSize,
+                ProblemSpace::Ordering ordering = ProblemSpace::Ordering::eHilbert) :
+            m_imageWidth(imageWidth),
+            m_imageHeight(imageHeight),
+            m_tileSize(std::max<std::size_t>(tileSize, 1)),
+            m_problemSpace(tileCount(imageWidth, m_tileSize), tileCount(imageHeight, m_tileSize), 1, 1, ordering)
+        { }
+
+        const ProblemSpace& problemSpace() const {
+            return m_problemSpace;
+        }
+
+        std::size_t tileSize() const {
+            return m_tileSize;
+        }
+
+        std::size_t tileCount() const {
+            return m_problemSpace.size();
+        }
+
+        Tile tile(const Problem& problem) const {
+            std::size_t x = problem[0] * m_tileSize;
+            std::size_t y = problem[1] * m_tileSize;
+
+            return Tile{x, y, std::min(m_tileSize, m_imageWidth - x), std::min(m_tileSize, m_imageHeight - y)};
+        }
+    };
+
+}
+
+#endif // TILE_LAYOUT_HPP
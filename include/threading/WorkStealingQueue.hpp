@@ -0,0 +1,83 @@
+#ifndef WORK_STEALING_QUEUE_HPP
+#define WORK_STEALING_QUEUE_HPP
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace threading
+{
+
+    // Double ended job queue owned by a single worker. The owner pushes and pops at the back, so it keeps working on
+    // the most recently split (smallest, cache warm) piece of work, while other workers steal from the front where
+    // the largest pieces are. Each queue has its own lock, so contention is limited to a thief and the owner.
+    template <typename T>
+    class WorkStealingQueue
+    {
+    private:
+        std::deque<T> m_items;
+        std::mutex m_mutex;
+        std::atomic<std::size_t> m_size;
+
+    public:
+        WorkStealingQueue() :
+            m_items(),
+            m_mutex(),
+            m_size(0)
+        { }
+
+        WorkStealingQueue(const WorkStealingQueue&) = delete;
+        WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+        void push(T&& item) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_items.push_back(std::move(item));
+            m_size++;
+        }
+
+        bool pop(T& item) {
+            if (empty()) {
+                return false;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            if (m_items.empty()) {
+                return false;
+            }
+
+            item = std::move(m_items.back());
+            m_items.pop_back();
+            m_size--;
+
+            return true;
+        }
+
+        bool steal(T& item) {
+            if (empty()) {
+                return false;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            if (m_items.empty()) {
+                return false;
+            }
+
+            item = std::move(m_items.front());
+            m_items.pop_front();
+            m_size--;
+
+            return true;
+        }
+
+        // Lock free hint used to skip empty queues; may be stale by the time it is acted upon
+        bool empty() const {
+            return m_size.load(std::memory_order_relaxed) == 0;
+        }
+    };
+
+}
+
+#endif // WORK_STEALING_QUEUE_HPP
@@ -0,0 +1,166 @@
+#ifndef WORKERGROUP_HPP
+#define WORKERGROUP_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace threading
+{
+
+    // A fixed set of threads that run loops over chunks together with the calling thread. Meant for many short
+    // loops in a row, such as the levels of a hierarchy build, where starting threads for every loop would cost
+    // more than the loop itself. The threads are started by the first loop with more than one chunk.
+    class WorkerGroup
+    {
+    public:
+        // threadCount includes the thread that calls run(); a count of one runs every loop on the caller alone
+        WorkerGroup(std::size_t threadCount) :
+            m_mutex(),
+            m_wake(),
+            m_done(),
+            m_threads(),
+            m_threadCount(threadCount),
+            m_generation(0),
+            m_busy(0),
+            m_stopping(false),
+            m_context(nullptr),
+            m_invoke(nullptr),
+            m_chunkCount(0),
+            m_nextChunk(0)
+        {
+
+        }
+
+        WorkerGroup(const WorkerGroup&) = delete;
+        WorkerGroup(WorkerGroup&&) = delete;
+        WorkerGroup& operator=(const WorkerGroup&) = delete;
+
+        ~WorkerGroup();
+
+        // Runs task(chunk) for every chunk in [0, chunkCount) and returns once all of them have finished. Loops
+        // must not be nested.
+        template <typename Task>
+        void run(std::size_t chunkCount, Task&& task);
+
+    private:
+        template <typename Task>
+        static void invoke(const void* context, std::size_t chunk)
+        {
+            (*static_cast<const typename std::remove_reference<Task>::type*>(context))(chunk);
+        }
+
+        void work();
+
+        void runChunks();
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        std::vector<std::thread> m_threads;
+        std::size_t m_threadCount;
+        std::size_t m_generation;
+        std::size_t m_busy;
+        bool m_stopping;
+
+        // The current loop, published under the mutex along with a new generation
+        const void* m_context;
+        void (*m_invoke)(const void* context, std::size_t chunk);
+        std::size_t m_chunkCount;
+        std::atomic<std::size_t> m_nextChunk;
+    };
+
+    inline WorkerGroup::~WorkerGroup()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_wake.notify_all();
+
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    template <typename Task>
+    inline void WorkerGroup::run(std::size_t chunkCount, Task&& task)
+    {
+        if (chunkCount <= 1 || m_threadCount <= 1)
+        {
+            for (std::size_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                task(chunk);
+            }
+
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while (m_threads.size() + 1 < m_threadCount)
+            {
+                m_threads.emplace_back([this]() { work(); });
+            }
+
+            m_context = &task;
+            m_invoke = &invoke<Task>;
+            m_chunkCount = chunkCount;
+            m_nextChunk = 0;
+            m_busy = m_threads.size();
+            m_generation++;
+        }
+
+        m_wake.notify_all();
+        runChunks();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_busy == 0; });
+    }
+
+    inline void WorkerGroup::work()
+    {
+        std::size_t generation = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this, generation]() { return m_stopping || m_generation != generation; });
+
+                if (m_stopping)
+                {
+                    return;
+                }
+
+                generation = m_generation;
+            }
+
+            runChunks();
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            if (--m_busy == 0)
+            {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    inline void WorkerGroup::runChunks()
+    {
+        for (std::size_t chunk = m_nextChunk++; chunk < m_chunkCount; chunk = m_nextChunk++)
+        {
+            m_invoke(m_context, chunk);
+        }
+    }
+
+}
+
+#endif
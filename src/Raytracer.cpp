@@ -1,15 +1,19 @@
 #include <Raytracer.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
-#include <random>
+#include <cstdint>
 #include <vector>
 
 #include <geometry/Ray.hpp>
 #include <geometry/Vector.hpp>
 #include <graphics/Colour.hpp>
 #include <IntersectionInfo.hpp>
-#include <RandomGenerator.hpp>
+#include <MediumStack.hpp>
+#include <RenderStatistics.hpp>
 #include <Scene.hpp>
+#include <sampling/IndependentSampler.hpp>
 
 using namespace geometry;
 using namespace graphics;
@@ -17,14 +21,61 @@ using namespace threading;
 
 static constexpr double pi() { return std::atan(1.0) * 4.0; }
 
-constexpr float epsilon = 1e-10;
+// Rays leaving a surface ignore hits closer than this. Single precision geometry puts points on a surface much further
+// from it, so needs a far larger offset.
+constexpr float epsilon = sizeof(geo_type) < sizeof(double) ? 1e-4f : 1e-10f;
 
-ColourRgb<float> calculateRayColour(const Ray3& lightRay, const Scene& scene, int recursionDepth, double weight, const std::vector<float>& refractiveIndexStack = {1.0f}, const Vector3& lastNormal = {0, 0, 0});
+// Shadow rays towards a sampled light stop short of it by this fraction of their length, so that the light itself
+// does not count as an occluder
+constexpr double shadowEpsilon = sizeof(geo_type) < sizeof(double) ? 1e-3 : 1e-6;
 
-Vector3 randomVectorOnUnitHemisphere(const Vector3& direction)
+// Longest path traced, and the most branches that can be pending at once: every vertex consumes one branch and
+// spawns at most four (diffuse, mirror, and the reflected and refracted halves of a transmission)
+constexpr int recursionLimit = 20;
+constexpr std::size_t branchLimit = 3 * recursionLimit + 1;
+
+namespace
 {
-    thread_local std::uniform_real_distribution<float> dist(0, 1);
+    // A path segment waiting to be traced. Branches live in a fixed size array on the stack, so tracing a sample
+    // never allocates.
+    struct PathBranch
+    {
+        Point3 origin;
+        Vector3 direction;
+        ColourRgb<float> throughput;
+        double bsdfPdf;         // Solid angle density the direction was sampled with; zero for camera rays and specular bounces
+        MediumStack media;
+        int depth;
+
+        PathBranch() :
+            origin(),
+            direction(),
+            throughput(),
+            bsdfPdf(0.0),
+            media(),
+            depth(0)
+        {
+
+        }
+
+        PathBranch(const Point3& _origin, const Vector3& _direction, const ColourRgb<float>& _throughput, double _bsdfPdf,
+                const MediumStack& _media, int _depth) :
+            origin(_origin),
+            direction(_direction),
+            throughput(_throughput),
+            bsdfPdf(_bsdfPdf),
+            media(_media),
+            depth(_depth)
+        {
+
+        }
+    };
+}
 
+// Direction about the given normal picked with a density of cos(theta) / pi, which matches the cosine factor of a
+// lambertian surface so that the reflected radiance only needs to be scaled by its albedo
+Vector3 randomVectorOnUnitHemisphere(const Vector3& direction, const Point2& sample)
+{
     Vector3 i = direction;
     Vector3 j, k;
 
@@ -41,198 +92,560 @@ Vector3 randomVectorOnUnitHemisphere(const Vector3& direction)
 
     k = cross_product(i, j);
 
-    float theta = 2 * pi() * dist(RandomGenerator::get_instance());
-    float phi = pi() * 0.5 - std::acos(std::acos(dist(RandomGenerator::get_instance())) * 2 / pi());
+    // Project a uniform point on the unit disc up onto the hemisphere
+    double radiusSquared = sample.x();
+    double radius = std::sqrt(radiusSquared);
+    double theta = 2 * pi() * sample.y();
 
-    return std::cos(phi) * i + std::cos(theta) * std::sin(phi) * j + std::sin(theta) * sin(phi) * k;
+    return std::sqrt(1 - radiusSquared) * i + radius * std::cos(theta) * j + radius * std::sin(theta) * k;
 }
 
 IntersectionInfo nearestShapeIntersection(const Ray3& ray, const Scene& scene)
 {
-    shapes::Shape::IntersectionResult nearest;
+    RenderStatistics::countRay();
+    return IntersectionInfo(ray, scene.nearestIntersection(ray, epsilon), scene.materials());
+}
 
-    for (auto&& shape : scene.geometry())
-    {
-        shapes::Shape::IntersectionResult intersection = shape->calculateRayIntersection(ray);
+Vector3 reflect(const Vector3& direction, const Vector3& normal)
+{
+    return direction - 2 * (direction * normal) * normal;
+}
 
-        if (intersection.distance() < nearest.distance() && intersection.distance() > epsilon)
-        {
-            nearest = intersection;
-        }
+// Refracts the ray through the surface with Snell's law and returns the Fresnel reflectance, which is 1 on total
+// internal reflection.
+double refract(const IntersectionInfo& info, const Ray3& ray, float n1, float n2, Vector3& refractedRayDirection)
+{
+    Vector3 rayProjectedOnNormal = (ray.direction() * info.normal()) * info.normal();
+
+    //Snell's law
+    Vector3 vsinTheta1 = -rayProjectedOnNormal + ray.direction();
+    Vector3 vsinTheta2 = vsinTheta1 * (n1 / n2);
+    double cos2Theta2 = 1 - vsinTheta2 * vsinTheta2;
+
+    //Total internal reflection
+    if (cos2Theta2 < 0)
+    {
+        refractedRayDirection = ray.direction();
+        return 1.0;
     }
 
-    return IntersectionInfo(ray, nearest);
+    Vector3 vcosTheta2 = -std::sqrt(cos2Theta2) * info.normal();
+
+    refractedRayDirection = vsinTheta2 + vcosTheta2;
+
+    //Fresnel equations
+    double cosTheta1 = -(ray.direction() * info.normal());
+    double cosTheta2 = -(refractedRayDirection * info.normal());
+
+    double rs = (n1 * cosTheta1 - n2 * cosTheta2) / (n1 * cosTheta1 + n2 * cosTheta2);
+    double rp = (n2 * cosTheta1 - n1 * cosTheta2) / (n2 * cosTheta1 + n1 * cosTheta2);
+
+    double fresnelReflectance = std::min((rs * rs + rp * rp) * 0.5, 1.0);
+
+    return std::isnan(fresnelReflectance) ? 1.0 : fresnelReflectance;
 }
 
-ColourRgb<float> calculateDifuseReflection(const IntersectionInfo& info, const Ray3&, const Scene& scene, int recursionDepth, double weight, const std::vector<float>& refractiveIndexStack, const geometry::Vector3& lastNormal)
+bool clearLineOfSight(const Point3 p1, const Point3 p2, const Scene& scene)
 {
-    Vector3 nextRayDirection = randomVectorOnUnitHemisphere(info.normal());
-    Ray3 nextRay = Ray3(info.location(), nextRayDirection);
-    double newWeight = info.surface().colour().average() * weight * (info.normal() * nextRay.direction());
+    Vector3 direction = normalize(p2 - p1);
+    Ray3 ray = Ray3(p1 + direction * epsilon, direction);
+    RenderStatistics::countRay();
+
+    return !scene.isOccluded(ray, epsilon, abs(p2 - p1) * (1.0 - shadowEpsilon));
+}
+
+double misWeight(double pdf, double otherPdf, RenderSettings::MisHeuristic heuristic)
+{
+    if (heuristic == RenderSettings::MisHeuristic::ePower)
+    {
+        pdf *= pdf;
+        otherPdf *= otherPdf;
+    }
 
-    return calculateRayColour(nextRay, scene, recursionDepth + 1, newWeight, refractiveIndexStack, lastNormal) * info.surface().colour();
+    return pdf / (pdf + otherPdf);
 }
 
-ColourRgb<float> calculateReflection(const IntersectionInfo& info, const Ray3& ray, const Scene& scene, int recursionDepth, double weight, const std::vector<float>& refractiveIndexStack)
+// Solid angle density with which light sampling picks a point on the light seen at the given distance and angle
+double lightPdf(const shapes::Shape& light, double distance, double cosLight, const Scene& scene)
 {
-    Vector3 nextRayDirection = ray.direction() - 2 * (ray.direction() * info.normal()) * info.normal();
-    Ray3 nextRay = Ray3(info.location(), nextRayDirection);
-    double newWeight = info.surface().colour().average() * weight;
+    return distance * distance / (cosLight * light.surfaceArea() * scene.sampledLights().size());
+}
 
-    return calculateRayColour(nextRay, scene, recursionDepth + 1, newWeight, refractiveIndexStack) * info.surface().reflectance() * info.surface().colour();
+namespace
+{
+    // A point picked on an emitter for next event estimation, and the light it sends to a diffuse vertex unless
+    // something is in the way. Points that cannot light the vertex are not valid and need no shadow ray.
+    struct LightSample
+    {
+        Point3 from;
+        Point3 to;
+        ColourRgb<float> radiance;
+        bool valid;
+    };
 }
 
-ColourRgb<float> calculateTransmission(const IntersectionInfo& info, const Ray3& ray, const Scene& scene, int recursionDepth, double weight, const std::vector<float>& refractiveIndexStack)
+bool samplesLights(const Scene& scene)
 {
+    return scene.settings().lightSampling && !scene.sampledLights().empty();
+}
 
-    std::vector<float> newRefractiveIndexStack(refractiveIndexStack);
+// Light from one randomly picked emitter reaching a diffuse vertex, multiplied by the lambertian BRDF without its
+// albedo and weighted against the bounced ray finding the same point. Visibility is left to the caller.
+LightSample sampleLight(const IntersectionInfo& info, const Scene& scene, sampling::Sampler& sampler)
+{
+    const auto& lights = scene.sampledLights();
+    std::size_t index = std::min(std::size_t(sampler.next1D() * lights.size()), lights.size() - 1);
+    const shapes::Shape& light = *lights[index];
 
-    float n1 = refractiveIndexStack.back();
-    float n2 = 0.0;
+    Point3 lightPoint = light.sampleSurface(sampler.next2D());
+    Vector3 toLight = lightPoint - info.location();
+    double distance = abs(toLight);
+    Vector3 direction = toLight / distance;
 
-    if (info.isEnteringSurface())
+    double cosSurface = direction * info.normal();
+    double cosLight = std::abs(direction * light.calculateNormal(lightPoint));
+
+    if (!(cosSurface > 0.0) || !(cosLight > epsilon))
     {
-        newRefractiveIndexStack.push_back(info.surface().refractiveIndex());
-        n2 = newRefractiveIndexStack.back();
+        return LightSample{info.location(), lightPoint, ColourRgb<float>(0, 0, 0), false};
     }
-    else
+
+    double pdf = lightPdf(light, distance, cosLight, scene);
+    double weight = misWeight(pdf, cosSurface / pi(), scene.settings().misHeuristic);
+
+    return LightSample{info.location(), lightPoint,
+            light.surface().colour() * float(light.surface().emittance() * cosSurface / pi() * weight / pdf), true};
+}
+
+// Next event estimation: sampleLight() followed by its shadow ray
+ColourRgb<float> sampleDirectLight(const IntersectionInfo& info, const Scene& scene, sampling::Sampler& sampler)
+{
+    LightSample light = sampleLight(info, scene, sampler);
+
+    if (!light.valid || !clearLineOfSight(light.from, light.to, scene))
     {
-        newRefractiveIndexStack.pop_back();
-        n2 = newRefractiveIndexStack.back();
+        return ColourRgb<float>(0, 0, 0);
     }
 
-    Vector3 rayProjectedOnNormal = (ray.direction() * info.normal()) * info.normal();
+    return light.radiance;
+}
 
-    //Snell's law
-    Vector3 vsinTheta1 = -rayProjectedOnNormal + ray.direction();
-    Vector3 vsinTheta2 = vsinTheta1 * (n1 / n2);
-    Vector3 vcosTheta2 = -std::sqrt(1 - vsinTheta2 * vsinTheta2) * info.normal();
+// Russian roulette on the path throughput: dim paths are likely to be cut, and survivors are weighted up to
+// compensate. Survivors reach a throughput of at least one, so they are not cut again until they lose energy; capping
+// the survival probability below one would instead grow their weight at every bounce.
+bool survivesRoulette(const PathBranch& branch, sampling::Sampler& sampler, ColourRgb<float>& throughput)
+{
+    double survivalProb = (branch.depth < 2) ? 1.0 : std::min(1.0, double(throughput.max()));
 
-    Vector3 refractedRayDirection = vsinTheta2 + vcosTheta2;
-    Vector3 reflectedRayDirection = ray.direction() - 2 * rayProjectedOnNormal;
+    if (branch.depth >= recursionLimit || !(survivalProb > 0.0) || sampler.next1D() >= survivalProb)
+    {
+        return false;
+    }
 
-    Ray3 refractedRay = Ray3(info.location(), refractedRayDirection);
-    Ray3 reflectedRay = Ray3(info.location(), reflectedRayDirection);
+    throughput *= float(1.0 / survivalProb);
+    return true;
+}
 
-    //Fresnel equations
-    double cosTheta1 = -(ray.direction() * info.normal());
-    double cosTheta2 = -(refractedRayDirection * info.normal());
+// The scattering of each kind of surface, shared by the recursive and the wavefront integrator. Each takes the hit
+// of a branch and the branch's throughput after Russian roulette.
 
-    double rs = (n1 * cosTheta1 - n2 * cosTheta2) / (n1 * cosTheta1 + n2 * cosTheta2);
-    double rp = (n2 * cosTheta1 - n1 * cosTheta2) / (n2 * cosTheta1 + n1 * cosTheta2);
+PathBranch diffuseBounce(const IntersectionInfo& info, const PathBranch& branch, const ColourRgb<float>& throughput,
+        sampling::Sampler& sampler)
+{
+    Vector3 direction = randomVectorOnUnitHemisphere(info.normal(), sampler.next2D());
 
-    double fresnelReflectance = std::min((rs * rs + rp * rp) * 0.5, 1.0);
-    fresnelReflectance = std::isnan(fresnelReflectance) ? 1.0 : fresnelReflectance;
+    return PathBranch{info.location(), direction, throughput * info.surface().colour(),
+            (direction * info.normal()) / pi(), branch.media, branch.depth + 1};
+}
+
+PathBranch mirrorBounce(const IntersectionInfo& info, const PathBranch& branch, const ColourRgb<float>& throughput)
+{
+    const Surface& surface = info.surface();
 
-    ColourRgb<float> refractedLight(0, 0, 0);
-    ColourRgb<float> reflectedLight = calculateRayColour(reflectedRay, scene, recursionDepth + 1, weight, refractiveIndexStack);
+    return PathBranch{info.location(), reflect(branch.direction, info.normal()),
+            throughput * surface.colour() * float(surface.reflectance()), 0.0, branch.media, branch.depth + 1};
+}
+
+// Calls spawn(branch) with the reflected and refracted branches of a dielectric hit, or with one of them
+template <typename Spawn>
+void transmit(const IntersectionInfo& info, const PathBranch& branch, const ColourRgb<float>& throughput,
+        const RenderSettings& settings, sampling::Sampler& sampler, Spawn&& spawn)
+{
+    const Surface& surface = info.surface();
+    const Ray3 ray(branch.origin, branch.direction);
+    const int depth = branch.depth + 1;
 
-    if (fresnelReflectance < 1.0)
+    MediumStack media = branch.media;
+    float n1 = media.top();
+
+    if (info.isEnteringSurface())
     {
-        double newWeight = info.surface().colour().average() * weight;
-        refractedLight = calculateRayColour(refractedRay, scene, recursionDepth + 1, newWeight, newRefractiveIndexStack) * info.surface().colour();
+        media.push(surface.refractiveIndex());
     }
+    else
+    {
+        media.pop();
+    }
+
+    Vector3 refractedRayDirection;
+    double fresnelReflectance = refract(info, ray, n1, media.top(), refractedRayDirection);
+    ColourRgb<float> transmitted = throughput * float(surface.transmittance());
+
+    PathBranch reflected{info.location(), reflect(ray.direction(), info.normal()), transmitted, 0.0, branch.media, depth};
+    PathBranch refracted{info.location(), refractedRayDirection, transmitted * surface.colour(), 0.0, media, depth};
+
+    if (settings.fresnelMode == RenderSettings::FresnelMode::eBoth || branch.depth < settings.fresnelSplitDepth)
+    {
+        reflected.throughput *= float(fresnelReflectance);
+        spawn(reflected);
 
-    return (reflectedLight * fresnelReflectance + refractedLight * (1.0 - fresnelReflectance)) * info.surface().transmittance();
+        if (fresnelReflectance < 1.0)
+        {
+            refracted.throughput *= float(1.0 - fresnelReflectance);
+            spawn(refracted);
+        }
+    }
+    else
+    {
+        // Picking each ray with the probability it is weighted by leaves the throughput unchanged
+        spawn(sampler.next1D() < fresnelReflectance ? reflected : refracted);
+    }
 }
 
-bool clearLineOfSight(const Point3 p1, const Point3 p2, const Scene& scene)
+ColourRgb<float> emitted(const IntersectionInfo& info, const PathBranch& branch, const ColourRgb<float>& throughput,
+        const Scene& scene)
 {
-    Vector3 direction = normalize(p2 - p1);
-    Ray3 ray = Ray3(p1 + direction * epsilon, direction);
+    const Surface& surface = info.surface();
+    double weight = 1.0;
 
-    IntersectionInfo info = nearestShapeIntersection(ray, scene);
+    // After a diffuse bounce the light sampled at that vertex may have found this point too
+    if (samplesLights(scene) && branch.bsdfPdf > 0.0 && info.shape().surfaceArea() > 0.0)
+    {
+        double pdf = lightPdf(info.shape(), info.distance(), info.cosAngleOfIncidence(), scene);
+        weight = misWeight(branch.bsdfPdf, pdf, scene.settings().misHeuristic);
+    }
 
-    return info.distance() > (abs(p2 - p1) - epsilon * 2);
+    return throughput * surface.colour() * float(surface.emittance() * weight);
 }
 
-ColourRgb<float> calculateLightRay(const Ray3& ray, const Scene& scene, const geometry::Vector3& lastNormal)
+// Traces a camera sample. The nearest intersection of the camera ray is taken from primaryHit when given, as found
+// by tracing a whole packet of camera rays together.
+ColourRgb<float> tracePath(const Ray3& cameraRay, const Scene& scene, sampling::Sampler& sampler, const shapes::Shape::IntersectionResult* primaryHit)
 {
-    ColourRgb<float> lightColour(0, 0, 0);
+    std::array<PathBranch, branchLimit> branches;
+    std::size_t branchCount = 0;
+    ColourRgb<float> radiance(0, 0, 0);
 
-    for (const auto& light : scene.lights())
+    branches[branchCount++] = PathBranch{cameraRay.origin(), cameraRay.direction(), ColourRgb<float>(1, 1, 1), 0.0, MediumStack(), 0};
+
+    while (branchCount > 0)
     {
-        Point3 lightPoint = light->sampleSurface();
-        Vector3 direction = normalize(lightPoint - ray.origin());
+        const PathBranch branch = branches[--branchCount];
+        const Ray3 ray(branch.origin, branch.direction);
+        ColourRgb<float> throughput = branch.throughput;
 
-        if (clearLineOfSight(ray.origin(), lightPoint, scene))
+        if (!survivesRoulette(branch, sampler, throughput))
         {
-            Vector3 zero(0.0, 0.0, 0.0);
-            double cosineFactor = !(abs(lastNormal) < 0.0001) ? std::abs(direction * lastNormal) : 1.0;
+            continue;
+        }
+
+        IntersectionInfo info = (primaryHit && branch.depth == 0) ? IntersectionInfo(ray, *primaryHit, scene.materials()) : nearestShapeIntersection(ray, scene);
 
-            lightColour += light->surface().emittance() * light->surface().colour() * cosineFactor;
+        // Nothing is gathered by rays that miss all geometry or graze a surface
+        if (!info || info.cosAngleOfIncidence() < epsilon)
+        {
+            continue;
+        }
+
+        const Surface& surface = info.surface();
+
+        if (surface.difuseReflectance() > 0.0)
+        {
+            if (samplesLights(scene))
+            {
+                radiance += throughput * surface.colour() * sampleDirectLight(info, scene, sampler);
+            }
+
+            branches[branchCount++] = diffuseBounce(info, branch, throughput, sampler);
+        }
+
+        if (surface.reflectance() > 0.0)
+        {
+            branches[branchCount++] = mirrorBounce(info, branch, throughput);
+        }
+
+        if (surface.transmittance() > 0.0)
+        {
+            transmit(info, branch, throughput, scene.settings(), sampler, [&](const PathBranch& spawned) {
+                branches[branchCount++] = spawned;
+            });
+        }
+
+        if (surface.emittance() > 0.0)
+        {
+            radiance += emitted(info, branch, throughput, scene);
         }
     }
 
-    return lightColour;
+    return radiance;
 }
 
+ColourRgb<float> tracePath(const Ray3& cameraRay, const Scene& scene, sampling::Sampler& sampler)
+{
+    return tracePath(cameraRay, scene, sampler, nullptr);
+}
 
-
-//TODO: add case for transmittance
-//TODO: break this function into smaller functions: one function for each surface type. sum results
-ColourRgb<float> calculateRayColour(const Ray3& ray, const Scene& scene, int recursionDepth = 0, double weight = 1.0, const std::vector<float>& refractiveIndexStack, const geometry::Vector3& lastNormal)
+ColourRgb<float> tracePath(const Ray3& cameraRay, const Scene& scene)
 {
-    //Ray3 ray = Ray3(lightRay.origin(), normalize(lightRay.direction()));
-    double survivalProb = (recursionDepth < 2) ? 1.0 : 0.8;
-    int recursionLimit = 20;
+    thread_local sampling::IndependentSampler sampler;
+    sampler.startSample(0, 0, 0);
 
-    // Return black if recursion limit hit
-    if (recursionDepth >= recursionLimit || weight < (1.0 / 255.0))
-    {
-        return calculateLightRay(ray, scene, lastNormal);
-    }
+    return tracePath(cameraRay, scene, sampler);
+}
 
-    // Russian roulette
+void tracePacket(const CameraPacket<packetWidth()>& packet, const Scene& scene, sampling::Sampler& sampler,
+        CameraPacket<packetWidth()>::Colours& colours)
+{
+    // Only camera rays are coherent enough to gain from being traced together. Past their first hit, and for packets
+    // that do not share an origin and octant to begin with, every ray goes its own way.
+    if (!packet.rays.isCoherent())
     {
-        thread_local std::uniform_real_distribution<float> dist(0, 1);
-
-        if (dist(RandomGenerator::get_instance()) > survivalProb)
+        for (std::size_t lane = 0; lane < packet.rays.count; lane++)
         {
-            return calculateLightRay(ray, scene, lastNormal);
+            packet.resumeSample(sampler, lane);
+            colours[lane] = tracePath(packet.rays.ray(lane), scene, sampler, nullptr);
         }
+
+        return;
     }
 
-    IntersectionInfo info = nearestShapeIntersection(ray, scene);
+    shapes::Shape::PacketResults primaryHits;
+    scene.nearestIntersection(packet.rays, epsilon, primaryHits);
 
-    // Return black if ray did not intersect with any geometry
-    if (!info)
+    for (std::size_t lane = 0; lane < packet.rays.count; lane++)
     {
-        return ColourRgb<float>(0, 0, 0);
+        RenderStatistics::countRay();
+        packet.resumeSample(sampler, lane);
+        colours[lane] = tracePath(packet.rays.ray(lane), scene, sampler, &primaryHits[lane]);
     }
+}
 
-    // Return black if ray is parallel to surface
-    if (info.cosAngleOfIncidence() < epsilon)
+namespace
+{
+    // Kinds of scattering, each shaded from its own queue. A hit is queued once for every kind its surface does.
+    enum SurfaceQueue
     {
-        return ColourRgb<float>(0, 0, 0);
-    }
+        eDiffuseQueue,
+        eReflectiveQueue,
+        eTransmissiveQueue,
+        eEmissiveQueue,
+        eSurfaceQueueCount
+    };
+
+    struct WavefrontPath
+    {
+        PathBranch branch;
+        std::uint32_t lane;
+    };
 
-    ColourRgb<float> colour{0, 0, 0};
+    struct WavefrontHit
+    {
+        WavefrontPath path;     // Throughput already weighted by Russian roulette
+        IntersectionInfo info;
+    };
 
-    if (info.surface().difuseReflectance() > 0.0)
+    struct WavefrontShadowRay
     {
-        colour += calculateDifuseReflection(info, ray, scene, recursionDepth, weight, refractiveIndexStack, info.normal());
-    }
+        LightSample light;      // Radiance already weighted by the path throughput and albedo
+        std::uint32_t lane;
+    };
 
-    if (info.surface().reflectance() > 0.0)
+    // Queues of the wavefront integrator, kept per thread so that they only grow during the first batches
+    struct Wavefront
     {
-        colour += calculateReflection(info, ray, scene, recursionDepth, weight, refractiveIndexStack);
-    }
+        std::vector<WavefrontPath> paths;
+        std::vector<WavefrontHit> hits;
+        std::array<std::vector<std::uint32_t>, eSurfaceQueueCount> queues;
+        std::vector<WavefrontShadowRay> shadowRays;
+        std::vector<std::uint32_t> dimensions;      // Next sampler dimension of each lane's sample
+
+        Wavefront() :
+            paths(),
+            hits(),
+            queues(),
+            shadowRays(),
+            dimensions()
+        {
+
+        }
+    };
+}
 
-    if (info.surface().transmittance() > 0.0)
+void traceWavefront(const CameraPacket<wavefrontWidth()>& packet, const Scene& scene, sampling::Sampler& sampler,
+        CameraPacket<wavefrontWidth()>::Colours& colours)
+{
+    thread_local Wavefront wavefront;
+    auto& paths = wavefront.paths;
+    auto& hits = wavefront.hits;
+    auto& queues = wavefront.queues;
+    auto& shadowRays = wavefront.shadowRays;
+    auto& dimensions = wavefront.dimensions;
+
+    // The branches of a sample take their random numbers from the sample in the order they are shaded, so each lane
+    // keeps its place in the sampler from one stage to the next
+    auto resume = [&](std::uint32_t lane) {
+        packet.resumeSample(sampler, lane, dimensions[lane]);
+    };
+
+    auto suspend = [&](std::uint32_t lane) {
+        dimensions[lane] = sampler.dimension();
+    };
+
+    // Generate
+    paths.clear();
+    dimensions.assign(packet.rays.count, packet.dimension);
+
+    for (std::uint32_t lane = 0; lane < packet.rays.count; lane++)
     {
-        colour += calculateTransmission(info, ray, scene, recursionDepth, weight, refractiveIndexStack);
+        Ray3 ray = packet.rays.ray(lane);
+        colours[lane] = ColourRgb<float>(0, 0, 0);
+        paths.push_back(WavefrontPath{PathBranch{ray.origin(), ray.direction(), ColourRgb<float>(1, 1, 1), 0.0, MediumStack(), 0}, lane});
     }
 
-    if (info.surface().emittance() > 0.0)
+    while (!paths.empty())
     {
-        colour += info.surface().emittance() * info.surface().colour();
-    }
+        // Intersect, keeping only the paths that survive Russian roulette and hit something head on
+        hits.clear();
+
+        for (WavefrontPath& path : paths)
+        {
+            resume(path.lane);
+            bool survives = survivesRoulette(path.branch, sampler, path.branch.throughput);
+            suspend(path.lane);
+
+            if (!survives)
+            {
+                continue;
+            }
 
-    return colour * (1.0 / survivalProb);
+            IntersectionInfo info = nearestShapeIntersection(Ray3(path.branch.origin, path.branch.direction), scene);
+
+            if (info && info.cosAngleOfIncidence() >= epsilon)
+            {
+                hits.push_back(WavefrontHit{path, info});
+            }
+        }
+
+        // Sort the hits by the kinds of scattering their surface does
+        for (auto& queue : queues)
+        {
+            queue.clear();
+        }
+
+        for (std::uint32_t i = 0; i < hits.size(); i++)
+        {
+            const Surface& surface = hits[i].info.surface();
+
+            if (surface.difuseReflectance() > 0.0)
+            {
+                queues[eDiffuseQueue].push_back(i);
+            }
+
+            if (surface.reflectance() > 0.0)
+            {
+                queues[eReflectiveQueue].push_back(i);
+            }
+
+            if (surface.transmittance() > 0.0)
+            {
+                queues[eTransmissiveQueue].push_back(i);
+            }
+
+            if (surface.emittance() > 0.0)
+            {
+                queues[eEmissiveQueue].push_back(i);
+            }
+        }
+
+        // Shade one queue at a time, gathering the next bounce of every path and the shadow rays of this one
+        paths.clear();
+        shadowRays.clear();
+
+        for (std::uint32_t i : queues[eDiffuseQueue])
+        {
+            const WavefrontHit& hit = hits[i];
+            const ColourRgb<float>& throughput = hit.path.branch.throughput;
+            resume(hit.path.lane);
+
+            if (samplesLights(scene))
+            {
+                LightSample light = sampleLight(hit.info, scene, sampler);
+
+                if (light.valid)
+                {
+                    light.radiance = throughput * hit.info.surface().colour() * light.radiance;
+                    shadowRays.push_back(WavefrontShadowRay{light, hit.path.lane});
+                }
+            }
+
+            paths.push_back(WavefrontPath{diffuseBounce(hit.info, hit.path.branch, throughput, sampler), hit.path.lane});
+            suspend(hit.path.lane);
+        }
+
+        for (std::uint32_t i : queues[eReflectiveQueue])
+        {
+            const WavefrontHit& hit = hits[i];
+            paths.push_back(WavefrontPath{mirrorBounce(hit.info, hit.path.branch, hit.path.branch.throughput), hit.path.lane});
+        }
+
+        for (std::uint32_t i : queues[eTransmissiveQueue])
+        {
+            const WavefrontHit& hit = hits[i];
+            resume(hit.path.lane);
+
+            transmit(hit.info, hit.path.branch, hit.path.branch.throughput, scene.settings(), sampler, [&](const PathBranch& spawned) {
+                paths.push_back(WavefrontPath{spawned, hit.path.lane});
+            });
+
+            suspend(hit.path.lane);
+        }
+
+        for (std::uint32_t i : queues[eEmissiveQueue])
+        {
+            const WavefrontHit& hit = hits[i];
+            colours[hit.path.lane] += emitted(hit.info, hit.path.branch, hit.path.branch.throughput, scene);
+        }
+
+        // Shadow
+        for (const WavefrontShadowRay& shadowRay : shadowRays)
+        {
+            if (clearLineOfSight(shadowRay.light.from, shadowRay.light.to, scene))
+            {
+                colours[shadowRay.lane] += shadowRay.light.radiance;
+            }
+        }
+    }
 }
 
-TaskHandle render(ThreadPool& pool, const std::shared_ptr<Scene>& scene)
+TaskHandle render(ThreadPool& pool, const std::shared_ptr<Scene>& scene, const std::shared_ptr<PixelStatistics>& statistics)
 {
-    return scene->camera().render(pool, [=](const Ray3& ray) { return calculateRayColour(ray, *scene); });
+    if (scene->settings().integrator == RenderSettings::Integrator::eWavefront)
+    {
+        return scene->camera().renderPackets<wavefrontWidth()>(pool, [=](const CameraPacket<wavefrontWidth()>& packet, sampling::Sampler& sampler,
+                CameraPacket<wavefrontWidth()>::Colours& colours) {
+            traceWavefront(packet, *scene, sampler, colours);
+        }, statistics);
+    }
+
+    if (scene->settings().packetTracing)
+    {
+        return scene->camera().renderPackets<packetWidth()>(pool, [=](const CameraPacket<packetWidth()>& packet, sampling::Sampler& sampler,
+                CameraPacket<packetWidth()>::Colours& colours) {
+            tracePacket(packet, *scene, sampler, colours);
+        }, statistics);
+    }
+
+    return scene->camera().render(pool, [=](const Ray3& ray, sampling::Sampler& sampler) {
+        return tracePath(ray, *scene, sampler);
+    }, statistics);
 }
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <SceneLoaderJson.hpp>
+#include <acceleration/BoundingVolumeHierarchy.hpp>
+#include <acceleration/BuildStatistics.hpp>
+#include <builders/SceneBuilder.hpp>
+#include <threading/ThreadPool.hpp>
+#include <graphics/Image.hpp>
+#include <Camera.hpp>
+#include <Exceptions.hpp>
+#include <PixelStatistics.hpp>
+#include <RandomGenerator.hpp>
+#include <Raytracer.hpp>
+#include <RenderStatistics.hpp>
+#include <Shapes.hpp>
+
+namespace
+{
+    // Used when the time budget or noise target asks for a progressive render of a scene that does not set one up
+    const std::size_t defaultSamplesPerPass = 4;
+
+    struct Options
+    {
+        std::string scenePath;
+        std::string outputPath;
+        std::int64_t samplesPerPixel = 0;           // Zero keeps the scene's setting
+        std::int64_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        double timeBudget = 0.0;                    // Seconds, zero keeps the scene's setting
+        std::int64_t samplesPerPass = 0;            // Zero keeps the scene's setting
+        double noiseTarget = 0.0;                   // Zero keeps the scene's setting
+        bool seeded = false;
+        std::uint64_t seed = 0;
+        bool overrideSampler = false;
+        sampling::Sampler::Type sampler = sampling::Sampler::Type::eSobol;
+    };
+
+    void printUsage(const char* program)
+    {
+        std::cerr << "usage: " << program << " <scene.json> <output.png> [--spp N] [--threads N] [--time-budget SECONDS] [--samples-per-pass N] [--noise-target ERROR] [--seed N] [--sampler NAME]" << std::endl;
+    }
+
+    // Path of the sample count heatmap written next to the output image: "out.png" becomes "out-spp.png"
+    std::string heatmapPath(const std::string& outputPath)
+    {
+        std::size_t extension = outputPath.find_last_of('.');
+        std::size_t directory = outputPath.find_last_of("/\\");
+
+        if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+        {
+            return outputPath + "-spp";
+        }
+
+        return outputPath.substr(0, extension) + "-spp" + outputPath.substr(extension);
+    }
+
+    Options parseArguments(int argc, char** argv)
+    {
+        Options options;
+        int positional = 0;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+
+            if (arg.compare(0, 2, "--") != 0)
+            {
+                if (positional == 0)
+                {
+                    options.scenePath = arg;
+                }
+                else if (positional == 1)
+                {
+                    options.outputPath = arg;
+                }
+                else
+                {
+                    throw std::invalid_argument("unexpected argument '" + arg + "'");
+                }
+
+                positional++;
+                continue;
+            }
+
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("missing value for '" + arg + "'");
+            }
+
+            std::string value = argv[++i];
+
+            if (arg == "--spp")
+            {
+                options.samplesPerPixel = std::stoll(value);
+            }
+            else if (arg == "--threads")
+            {
+                options.threads = std::stoll(value);
+            }
+            else if (arg == "--time-budget")
+            {
+                options.timeBudget = std::stod(value);
+            }
+            else if (arg == "--samples-per-pass")
+            {
+                options.samplesPerPass = std::stoll(value);
+            }
+            else if (arg == "--noise-target")
+            {
+                options.noiseTarget = std::stod(value);
+            }
+            else if (arg == "--seed")
+            {
+                options.seed = std::stoull(value);
+                options.seeded = true;
+            }
+            else if (arg == "--sampler")
+            {
+                options.sampler = builders::CameraBuilder::samplerType(value);
+                options.overrideSampler = true;
+            }
+            else
+            {
+                throw std::invalid_argument("unknown option '" + arg + "'");
+            }
+        }
+
+        if (positional != 2)
+        {
+            throw std::invalid_argument("expected a scene and an output path");
+        }
+
+        if (options.samplesPerPixel < 0 || options.threads < 1 || options.timeBudget < 0.0 ||
+                options.samplesPerPass < 0 || options.noiseTarget < 0.0)
+        {
+            throw std::invalid_argument("option values out of range");
+        }
+
+        return options;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    try
+    {
+        options = parseArguments(argc, argv);
+    }
+    catch (const BuilderException& ex)
+    {
+        std::cerr << argv[0] << ": " << ex.what() << std::endl;
+        printUsage(argv[0]);
+        return 2;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << argv[0] << ": " << ex.what() << std::endl;
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::shared_ptr<Scene> scene;
+    acceleration::BoundingVolumeHierarchy::defaultBuildSettings().threadCount = options.threads;
+    acceleration::BuildStatistics::reset();
+
+    try
+    {
+        SceneLoaderJson loader;
+        builders::BuilderArgs args = loader.load(options.scenePath);
+        scene = builders::SceneBuilder().build(args);
+    }
+    catch (const BuilderException& ex)
+    {
+        std::cerr << options.scenePath << ": " << ex.what() << std::endl;
+        return 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << options.scenePath << ": " << ex.what() << std::endl;
+        return 1;
+    }
+
+    if (options.samplesPerPixel > 0)
+    {
+        scene->camera().setSamplesPerPixel(options.samplesPerPixel);
+    }
+
+    if (options.overrideSampler)
+    {
+        scene->camera().setSamplerType(options.sampler);
+    }
+
+    if (options.samplesPerPass > 0 || options.noiseTarget > 0.0 || options.timeBudget > 0.0)
+    {
+        // Stopping early needs a progressive render, so that the image is complete whenever it stops
+        std::size_t samplesPerPass = options.samplesPerPass > 0 ? options.samplesPerPass : scene->camera().samplesPerPass();
+
+        scene->camera().setProgressive(samplesPerPass > 0 ? samplesPerPass : defaultSamplesPerPass,
+                options.noiseTarget > 0.0 ? options.noiseTarget : scene->camera().noiseTarget(),
+                options.timeBudget > 0.0 ? options.timeBudget : scene->camera().timeBudget());
+    }
+
+    if (options.seeded)
+    {
+        RandomGenerator::seed(options.seed);
+    }
+
+    std::shared_ptr<PixelStatistics> pixelStatistics;
+
+    if (scene->camera().adaptiveThreshold() > 0.0)
+    {
+        pixelStatistics = std::make_shared<PixelStatistics>(scene->camera().resolutionX(), scene->camera().resolutionY());
+    }
+
+    threading::ThreadPool pool(options.threads);
+    RenderStatistics::reset();
+
+    auto start = std::chrono::steady_clock::now();
+    threading::TaskHandle task = ::render(pool, scene, pixelStatistics);
+    task.wait();
+
+    std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - start;
+    RenderStatistics::Counters totals = RenderStatistics::totals();
+    acceleration::BuildStatistics::Totals buildTotals = acceleration::BuildStatistics::totals();
+
+    // A progressive render cut short by the time budget is saved with the passes it managed; only the last pass may
+    // have left some tiles with fewer samples than the rest
+    task.result().save(options.outputPath);
+
+    if (pixelStatistics)
+    {
+        pixelStatistics->heatmap(scene->camera().samplesPerPixel()).save(heatmapPath(options.outputPath));
+    }
+
+    std::cout << "{\"wall-time\": " << wallTime.count()
+              << ", \"rays\": " << totals.rays
+              << ", \"mrays-per-second\": " << totals.rays / wallTime.count() * 1e-6
+              << ", \"samples\": " << totals.samples
+              << ", \"samples-per-second\": " << totals.samples / wallTime.count()
+              << ", \"threads\": " << pool.threadCount()
+              << ", \"passes\": " << task.passesCompleted()
+              << ", \"bvh-build-time\": " << buildTotals.seconds
+              << ", \"bvh-sah-cost\": " << buildTotals.largestSahCost
+#if GEOMETRY_NAN_CHECK == GEOMETRY_NAN_CHECK_COUNT
+              << ", \"nans\": " << geometry::NanCheck::count()
+#endif
+              << ", \"completed\": " << (task.timedOut() ? "false" : "true") << "}" << std::endl;
+
+    return 0;
+}
@@ -49,7 +49,8 @@ RaytracerWindow::RaytracerWindow(QWidget* parent) : QMainWindow(parent),
 
     connect(this, SIGNAL(renderStart(int)), this, SLOT(renderStarted(int)));
     connect(this, SIGNAL(renderComplete(bool)), this, SLOT(renderCompleted(bool)));
-    connect(this, SIGNAL(lineComplete(int)), this, SLOT(lineCompleted(int)));
+    connect(this, SIGNAL(tileComplete(int)), this, SLOT(tileCompleted(int)));
+    connect(this, SIGNAL(passComplete(int)), this, SLOT(passCompleted(int)));
 
     connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refreshTimerTick()));
 
@@ -62,7 +63,7 @@ RaytracerWindow::RaytracerWindow(QWidget* parent) : QMainWindow(parent),
 
     m_task->setStartCallback([this](const graphics::Image<graphics::ColourRgb<float>>& result) {
         m_image = QImage(QSize(result.width(), result.height()), QImage::Format_ARGB32);
-        emit renderStart(result.height());
+        emit renderStart(result.width() * result.height());
     });
 
     m_task->setCompleteCallback([this](const graphics::Image<graphics::ColourRgb<float>>& result, bool success) {
@@ -86,14 +87,21 @@ RaytracerWindow::RaytracerWindow(QWidget* parent) : QMainWindow(parent),
         emit renderComplete(success);
     });
 
-    m_task->setProblemCallback([this](const graphics::Image<graphics::ColourRgb<float>>& image, const threading::Problem& p) {
-        auto row = *(image.begin() + p[0]);
-        std::transform(row.begin(), row.end(), (QRgb*)m_image.scanLine(p[0]), [](const graphics::ColourRgb<float>& col) {
-            auto temp = graphics::colour_cast<graphics::ColourRgb<std::uint8_t>>(col);
-            return qRgb(temp.red(), temp.green(), temp.blue());
-        });
+    m_task->setTileCallback([this](const graphics::Image<graphics::ColourRgb<float>>& image, const threading::Tile& tile) {
+        for (size_t y = tile.y; y < tile.y + tile.height; y++) {
+            auto row = *(image.begin() + y);
+            std::transform(row.begin() + tile.x, row.begin() + tile.x + tile.width, (QRgb*)m_image.scanLine(y) + tile.x, [](const graphics::ColourRgb<float>& col) {
+                auto temp = graphics::colour_cast<graphics::ColourRgb<std::uint8_t>>(col);
+                return qRgb(temp.red(), temp.green(), temp.blue());
+            });
+        }
+
+        emit tileComplete(tile.width * tile.height);
+    });
 
-        emit lineComplete(p[0]);
+    // Progressive renders visit every pixel once per pass, so the progress bar shows the current pass
+    m_task->setPassCallback([this](const graphics::Image<graphics::ColourRgb<float>>&, std::size_t passesCompleted) {
+        emit passComplete(int(passesCompleted));
     });
 }
 
@@ -125,10 +133,15 @@ void RaytracerWindow::renderCompleted(bool success)
     emit refreshTimerTick();
 }
 
-void RaytracerWindow::lineCompleted(int line)
+void RaytracerWindow::tileCompleted(int pixels)
+{
+    m_progressBar->setValue(m_progressBar->value() + pixels);
+}
+
+void RaytracerWindow::passCompleted(int passesCompleted)
 {
-    (void)line;
-    m_progressBar->setValue(m_progressBar->value() + 1);
+    m_progressBar->setValue(0);
+    m_progressBar->setFormat(QString("Pass %1: %p%").arg(passesCompleted + 1));
 }
 
 void RaytracerWindow::refreshTimerTick()
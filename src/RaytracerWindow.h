@@ -19,12 +19,14 @@ class RaytracerWindow : public QMainWindow
 signals:
     void renderStart(int size);
     void renderComplete(bool success);
-    void lineComplete(int line);
+    void tileComplete(int pixels);
+    void passComplete(int passesCompleted);
 
 private slots:
     void renderStarted(int size);
     void renderCompleted(bool success);
-    void lineCompleted(int line);
+    void tileCompleted(int pixels);
+    void passCompleted(int passesCompleted);
     void refreshTimerTick();
 
 public:
@@ -0,0 +1,18 @@
+#include <Shapes.hpp>
+
+// The shape builders register themselves here rather than in their headers, where every translation unit including
+// a header would register its builder again. Each program that builds scenes links this file once.
+namespace shapes
+{
+
+    builders::ShapeBuilder::Registration BoxBuilder::sm_registration("box", std::make_unique<BoxBuilder>());
+    builders::ShapeBuilder::Registration ChmutovBuilder::sm_registration("chmutov", std::make_unique<ChmutovBuilder>());
+    builders::ShapeBuilder::Registration InstanceBuilder::sm_registration("instance", std::make_unique<InstanceBuilder>());
+    builders::ShapeBuilder::Registration PlaneBuilder::sm_registration("plane", std::make_unique<PlaneBuilder>());
+    builders::ShapeBuilder::Registration RectangleBuilder::sm_registration("rectangle", std::make_unique<RectangleBuilder>());
+    builders::ShapeBuilder::Registration SignedDistanceFieldBuilder::sm_registration("sdf", std::make_unique<SignedDistanceFieldBuilder>());
+    builders::ShapeBuilder::Registration SphereBuilder::sm_registration("sphere", std::make_unique<SphereBuilder>());
+    builders::ShapeBuilder::Registration SphereSetBuilder::sm_registration("sphere-set", std::make_unique<SphereSetBuilder>());
+    builders::ShapeBuilder::Registration TriangleMeshBuilder::sm_registration("mesh", std::make_unique<TriangleMeshBuilder>());
+
+}
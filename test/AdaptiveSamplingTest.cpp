@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <threading/ThreadPool.hpp>
+#include <Camera.hpp>
+#include <PixelStatistics.hpp>
+#include <RandomGenerator.hpp>
+
+TEST(AdaptiveSamplingTest, WelfordMatchesTwoPassVariance)
+{
+    std::vector<double> values = {0.5, 2.0, 0.25, 7.0, 3.5, 0.0, 1.0};
+    PixelStatistics::Accumulator accumulator;
+    double sum = 0.0;
+
+    for (double value : values)
+    {
+        accumulator.add(value);
+        sum += value;
+    }
+
+    double mean = sum / values.size();
+    double squares = 0.0;
+
+    for (double value : values)
+    {
+        squares += (value - mean) * (value - mean);
+    }
+
+    EXPECT_EQ(accumulator.count, values.size());
+    EXPECT_NEAR(accumulator.mean, mean, 1e-12);
+    EXPECT_NEAR(accumulator.variance(), squares / (values.size() - 1), 1e-12);
+}
+
+TEST(AdaptiveSamplingTest, FlatPixelsRetireEarly)
+{
+    Camera camera(32, 8, Point3(0, 0, 0), Vector3(0, 0, 1), 1.0, Vector3(0, 1, 0), 256);
+    camera.setAdaptiveSampling(0.05, 16);
+
+    auto statistics = std::make_shared<PixelStatistics>(32, 8);
+    threading::ThreadPool pool(2);
+
+    // The left half of the frame is flat grey, the right half noise with the same mean
+    auto task = camera.render(pool, [](const Ray3& ray, sampling::Sampler& sampler) {
+        float value = ray.direction()[0] < 0.0 ? 0.5f : float(sampler.next1D());
+        return graphics::ColourRgb<float>(value, value, value);
+    }, statistics);
+
+    task.wait();
+
+    const auto& image = task.result();
+
+    for (std::size_t y = 0; y < 8; y++)
+    {
+        for (std::size_t x = 0; x < 32; x++)
+        {
+            const PixelStatistics::Accumulator& pixel = statistics->at(x, y);
+            graphics::ColourRgb<float> colour = image.data()[y * image.stride() + x];
+            bool flat = x < 16;
+
+            // Pixel 16 straddles the edge between the halves
+            if (x != 16)
+            {
+                EXPECT_EQ(pixel.count, flat ? 16u : 256u) << x << ", " << y;
+            }
+
+            EXPECT_NEAR(colour.red(), 0.5, flat ? 1e-6 : 0.1);
+        }
+    }
+}
+
+TEST(AdaptiveSamplingTest, ProgressivePassesAverageAllSamples)
+{
+    Camera camera(16, 16, Point3(0, 0, 0), Vector3(0, 0, 1), 1.0, Vector3(0, 1, 0), 40);
+    camera.setProgressive(16, 0.0, 0.0);
+
+    auto statistics = std::make_shared<PixelStatistics>(16, 16);
+    threading::ThreadPool pool(2);
+
+    // Sample i of every pixel has the value i, so the image after n samples is (n - 1) / 2 throughout
+    auto task = camera.render(pool, [](const Ray3&, sampling::Sampler& sampler) {
+        float value = float(sampler.sampleIndex());
+        return graphics::ColourRgb<float>(value, value, value);
+    }, statistics);
+
+    task.wait();
+
+    EXPECT_EQ(camera.passCount(), 3u);
+    EXPECT_EQ(task.passesCompleted(), 3u);
+
+    const auto& image = task.result();
+
+    for (std::size_t y = 0; y < 16; y++)
+    {
+        for (std::size_t x = 0; x < 16; x++)
+        {
+            EXPECT_EQ(statistics->at(x, y).count, 40u);
+            EXPECT_NEAR(image.data()[y * image.stride() + x].red(), 19.5, 1e-4);
+        }
+    }
+}
+
+TEST(AdaptiveSamplingTest, NoiseTargetEndsProgressiveRender)
+{
+    Camera camera(16, 16, Point3(0, 0, 0), Vector3(0, 0, 1), 1.0, Vector3(0, 1, 0), 1 << 20);
+    camera.setProgressive(8, 0.05, 0.0);
+
+    auto statistics = std::make_shared<PixelStatistics>(16, 16);
+    threading::ThreadPool pool(2);
+
+    auto task = camera.render(pool, [](const Ray3&, sampling::Sampler& sampler) {
+        float value = float(sampler.next1D());
+        return graphics::ColourRgb<float>(value, value, value);
+    }, statistics);
+
+    task.wait();
+
+    // Uniform noise with mean 0.5 needs about (1.96 * 0.29 / 0.5 / 0.05)^2 = 500 samples per pixel
+    EXPECT_LT(statistics->noiseEstimate(), 0.05);
+    EXPECT_LT(task.passesCompleted(), 200u);
+    EXPECT_FALSE(task.timedOut());
+}
+
+TEST(AdaptiveSamplingTest, SeededPassesDrawNewSamples)
+{
+    RandomGenerator::seed(42);
+
+    Camera camera(8, 8, Point3(0, 0, 0), Vector3(0, 0, 1), 1.0, Vector3(0, 1, 0), 2);
+    camera.setSamplerType(sampling::Sampler::Type::eIndependent);
+    camera.setProgressive(1, 0.0, 0.0);
+
+    auto statistics = std::make_shared<PixelStatistics>(8, 8);
+    threading::ThreadPool pool(2);
+
+    std::mutex mutex;
+    std::vector<std::set<double>> drawn(2);
+
+    // Sample i of every pixel is taken in pass i
+    auto task = camera.render(pool, [&](const Ray3&, sampling::Sampler& sampler) {
+        double value = sampler.next1D();
+        std::unique_lock<std::mutex> lock(mutex);
+        drawn.at(sampler.sampleIndex()).insert(value);
+        return graphics::ColourRgb<float>(float(value), float(value), float(value));
+    }, statistics);
+
+    task.wait();
+
+    ASSERT_EQ(task.passesCompleted(), 2u);
+    EXPECT_EQ(drawn[0].size(), 64u);
+    EXPECT_EQ(drawn[1].size(), 64u);
+
+    std::size_t repeated = 0;
+
+    for (double value : drawn[1])
+    {
+        repeated += drawn[0].count(value);
+    }
+
+    EXPECT_EQ(repeated, 0u);
+}
@@ -0,0 +1,330 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <acceleration/BoundingVolumeHierarchy.hpp>
+#include <acceleration/BuildStatistics.hpp>
+#include <geometry/BoundingBox.hpp>
+#include <geometry/Ray.hpp>
+#include <geometry/RayPacket.hpp>
+
+using namespace geometry;
+
+namespace
+{
+    struct TestSphere
+    {
+        Point3 centre;
+        double radius;
+    };
+
+    double intersectSphere(const TestSphere& sphere, const Ray3& ray)
+    {
+        Vector3 toCentre = sphere.centre - ray.origin();
+        double projected = toCentre * ray.direction();
+        double discriminant = sphere.radius * sphere.radius - (toCentre * toCentre - projected * projected);
+
+        if (discriminant < 0)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        double root = std::sqrt(discriminant);
+        double t = projected - root > 0 ? projected - root : projected + root;
+
+        return t > 0 ? t : std::numeric_limits<double>::infinity();
+    }
+
+    std::vector<TestSphere> randomSpheres(std::size_t count, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<double> position(-10.0, 10.0);
+        std::uniform_real_distribution<double> radius(0.05, 0.5);
+        std::vector<TestSphere> spheres;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            spheres.push_back(TestSphere{Point3(position(rng), position(rng), position(rng)), radius(rng)});
+        }
+
+        return spheres;
+    }
+
+    std::vector<BoundingBox3> boundsOf(const std::vector<TestSphere>& spheres)
+    {
+        std::vector<BoundingBox3> bounds;
+
+        for (const auto& sphere : spheres)
+        {
+            Vector3 extent(sphere.radius, sphere.radius, sphere.radius);
+            bounds.push_back(BoundingBox3(sphere.centre - extent, sphere.centre + extent));
+        }
+
+        return bounds;
+    }
+}
+
+TEST(BoundingVolumeHierarchyTest, BoundingBox)
+{
+    BoundingBox3 box;
+    EXPECT_TRUE(box.isEmpty());
+
+    box.expand(Point3(1, 2, 3));
+    box.expand(Point3(-1, 0, 4));
+
+    EXPECT_FALSE(box.isEmpty());
+    EXPECT_TRUE(box.isBounded());
+    EXPECT_NEAR(box.surfaceArea(), 2 * (2 * 2 + 2 * 1 + 1 * 2), 1e-10);
+    EXPECT_EQ(box.longestAxis(), 0u);
+    EXPECT_FALSE(BoundingBox3::infinite().isBounded());
+}
+
+TEST(BoundingVolumeHierarchyTest, ContainsEveryPrimitiveOnce)
+{
+    std::mt19937 rng(1);
+    auto spheres = randomSpheres(500, rng);
+    acceleration::BoundingVolumeHierarchy bvh(boundsOf(spheres));
+
+    std::vector<std::uint32_t> indices(bvh.primitiveIndices().begin(), bvh.primitiveIndices().end());
+    std::sort(indices.begin(), indices.end());
+
+    ASSERT_EQ(indices.size(), spheres.size());
+
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        EXPECT_EQ(indices[i], i);
+    }
+}
+
+TEST(BoundingVolumeHierarchyTest, MatchesLinearScan)
+{
+    std::mt19937 rng(2);
+    auto spheres = randomSpheres(1000, rng);
+    acceleration::BoundingVolumeHierarchy bvh(boundsOf(spheres));
+
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        Ray3 ray(Point3(dist(rng) * 12, dist(rng) * 12, dist(rng) * 12), normalize(Vector3(dist(rng), dist(rng), dist(rng))));
+
+        double expected = std::numeric_limits<double>::infinity();
+
+        for (const auto& sphere : spheres)
+        {
+            expected = std::min(expected, intersectSphere(sphere, ray));
+        }
+
+        double nearest = std::numeric_limits<double>::infinity();
+
+        bvh.intersect(ray, 0.0, nearest, [&](std::uint32_t index, double& maxDistance) {
+            maxDistance = std::min(maxDistance, intersectSphere(spheres[index], ray));
+        });
+
+        EXPECT_EQ(nearest, expected);
+    }
+}
+
+TEST(BoundingVolumeHierarchyTest, MortonBuildMatchesLinearScan)
+{
+    std::mt19937 rng(5);
+    auto spheres = randomSpheres(1000, rng);
+    acceleration::BoundingVolumeHierarchy::BuildSettings settings;
+    settings.method = acceleration::BoundingVolumeHierarchy::BuildMethod::eMorton;
+    acceleration::BoundingVolumeHierarchy bvh(boundsOf(spheres), settings);
+
+    std::vector<std::uint32_t> indices(bvh.primitiveIndices().begin(), bvh.primitiveIndices().end());
+    std::sort(indices.begin(), indices.end());
+    ASSERT_EQ(indices.size(), spheres.size());
+    EXPECT_EQ(indices.back(), spheres.size() - 1);
+    EXPECT_EQ(std::unique(indices.begin(), indices.end()), indices.end());
+
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        Ray3 ray(Point3(dist(rng) * 12, dist(rng) * 12, dist(rng) * 12), normalize(Vector3(dist(rng), dist(rng), dist(rng))));
+
+        double expected = std::numeric_limits<double>::infinity();
+
+        for (const auto& sphere : spheres)
+        {
+            expected = std::min(expected, intersectSphere(sphere, ray));
+        }
+
+        double nearest = std::numeric_limits<double>::infinity();
+
+        bvh.intersect(ray, 0.0, nearest, [&](std::uint32_t index, double& maxDistance) {
+            maxDistance = std::min(maxDistance, intersectSphere(spheres[index], ray));
+        });
+
+        EXPECT_EQ(nearest, expected);
+    }
+}
+
+TEST(BoundingVolumeHierarchyTest, ParallelBuildMatchesSerialBuild)
+{
+    std::mt19937 rng(6);
+    auto bounds = boundsOf(randomSpheres(50000, rng));
+
+    for (auto method : {acceleration::BoundingVolumeHierarchy::BuildMethod::eSah, acceleration::BoundingVolumeHierarchy::BuildMethod::eMorton})
+    {
+        acceleration::BoundingVolumeHierarchy::BuildSettings serial;
+        serial.method = method;
+        serial.threadCount = 1;
+
+        // More threads than primitives per chunk allow, and a count that does not divide the chunks evenly
+        acceleration::BoundingVolumeHierarchy::BuildSettings parallel = serial;
+        parallel.threadCount = 3;
+
+        acceleration::BuildStatistics::reset();
+        acceleration::BoundingVolumeHierarchy expected(bounds, serial);
+        acceleration::BoundingVolumeHierarchy bvh(bounds, parallel);
+
+        acceleration::BuildStatistics::Totals totals = acceleration::BuildStatistics::totals();
+        EXPECT_EQ(totals.hierarchies, 2u);
+        EXPECT_EQ(totals.primitives, 2 * bounds.size());
+        EXPECT_EQ(totals.largestSahCost, bvh.sahCost());
+        EXPECT_GT(bvh.sahCost(), 1.0);
+
+        ASSERT_EQ(bvh.nodes().size(), expected.nodes().size());
+        EXPECT_TRUE(std::equal(bvh.primitiveIndices().begin(), bvh.primitiveIndices().end(), expected.primitiveIndices().begin()));
+
+        for (std::size_t i = 0; i < bvh.nodes().size(); i++)
+        {
+            const auto& node = bvh.nodes()[i];
+            const auto& expectedNode = expected.nodes()[i];
+
+            ASSERT_EQ(node.offset, expectedNode.offset);
+            ASSERT_EQ(node.count, expectedNode.count);
+            ASSERT_EQ(node.axis, expectedNode.axis);
+
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                ASSERT_EQ(node.bounds.min()[axis], expectedNode.bounds.min()[axis]);
+                ASSERT_EQ(node.bounds.max()[axis], expectedNode.bounds.max()[axis]);
+            }
+        }
+    }
+}
+
+TEST(BoundingVolumeHierarchyTest, CoincidentPrimitives)
+{
+    std::vector<BoundingBox3> bounds(100, BoundingBox3(Point3(0, 0, 0), Point3(1, 1, 1)));
+    acceleration::BoundingVolumeHierarchy bvh(bounds);
+
+    int visited = 0;
+    double maxDistance = std::numeric_limits<double>::infinity();
+
+    bvh.intersect(Ray3(Point3(0.5, 0.5, -1), Vector3(0, 0, 1)), 0.0, maxDistance, [&](std::uint32_t, double&) {
+        visited++;
+    });
+
+    EXPECT_EQ(visited, 100);
+}
+
+TEST(BoundingVolumeHierarchyTest, LargeLeavesFitTheirCount)
+{
+    std::vector<BoundingBox3> bounds(70000, BoundingBox3(Point3(0, 0, 0), Point3(1, 1, 1)));
+
+    for (auto method : {acceleration::BoundingVolumeHierarchy::BuildMethod::eSah, acceleration::BoundingVolumeHierarchy::BuildMethod::eMorton})
+    {
+        acceleration::BoundingVolumeHierarchy::BuildSettings settings;
+        settings.method = method;
+        settings.maxLeafSize = 100000;
+        acceleration::BoundingVolumeHierarchy bvh(bounds, settings);
+
+        std::size_t leafPrimitives = 0;
+
+        for (const auto& node : bvh.nodes())
+        {
+            leafPrimitives += node.count;
+        }
+
+        EXPECT_EQ(leafPrimitives, bounds.size());
+    }
+}
+
+TEST(BoundingVolumeHierarchyTest, AnyHitMatchesNearestHit)
+{
+    std::mt19937 rng(3);
+    auto spheres = randomSpheres(1000, rng);
+    acceleration::BoundingVolumeHierarchy bvh(boundsOf(spheres));
+
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::uniform_real_distribution<double> length(0.0, 20.0);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        Ray3 ray(Point3(dist(rng) * 12, dist(rng) * 12, dist(rng) * 12), normalize(Vector3(dist(rng), dist(rng), dist(rng))));
+        double maxDistance = length(rng);
+
+        double nearest = std::numeric_limits<double>::infinity();
+
+        bvh.intersect(ray, 0.0, nearest, [&](std::uint32_t index, double& limit) {
+            limit = std::min(limit, intersectSphere(spheres[index], ray));
+        });
+
+        bool occluded = bvh.intersectsAny(ray, 0.0, maxDistance, [&](std::uint32_t index, double limit) {
+            return intersectSphere(spheres[index], ray) < limit;
+        });
+
+        EXPECT_EQ(occluded, nearest < maxDistance);
+    }
+}
+
+TEST(BoundingVolumeHierarchyTest, PacketMatchesSingleRays)
+{
+    std::mt19937 rng(4);
+    auto spheres = randomSpheres(1000, rng);
+    acceleration::BoundingVolumeHierarchy bvh(boundsOf(spheres));
+
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    const std::size_t width = 4;
+
+    for (int i = 0; i < 500; i++)
+    {
+        // Every other packet is a narrow cone from one origin, which is traversed with the frustum test; the rest
+        // are rays in arbitrary directions
+        bool coherent = i % 2 == 0;
+        Point3 origin(dist(rng) * 12, dist(rng) * 12, dist(rng) * 12);
+        Vector3 axis = normalize(Vector3(dist(rng), dist(rng), dist(rng)));
+
+        RayPacket<geo_type, width> packet;
+
+        for (std::size_t lane = 0; lane < width; lane++)
+        {
+            Vector3 direction = coherent ? axis + 0.01 * Vector3(dist(rng), dist(rng), dist(rng)) : Vector3(dist(rng), dist(rng), dist(rng));
+            packet.push(Ray3(origin, normalize(direction)));
+        }
+
+        std::array<double, width> nearest;
+        nearest.fill(std::numeric_limits<double>::infinity());
+
+        bvh.intersect(packet, 0.0, nearest, [&](std::uint32_t index, const PacketMask<width>& active, std::array<double, width>& maxDistances) {
+            for (std::size_t lane = 0; lane < width; lane++)
+            {
+                if (active[lane])
+                {
+                    maxDistances[lane] = std::min(maxDistances[lane], intersectSphere(spheres[index], packet.ray(lane)));
+                }
+            }
+        });
+
+        for (std::size_t lane = 0; lane < width; lane++)
+        {
+            Ray3 ray = packet.ray(lane);
+            double expected = std::numeric_limits<double>::infinity();
+
+            bvh.intersect(ray, 0.0, expected, [&](std::uint32_t index, double& maxDistance) {
+                maxDistance = std::min(maxDistance, intersectSphere(spheres[index], ray));
+            });
+
+            EXPECT_EQ(nearest[lane], expected);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <shapes/Box.hpp>
+#include <shapes/Rectangle.hpp>
+
+using namespace geometry;
+
+TEST(BoxTest, ReportsOutwardNormals)
+{
+    auto white = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 1.0);
+    shapes::Box box(Vector3(2, 2, 2), Point3(0.5, 0, 0), Vector3(0.1, 0.2, 0.3), white);
+    std::mt19937 rng(4);
+    std::normal_distribution<double> dist;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        Vector3 direction = normalize(Vector3(dist(rng), dist(rng), dist(rng)));
+        Point3 centre(0.5, 0, 0);
+
+        // Hits are reported for the box itself, with a unit normal pointing out of it on the side that was hit
+        shapes::Shape::IntersectionResult outside = box.calculateRayIntersection(Ray3(centre - 5 * direction, direction));
+        ASSERT_EQ(outside.shape(), &box);
+        EXPECT_NEAR(abs(outside.normal()), 1.0, 1e-5);
+        EXPECT_LT(outside.normal() * direction, 0.0);
+        EXPECT_GE(outside.uv().x(), 0.0);
+        EXPECT_LE(outside.uv().y(), 1.0);
+
+        shapes::Shape::IntersectionResult inside = box.calculateRayIntersection(Ray3(centre, direction));
+        ASSERT_EQ(inside.shape(), &box);
+        EXPECT_GT(inside.normal() * direction, 0.0);
+    }
+}
+
+TEST(BoxTest, MatchesItsFaces)
+{
+    auto white = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 1.0);
+    Vector3 size(1, 2, 3);
+    Point3 centre(0.5, -1, 2);
+    Vector3 orientation(0.1, 0.2, 0.3);
+    shapes::Box box(size, centre, orientation, white);
+    shapes::Box axisAligned(size, centre, Vector3(0, 0, 0), white);
+
+    // The faces as rectangles, wound so that their normals point outwards
+    auto faces = [&](const Vector3& turns) {
+        const double turn = 8.0 * std::atan(1.0);
+        auto rotationTransform = rotation<geo_type>(turns[0] * turn, turns[1] * turn, turns[2] * turn);
+        Vector3 s = size * 0.5;
+        Vector3 offset = centre - Point3(0, 0, 0);
+        auto corner = [&](double x, double y, double z) {
+            return rotationTransform * Point3(x * s[0], y * s[1], z * s[2]) + offset;
+        };
+
+        return std::vector<shapes::Rectangle>{
+            shapes::Rectangle(corner(-1, 1, -1), corner(-1, 1, 1), corner(1, 1, -1), white),
+            shapes::Rectangle(corner(-1, -1, -1), corner(1, -1, -1), corner(-1, -1, 1), white),
+            shapes::Rectangle(corner(-1, -1, -1), corner(-1, 1, -1), corner(1, -1, -1), white),
+            shapes::Rectangle(corner(-1, -1, 1), corner(1, -1, 1), corner(-1, 1, 1), white),
+            shapes::Rectangle(corner(-1, -1, -1), corner(-1, -1, 1), corner(-1, 1, -1), white),
+            shapes::Rectangle(corner(1, -1, -1), corner(1, 1, -1), corner(1, -1, 1), white),
+        };
+    };
+
+    std::mt19937 rng(6);
+    std::uniform_real_distribution<double> dist(-4, 4);
+    const double tolerance = sizeof(geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+
+    for (const auto& test : {std::make_pair(&box, orientation), std::make_pair(&axisAligned, Vector3(0, 0, 0))})
+    {
+        std::vector<shapes::Rectangle> rectangles = faces(test.second);
+        int disagreements = 0;
+
+        for (int i = 0; i < 2000; i++)
+        {
+            Point3 origin = centre + Vector3(dist(rng), dist(rng), dist(rng));
+            Ray3 ray(origin, normalize(Vector3(dist(rng), dist(rng), dist(rng))));
+
+            shapes::Shape::IntersectionResult expected;
+
+            for (const auto& rectangle : rectangles)
+            {
+                shapes::Shape::IntersectionResult result = rectangle.calculateRayIntersection(ray);
+
+                if (result.distance() > 0 && result.distance() < expected.distance())
+                {
+                    expected = result;
+                }
+            }
+
+            shapes::Shape::IntersectionResult hit = test.first->calculateRayIntersection(ray);
+
+            if ((hit.shape() != nullptr) != (expected.shape() != nullptr))
+            {
+                disagreements++;
+                continue;
+            }
+
+            EXPECT_EQ(test.first->intersectsWithin(ray, 0, 100), hit.shape() != nullptr);
+
+            if (hit.shape())
+            {
+                EXPECT_NEAR(hit.distance(), expected.distance(), tolerance * (1 + expected.distance()));
+                EXPECT_NEAR(hit.normal() * expected.normal(), 1.0, tolerance);
+            }
+        }
+
+        // Rays that graze an edge may be found by one test and not the other
+        EXPECT_LE(disagreements, 2);
+    }
+
+    EXPECT_NEAR(axisAligned.boundingBox().surfaceArea(), 22.0, 1e-9);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <random>
+
+#include <shapes/Chmutov.hpp>
+
+using namespace geometry;
+
+TEST(ChmutovTest, FindsFirstCrossing)
+{
+    auto glass = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 0.0, 1.0);
+    const double a = 3, b = 2, c = 4.2;
+    Point3 origin(0.5, -0.25, 1);
+    shapes::Chmutov chmutov(origin, Vector3(0, 0, 0), a, b, c, glass);
+
+    auto f = [&](const Point3& p) {
+        Vector3 q = p - origin;
+        double x2 = q[0] * q[0], y2 = q[1] * q[1], z2 = q[2] * q[2];
+        return a + b * (x2 * x2 + y2 * y2 + z2 * z2) - c * (x2 + y2 + z2);
+    };
+
+    std::mt19937 rng(12);
+    std::uniform_real_distribution<double> dist(-3, 3);
+    const double step = 1e-3;
+    const double tolerance = sizeof(geo_type) < sizeof(double) ? 1e-3 : 1e-6;
+    int hits = 0;
+
+    for (int i = 0; i < 500; i++)
+    {
+        Point3 from = origin + Vector3(dist(rng), dist(rng), dist(rng));
+        Ray3 ray(from, normalize(origin + 0.5 * Vector3(dist(rng), dist(rng), dist(rng)) - from));
+        shapes::Shape::IntersectionResult hit = chmutov.calculateRayIntersection(ray);
+
+        // First sign change of the implicit function along the ray, found by stepping
+        double crossing = std::numeric_limits<double>::infinity();
+
+        for (double t = step; t < 12; t += step)
+        {
+            if ((f(ray.origin() + (t - step) * ray.direction()) < 0) != (f(ray.origin() + t * ray.direction()) < 0))
+            {
+                crossing = t;
+                break;
+            }
+        }
+
+        EXPECT_EQ(chmutov.intersectsWithin(ray, 0, 100), hit.shape() != nullptr);
+
+        if (crossing < std::numeric_limits<double>::infinity())
+        {
+            // Tangent rays can touch the surface before the first sign change
+            ASSERT_EQ(hit.shape(), &chmutov);
+            EXPECT_LE(hit.distance(), crossing + step);
+            hits++;
+        }
+
+        if (hit.shape())
+        {
+            Point3 p = ray.origin() + hit.distance() * ray.direction();
+            EXPECT_NEAR(f(p), 0.0, tolerance);
+            EXPECT_NEAR(abs(hit.normal()), 1.0, tolerance);
+            EXPECT_TRUE(chmutov.intersectsWithin(ray, 0, hit.distance() * 1.001));
+            EXPECT_FALSE(chmutov.intersectsWithin(ray, 0, hit.distance() * 0.999));
+        }
+    }
+
+    EXPECT_GT(hits, 100);
+
+    // The bounding box holds every point inside the surface
+    geometry::BoundingBox3 bounds = chmutov.boundingBox();
+
+    for (int i = 0; i < 100000; i++)
+    {
+        Point3 p = origin + Vector3(dist(rng), dist(rng), dist(rng));
+
+        if (f(p) < 0)
+        {
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                EXPECT_GE(p[axis], bounds.min()[axis]);
+                EXPECT_LE(p[axis], bounds.max()[axis]);
+            }
+        }
+    }
+
+    EXPECT_LT(bounds.max()[0] - origin[0], 1.6);
+}
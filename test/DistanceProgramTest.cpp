@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <geometry/DistanceProgram.hpp>
+
+using namespace geometry;
+
+namespace
+{
+    using Position = DistanceProgram::Position;
+
+    double distanceBetween(const Position& a, const Position& b)
+    {
+        return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+    }
+
+    // Rounded box smoothly joined to a sphere, with a torus cut out and a ripple over the whole
+    std::shared_ptr<DistanceNode> blob()
+    {
+        auto box = DistanceNode::box({{0, 0, 0}}, {{1, 0.5, 0.75}}, 0.1);
+        auto sphere = DistanceNode::sphere({{1, 0.5, 0}}, 0.6);
+        auto torus = DistanceNode::torus({{0, 0.5, 0}}, 0.8, 0.2);
+        auto joined = DistanceNode::combine(DistanceNode::Type::eUnion, box, sphere, 0.3);
+        auto cut = DistanceNode::combine(DistanceNode::Type::eDifference, joined, torus, 0.1);
+
+        return DistanceNode::ripple(cut, 0.05, 6);
+    }
+}
+
+TEST(DistanceProgramTest, PrimitivesAreExactDistances)
+{
+    DistanceProgram sphere(*DistanceNode::sphere({{1, 2, 3}}, 2));
+    EXPECT_DOUBLE_EQ(sphere.evaluate({{1, 2, 3}}), -2);
+    EXPECT_DOUBLE_EQ(sphere.evaluate({{1, 2, 8}}), 3);
+
+    DistanceProgram box(*DistanceNode::box({{0, 0, 0}}, {{1, 2, 3}}, 0.5));
+    EXPECT_DOUBLE_EQ(box.evaluate({{3, 0, 0}}), 2);
+    EXPECT_DOUBLE_EQ(box.evaluate({{0, 0, -1}}), -1);
+    // Beyond a corner, the distance is to the rounded edge
+    EXPECT_NEAR(box.evaluate({{1.5, 2.5, 0}}), std::sqrt(2.0) - 0.5, 1e-12);
+
+    DistanceProgram torus(*DistanceNode::torus({{0, 0, 0}}, 2, 0.5));
+    EXPECT_DOUBLE_EQ(torus.evaluate({{0, 0, 2}}), -0.5);
+    EXPECT_DOUBLE_EQ(torus.evaluate({{0, 3, 0}}), std::sqrt(13.0) - 0.5);
+
+    EXPECT_EQ(sphere.lipschitzBound(), 1.0);
+    EXPECT_EQ(sphere.size(), 1u);
+}
+
+TEST(DistanceProgramTest, CombinesChildren)
+{
+    auto a = DistanceNode::sphere({{-0.5, 0, 0}}, 1);
+    auto b = DistanceNode::sphere({{0.5, 0, 0}}, 1);
+    Position between = {{0, 0.5, 0}};
+    double da = DistanceProgram(*a).evaluate(between);
+    double db = DistanceProgram(*b).evaluate(between);
+
+    EXPECT_DOUBLE_EQ(DistanceProgram(*DistanceNode::combine(DistanceNode::Type::eUnion, a, b, 0)).evaluate(between), std::min(da, db));
+    EXPECT_DOUBLE_EQ(DistanceProgram(*DistanceNode::combine(DistanceNode::Type::eIntersection, a, b, 0)).evaluate(between), std::max(da, db));
+    EXPECT_DOUBLE_EQ(DistanceProgram(*DistanceNode::combine(DistanceNode::Type::eDifference, a, b, 0)).evaluate(between), std::max(da, -db));
+
+    // Smoothing undercuts the union by at most a quarter of its radius, where the children are close
+    double smooth = DistanceProgram(*DistanceNode::combine(DistanceNode::Type::eUnion, a, b, 0.4)).evaluate(between);
+    EXPECT_LT(smooth, std::min(da, db));
+    EXPECT_GE(smooth, std::min(da, db) - 0.1);
+
+    double far = DistanceProgram(*DistanceNode::combine(DistanceNode::Type::eUnion, a, b, 0.4)).evaluate({{-3, 0, 0}});
+    EXPECT_DOUBLE_EQ(far, 1.5);
+}
+
+TEST(DistanceProgramTest, BoundsHoldForCompositeExpressions)
+{
+    DistanceProgram program(*blob());
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> dist(-3, 3);
+
+    // Both children of the difference are exact, so only the ripple steepens the expression
+    EXPECT_DOUBLE_EQ(program.lipschitzBound(), 1.3);
+    EXPECT_EQ(program.size(), 6u);
+
+    for (int i = 0; i < 100000; i++)
+    {
+        Position p = {{dist(rng), dist(rng), dist(rng)}};
+        Position q = p;
+
+        for (double& component : q)
+        {
+            component += 0.05 * dist(rng);
+        }
+
+        double value = program.evaluate(p);
+        EXPECT_LE(std::abs(value - program.evaluate(q)), program.lipschitzBound() * distanceBetween(p, q) + 1e-12);
+
+        if (value <= 0)
+        {
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                EXPECT_GE(p[axis], program.lower()[axis]);
+                EXPECT_LE(p[axis], program.upper()[axis]);
+            }
+        }
+    }
+
+    // The normal of a sphere points away from its centre
+    DistanceProgram sphere(*DistanceNode::sphere({{1, 0, 0}}, 1));
+    auto normal = sphere.gradientDirection({{1, 0.6, 0.8}}, 1e-6);
+    EXPECT_NEAR(normal[0], 0.0, 1e-8);
+    EXPECT_NEAR(normal[1], 0.6, 1e-8);
+    EXPECT_NEAR(normal[2], 0.8, 1e-8);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <initializer_list>
+#include <memory>
+#include <random>
+#include <utility>
+
+#include <builders/SceneBuilder.hpp>
+#include <shapes/Box.hpp>
+#include <shapes/Instance.hpp>
+#include <shapes/Sphere.hpp>
+#include <Scene.hpp>
+
+using namespace geometry;
+
+TEST(InstanceTest, MatchesTransformedShapes)
+{
+    using namespace builders;
+
+    auto object = [](std::initializer_list<std::pair<const char*, ParamValue>> entries) {
+        auto args = std::make_shared<BuilderArgs>();
+
+        for (const auto& entry : entries)
+        {
+            args->insert(entry.first, entry.second);
+        }
+
+        return args;
+    };
+
+    // A box and a sphere grouped as a prototype, placed once by location, orientation and scale and once by a
+    // matrix that stretches it along x
+    auto sceneArgs = object({
+        {"title", ParamTypes::String("instances")},
+        {"description", ParamTypes::String("")},
+        {"camera", object({{"resolution", ParamTypes::IntegerList{16, 16}}, {"location", ParamTypes::IntegerList{0, 0, -5}},
+                {"direction", ParamTypes::IntegerList{0, 0, 1}}})},
+        {"Surfaces", object({{"red", object({{"colour", ParamTypes::IntegerList{1, 0, 0}}})},
+                {"blue", object({{"colour", ParamTypes::IntegerList{0, 0, 1}}})}})},
+        {"prototypes", object({{"lamp", object({
+                {"base", object({{"shape", ParamTypes::String("box")}, {"location", ParamTypes::IntegerList{0, 0, 0}},
+                        {"dimensions", ParamTypes::FloatList{1, 2, 0.5}}, {"surface", ParamTypes::String("red")}})},
+                {"shade", object({{"shape", ParamTypes::String("sphere")}, {"location", ParamTypes::IntegerList{1, 0, 0}},
+                        {"radius", ParamTypes::Float(0.5)}, {"surface", ParamTypes::String("blue")}})}})}})},
+        {"geometry", object({
+                {"a", object({{"shape", ParamTypes::String("instance")}, {"prototype", ParamTypes::String("lamp")},
+                        {"location", ParamTypes::FloatList{1, 0.5, 2}}, {"orientation", ParamTypes::FloatList{0.1, 0.2, 0.05}},
+                        {"scale", ParamTypes::Float(0.8)}})},
+                {"b", object({{"shape", ParamTypes::String("instance")}, {"prototype", ParamTypes::String("lamp")},
+                        {"transform", ParamTypes::IntegerList{2, 0, 0, -1, 0, 1, 0, 0, 0, 0, 1, -2}}})}})}
+    });
+
+    std::shared_ptr<Scene> scene = SceneBuilder().build(*sceneArgs);
+    ASSERT_EQ(scene->geometry().size(), 2u);
+    const auto& a = dynamic_cast<const shapes::Instance&>(*scene->geometry()[0]);
+    const auto& b = dynamic_cast<const shapes::Instance&>(*scene->geometry()[1]);
+    EXPECT_EQ(&a.prototype(), &b.prototype());
+    EXPECT_EQ(scene->materials().size(), 4u);
+
+    // The same shapes built in place of the first instance
+    const double turn = 8.0 * std::atan(1.0);
+    auto rotationTransform = rotation<geo_type>(0.1 * turn, 0.2 * turn, 0.05 * turn);
+    auto red = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 0, 0), 1.0);
+    auto blue = std::make_shared<Surface>(graphics::ColourRgb<float>(0, 0, 1), 1.0);
+    shapes::Box box(Vector3(0.8, 1.6, 0.4), Point3(1, 0.5, 2), Vector3(0.1, 0.2, 0.05), red);
+    shapes::Sphere sphere(Point3(1, 0.5, 2) + rotationTransform * Vector3(0.8, 0, 0), Vector3(0, 1, 0), 0.4, blue);
+
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<double> dist(-2, 2);
+    const double tolerance = sizeof(geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+    const double normalTolerance = sizeof(geo_type) < sizeof(double) ? 1e-3 : 1e-6;
+    int hits = 0;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        Point3 origin = Point3(1, 0.5, 2) + 2 * Vector3(dist(rng), dist(rng), dist(rng));
+        Ray3 ray(origin, normalize(Point3(1, 0.5, 2) + 0.5 * Vector3(dist(rng), dist(rng), dist(rng)) - origin));
+
+        shapes::Shape::IntersectionResult expected = box.calculateRayIntersection(ray);
+        shapes::Shape::IntersectionResult sphereHit = sphere.calculateRayIntersection(ray);
+
+        if (sphereHit.distance() < expected.distance())
+        {
+            expected = sphereHit;
+        }
+
+        shapes::Shape::IntersectionResult hit = a.calculateRayIntersection(ray);
+        ASSERT_EQ(hit.shape() != nullptr, expected.shape() != nullptr);
+
+        if (!hit.shape())
+        {
+            continue;
+        }
+
+        hits++;
+        EXPECT_NEAR(hit.distance(), expected.distance(), tolerance * (1 + expected.distance()));
+        EXPECT_LT(abs(hit.normal() - expected.normal()), normalTolerance);
+        EXPECT_EQ(scene->materials()[hit.material()].colour().blue(), expected.shape()->surface().colour().blue());
+        EXPECT_TRUE(a.intersectsWithin(ray, 0, expected.distance() * 1.01));
+        EXPECT_FALSE(a.intersectsWithin(ray, 0, expected.distance() * 0.99));
+    }
+
+    EXPECT_GT(hits, 1000);
+
+    // Stretching doubles the sphere along x, which tilts its normals towards the stretched axes
+    shapes::Shape::IntersectionResult tip = scene->nearestIntersection(Ray3(Point3(10, 0, -2), Vector3(-1, 0, 0)), 1e-6);
+    ASSERT_EQ(tip.shape(), &b);
+    EXPECT_NEAR(tip.distance(), 8, 1e-6);
+    EXPECT_EQ(scene->materials()[tip.material()].colour().blue(), 1.0f);
+
+    shapes::Shape::IntersectionResult side = b.calculateRayIntersection(Ray3(Point3(10, 0.25, -2), Vector3(-1, 0, 0)));
+    EXPECT_NEAR(side.distance(), 11 - 2 * (1 + std::sqrt(0.1875)), 1e-6);
+    Vector3 normal = normalize(Vector3(std::sqrt(0.1875) / 2, 0.25, 0));
+    EXPECT_LT(abs(side.normal() - normal), 1e-6);
+
+    shapes::Shape::IntersectionResult front = scene->nearestIntersection(Ray3(Point3(-1, 0, -10), Vector3(0, 0, 1)), 1e-6);
+    ASSERT_EQ(front.shape(), &b);
+    EXPECT_NEAR(front.distance(), 7.75, 1e-6);
+    EXPECT_EQ(scene->materials()[front.material()].colour().red(), 1.0f);
+}
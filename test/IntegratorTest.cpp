@@ -0,0 +1,398 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <sampling/SobolSampler.hpp>
+#include <shapes/Box.hpp>
+#include <shapes/Plane.hpp>
+#include <shapes/Rectangle.hpp>
+#include <shapes/Sphere.hpp>
+#include <MediumStack.hpp>
+#include <RandomGenerator.hpp>
+#include <Raytracer.hpp>
+#include <RenderSettings.hpp>
+#include <RenderStatistics.hpp>
+#include <Scene.hpp>
+
+using namespace geometry;
+
+// Counts heap allocations made by the current thread while enabled
+namespace
+{
+    thread_local bool countAllocations = false;
+    thread_local std::size_t allocationCount = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    if (countAllocations)
+    {
+        allocationCount++;
+    }
+
+    void* p = std::malloc(size ? size : 1);
+
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    // A lit box holding nested glass spheres, so that paths branch, refract and enter several media at once
+    Scene glassScene(const RenderSettings& settings = RenderSettings())
+    {
+        auto white = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 1.0);
+        auto light = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 0.0, 0.0, 0.0, 4.0);
+        auto glass = std::make_shared<Surface>(graphics::ColourRgb<float>(0.9, 0.9, 1), 0.0, 0.0, 1.0, 0.0, 1.5);
+        auto mirror = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 0.0, 1.0);
+
+        Scene::ShapeListType shapes = {
+            std::make_shared<shapes::Rectangle>(Point3(-2, -2, -2), Point3(2, -2, -2), Point3(-2, -2, 2), white),
+            std::make_shared<shapes::Rectangle>(Point3(-2, 2, -2), Point3(-2, 2, 2), Point3(2, 2, -2), white),
+            std::make_shared<shapes::Rectangle>(Point3(-2, -2, 2), Point3(2, -2, 2), Point3(-2, 2, 2), mirror),
+            std::make_shared<shapes::Rectangle>(Point3(-0.5, 1.9, -0.5), Point3(0.5, 1.9, -0.5), Point3(-0.5, 1.9, 0.5), light),
+            std::make_shared<shapes::Sphere>(Point3(0, 0, 0), Vector3(0, 1, 0), 1.0, glass),
+            std::make_shared<shapes::Sphere>(Point3(0, 0, 0), Vector3(0, 1, 0), 0.5, glass),
+        };
+
+        return Scene("glass", "", Camera(16, 16, Point3(0, 0, -1.9), Vector3(0, 0, 1)), shapes, settings);
+    }
+
+    // Diffuse box lit by a small panel and a small sphere, where light sampling and BSDF sampling both matter
+    Scene diffuseScene(const RenderSettings& settings)
+    {
+        auto white = std::make_shared<Surface>(graphics::ColourRgb<float>(0.8, 0.8, 0.8), 1.0);
+        auto light = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 0.0, 0.0, 0.0, 4.0);
+
+        Scene::ShapeListType shapes = {
+            std::make_shared<shapes::Rectangle>(Point3(-2, -2, -2), Point3(2, -2, -2), Point3(-2, -2, 2), white),
+            std::make_shared<shapes::Rectangle>(Point3(-2, 2, -2), Point3(-2, 2, 2), Point3(2, 2, -2), white),
+            std::make_shared<shapes::Rectangle>(Point3(-2, -2, 2), Point3(2, -2, 2), Point3(-2, 2, 2), white),
+            std::make_shared<shapes::Rectangle>(Point3(-0.5, 1.9, -0.5), Point3(0.5, 1.9, -0.5), Point3(-0.5, 1.9, 0.5), light),
+            std::make_shared<shapes::Sphere>(Point3(1, -1.5, 1), Vector3(0, 1, 0), 0.3, light),
+            std::make_shared<shapes::Sphere>(Point3(-0.5, -1, 0.5), Vector3(0, 1, 0), 0.8, white),
+        };
+
+        return Scene("diffuse", "", Camera(16, 16, Point3(0, 0, -1.9), Vector3(0, 0, 1)), shapes, settings);
+    }
+
+    double meanRadiance(const Scene& scene, int samples)
+    {
+        // Paths draw from the thread's generator; fix it so that the estimate is the same on every run
+        RandomGenerator::seed(6);
+        std::mt19937 rng(6);
+        std::uniform_real_distribution<double> dist(-0.6, 0.6);
+        double sum = 0.0;
+
+        for (int i = 0; i < samples; i++)
+        {
+            graphics::ColourRgb<float> radiance = tracePath(Ray3(Point3(0, 0, -1.9), normalize(Vector3(dist(rng), dist(rng), 1))), scene);
+            sum += radiance.red() + radiance.green() + radiance.blue();
+        }
+
+        return sum / samples;
+    }
+}
+
+TEST(IntegratorTest, MediumStack)
+{
+    MediumStack media;
+    EXPECT_EQ(media.top(), 1.0f);
+
+    for (std::size_t i = 0; i < MediumStack::sm_capacity + 2; i++)
+    {
+        media.push(1.0f + i);
+    }
+
+    EXPECT_EQ(media.depth(), MediumStack::sm_capacity + 3);
+
+    for (std::size_t i = 0; i < MediumStack::sm_capacity + 5; i++)
+    {
+        media.pop();
+    }
+
+    // Exits past the outermost medium leave the path where it started
+    EXPECT_EQ(media.depth(), 1u);
+    EXPECT_EQ(media.top(), 1.0f);
+}
+
+TEST(IntegratorTest, TracePathDoesNotAllocate)
+{
+    Scene scene = glassScene();
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<double> dist(-0.6, 0.6);
+
+    // Warm up thread local state before counting
+    tracePath(Ray3(Point3(0, 0, -1.9), Vector3(0, 0, 1)), scene);
+
+    allocationCount = 0;
+    countAllocations = true;
+
+    // Make sure the hook sees allocations at all. A new expression whose result goes unused may be elided, so the
+    // probe calls the allocation function itself and keeps the pointer in a volatile
+    void* volatile probe = ::operator new(sizeof(int));
+    ::operator delete(probe);
+    EXPECT_EQ(allocationCount, 1u);
+    allocationCount = 0;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        tracePath(Ray3(Point3(0, 0, -1.9), normalize(Vector3(dist(rng), dist(rng), 1))), scene);
+    }
+
+    countAllocations = false;
+
+    EXPECT_EQ(allocationCount, 0u);
+}
+
+TEST(IntegratorTest, StochasticFresnelTracesSinglePath)
+{
+    RenderSettings settings;
+    settings.fresnelMode = RenderSettings::FresnelMode::eStochastic;
+    settings.fresnelSplitDepth = 0;
+
+    Scene scene = glassScene(settings);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> dist(-0.6, 0.6);
+
+    // Without splitting, every path is a single chain: one ray per vertex plus a shadow ray per diffuse vertex
+    for (int i = 0; i < 2000; i++)
+    {
+        RenderStatistics::flush();
+        RenderStatistics::reset();
+
+        tracePath(Ray3(Point3(0, 0, -1.9), normalize(Vector3(dist(rng), dist(rng), 1))), scene);
+
+        RenderStatistics::flush();
+        EXPECT_LE(RenderStatistics::totals().rays, 40u);
+    }
+}
+
+TEST(IntegratorTest, LightSamplingIsUnbiased)
+{
+    RenderSettings bsdfOnly;
+    bsdfOnly.lightSampling = false;
+
+    RenderSettings balance;
+    balance.misHeuristic = RenderSettings::MisHeuristic::eBalance;
+
+    // Sampling the lights only changes the noise, not the expected radiance
+    double reference = meanRadiance(diffuseScene(bsdfOnly), 200000);
+
+    EXPECT_NEAR(meanRadiance(diffuseScene(RenderSettings()), 50000), reference, reference * 0.03);
+    EXPECT_NEAR(meanRadiance(diffuseScene(balance), 50000), reference, reference * 0.03);
+}
+
+TEST(IntegratorTest, SampleSurfaceCoversShape)
+{
+    auto white = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 1.0);
+    shapes::Rectangle rectangle(Point3(0, 0, 0), Point3(2, 0, 0), Point3(0, 0, 3), white);
+    shapes::Sphere sphere(Point3(1, 1, 1), Vector3(0, 1, 0), 2.0, white);
+
+    EXPECT_NEAR(rectangle.surfaceArea(), 6.0, 1e-9);
+    EXPECT_NEAR(sphere.surfaceArea(), 16.0 * std::atan(1.0) * 4.0, 1e-9);
+
+    Vector3 rectangleMean(0, 0, 0);
+    Vector3 sphereMean(0, 0, 0);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+    for (int i = 0; i < 20000; i++)
+    {
+        Point3 p = rectangle.sampleSurface(Point2(dist(rng), dist(rng)));
+        EXPECT_TRUE(p.x() >= 0 && p.x() <= 2 && p.y() == 0 && p.z() >= 0 && p.z() <= 3);
+        rectangleMean += (p - Point3(0, 0, 0)) / 20000.0;
+
+        Point3 q = sphere.sampleSurface(Point2(dist(rng), dist(rng)));
+        EXPECT_NEAR(abs(q - Point3(1, 1, 1)), 2.0, sizeof(geo_type) < sizeof(double) ? 1e-5 : 1e-9);
+        sphereMean += (q - Point3(1, 1, 1)) / 20000.0;
+    }
+
+    EXPECT_NEAR(rectangleMean.x(), 1.0, 0.05);
+    EXPECT_NEAR(rectangleMean.z(), 1.5, 0.05);
+    EXPECT_LT(abs(sphereMean), 0.05);
+}
+
+TEST(IntegratorTest, CompiledSceneMatchesShapes)
+{
+    auto red = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 0, 0), 1.0);
+    auto green = std::make_shared<Surface>(graphics::ColourRgb<float>(0, 1, 0), 1.0);
+    auto blue = std::make_shared<Surface>(graphics::ColourRgb<float>(0, 0, 1), 0.0, 1.0);
+
+    // Packed spheres, rectangles and planes next to a box, which is tested through its virtual interface
+    Scene::ShapeListType shapes = {
+        std::make_shared<shapes::Plane>(Point3(0, -2, 0), Vector3(0, 1, 0), red),
+        std::make_shared<shapes::Rectangle>(Point3(-2, 2, -2), Point3(-2, 2, 2), Point3(2, 2, -2), green),
+        std::make_shared<shapes::Sphere>(Point3(1, 0, 0), Vector3(0, 1, 0), 0.7, blue),
+        std::make_shared<shapes::Sphere>(Point3(-1, 0.5, 1), Vector3(0, 1, 0), 0.4, red),
+        std::make_shared<shapes::Box>(Vector3(1, 1, 1), Point3(-1, -1, -1), Vector3(0.2, 0.3, 0), green),
+    };
+
+    Scene scene("compiled", "", Camera(16, 16, Point3(0, 0, -1.9), Vector3(0, 0, 1)), shapes);
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<double> dist(-2.5, 2.5);
+
+    // The compiled tests do the same arithmetic as the shapes, but the compiler may fuse it into multiply-adds
+    // differently, so distances can differ by rounding and rays that graze an edge may disagree
+    const double tolerance = sizeof(geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+    int disagreements = 0;
+
+    EXPECT_EQ(scene.materials().size(), 3u);
+
+    for (int i = 0; i < 20000; i++)
+    {
+        Point3 origin(dist(rng), dist(rng), dist(rng));
+        Ray3 ray(origin, normalize(Point3(dist(rng), dist(rng), dist(rng)) - origin));
+        double maxDistance = std::abs(dist(rng)) * 2;
+
+        shapes::Shape::IntersectionResult expected;
+        bool occluded = false;
+
+        for (const auto& shape : scene.geometry())
+        {
+            shapes::Shape::IntersectionResult result = shape->calculateRayIntersection(ray);
+
+            if (result.distance() < expected.distance() && result.distance() > 1e-6)
+            {
+                expected = result;
+            }
+
+            occluded = occluded || shape->intersectsWithin(ray, 1e-6, maxDistance);
+        }
+
+        shapes::Shape::IntersectionResult nearest = scene.nearestIntersection(ray, 1e-6);
+
+        if (nearest.shape() != expected.shape() || scene.isOccluded(ray, 1e-6, maxDistance) != occluded)
+        {
+            disagreements++;
+            continue;
+        }
+
+        if (nearest.shape())
+        {
+            EXPECT_NEAR(nearest.distance(), expected.distance(), tolerance * (1 + expected.distance()));
+            EXPECT_NEAR(abs(nearest.normal() - expected.normal()), 0.0, 1e-3);
+            const Surface& material = scene.materials()[nearest.material()];
+            EXPECT_EQ(material.colour().red(), nearest.shape()->surface().colour().red());
+            EXPECT_EQ(material.colour().green(), nearest.shape()->surface().colour().green());
+            EXPECT_EQ(material.reflectance(), nearest.shape()->surface().reflectance());
+        }
+    }
+
+    EXPECT_LE(disagreements, 10);
+}
+
+TEST(IntegratorTest, PacketMatchesSingleRays)
+{
+    Scene scene = glassScene();
+    sampling::SobolSampler sampler(16);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> dist(-0.6, 0.6);
+
+    for (int i = 0; i < 200; i++)
+    {
+        // Every other packet is a narrow fan as the camera makes them, the rest are spread out and traced ray by ray
+        double spread = i % 2 == 0 ? 0.01 : 1.0;
+        Vector3 axis(dist(rng), dist(rng), 1);
+
+        CameraPacket<packetWidth()> packet;
+        packet.dimension = 1;
+
+        for (std::size_t lane = 0; lane < packetWidth(); lane++)
+        {
+            packet.x[lane] = lane;
+            packet.y[lane] = std::size_t(i);
+            packet.sampleIndex[lane] = std::size_t(i) % 16;
+            packet.rays.push(Ray3(Point3(0, 0, -1.9), normalize(axis + spread * Vector3(dist(rng), dist(rng), 0))));
+        }
+
+        CameraPacket<packetWidth()>::Colours colours;
+        tracePacket(packet, scene, sampler, colours);
+
+        for (std::size_t lane = 0; lane < packetWidth(); lane++)
+        {
+            packet.resumeSample(sampler, lane);
+            graphics::ColourRgb<float> expected = tracePath(packet.rays.ray(lane), scene, sampler);
+
+            EXPECT_NEAR(colours[lane].red(), expected.red(), 1e-4 * (1 + expected.red()));
+            EXPECT_NEAR(colours[lane].green(), expected.green(), 1e-4 * (1 + expected.green()));
+            EXPECT_NEAR(colours[lane].blue(), expected.blue(), 1e-4 * (1 + expected.blue()));
+        }
+    }
+}
+
+TEST(IntegratorTest, WavefrontMatchesRecursive)
+{
+    RenderSettings split;
+    split.fresnelMode = RenderSettings::FresnelMode::eBoth;
+
+    // Without splitting, every sample is a single chain that draws its random numbers in the same order either way,
+    // so the colours match. Split paths are shaded in another order, so then only the expected radiance is the same.
+    std::vector<std::pair<Scene, bool>> scenes = {{glassScene(), true}, {diffuseScene(RenderSettings()), true}, {glassScene(split), false}};
+
+    for (const auto& entry : scenes)
+    {
+        const Scene& scene = entry.first;
+        sampling::SobolSampler sampler(64);
+        std::mt19937 rng(8);
+        std::uniform_real_distribution<double> dist(-0.6, 0.6);
+        double wavefrontSum = 0.0;
+        double recursiveSum = 0.0;
+        std::size_t index = 0;
+
+        for (int i = 0; i < 24; i++)
+        {
+            auto packet = std::make_unique<CameraPacket<wavefrontWidth()>>();
+            packet->dimension = 1;
+
+            for (std::size_t lane = 0; lane < wavefrontWidth(); lane++, index++)
+            {
+                packet->x[lane] = index % 16;
+                packet->y[lane] = index / 16 % 16;
+                packet->sampleIndex[lane] = index / 256;
+                packet->rays.push(Ray3(Point3(0, 0, -1.9), normalize(Vector3(dist(rng), dist(rng), 1))));
+            }
+
+            auto colours = std::make_unique<CameraPacket<wavefrontWidth()>::Colours>();
+            traceWavefront(*packet, scene, sampler, *colours);
+
+            for (std::size_t lane = 0; lane < wavefrontWidth(); lane++)
+            {
+                packet->resumeSample(sampler, lane);
+                graphics::ColourRgb<float> expected = tracePath(packet->rays.ray(lane), scene, sampler);
+                const graphics::ColourRgb<float>& colour = (*colours)[lane];
+
+                if (entry.second)
+                {
+                    EXPECT_NEAR(colour.red(), expected.red(), 1e-4 * (1 + expected.red()));
+                    EXPECT_NEAR(colour.green(), expected.green(), 1e-4 * (1 + expected.green()));
+                    EXPECT_NEAR(colour.blue(), expected.blue(), 1e-4 * (1 + expected.blue()));
+                }
+
+                wavefrontSum += colour.red() + colour.green() + colour.blue();
+                recursiveSum += expected.red() + expected.green() + expected.blue();
+            }
+        }
+
+        EXPECT_NEAR(wavefrontSum, recursiveSum, recursiveSum * 0.05);
+    }
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <sampling/Samplers.hpp>
+
+using namespace sampling;
+
+namespace
+{
+    // Counts how many of the first n samples of a pixel fall into each of the n strata along each axis of every
+    // dimension; a stratified set of samples hits every stratum once.
+    bool stratifiesDimensions(Sampler& sampler, std::size_t n, std::size_t dimensions)
+    {
+        for (std::size_t dimension = 0; dimension < dimensions; dimension++)
+        {
+            std::vector<int> strata1D(n, 0);
+            std::vector<int> stratumX(n, 0);
+            std::vector<int> stratumY(n, 0);
+
+            for (std::size_t i = 0; i < n; i++)
+            {
+                sampler.startSample(5, 9, i);
+
+                for (std::size_t skip = 0; skip < dimension; skip++)
+                {
+                    sampler.next1D();
+                }
+
+                strata1D[std::size_t(sampler.next1D() * n)]++;
+
+                sampler.startSample(5, 9, i);
+
+                for (std::size_t skip = 0; skip < dimension; skip++)
+                {
+                    sampler.next1D();
+                }
+
+                geometry::Point2 sample = sampler.next2D();
+                stratumX[std::size_t(sample.x() * n)]++;
+                stratumY[std::size_t(sample.y() * n)]++;
+            }
+
+            auto once = [](int count) { return count == 1; };
+
+            if (!std::all_of(strata1D.begin(), strata1D.end(), once) ||
+                    !std::all_of(stratumX.begin(), stratumX.end(), once) ||
+                    !std::all_of(stratumY.begin(), stratumY.end(), once))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+TEST(SamplerTest, ValuesInUnitInterval)
+{
+    for (auto type : {Sampler::Type::eIndependent, Sampler::Type::eStratified, Sampler::Type::eSobol, Sampler::Type::eBlueNoise})
+    {
+        auto sampler = createSampler(type, 16);
+
+        for (std::size_t i = 0; i < 64; i++)
+        {
+            sampler->startSample(i % 7, i / 7, i);
+
+            for (int dimension = 0; dimension < 50; dimension++)
+            {
+                double value = sampler->next1D();
+                geometry::Point2 sample = sampler->next2D();
+
+                EXPECT_TRUE(value >= 0.0 && value < 1.0);
+                EXPECT_TRUE(sample.x() >= 0.0 && sample.x() < 1.0);
+                EXPECT_TRUE(sample.y() >= 0.0 && sample.y() < 1.0);
+            }
+        }
+    }
+}
+
+TEST(SamplerTest, SobolIsStratified)
+{
+    SobolSampler sampler(16);
+    EXPECT_TRUE(stratifiesDimensions(sampler, 16, 8));
+
+    // The points of a 2D pair also form a (0, 4, 2)-net: one point in each 4x4 cell
+    std::vector<int> cells(16, 0);
+
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        sampler.startSample(1, 2, i);
+        geometry::Point2 sample = sampler.next2D();
+        cells[std::size_t(sample.x() * 4) + 4 * std::size_t(sample.y() * 4)]++;
+    }
+
+    EXPECT_EQ(std::count(cells.begin(), cells.end(), 1), 16);
+}
+
+TEST(SamplerTest, StratifiedIsStratified)
+{
+    StratifiedSampler sampler(16);
+
+    for (std::size_t dimension = 0; dimension < 8; dimension++)
+    {
+        std::vector<int> strata(16, 0);
+        std::vector<int> cells(16, 0);
+
+        for (std::size_t i = 0; i < 16; i++)
+        {
+            sampler.startSample(3, 4, i);
+
+            for (std::size_t skip = 0; skip < dimension; skip++)
+            {
+                sampler.next1D();
+            }
+
+            strata[std::size_t(sampler.next1D() * 16)]++;
+            geometry::Point2 sample = sampler.next2D();
+            cells[std::size_t(sample.x() * 4) + 4 * std::size_t(sample.y() * 4)]++;
+        }
+
+        EXPECT_EQ(std::count(strata.begin(), strata.end(), 1), 16);
+        EXPECT_EQ(std::count(cells.begin(), cells.end(), 1), 16);
+    }
+}
+
+TEST(SamplerTest, DimensionsAreDecorrelated)
+{
+    SobolSampler sampler(16);
+    int identical = 0;
+
+    // Without per dimension scrambles every dimension would repeat the same sequence
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        sampler.startSample(0, 0, i);
+        identical += sampler.next1D() == sampler.next1D();
+    }
+
+    EXPECT_EQ(identical, 0);
+}
+
+TEST(SamplerTest, BlueNoiseMaskIsPermutation)
+{
+    const BlueNoiseMask& mask = BlueNoiseMask::instance();
+    const std::size_t size = BlueNoiseMask::sm_size;
+    std::vector<int> ranks(size * size, 0);
+    double neighbourDifference = 0.0;
+
+    for (std::uint32_t y = 0; y < size; y++)
+    {
+        for (std::uint32_t x = 0; x < size; x++)
+        {
+            ranks[std::size_t(mask.value(x, y) * size * size)]++;
+            neighbourDifference += std::abs(mask.value(x, y) - mask.value(x + 1, y));
+        }
+    }
+
+    EXPECT_EQ(std::count(ranks.begin(), ranks.end(), 1), int(size * size));
+
+    // White noise would average 1/3; blue noise keeps neighbours further apart
+    EXPECT_GT(neighbourDifference / (size * size), 0.36);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+
+#include <shapes/SignedDistanceField.hpp>
+#include <shapes/Sphere.hpp>
+
+using namespace geometry;
+
+TEST(SignedDistanceFieldTest, MatchesSphere)
+{
+    auto white = std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 1.0);
+    Point3 centre(0.5, -0.25, 1);
+
+    // The field is read the way a scene file nests it, with the sphere placed relative to the shape's location
+    builders::BuilderArgs sphereArgs;
+    sphereArgs.insert("op", builders::ParamTypes::String("sphere"));
+    sphereArgs.insert("location", builders::ParamTypes::FloatList{0.25, 0, 0});
+    sphereArgs.insert("radius", builders::ParamTypes::Integer(1));
+    auto field = shapes::DistanceNodeBuilder().build(sphereArgs);
+
+    shapes::SignedDistanceField sdf(*field, centre - Vector3(0.25, 0, 0), white);
+    shapes::Sphere sphere(centre, Vector3(0, 1, 0), 1.0, white);
+
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<double> dist(-3, 3);
+    const double tolerance = sizeof(geo_type) < sizeof(double) ? 1e-3 : 1e-5;
+    int hits = 0;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        Point3 from = centre + Vector3(dist(rng), dist(rng), dist(rng));
+        Ray3 ray(from, normalize(centre + 0.5 * Vector3(dist(rng), dist(rng), dist(rng)) - from));
+        shapes::Shape::IntersectionResult expected = sphere.calculateRayIntersection(ray);
+        shapes::Shape::IntersectionResult hit = sdf.calculateRayIntersection(ray);
+
+        EXPECT_EQ(sdf.intersectsWithin(ray, 0, 100), hit.shape() != nullptr);
+
+        if ((hit.shape() != nullptr) != (expected.shape() != nullptr))
+        {
+            // Only rays that graze the sphere may be hits for one and not the other
+            Vector3 toCentre = centre - ray.origin();
+            EXPECT_NEAR(abs(toCentre - (toCentre * ray.direction()) * ray.direction()), 1.0, tolerance);
+            continue;
+        }
+
+        if (!hit.shape())
+        {
+            continue;
+        }
+
+        hits++;
+
+        // Tracing stops within a tolerance of the surface, which is further along the ray for glancing rays
+        Point3 p = ray.origin() + hit.distance() * ray.direction();
+        EXPECT_NEAR(abs(p - centre), 1.0, tolerance);
+        EXPECT_LT(abs(hit.normal() - normalize(p - centre)), tolerance);
+
+        // Rays leaving the surface of the sphere from outside find its far side going in, and nothing going out
+        Vector3 n = hit.normal();
+
+        if (ray.direction() * n < 0)
+        {
+            Ray3 reflected(p, ray.direction() - 2 * (ray.direction() * n) * n);
+            Ray3 inward(p, -n);
+
+            EXPECT_EQ(sdf.calculateRayIntersection(reflected).shape(), nullptr);
+            shapes::Shape::IntersectionResult through = sdf.calculateRayIntersection(inward);
+            ASSERT_EQ(through.shape(), &sdf);
+            EXPECT_NEAR(through.distance(), 2.0, tolerance);
+        }
+    }
+
+    EXPECT_GT(hits, 200);
+}
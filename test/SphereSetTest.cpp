@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <shapes/SphereSet.hpp>
+#include <Scene.hpp>
+
+#include "TestFiles.hpp"
+
+using namespace geometry;
+
+namespace
+{
+    std::shared_ptr<Surface> surfaceOfColour(float red, float green, float blue)
+    {
+        return std::make_shared<Surface>(graphics::ColourRgb<float>(red, green, blue), 1.0);
+    }
+
+    template <typename T>
+    void writeLittleEndian(std::ostream& out, T value)
+    {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        const std::uint16_t probe = 1;
+        bool littleEndianHost = *reinterpret_cast<const unsigned char*>(&probe) == 1;
+
+        for (std::size_t i = 0; i < sizeof(T); i++)
+        {
+            out.put(char(bytes[littleEndianHost ? i : sizeof(T) - 1 - i]));
+        }
+    }
+
+    void writeSphereSet(const std::string& filename, const shapes::SphereSetData& spheres)
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out.write("SPHERES1", 8);
+        writeLittleEndian(out, std::uint32_t(spheres.size()));
+        writeLittleEndian(out, std::uint32_t(spheres.materials.empty() ? 0 : 1));
+
+        for (std::size_t i = 0; i < spheres.size(); i++)
+        {
+            writeLittleEndian(out, spheres.x[i]);
+            writeLittleEndian(out, spheres.y[i]);
+            writeLittleEndian(out, spheres.z[i]);
+            writeLittleEndian(out, spheres.radius[i]);
+        }
+
+        for (std::uint16_t material : spheres.materials)
+        {
+            writeLittleEndian(out, material);
+        }
+    }
+
+    // Small spheres scattered through [-2, 2]^3, some of them overlapping, with materials cycling through three
+    shapes::SphereSetData cloud(std::size_t count, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-2, 2);
+        std::uniform_real_distribution<float> radius(0.01f, 0.1f);
+        shapes::SphereSetData spheres;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            spheres.x.push_back(position(rng));
+            spheres.y.push_back(position(rng));
+            spheres.z.push_back(position(rng));
+            spheres.radius.push_back(radius(rng));
+            spheres.materials.push_back(std::uint16_t(i % 3));
+        }
+
+        return spheres;
+    }
+
+    // Nearest distance beyond minDistance at which the ray meets sphere i, or infinity
+    double sphereDistance(const shapes::SphereSetData& spheres, std::size_t i, const Ray3& ray, double minDistance)
+    {
+        Vector3 toCentre = Point3(spheres.x[i], spheres.y[i], spheres.z[i]) - ray.origin();
+        double projectedCentre = toCentre * ray.direction();
+        double discriminant = double(spheres.radius[i]) * spheres.radius[i] - (toCentre * toCentre - projectedCentre * projectedCentre);
+
+        if (discriminant >= 0)
+        {
+            double p1 = projectedCentre - std::sqrt(discriminant);
+            double p2 = projectedCentre + std::sqrt(discriminant);
+
+            if (p1 > minDistance)
+            {
+                return p1;
+            }
+
+            if (p2 > minDistance)
+            {
+                return p2;
+            }
+        }
+
+        return std::numeric_limits<double>::infinity();
+    }
+}
+
+TEST(SphereSetTest, LoadsFile)
+{
+    std::string filename = testfiles::tempPath("SphereSetTest-load.spheres");
+    shapes::SphereSetData written = cloud(5, 1);
+    writeSphereSet(filename, written);
+
+    shapes::SphereSetData loaded = shapes::SphereSetLoader::load(filename);
+    ASSERT_EQ(loaded.size(), 5u);
+    EXPECT_EQ(loaded.x, written.x);
+    EXPECT_EQ(loaded.radius, written.radius);
+    EXPECT_EQ(loaded.materials, written.materials);
+
+    // A truncated file and a negative radius are both rejected
+    {
+        std::ofstream out(filename, std::ios::binary | std::ios::app);
+        out.put('\0');
+    }
+
+    EXPECT_THROW(shapes::SphereSetLoader::load(filename), SphereSetLoadException);
+
+    written.materials.clear();
+    written.radius[2] = -1;
+    writeSphereSet(filename, written);
+    EXPECT_THROW(shapes::SphereSetLoader::load(filename), SphereSetLoadException);
+
+    std::remove(filename.c_str());
+    EXPECT_THROW(shapes::SphereSetLoader::load(filename), SphereSetLoadException);
+}
+
+TEST(SphereSetTest, MatchesIndividualSpheres)
+{
+    shapes::SphereSetData spheres = cloud(2001, 2);
+    shapes::SphereSet set(shapes::SphereSetData(spheres), {surfaceOfColour(1, 1, 1), surfaceOfColour(1, 0, 0), surfaceOfColour(0, 1, 0)});
+
+    // Sorting and padding the set does not lose or add spheres, and it takes about 16 bytes each besides the materials and hierarchy
+    EXPECT_EQ(set.size(), spheres.size());
+    EXPECT_LT(set.memoryUsage(), spheres.size() * 23);
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> dist(-2.5, 2.5);
+    // Hits nearer than this are skipped by the set, as they are by meshes
+    const double tolerance = sizeof(geo_type) < sizeof(double) ? 1e-4 : 1e-9;
+    int hits = 0;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        Point3 origin(dist(rng), dist(rng), dist(rng));
+        Ray3 ray(origin, normalize(Point3(dist(rng), dist(rng), dist(rng)) - origin));
+        double maxDistance = std::abs(dist(rng));
+
+        double expected = std::numeric_limits<double>::infinity();
+        std::size_t expectedSphere = 0;
+        bool occluded = false;
+
+        for (std::size_t sphere = 0; sphere < spheres.size(); sphere++)
+        {
+            double distance = sphereDistance(spheres, sphere, ray, tolerance);
+
+            if (distance < expected)
+            {
+                expected = distance;
+                expectedSphere = sphere;
+            }
+
+            occluded = occluded || sphereDistance(spheres, sphere, ray, 1e-6) < maxDistance;
+        }
+
+        shapes::Shape::IntersectionResult hit = set.calculateRayIntersection(ray);
+        EXPECT_EQ(set.intersectsWithin(ray, 1e-6, maxDistance), occluded);
+
+        if (expected == std::numeric_limits<double>::infinity())
+        {
+            EXPECT_EQ(hit.shape(), nullptr);
+            continue;
+        }
+
+        Point3 centre(spheres.x[expectedSphere], spheres.y[expectedSphere], spheres.z[expectedSphere]);
+        Vector3 normal = (ray.origin() + ray.direction() * expected - centre) * (1.0 / spheres.radius[expectedSphere]);
+
+        ASSERT_EQ(hit.shape(), &set);
+        EXPECT_NEAR(hit.distance(), expected, tolerance * (1 + expected));
+        EXPECT_NEAR(abs(hit.normal() - normal), 0.0, 1e-3);
+        EXPECT_EQ(hit.material(), spheres.materials[expectedSphere]);
+        hits++;
+    }
+
+    EXPECT_GT(hits, 500);
+}
+
+TEST(SphereSetTest, SceneUsesParticleMaterials)
+{
+    shapes::SphereSetData spheres;
+    spheres.x = {-1, 1};
+    spheres.y = {0, 0};
+    spheres.z = {0, 0};
+    spheres.radius = {0.5f, 0.5f};
+    spheres.materials = {1, 0};
+
+    auto white = surfaceOfColour(1, 1, 1);
+    auto red = surfaceOfColour(1, 0, 0);
+
+    shapes::SphereSetData above;
+    above.x = {0};
+    above.y = {3};
+    above.z = {0};
+    above.radius = {0.5f};
+
+    // The second set's materials are offset in the scene's table by the first's surfaces
+    Scene::ShapeListType shapes = {
+        std::make_shared<shapes::SphereSet>(std::move(above), std::vector<std::shared_ptr<Surface>>{surfaceOfColour(0, 0, 1)}),
+        std::make_shared<shapes::SphereSet>(std::move(spheres), std::vector<std::shared_ptr<Surface>>{white, red}),
+    };
+
+    Scene scene("spheres", "", Camera(16, 16, Point3(0, 0, -3), Vector3(0, 0, 1)), shapes);
+
+    auto left = scene.nearestIntersection(Ray3(Point3(-1, 0, -3), Vector3(0, 0, 1)), 1e-6);
+    auto right = scene.nearestIntersection(Ray3(Point3(1, 0, -3), Vector3(0, 0, 1)), 1e-6);
+
+    ASSERT_EQ(left.shape(), shapes[1].get());
+    ASSERT_EQ(right.shape(), shapes[1].get());
+    EXPECT_NEAR(left.distance(), 2.5, 1e-6);
+    EXPECT_EQ(scene.materials()[left.material()].colour().green(), 0.0f);
+    EXPECT_EQ(scene.materials()[right.material()].colour().green(), 1.0f);
+    EXPECT_EQ(scene.materials()[right.material()].colour().blue(), 1.0f);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+#include <geometry/SturmSequence.hpp>
+
+using namespace geometry;
+
+namespace
+{
+    // Coefficients, constant term first, of the monic quartic with the given roots
+    SturmSequence<4>::Coefficients fromRoots(double r0, double r1, double r2, double r3)
+    {
+        SturmSequence<4>::Coefficients coefficients = {1, 0, 0, 0, 0};
+
+        for (double root : {r0, r1, r2, r3})
+        {
+            for (std::size_t i = 4; i > 0; i--)
+            {
+                coefficients[i] = coefficients[i - 1] - root * coefficients[i];
+            }
+
+            coefficients[0] *= -root;
+        }
+
+        return coefficients;
+    }
+}
+
+TEST(SturmSequenceTest, CountsAndFindsSimpleRoots)
+{
+    SturmSequence<4> quartic(fromRoots(1, 2, 3, 4));
+    double root;
+
+    EXPECT_EQ(quartic.rootCount(0, 5), 4);
+    EXPECT_EQ(quartic.rootCount(1.5, 3.5), 2);
+    EXPECT_EQ(quartic.rootCount(4.5, 10), 0);
+
+    ASSERT_TRUE(quartic.smallestRoot(0, 5, root));
+    EXPECT_NEAR(root, 1.0, 1e-12);
+    ASSERT_TRUE(quartic.smallestRoot(2.5, 5, root));
+    EXPECT_NEAR(root, 3.0, 1e-12);
+    EXPECT_FALSE(quartic.smallestRoot(4.5, 10, root));
+}
+
+TEST(SturmSequenceTest, HandlesRepeatedAndComplexRoots)
+{
+    double root;
+
+    // A double root is counted once, and found even though the polynomial does not change sign there
+    SturmSequence<4> touching(fromRoots(2, 2, -1, -3));
+    EXPECT_EQ(touching.rootCount(0, 5), 1);
+    ASSERT_TRUE(touching.smallestRoot(0, 5, root));
+    EXPECT_NEAR(root, 2.0, 1e-6);
+
+    // t^4 + 1 has no real roots
+    SturmSequence<4> none({1, 0, 0, 0, 1});
+    EXPECT_EQ(none.rootCount(-10, 10), 0);
+    EXPECT_FALSE(none.smallestRoot(-10, 10, root));
+
+    // (t^2 + 1)(t - 0.5)(t - 7): the complex pair does not hide the real roots
+    SturmSequence<4> mixed({3.5, -7.5, 4.5, -7.5, 1});
+    EXPECT_EQ(mixed.rootCount(0, 10), 2);
+    ASSERT_TRUE(mixed.smallestRoot(0, 10, root));
+    EXPECT_NEAR(root, 0.5, 1e-12);
+}
+
+TEST(SturmSequenceTest, SeparatesCloseRoots)
+{
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<double> dist(-5, 5);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        std::array<double, 4> roots = {dist(rng), dist(rng), dist(rng), dist(rng)};
+
+        // Every tenth polynomial has two roots very close together
+        if (i % 10 == 0)
+        {
+            roots[1] = roots[0] + 1e-5;
+        }
+
+        SturmSequence<4> quartic(fromRoots(roots[0], roots[1], roots[2], roots[3]));
+        std::sort(roots.begin(), roots.end());
+
+        double lower = roots[0] - 1;
+        double root;
+
+        ASSERT_TRUE(quartic.smallestRoot(lower, 6, root));
+        EXPECT_NEAR(root, roots[0], 1e-7);
+
+        double between = 0.5 * (roots[2] + roots[3]);
+
+        if (roots[3] - roots[2] > 1e-3)
+        {
+            ASSERT_TRUE(quartic.smallestRoot(between, 6, root));
+            EXPECT_NEAR(root, roots[3], 1e-7);
+        }
+    }
+}
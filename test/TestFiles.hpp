@@ -0,0 +1,24 @@
+#ifndef TEST_TESTFILES_HPP
+#define TEST_TESTFILES_HPP
+
+#include <cstdlib>
+#include <string>
+
+namespace testfiles
+{
+    // Path of a scratch file in $TMPDIR, or /tmp if that is not set
+    inline std::string tempPath(const std::string& name)
+    {
+        const char* directory = std::getenv("TMPDIR");
+        std::string path = directory && *directory ? directory : "/tmp";
+
+        if (path.back() != '/')
+        {
+            path += '/';
+        }
+
+        return path + name;
+    }
+}
+
+#endif
@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include <threading/ThreadPool.hpp>
+#include <threading/WorkerGroup.hpp>
+
+using namespace threading;
+
+namespace
+{
+    typedef graphics::Image<graphics::ColourRgb<float>> ResultImage;
+}
+
+TEST(ThreadPoolTest, ProblemSpaceRandomAccess)
+{
+    ProblemSpace space(3, 4, 2);
+    std::size_t index = 0;
+
+    ASSERT_EQ(space.size(), 24u);
+
+    for (auto problem = space.begin(); problem != space.end(); ++problem)
+    {
+        EXPECT_TRUE(problem == space.at(index));
+        index++;
+    }
+
+    EXPECT_EQ(index, space.size());
+    EXPECT_TRUE(space.at(space.size()) == space.end());
+}
+
+TEST(ThreadPoolTest, SpaceFillingOrders)
+{
+    for (auto ordering : {ProblemSpace::Ordering::eMorton, ProblemSpace::Ordering::eHilbert})
+    {
+        ProblemSpace space(13, 7, 1, 1, ordering);
+        std::vector<int> visits(space.size(), 0);
+
+        for (std::size_t i = 0; i < space.size(); i++)
+        {
+            visits[space.at(i)[0] + space.at(i)[1] * 13]++;
+        }
+
+        EXPECT_EQ(std::count(visits.begin(), visits.end(), 1), 13 * 7);
+    }
+
+    // On a power of two grid every step along the Hilbert curve moves to an adjacent cell
+    ProblemSpace hilbert(8, 8, 1, 1, ProblemSpace::Ordering::eHilbert);
+
+    for (std::size_t i = 1; i < hilbert.size(); i++)
+    {
+        auto a = hilbert.at(i - 1);
+        auto b = hilbert.at(i);
+        int distance = std::abs(int(a[0]) - int(b[0])) + std::abs(int(a[1]) - int(b[1]));
+
+        EXPECT_EQ(distance, 1);
+    }
+}
+
+TEST(ThreadPoolTest, TileLayoutClipsEdges)
+{
+    TileLayout tiles(70, 40, 32);
+    std::size_t area = 0;
+
+    EXPECT_EQ(tiles.tileCount(), 6u);
+
+    for (auto problem = tiles.problemSpace().begin(); problem != tiles.problemSpace().end(); ++problem)
+    {
+        Tile tile = tiles.tile(problem);
+
+        EXPECT_LE(tile.x + tile.width, 70u);
+        EXPECT_LE(tile.y + tile.height, 40u);
+        area += tile.width * tile.height;
+    }
+
+    EXPECT_EQ(area, 70u * 40u);
+}
+
+TEST(ThreadPoolTest, RunsEveryProblemOnce)
+{
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> visits(1000);
+
+    for (auto& visit : visits)
+    {
+        visit = 0;
+    }
+
+    std::atomic<int> started(0);
+    std::atomic<int> tilesCompleted(0);
+    bool succeeded = false;
+
+    auto handle = pool.enqueueTask(ResultImage(1, 1), [&](ResultImage&, const Problem& problem, const std::atomic<bool>&) {
+        visits[problem[0] + problem[1] * 100]++;
+    }, TileLayout(100, 10, 1, ProblemSpace::Ordering::eLinear));
+
+    handle.setStartCallback([&](const ResultImage&) { started++; });
+    handle.setTileCallback([&](const ResultImage&, const Tile&) { tilesCompleted++; });
+    handle.setCompleteCallback([&](const ResultImage&, bool success) { succeeded = success; });
+    handle.wait();
+
+    EXPECT_EQ(started, 1);
+    EXPECT_LE(tilesCompleted, 1000);
+    EXPECT_TRUE(succeeded);
+
+    for (const auto& visit : visits)
+    {
+        EXPECT_EQ(visit, 1);
+    }
+}
+
+TEST(ThreadPoolTest, ConcurrentTasks)
+{
+    ThreadPool pool(2);
+    std::atomic<bool> release(false);
+
+    // The first task cannot finish until the second one has run to completion, and holds one worker meanwhile
+    auto blocked = pool.enqueueTask(ResultImage(1, 1), [&](ResultImage&, const Problem& problem, const std::atomic<bool>& cancelled) {
+        while (problem[0] == 0 && !release && !cancelled)
+        {
+            std::this_thread::yield();
+        }
+    }, TileLayout(64, 1, 1, ProblemSpace::Ordering::eLinear));
+
+    auto quick = pool.enqueueTask(ResultImage(1, 1), [](ResultImage&, const Problem&, const std::atomic<bool>&) { }, TileLayout(64, 1, 1, ProblemSpace::Ordering::eLinear));
+
+    EXPECT_TRUE(quick.wait_for(std::chrono::seconds(10)));
+    EXPECT_FALSE(blocked.completed());
+
+    release = true;
+    blocked.wait();
+}
+
+TEST(ThreadPoolTest, CancelledTaskCompletes)
+{
+    ThreadPool pool(2);
+    std::atomic<int> executed(0);
+    bool succeeded = true;
+
+    auto handle = pool.enqueueTask(ResultImage(1, 1), [&](ResultImage&, const Problem&, const std::atomic<bool>&) {
+        executed++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }, TileLayout(100, 100, 1, ProblemSpace::Ordering::eLinear));
+
+    handle.setCompleteCallback([&](const ResultImage&, bool success) { succeeded = success; });
+    handle.cancel();
+    handle.wait();
+
+    EXPECT_FALSE(succeeded);
+    EXPECT_LT(executed, 10000);
+}
+
+TEST(ThreadPoolTest, PassesAndStopping)
+{
+    ThreadPool pool(3);
+    std::vector<std::atomic<int>> visits(5);
+
+    for (auto& visit : visits)
+    {
+        visit = 0;
+    }
+
+    // Every problem is run once per pass, and passes never overlap
+    PassSettings passes;
+    passes.passCount = 5;
+    std::atomic<bool> release(false);
+    std::vector<std::size_t> passCallbacks;
+
+    auto handle = pool.enqueueTask(ResultImage(1, 1), [&](ResultImage&, const Problem& problem, const std::atomic<bool>&) {
+        while (!release)
+        {
+            std::this_thread::yield();
+        }
+
+        EXPECT_TRUE(problem.pass() == 0 || visits[problem.pass() - 1] == 64);
+        EXPECT_LE(++visits[problem.pass()], 64);
+    }, TileLayout(8, 8, 1), passes);
+
+    handle.setPassCallback([&](const ResultImage&, std::size_t passesCompleted) {
+        EXPECT_EQ(visits[passesCompleted - 1], 64);
+        passCallbacks.push_back(passesCompleted);
+    });
+
+    release = true;
+    handle.wait();
+
+    EXPECT_EQ(handle.passesCompleted(), 5u);
+    EXPECT_EQ(passCallbacks, std::vector<std::size_t>({1, 2, 3, 4, 5}));
+    EXPECT_FALSE(handle.timedOut());
+
+    // The stop condition is checked after each pass
+    std::atomic<int> executed(0);
+    passes.passCount = 100;
+    passes.stopCondition = [](std::size_t passesCompleted) { return passesCompleted == 3; };
+
+    auto stopped = pool.enqueueTask(ResultImage(1, 1), [&](ResultImage&, const Problem&, const std::atomic<bool>&) {
+        executed++;
+    }, TileLayout(8, 8, 1), passes);
+
+    stopped.wait();
+
+    EXPECT_EQ(stopped.passesCompleted(), 3u);
+    EXPECT_EQ(executed, 3 * 64);
+    EXPECT_FALSE(stopped.timedOut());
+
+    // Past the deadline no more problems are started, but the task still succeeds
+    passes.stopCondition = nullptr;
+    passes.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+    bool succeeded = false;
+
+    auto timed = pool.enqueueTask(ResultImage(1, 1), [&](ResultImage&, const Problem&, const std::atomic<bool>&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }, TileLayout(8, 8, 1), passes);
+
+    timed.setCompleteCallback([&](const ResultImage&, bool success) { succeeded = success; });
+    timed.wait();
+
+    EXPECT_TRUE(succeeded);
+    EXPECT_TRUE(timed.timedOut());
+    EXPECT_LT(timed.passesCompleted(), 100u);
+}
+
+TEST(ThreadPoolTest, WorkerGroupRunsEveryChunkOnce)
+{
+    WorkerGroup workers(4);
+
+    // Many loops in a row on the same threads, as a hierarchy build does
+    for (std::size_t chunkCount : {0, 1, 2, 7, 100, 3, 1000})
+    {
+        std::vector<std::atomic<int>> visits(chunkCount);
+
+        for (auto& visit : visits)
+        {
+            visit = 0;
+        }
+
+        workers.run(chunkCount, [&](std::size_t chunk) { visits[chunk]++; });
+
+        for (std::size_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            EXPECT_EQ(visits[chunk], 1) << chunkCount << ", " << chunk;
+        }
+    }
+}
@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <shapes/MeshCache.hpp>
+#include <shapes/MeshLoader.hpp>
+#include <shapes/TriangleMesh.hpp>
+
+#include "TestFiles.hpp"
+
+using namespace geometry;
+
+namespace
+{
+    // Unit cube centred on the origin, with quads split into triangles by the loader
+    const char* cubeObj =
+        "# cube\n"
+        "v -0.5 -0.5 -0.5\nv 0.5 -0.5 -0.5\nv 0.5 0.5 -0.5\nv -0.5 0.5 -0.5\n"
+        "v -0.5 -0.5 0.5\nv 0.5 -0.5 0.5\nv 0.5 0.5 0.5\nv -0.5 0.5 0.5\n"
+        "vn 0 0 -1\n"
+        "f 1//1 4//1 3//1 2//1\nf 5 6 7 8\nf 1 2 6 5\nf 4 8 7 3\nf 1 5 8 4\nf -7 -6 -2 -3\n";
+
+    std::shared_ptr<Surface> white()
+    {
+        return std::make_shared<Surface>(graphics::ColourRgb<float>(1, 1, 1), 1.0);
+    }
+
+    // Regular grid of n x n quads in the z = 0 plane, two triangles each, spanning [0, 1] x [0, 1]
+    shapes::MeshData grid(std::size_t n)
+    {
+        shapes::MeshData mesh;
+
+        for (std::size_t y = 0; y <= n; y++)
+        {
+            for (std::size_t x = 0; x <= n; x++)
+            {
+                mesh.addVertex(double(x) / n, double(y) / n, 0.0);
+            }
+        }
+
+        for (std::size_t y = 0; y < n; y++)
+        {
+            for (std::size_t x = 0; x < n; x++)
+            {
+                std::uint32_t i = std::uint32_t(y * (n + 1) + x);
+                mesh.addPolygon({i, i + 1, i + std::uint32_t(n) + 2, i + std::uint32_t(n) + 1});
+            }
+        }
+
+        return mesh;
+    }
+
+    template <typename T>
+    void writeBigEndian(std::ostream& out, T value)
+    {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+
+        for (std::size_t i = 0; i < sizeof(T); i++)
+        {
+            out.put(char(bytes[sizeof(T) - 1 - i]));
+        }
+    }
+}
+
+TEST(TriangleMeshTest, LoadsObj)
+{
+    std::istringstream in(cubeObj);
+    shapes::MeshData mesh = shapes::MeshLoader::loadObj(in);
+
+    EXPECT_EQ(mesh.vertexCount(), 8u);
+    EXPECT_EQ(mesh.triangleCount(), 12u);
+
+    std::istringstream bad("v 0 0 0\nf 1 2 3\n");
+    EXPECT_THROW(shapes::MeshLoader::loadObj(bad), MeshLoadException);
+}
+
+TEST(TriangleMeshTest, LoadsBinaryPly)
+{
+    // Big endian on purpose, so that the byte swapping is exercised on the usual little endian hosts. The extra
+    // vertex property and the face list with a different count type must be skipped correctly.
+    std::ostringstream out;
+    out << "ply\r\nformat binary_big_endian 1.0\r\ncomment test\r\n"
+        << "element vertex 4\r\nproperty float x\r\nproperty float y\r\nproperty float z\r\nproperty uchar red\r\n"
+        << "element face 1\r\nproperty list uchar int vertex_indices\r\nend_header\r\n";
+
+    const float vertices[4][3] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 2.5f}};
+
+    for (const auto& v : vertices)
+    {
+        writeBigEndian(out, v[0]);
+        writeBigEndian(out, v[1]);
+        writeBigEndian(out, v[2]);
+        writeBigEndian(out, std::uint8_t(255));
+    }
+
+    writeBigEndian(out, std::uint8_t(4));
+
+    for (std::int32_t i = 0; i < 4; i++)
+    {
+        writeBigEndian(out, i);
+    }
+
+    std::istringstream in(out.str());
+    shapes::MeshData mesh = shapes::MeshLoader::loadPly(in);
+
+    ASSERT_EQ(mesh.vertexCount(), 4u);
+    ASSERT_EQ(mesh.triangleCount(), 2u);
+    EXPECT_EQ(mesh.z[3], 2.5);
+    EXPECT_EQ(mesh.indices[5], 3u);
+}
+
+TEST(TriangleMeshTest, IntersectsCube)
+{
+    std::istringstream in(cubeObj);
+    shapes::TriangleMesh cube(shapes::MeshLoader::loadObj(in), white());
+
+    Ray3 ray(Point3(0.1, 0.2, -3), Vector3(0, 0, 1));
+    auto hit = cube.calculateRayIntersection(ray);
+
+    ASSERT_EQ(hit.shape(), &cube);
+    EXPECT_NEAR(hit.distance(), 2.5, 1e-12);
+    EXPECT_NEAR(std::abs(hit.normal()[2]), 1.0, 1e-6);
+
+    // The barycentric coordinates give back the hit point
+    auto corner = [&](std::size_t vertex, std::size_t axis) {
+        std::uint32_t index = cube.indices()[3 * hit.primitive() + vertex];
+        return axis == 0 ? cube.x()[index] : (axis == 1 ? cube.y()[index] : cube.z()[index]);
+    };
+    const double expected[] = {0.1, 0.2, -0.5};
+
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        double p = (1 - hit.uv().x() - hit.uv().y()) * corner(0, axis) + hit.uv().x() * corner(1, axis) + hit.uv().y() * corner(2, axis);
+        EXPECT_NEAR(p, expected[axis], 1e-6);
+    }
+
+    // From inside, the far wall is found rather than the one the ray starts on
+    Ray3 inside(Point3(0.1, 0.2, -0.5), Vector3(0, 0, 1));
+    EXPECT_NEAR(cube.calculateRayIntersection(inside).distance(), 1.0, 1e-12);
+
+    EXPECT_TRUE(cube.intersectsWithin(ray, 0.0, 3.0));
+    EXPECT_FALSE(cube.intersectsWithin(ray, 0.0, 2.0));
+    EXPECT_EQ(cube.calculateRayIntersection(Ray3(Point3(0.6, 0, -3), Vector3(0, 0, 1))).shape(), nullptr);
+    EXPECT_NEAR(cube.boundingBox().surfaceArea(), 6.0, 1e-12);
+}
+
+TEST(TriangleMeshTest, SharedEdgesAreWatertight)
+{
+    shapes::TriangleMesh mesh(grid(8), white());
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> cell(1, 7);
+    std::uniform_real_distribution<double> offset(0.0, 1.0);
+    std::uniform_real_distribution<double> tilt(-0.3, 0.3);
+
+    // Rays aimed exactly at grid vertices, along grid lines and across the diagonals shared by triangle pairs
+    for (int i = 0; i < 20000; i++)
+    {
+        double x = cell(rng) / 8.0;
+        double y = cell(rng) / 8.0;
+
+        switch (i % 3)
+        {
+            case 0: break;
+            case 1: x += offset(rng) / 8.0 * (i % 2 ? 1 : 0); break;
+            case 2: { double t = offset(rng) / 8.0; x += t; y += t; break; }
+        }
+
+        Vector3 direction = normalize(Vector3(tilt(rng), tilt(rng), 1));
+        Point3 target(x, y, 0);
+        Ray3 ray(target - direction * 2.0, direction);
+
+        EXPECT_NEAR(mesh.calculateRayIntersection(ray).distance(), 2.0, 1e-9) << x << ", " << y;
+    }
+}
+
+TEST(TriangleMeshTest, CacheRoundTrip)
+{
+    std::string source = testfiles::tempPath("TriangleMeshTest-cube.obj");
+    std::string cachePath = shapes::MeshCache::path(source, 42);
+
+    {
+        std::ofstream file(source);
+        file << cubeObj;
+    }
+
+    std::istringstream in(cubeObj);
+    shapes::TriangleMesh built(shapes::MeshLoader::loadObj(in), white());
+
+    shapes::MeshCache::Entry entry;
+    entry.x = built.x();
+    entry.y = built.y();
+    entry.z = built.z();
+    entry.indices = built.indices();
+    entry.hierarchy = built.hierarchy();
+    ASSERT_TRUE(shapes::MeshCache::store(cachePath, source, 42, entry));
+
+    shapes::MeshCache::Entry cached;
+    EXPECT_FALSE(shapes::MeshCache::load(cachePath, source, 43, cached));
+    ASSERT_TRUE(shapes::MeshCache::load(cachePath, source, 42, cached));
+
+    shapes::TriangleMesh cube(cached.x, cached.y, cached.z, cached.indices, cached.hierarchy, cached.storage, white());
+    ASSERT_EQ(cube.triangleCount(), 12u);
+    EXPECT_EQ(cube.hierarchy().nodes().size(), built.hierarchy().nodes().size());
+
+    for (double x = -0.45; x < 0.5; x += 0.1)
+    {
+        Ray3 ray(Point3(x, 0.2, -3), normalize(Vector3(0.01, 0.02, 1)));
+        auto expected = built.calculateRayIntersection(ray);
+        auto hit = cube.calculateRayIntersection(ray);
+
+        EXPECT_EQ(hit.distance(), expected.distance());
+        EXPECT_EQ(hit.primitive(), expected.primitive());
+    }
+
+    // Changing the source invalidates the cache, even if its size stays the same
+    {
+        std::string edited = cubeObj;
+        edited[edited.find("0.5") + 2] = '4';
+        std::ofstream file(source);
+        file << edited;
+    }
+
+    EXPECT_FALSE(shapes::MeshCache::load(cachePath, source, 42, cached));
+
+    std::remove(source.c_str());
+    std::remove(cachePath.c_str());
+}
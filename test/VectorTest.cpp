@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <cmath>
+#include <limits>
 
 #include <geometry/Vector.hpp>
 
@@ -8,7 +9,8 @@ using namespace geometry;
 
 namespace
 {
-    const geo_type epsilon = 1e-10;
+    // Loose enough for builds with a single precision geo_type
+    const geo_type epsilon = sizeof(geo_type) < sizeof(double) ? 1e-5 : 1e-10;
 }
 
 template <typename T, std::size_t Dimensions>
@@ -88,3 +90,27 @@ TEST(VectorTest, Normalize)
 {
     VECTOR_EXPECT_NEAR(normalize(Vector3(1, 2, 3)), Vector3(1 / sqrt(14), 2 / sqrt(14), 3 / sqrt(14)), epsilon);
 }
+
+TEST(VectorTest, CrossProduct)
+{
+    VECTOR_EXPECT_NEAR(cross_product(Vector3(1, 0, 0), Vector3(0, 1, 0)), Vector3(0, 0, 1), epsilon);
+    VECTOR_EXPECT_NEAR(cross_product(Vector3(1, 2, 3), Vector3(-4, 5, 0)), Vector3(-15, -12, 13), epsilon);
+}
+
+TEST(VectorTest, PaddingDoesNotLeak)
+{
+    // Dividing by zero may leave NaN in the padding of SIMD vectors; only the visible components may take part
+    Vector3 v = Vector3(1, 2, 3) / geo_type(0);
+
+    EXPECT_EQ(v * Vector3(1, 1, 1), std::numeric_limits<geo_type>::infinity());
+    EXPECT_EQ(abs(v), std::numeric_limits<geo_type>::infinity());
+    EXPECT_FALSE(v.isNaN());
+}
+
+#if GEOMETRY_NAN_CHECK == GEOMETRY_NAN_CHECK_ASSERT
+TEST(VectorTest, NanNamesKernel)
+{
+    EXPECT_DEATH(Vector3(0, 0, 0) / geo_type(0), "first NaN produced by Vector division");
+    EXPECT_DEATH(Vector3(std::numeric_limits<geo_type>::infinity(), 1, 1) * geo_type(0), "first NaN produced by Vector scaling");
+}
+#endif